@@ -215,7 +215,7 @@ struct QtDecoder::Impl
     */
    void saveDecoderConfig(const QJsonObject &status)
    {
-      QStringList list = {"nfca", "nfcb", "nfcf", "nfcv"};
+      QStringList list = {"nfca", "nfcb", "nfcf", "nfcv", "compact"};
 
       for (QString &name: list)
       {
@@ -391,8 +391,31 @@ struct QtDecoder::Impl
    {
       QJsonObject json;
 
-      json["fileName"] = event->getString("fileName");
+      QString fileName = event->getString("fileName");
+
+      bool compress = settings.value("recorder/compress", false).toBool();
+
+      QString sampleFormat = settings.value("recorder/sampleFormat", "s16").toString();
+
+      // lossless codec only takes integer samples up to 24 bits, record plain WAV instead
+      if (compress && (sampleFormat == "f32" || sampleFormat == "s32"))
+      {
+         qWarning() << "compressed recording does not support sample format" << sampleFormat << ", recording WAV";
+
+         compress = false;
+      }
+
+      // compressed recordings use their own extension so they are recognized when opened
+      if (compress && fileName.endsWith(".wav"))
+         fileName = fileName.left(fileName.length() - 4) + ".iqz";
+
+      json["fileName"] = fileName;
       json["sampleRate"] = event->getInteger("sampleRate");
+      json["compress"] = compress;
+      json["sampleFormat"] = sampleFormat;
+      json["dither"] = settings.value("recorder/dither", false).toBool();
+      json["segmentSize"] = settings.value("recorder/segmentSize", 0).toInt();
+      json["segmentTime"] = settings.value("recorder/segmentTime", 0).toInt();
 
       // clear signal cache
       cache->clear();
@@ -435,6 +458,7 @@ struct QtDecoder::Impl
       QJsonObject nfcb;
       QJsonObject nfcf;
       QJsonObject nfcv;
+      QJsonObject compact;
 
       if (event->contains("sampleRate"))
          json["sampleRate"] = event->getInteger("sampleRate");
@@ -488,6 +512,16 @@ struct QtDecoder::Impl
       if (event->contains("nfcv/maximumModulationDeep"))
          nfcv["maximumModulationDeep"] = event->getFloat("nfcv/maximumModulationDeep");
 
+      // idle polling compaction
+      if (event->contains("compact/enabled"))
+         compact["enabled"] = event->getBoolean("compact/enabled");
+
+      if (event->contains("compact/minimumRepeats"))
+         compact["minimumRepeats"] = (int) event->getFloat("compact/minimumRepeats");
+
+      if (event->contains("compact/summaryInterval"))
+         compact["summaryInterval"] = event->getFloat("compact/summaryInterval");
+
       if (!nfca.isEmpty())
          json["nfca"] = nfca;
 
@@ -500,6 +534,9 @@ struct QtDecoder::Impl
       if (!nfcv.isEmpty())
          json["nfcv"] = nfcv;
 
+      if (!compact.isEmpty())
+         json["compact"] = compact;
+
       taskDecoderConfig(json);
    }
 
@@ -534,6 +571,15 @@ struct QtDecoder::Impl
       if (event->contains("directSampling"))
          json["directSampling"] = event->getInteger("directSampling");
 
+      if (event->contains("transferCount"))
+         json["transferCount"] = event->getInteger("transferCount");
+
+      if (event->contains("transferSize"))
+         json["transferSize"] = event->getInteger("transferSize");
+
+      if (event->contains("transferMode"))
+         json["transferMode"] = event->getInteger("transferMode");
+
       taskReceiverConfig(json);
    }
 
@@ -548,7 +594,7 @@ struct QtDecoder::Impl
 
       json["fileName"] = fileName;
 
-      if (fileName.endsWith(".wav"))
+      if (fileName.endsWith(".wav") || fileName.endsWith(".iqz"))
       {
          // clear storage queue
          taskStorageClear([=] {
@@ -559,7 +605,7 @@ struct QtDecoder::Impl
             });
          });
       }
-      else if (fileName.endsWith(".xml") || fileName.endsWith(".json"))
+      else if (fileName.endsWith(".xml") || fileName.endsWith(".json") || fileName.endsWith(".nfl"))
       {
          // clear storage queue
          taskStorageClear([=] {
@@ -583,7 +629,7 @@ struct QtDecoder::Impl
       if (fileName.endsWith(".wav"))
       {
       }
-      else if (fileName.endsWith(".xml") || fileName.endsWith(".json"))
+      else if (fileName.endsWith(".xml") || fileName.endsWith(".json") || fileName.endsWith(".nfl"))
       {
          // start XML file write
          taskStorageWrite(json);
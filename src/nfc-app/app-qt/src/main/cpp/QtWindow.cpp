@@ -22,6 +22,8 @@
 
 */
 
+#include <chrono>
+
 #include <QDebug>
 #include <QKeyEvent>
 #include <QClipboard>
@@ -35,8 +37,11 @@
 #include <QItemSelection>
 
 #include <rt/Subject.h>
+#include <rt/Histogram.h>
 #include <sdr/SignalBuffer.h>
 
+#include <nfc/FrameCompactor.h>
+
 #include <model/StreamFilter.h>
 #include <model/StreamModel.h>
 #include <model/ParserModel.h>
@@ -102,6 +107,12 @@ struct QtWindow::Impl
    // last decoder status received
    QString decoderStatus;
 
+   // show summaries of repeated polling as their individual frames
+   bool expandRepeated = false;
+
+   // expands summaries in time order for stream and timing views
+   mutable nfc::FrameExpander frameExpander;
+
    // interface
    QSharedPointer<Ui_QtWindow> ui;
 
@@ -132,6 +143,13 @@ struct QtWindow::Impl
    // fft signal stream subscription
    rt::Subject<sdr::SignalBuffer>::Subscription frequencySubscription;
 
+   // frame latency in microseconds, Qt event delivery and capture to UI
+   mutable rt::Histogram latencyDelivery;
+   mutable rt::Histogram latencyTotal;
+
+   // last latency report
+   mutable std::chrono::steady_clock::time_point lastLatency;
+
    explicit Impl(QMainWindow *window, QSettings &settings, QtMemory *cache) : window(window),
                                                                               settings(settings),
                                                                               cache(cache),
@@ -255,6 +273,10 @@ struct QtWindow::Impl
       {
          if (event->status() == DecoderStatusEvent::Idle && decoderStatus == DecoderStatusEvent::Decoding)
          {
+            // frames held back by expander are the last ones of capture
+            for (const auto &frame: frameExpander.flush())
+               appendFrame(frame);
+
             ui->framesView->setRange(INT32_MIN, INT32_MAX);
             ui->signalView->setRange(INT32_MIN, INT32_MAX);
 
@@ -329,6 +351,22 @@ struct QtWindow::Impl
    {
       const auto &frame = event->frame();
 
+      if (expandRepeated)
+      {
+         for (const auto &occurrence: frameExpander.nextFrames(frame))
+            appendFrame(occurrence);
+      }
+      else
+      {
+         appendFrame(frame);
+      }
+
+      // update latency statistics
+      updateLatency(event);
+   }
+
+   void appendFrame(const nfc::NfcFrame &frame) const
+   {
       // add frames to stream model
       streamModel->append(frame);
 
@@ -336,6 +374,31 @@ struct QtWindow::Impl
       ui->framesView->append(frame);
    }
 
+   void updateLatency(StreamFrameEvent *event) const
+   {
+      auto now = std::chrono::steady_clock::now();
+
+      long long time = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+
+      latencyDelivery.add((time - event->postTime()) / 1000);
+
+      // only frames from live capture have capture time
+      if (event->frame().captureTime())
+         latencyTotal.add((time - event->frame().captureTime()) / 1000);
+
+      if (now - lastLatency > std::chrono::seconds(1))
+      {
+         qInfo().nospace() << "frame latency p50/p99/max (us) delivery "
+                           << latencyDelivery.percentile(50) << "/" << latencyDelivery.percentile(99) << "/" << latencyDelivery.max()
+                           << ", total " << latencyTotal.percentile(50) << "/" << latencyTotal.percentile(99) << "/" << latencyTotal.max();
+
+         latencyDelivery.clear();
+         latencyTotal.clear();
+
+         lastLatency = now;
+      }
+   }
+
    void signalBufferEvent(SignalBufferEvent *event) const
    {
       ui->signalView->append(event->buffer());
@@ -366,6 +429,19 @@ struct QtWindow::Impl
             updateBiasTee(settings.value("device." + deviceType + "/biasTee", "0").toInt());
             updateDirectSampling(settings.value("device." + deviceType + "/directSampling", "0").toInt());
 
+            // async transfer setup for devices that support it
+            if (settings.contains("device." + deviceType + "/transferCount") || settings.contains("device." + deviceType + "/transferSize"))
+            {
+               QtApplication::post(new DecoderControlEvent(DecoderControlEvent::ReceiverConfig, {
+                     {"transferCount", settings.value("device." + deviceType + "/transferCount", "8").toInt()},
+                     {"transferSize", settings.value("device." + deviceType + "/transferSize", "65536").toInt()}
+               }));
+            }
+
+            // raw or packed transfers for devices that support it
+            if (settings.contains("device." + deviceType + "/transferMode"))
+               QtApplication::post(new DecoderControlEvent(DecoderControlEvent::ReceiverConfig, {{"transferMode", settings.value("device." + deviceType + "/transferMode").toInt()}}));
+
             ui->eventsLog->append(QString("Detected device %1").arg(deviceName));
          }
 
@@ -783,6 +859,8 @@ struct QtWindow::Impl
    void clearModel()
    {
       streamModel->resetModel();
+
+      frameExpander.reset();
    }
 
    void clearGraph()
@@ -1094,6 +1172,13 @@ QtWindow::QtWindow(QSettings &settings, QtMemory *cache) : impl(new Impl(this, s
    impl->setFollowEnabled(settings.value("window/followEnabled", true).toBool());
    impl->setFilterEnabled(settings.value("window/filterEnabled", true).toBool());
 
+   // summaries from decoder.compact are shown folded unless expanded
+   impl->expandRepeated = settings.value("window/expandRepeated", false).toBool();
+
+   // bound frames held in memory by stream view, older ones are paged from disk
+   impl->streamModel->setSpillPath(settings.value("storage/spillPath", "").toString());
+   impl->streamModel->setRetention(settings.value("storage/retentionFrames", 0).toLongLong(), settings.value("storage/retentionTime", 0).toDouble(), settings.value("storage/retentionBytes", 0).toLongLong());
+
    // update window size
    setMinimumSize(settings.value("window/defaultWidth", 1024).toInt(), settings.value("window/defaultHeight", 720).toInt());
 
@@ -1116,7 +1201,7 @@ void QtWindow::clearView()
 
 void QtWindow::openFile()
 {
-   QString fileName = QFileDialog::getOpenFileName(this, tr("Open capture file"), "", tr("Capture (*.wav *.xml *.json);;All Files (*)"));
+   QString fileName = QFileDialog::getOpenFileName(this, tr("Open capture file"), "", tr("Capture (*.wav *.iqz *.xml *.json *.nfl);;All Files (*)"));
 
    if (!fileName.isEmpty())
    {
@@ -1142,7 +1227,7 @@ void QtWindow::saveFile()
    QString date = QDateTime::currentDateTime().toString("yyyyMMddHHmmss");
    QString name = QString("record-%2.json").arg(date);
 
-   QString fileName = QFileDialog::getSaveFileName(this, tr("Save record file"), name, tr("Capture (*.xml *.json);;All Files (*)"));
+   QString fileName = QFileDialog::getSaveFileName(this, tr("Save record file"), name, tr("Capture (*.json *.nfl *.xml);;All Files (*)"));
 
    if (!fileName.isEmpty())
    {
@@ -22,12 +22,14 @@
 
 */
 
+#include <chrono>
+
 #include "StreamFrameEvent.h"
 
 int StreamFrameEvent::Type = QEvent::registerEventType();
 
 StreamFrameEvent::StreamFrameEvent(const nfc::NfcFrame &frame) :
-		QEvent(QEvent::Type(Type)), mFrame(frame)
+		QEvent(QEvent::Type(Type)), mFrame(frame), mPostTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
 {
 }
 
@@ -36,3 +38,8 @@ const nfc::NfcFrame &StreamFrameEvent::frame() const
 	return mFrame;
 }
 
+long long StreamFrameEvent::postTime() const
+{
+   return mPostTime;
+}
+
@@ -39,11 +39,16 @@ class StreamFrameEvent: public QEvent
 
       nfc::NfcFrame mFrame;
 
+      long long mPostTime;
+
 	public:
 
       explicit StreamFrameEvent(const nfc::NfcFrame &frame);
 
       const nfc::NfcFrame &frame() const;
+
+      // monotonic post time in nanoseconds (steady clock)
+      long long postTime() const;
 };
 
 #endif /* STREAMFRAMEEVENT_H */
@@ -24,8 +24,17 @@
 
 #include <cmath>
 
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+
 #include <rt/Logger.h>
+#include <rt/Qos.h>
+#include <rt/Tracer.h>
 #include <rt/Executor.h>
+#include <rt/Scheduler.h>
 #include <rt/Subject.h>
 #include <rt/Event.h>
 #include <rt/BlockingQueue.h>
@@ -39,6 +48,8 @@
 #include <nfc/FourierProcessTask.h>
 #include <nfc/FrameDecoderTask.h>
 #include <nfc/FrameStorageTask.h>
+#include <nfc/MetricsExportTask.h>
+#include <nfc/PipelineGroupTask.h>
 #include <nfc/SignalReceiverTask.h>
 #include <nfc/SignalRecorderTask.h>
 
@@ -354,6 +365,69 @@ int startTest3(int argc, char *argv[])
    return 0;
 }
 
+/*
+ * Read thread scheduling profile from [scheduling.<name>] group
+ */
+rt::Scheduler::Profile readProfile(QSettings &settings, const QString &name)
+{
+   settings.beginGroup("scheduling." + name);
+
+   // comma separated values are read as list by QSettings
+   QString cpuSet = settings.value("cpuSet").toStringList().join(",");
+   QString policy = settings.value("policy", "default").toString();
+   int priority = settings.value("priority", 0).toInt();
+
+   settings.endGroup();
+
+   return rt::Scheduler::parse(cpuSet.toStdString(), policy.toStdString(), priority);
+}
+
+/*
+ * Read pipeline thread scheduling profile from [scheduling.<name>.<pipeline>] group, or [scheduling.<name>] if not present
+ */
+rt::Scheduler::Profile readProfile(QSettings &settings, const QString &name, const QString &pipeline)
+{
+   if (!pipeline.isEmpty() && settings.childGroups().contains("scheduling." + name + "." + pipeline))
+      return readProfile(settings, name + "." + pipeline);
+
+   return readProfile(settings, name);
+}
+
+/*
+ * Read metrics export options from [metrics] group
+ */
+QJsonObject readStorage(QSettings &settings)
+{
+   QJsonObject config;
+
+   settings.beginGroup("storage");
+
+   config["logPath"] = settings.value("logPath", "").toString();
+   config["spillPath"] = settings.value("spillPath", "").toString();
+   config["retentionFrames"] = settings.value("retentionFrames", 0).toLongLong();
+   config["retentionTime"] = settings.value("retentionTime", 0).toDouble();
+   config["retentionBytes"] = settings.value("retentionBytes", 0).toLongLong();
+
+   settings.endGroup();
+
+   return config;
+}
+
+QJsonObject readMetrics(QSettings &settings)
+{
+   QJsonObject config;
+
+   settings.beginGroup("metrics");
+
+   config["enabled"] = settings.value("enabled", true).toBool();
+   config["path"] = settings.value("path", "metrics/nfc-lab.prom").toString();
+   config["interval"] = settings.value("interval", 5000).toInt();
+
+   settings.endGroup();
+
+   return config;
+}
+
 int startApp(int argc, char *argv[])
 {
    Logger log {"main"};
@@ -369,26 +443,96 @@ int startApp(int argc, char *argv[])
 
    log.info("using libusb version: {}.{}.{}", {lusbv->major, lusbv->minor, lusbv->micro});
 
-   // create executor service
-   Executor executor(128, 10);
+   // pipeline scheduling profiles
+   QSettings settings("nfc-lab.conf", QSettings::IniFormat);
+
+   // timeline tracing, exported on exit
+   bool traceEnabled = settings.value("trace/enabled", false).toBool();
+   QString tracePath = settings.value("trace/path", "trace/nfc-lab.json").toString();
+
+   if (traceEnabled)
+   {
+      log.info("timeline tracing enabled, output to {}", {tracePath.toStdString()});
+
+      rt::Tracer::enable(true);
+      rt::Tracer::thread("ui");
+   }
+
+   // load shedding for best-effort tasks when decoder or recorder fall behind
+   rt::Qos::configure(settings.value("qos/threshold", 50000).toLongLong(), settings.value("qos/decimation", 4).toInt(), settings.value("qos/overload", 4).toInt());
+
+   // receiver devices captured at once, each one with its own decoder pipeline
+   QStringList devices = settings.value("settings/devices").toStringList();
+
+   // create executor service, one thread per task plus spare threads for jobs
+   Executor executor(128, devices.size() > 1 ? 9 + 2 * devices.size() : 10);
+
+   auto submit = [&](rt::Worker *task, const QString &name, const QString &pipeline = {}) {
+      task->setProfile(readProfile(settings, name, pipeline));
+      executor.submit(task);
+   };
 
    // startup signal resampling task
-   executor.submit(nfc::AdaptiveSamplingTask::construct());
+   submit(nfc::AdaptiveSamplingTask::construct(), "adaptive");
 
    // startup fourier transform task
-   executor.submit(nfc::FourierProcessTask::construct());
-
-   // startup signal decoder task
-   executor.submit(nfc::FrameDecoderTask::construct());
+   submit(nfc::FourierProcessTask::construct(), "fourier");
 
    // startup frame writer task
    executor.submit(nfc::FrameStorageTask::construct());
 
+   // configure live frame log from settings
+   rt::Subject<rt::Event>::name("storage.command")->next({nfc::FrameStorageTask::Configure, {{"data", QJsonDocument(readStorage(settings)).toJson().toStdString()}}});
+
    // startup signal reader task
-   executor.submit(nfc::SignalRecorderTask::construct());
+   submit(nfc::SignalRecorderTask::construct(), "recorder");
 
-   // startup signal receiver task
-   executor.submit(nfc::SignalReceiverTask::construct());
+   if (devices.size() > 1)
+   {
+      std::vector<rt::Context> pipelines;
+
+      for (int i = 0; i < devices.size(); i++)
+      {
+         rt::Context pipeline("rx" + std::to_string(i));
+
+         log.info("pipeline {} for device {}", {pipeline.name(), devices[i].toStdString()});
+
+         // startup pipeline decoder task
+         submit(nfc::FrameDecoderTask::construct(pipeline), "decoder", QString::fromStdString(pipeline.name()));
+
+         // startup pipeline receiver task, device threads inherit its cpu set
+         submit(nfc::SignalReceiverTask::construct(pipeline, devices[i].toStdString()), "receiver", QString::fromStdString(pipeline.name()));
+
+         pipelines.push_back(pipeline);
+      }
+
+      // startup pipeline group, merges decoded frames into global frame stream
+      executor.submit(nfc::PipelineGroupTask::construct(pipelines));
+
+      // configure frame merge from settings
+      rt::Subject<rt::Event>::name("group.command")->next({nfc::PipelineGroupTask::Configure, {{"data", QJsonDocument(QJsonObject {{"mergeWindow", settings.value("group/mergeWindow", 50).toInt()}}).toJson().toStdString()}}});
+   }
+   else
+   {
+      // startup signal decoder task
+      submit(nfc::FrameDecoderTask::construct(), "decoder");
+
+      // startup signal receiver task, device threads inherit its cpu set
+      submit(nfc::SignalReceiverTask::construct({}, devices.value(0).toStdString()), "receiver");
+   }
+
+   // startup metrics export task
+   executor.submit(nfc::MetricsExportTask::construct());
+
+   // configure metrics export from settings
+   rt::Subject<rt::Event>::name("metrics.command")->next({nfc::MetricsExportTask::Configure, {{"data", QJsonDocument(readMetrics(settings)).toJson().toStdString()}}});
+
+   // apply UI profile to main thread, after pool threads are created
+   auto uiProfile = readProfile(settings, "ui");
+
+   log.info("apply UI scheduling profile {}", {rt::Scheduler::describe(uiProfile)});
+
+   rt::Scheduler::apply(uiProfile);
 
    // set logging handler
    qInstallMessageHandler(messageOutput);
@@ -400,7 +544,18 @@ int startApp(int argc, char *argv[])
    QtApplication app(argc, argv);
 
    // start application
-   return QtApplication::exec();
+   int result = QtApplication::exec();
+
+   // export timeline
+   if (traceEnabled)
+   {
+      QFileInfo(tracePath).absoluteDir().mkpath(".");
+
+      if (!rt::Tracer::dump(tracePath.toStdString()))
+         log.warn("unable to write timeline to {}", {tracePath.toStdString()});
+   }
+
+   return result;
 }
 
 int main(int argc, char *argv[])
@@ -26,15 +26,21 @@
 
 #include <QFont>
 #include <QLabel>
+#include <QDir>
+#include <QCache>
 #include <QQueue>
 #include <QDateTime>
 #include <QReadLocker>
 
 #include <nfc/Nfc.h>
 #include <nfc/NfcFrame.h>
+#include <nfc/FrameStore.h>
 
 #include "StreamModel.h"
 
+// materialized frames kept for display and selection
+#define FRAME_CACHE_SIZE 1024
+
 static QMap<int, QString> NfcACmd = {
       {0x1A, "AUTH"}, // MIFARE Ultralight C authentication
       {0x1B, "PWD_AUTH"}, // MIFARE Ultralight EV1
@@ -112,8 +118,11 @@ struct StreamModel::Impl
    // table header
    QVector<QString> headers;
 
-   // frame list
-   QList<nfc::NfcFrame *> frames;
+   // frame list, columnar store with binary searchable time columns
+   nfc::FrameStore frames;
+
+   // frames built from store, recently used rows stay valid
+   QCache<int, nfc::NfcFrame> cache {FRAME_CACHE_SIZE};
 
    // frame stream
    QQueue<nfc::NfcFrame> stream;
@@ -132,9 +141,16 @@ struct StreamModel::Impl
       responseDefaultFont.setItalic(true);
    }
 
-   ~Impl()
+   nfc::NfcFrame *frame(int row)
    {
-      qDeleteAll(frames);
+      if (auto frame = cache.object(row))
+         return frame;
+
+      auto frame = new nfc::NfcFrame(frames.frame(row));
+
+      cache.insert(row, frame);
+
+      return frame;
    }
 
    inline QString frameTime(const nfc::NfcFrame *frame)
@@ -428,7 +444,7 @@ StreamModel::StreamModel(QObject *parent) : QAbstractTableModel(parent), impl(ne
 
 int StreamModel::rowCount(const QModelIndex &parent) const
 {
-   return impl->frames.size();
+   return (int) impl->frames.size();
 }
 
 int StreamModel::columnCount(const QModelIndex &parent) const
@@ -438,15 +454,15 @@ int StreamModel::columnCount(const QModelIndex &parent) const
 
 QVariant StreamModel::data(const QModelIndex &index, int role) const
 {
-   if (!index.isValid() || index.row() >= impl->frames.size() || index.row() < 0)
+   if (!index.isValid() || index.row() >= rowCount() || index.row() < 0)
       return {};
 
    nfc::NfcFrame *prev = nullptr;
 
-   auto frame = impl->frames.at(index.row());
+   auto frame = impl->frame(index.row());
 
    if (index.row() > 0)
-      prev = impl->frames.at(index.row() - 1);
+      prev = impl->frame(index.row() - 1);
 
    if (role == Qt::DisplayRole || role == Qt::UserRole)
    {
@@ -468,7 +484,15 @@ QVariant StreamModel::data(const QModelIndex &index, int role) const
             return impl->frameTech(frame);
 
          case Columns::Event:
-            return impl->frameEvent(frame, prev);
+         {
+            QString event = impl->frameEvent(frame, prev);
+
+            // folded polling cycles, see FrameCompactor
+            if (frame->isRepeated())
+               event += QString(" %1%2").arg(QChar(0x00d7)).arg(frame->repeatCount());
+
+            return event;
+         }
 
          case Columns::Flags:
             return impl->frameFlags(frame);
@@ -556,7 +580,7 @@ QModelIndex StreamModel::index(int row, int column, const QModelIndex &parent) c
    if (!hasIndex(row, column, parent))
       return {};
 
-   return createIndex(row, column, impl->frames[row]);
+   return createIndex(row, column);
 }
 
 bool StreamModel::canFetchMore(const QModelIndex &parent) const
@@ -570,11 +594,11 @@ void StreamModel::fetchMore(const QModelIndex &parent)
 {
    QReadLocker locker(&impl->lock);
 
-   beginInsertRows(QModelIndex(), impl->frames.size(), impl->frames.size() + impl->stream.size() - 1);
+   beginInsertRows(QModelIndex(), rowCount(), rowCount() + impl->stream.size() - 1);
 
    while (!impl->stream.isEmpty())
    {
-      impl->frames.append(new nfc::NfcFrame(impl->stream.dequeue()));
+      impl->frames.append(impl->stream.dequeue());
    }
 
    endInsertRows();
@@ -585,8 +609,8 @@ void StreamModel::resetModel()
    QWriteLocker locker(&impl->lock);
 
    beginResetModel();
-   qDeleteAll(impl->frames);
    impl->frames.clear();
+   impl->cache.clear();
    endResetModel();
 }
 
@@ -594,13 +618,14 @@ QModelIndexList StreamModel::modelRange(double from, double to)
 {
    QModelIndexList list;
 
-   for (int i = 0; i < impl->frames.size(); i++)
-   {
-      auto frame = impl->frames.at(i);
+   // candidate rows by binary search on start time
+   auto range = impl->frames.range(from, to);
 
-      if (frame->timeStart() >= from && frame->timeEnd() <= to)
+   for (size_t i = range.first; i < range.second; i++)
+   {
+      if (impl->frames.timeStart(i) >= from && impl->frames.timeEnd(i) <= to)
       {
-         list.append(index(i, 0));
+         list.append(index((int) i, 0));
       }
    }
 
@@ -616,10 +641,27 @@ void StreamModel::append(const nfc::NfcFrame &frame)
 
 nfc::NfcFrame *StreamModel::frame(const QModelIndex &index) const
 {
-   if (!index.isValid())
+   if (!index.isValid() || index.row() >= rowCount())
       return nullptr;
 
-   return static_cast<nfc::NfcFrame *>(index.internalPointer());
+   return impl->frame(index.row());
+}
+
+void StreamModel::setRetention(qint64 frames, double seconds, qint64 bytes)
+{
+   QWriteLocker locker(&impl->lock);
+
+   impl->frames.setRetention(frames, seconds, bytes);
+}
+
+void StreamModel::setSpillPath(const QString &path)
+{
+   QWriteLocker locker(&impl->lock);
+
+   if (!path.isEmpty())
+      QDir().mkpath(path);
+
+   impl->frames.setSpillPath(path.toStdString());
 }
 
 void StreamModel::setTimeFormat(int mode)
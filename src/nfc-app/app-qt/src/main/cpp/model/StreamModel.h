@@ -89,6 +89,10 @@ class StreamModel : public QAbstractTableModel
 
       void setTimeFormat(int mode);
 
+      void setRetention(qint64 frames, double seconds, qint64 bytes);
+
+      void setSpillPath(const QString &path);
+
    signals:
 
       void modelChanged();
@@ -27,6 +27,8 @@
 
 #include <3party/customplot/QCustomPlot.h>
 
+#include <rt/Tracer.h>
+
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
 
@@ -51,6 +53,9 @@ struct FourierWidget::Impl
 
    QCustomPlot *plot = nullptr;
 
+   // start time of current replot, 0 if not traced
+   long long replotStart = 0;
+
    QCPGraph *graph = nullptr;
 
    QSharedPointer<QCPGraphValueMarker> peakMarker;
@@ -152,6 +157,16 @@ struct FourierWidget::Impl
       layout->addWidget(plot);
 
       // connect graph signals
+      // trace replot duration in timeline
+      QObject::connect(plot, &QCustomPlot::beforeReplot, [=]() {
+         replotStart = rt::Tracer::enabled() ? rt::Tracer::now() : 0;
+      });
+
+      QObject::connect(plot, &QCustomPlot::afterReplot, [=]() {
+         if (replotStart)
+            rt::Tracer::span("replot", "fourier", replotStart, rt::Tracer::now());
+      });
+
       QObject::connect(plot, &QCustomPlot::mouseMove, [=](QMouseEvent *event) {
          mouseMove(event);
       });
@@ -31,6 +31,8 @@
 
 #include <3party/customplot/QCustomPlot.h>
 
+#include <rt/Tracer.h>
+
 #include <graph/QCPAxisRangeMarker.h>
 #include <graph/QCPAxisCursorMarker.h>
 
@@ -42,6 +44,9 @@ struct FramesWidget::Impl
 
    QCustomPlot *plot = nullptr;
 
+   // start time of current replot, 0 if not traced
+   long long replotStart = 0;
+
    QSharedPointer<QCPAxisCursorMarker> cursorMarker;
    QSharedPointer<QCPAxisRangeMarker> selectedFrames;
 
@@ -147,6 +152,16 @@ struct FramesWidget::Impl
       layout->addWidget(plot);
 
       // connect graph signals
+      // trace replot duration in timeline
+      QObject::connect(plot, &QCustomPlot::beforeReplot, [=]() {
+         replotStart = rt::Tracer::enabled() ? rt::Tracer::now() : 0;
+      });
+
+      QObject::connect(plot, &QCustomPlot::afterReplot, [=]() {
+         if (replotStart)
+            rt::Tracer::span("replot", "frames", replotStart, rt::Tracer::now());
+      });
+
       QObject::connect(plot, &QCustomPlot::mouseMove, [=](QMouseEvent *event) {
          mouseMove(event);
       });
@@ -28,6 +28,8 @@
 
 #include <3party/customplot/QCustomPlot.h>
 
+#include <rt/Tracer.h>
+
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
 
@@ -48,6 +50,9 @@ struct SignalWidget::Impl
 
    QCustomPlot *plot = nullptr;
 
+   // start time of current replot, 0 if not traced
+   long long replotStart = 0;
+
    QCPGraph *graph = nullptr;
 
    QList<QSharedPointer<QCPAxisRangeMarker>> markerList;
@@ -135,6 +140,16 @@ struct SignalWidget::Impl
       layout->addWidget(plot);
 
       // connect graph signals
+      // trace replot duration in timeline
+      QObject::connect(plot, &QCustomPlot::beforeReplot, [=]() {
+         replotStart = rt::Tracer::enabled() ? rt::Tracer::now() : 0;
+      });
+
+      QObject::connect(plot, &QCustomPlot::afterReplot, [=]() {
+         if (replotStart)
+            rt::Tracer::span("replot", "signal", replotStart, rt::Tracer::now());
+      });
+
       QObject::connect(plot, &QCustomPlot::mouseMove, [=](QMouseEvent *event) {
          mouseMove(event);
       });
@@ -23,6 +23,7 @@
 */
 
 #include <rt/Logger.h>
+#include <rt/Tracer.h>
 
 #include <nfc/Nfc.h>
 #include <nfc/NfcDecoder.h>
@@ -93,7 +94,20 @@ void NfcDecoder::cleanup()
 
 std::list<NfcFrame> NfcDecoder::nextFrames(sdr::SignalBuffer samples)
 {
-   return impl->nextFrames(samples);
+   long long captureTime = samples.captureTime();
+
+   rt::Tracer::Scope scope("nextFrames", "decoder", samples.id(), rt::Tracer::FlowIn);
+
+   std::list<NfcFrame> frames = impl->nextFrames(samples);
+
+   // frames inherit capture time of the buffer where they are completed
+   if (captureTime)
+   {
+      for (auto &frame: frames)
+         frame.setCaptureTime(captureTime);
+   }
+
+   return frames;
 }
 
 bool NfcDecoder::isDebugEnabled() const
@@ -39,6 +39,10 @@ struct NfcFrame::Impl
    double timeStart = 0;
    double timeEnd = 0;
    double dateTime = 0;
+   long long captureTime = 0;
+   unsigned int sourceId = 0;
+   unsigned int repeatCount = 0;
+   double repeatPeriod = 0;
 };
 
 const NfcFrame NfcFrame::Nil;
@@ -70,6 +74,11 @@ NfcFrame::NfcFrame(const NfcFrame &other) : rt::ByteBuffer(other)
    impl = other.impl;
 }
 
+NfcFrame::NfcFrame(NfcFrame &&other) noexcept : rt::ByteBuffer(std::move(other))
+{
+   impl = std::move(other.impl);
+}
+
 NfcFrame &NfcFrame::operator=(const NfcFrame &other)
 {
    if (this == &other)
@@ -82,18 +91,48 @@ NfcFrame &NfcFrame::operator=(const NfcFrame &other)
    return *this;
 }
 
+NfcFrame &NfcFrame::operator=(NfcFrame &&other) noexcept
+{
+   if (this == &other)
+      return *this;
+
+   rt::ByteBuffer::operator=(std::move(other));
+
+   impl = std::move(other.impl);
+
+   return *this;
+}
+
+const NfcFrame::Impl *NfcFrame::attributes() const
+{
+   static const Impl empty;
+
+   return impl ? impl.get() : &empty;
+}
+
+NfcFrame::Impl *NfcFrame::attributes()
+{
+   if (!impl)
+      impl = std::make_shared<Impl>();
+
+   return impl.get();
+}
+
 bool NfcFrame::operator==(const NfcFrame &other) const
 {
    if (this == &other)
       return true;
 
-   if (impl->techType != other.impl->techType ||
-       impl->frameType != other.impl->frameType ||
-       impl->frameFlags != other.impl->frameFlags ||
-       impl->framePhase != other.impl->framePhase ||
-       impl->frameRate != other.impl->frameRate ||
-       impl->sampleStart != other.impl->sampleStart ||
-       impl->sampleEnd != other.impl->sampleEnd)
+   const Impl *a = attributes();
+   const Impl *b = other.attributes();
+
+   if (a->techType != b->techType ||
+       a->frameType != b->frameType ||
+       a->frameFlags != b->frameFlags ||
+       a->framePhase != b->framePhase ||
+       a->frameRate != b->frameRate ||
+       a->sampleStart != b->sampleStart ||
+       a->sampleEnd != b->sampleEnd)
       return false;
 
    return rt::ByteBuffer::operator==(other);
@@ -111,182 +150,227 @@ NfcFrame::operator bool() const
 
 bool NfcFrame::isNfcA() const
 {
-   return impl->techType == TechType::NfcA;
+   return attributes()->techType == TechType::NfcA;
 }
 
 bool NfcFrame::isNfcB() const
 {
-   return impl->techType == TechType::NfcB;
+   return attributes()->techType == TechType::NfcB;
 }
 
 bool NfcFrame::isNfcF() const
 {
-   return impl->techType == TechType::NfcF;
+   return attributes()->techType == TechType::NfcF;
 }
 
 bool NfcFrame::isNfcV() const
 {
-   return impl->techType == TechType::NfcV;
+   return attributes()->techType == TechType::NfcV;
 }
 
 bool NfcFrame::isCarrierOff() const
 {
-   return impl->frameType == FrameType::CarrierOff;
+   return attributes()->frameType == FrameType::CarrierOff;
 }
 
 bool NfcFrame::isCarrierOn() const
 {
-   return impl->frameType == FrameType::CarrierOn;
+   return attributes()->frameType == FrameType::CarrierOn;
 }
 
 bool NfcFrame::isPollFrame() const
 {
-   return impl->frameType == FrameType::PollFrame;
+   return attributes()->frameType == FrameType::PollFrame;
 }
 
 bool NfcFrame::isListenFrame() const
 {
-   return impl->frameType == FrameType::ListenFrame;
+   return attributes()->frameType == FrameType::ListenFrame;
 }
 
 bool NfcFrame::isShortFrame() const
 {
-   return impl->frameFlags & FrameFlags::ShortFrame;
+   return attributes()->frameFlags & FrameFlags::ShortFrame;
 }
 
 bool NfcFrame::isEncrypted() const
 {
-   return impl->frameFlags & FrameFlags::Encrypted;
+   return attributes()->frameFlags & FrameFlags::Encrypted;
 }
 
 bool NfcFrame::isTruncated() const
 {
-   return impl->frameFlags & FrameFlags::Truncated;
+   return attributes()->frameFlags & FrameFlags::Truncated;
 }
 
 bool NfcFrame::hasParityError() const
 {
-   return impl->frameFlags & FrameFlags::ParityError;
+   return attributes()->frameFlags & FrameFlags::ParityError;
 }
 
 bool NfcFrame::hasCrcError() const
 {
-   return impl->frameFlags & FrameFlags::CrcError;
+   return attributes()->frameFlags & FrameFlags::CrcError;
 }
 
 bool NfcFrame::hasSyncError() const
 {
-   return impl->frameFlags & FrameFlags::SyncError;
+   return attributes()->frameFlags & FrameFlags::SyncError;
 }
 
 unsigned int NfcFrame::techType() const
 {
-   return impl->techType;
+   return attributes()->techType;
 }
 
 void NfcFrame::setTechType(unsigned int techType)
 {
-   impl->techType = techType;
+   attributes()->techType = techType;
 }
 
 unsigned int NfcFrame::frameType() const
 {
-   return impl->frameType;
+   return attributes()->frameType;
 }
 
 void NfcFrame::setFrameType(unsigned int frameType)
 {
-   impl->frameType = frameType;
+   attributes()->frameType = frameType;
 }
 
 unsigned int NfcFrame::framePhase() const
 {
-   return impl->framePhase;
+   return attributes()->framePhase;
 }
 
 void NfcFrame::setFramePhase(unsigned int framePhase)
 {
-   impl->framePhase = framePhase;
+   attributes()->framePhase = framePhase;
 }
 
 unsigned int NfcFrame::frameFlags() const
 {
-   return impl->frameFlags;
+   return attributes()->frameFlags;
 }
 
 void NfcFrame::setFrameFlags(unsigned int frameFlags)
 {
-   impl->frameFlags |= frameFlags;
+   attributes()->frameFlags |= frameFlags;
 }
 
 void NfcFrame::clearFrameFlags(unsigned int frameFlags)
 {
-   impl->frameFlags &= ~frameFlags;
+   attributes()->frameFlags &= ~frameFlags;
 }
 
 bool NfcFrame::hasFrameFlags(unsigned int frameFlags)
 {
-   return impl->frameFlags & frameFlags;
+   return attributes()->frameFlags & frameFlags;
 }
 
 unsigned int NfcFrame::frameRate() const
 {
-   return impl->frameRate;
+   return attributes()->frameRate;
 }
 
 void NfcFrame::setFrameRate(unsigned int rate)
 {
-   impl->frameRate = rate;
+   attributes()->frameRate = rate;
 }
 
 double NfcFrame::timeStart() const
 {
-   return impl->timeStart;
+   return attributes()->timeStart;
 }
 
 void NfcFrame::setTimeStart(double timeStart)
 {
-   impl->timeStart = timeStart;
+   attributes()->timeStart = timeStart;
 }
 
 double NfcFrame::timeEnd() const
 {
-   return impl->timeEnd;
+   return attributes()->timeEnd;
 }
 
 void NfcFrame::setTimeEnd(double timeEnd)
 {
-   impl->timeEnd = timeEnd;
+   attributes()->timeEnd = timeEnd;
 }
 
 double NfcFrame::dateTime() const
 {
-   return impl->dateTime;
+   return attributes()->dateTime;
 }
 
 void NfcFrame::setDateTime(double dateTime)
 {
-   impl->dateTime = dateTime;
+   attributes()->dateTime = dateTime;
+}
+
+long long NfcFrame::captureTime() const
+{
+   return attributes()->captureTime;
+}
+
+void NfcFrame::setCaptureTime(long long captureTime)
+{
+   attributes()->captureTime = captureTime;
+}
+
+unsigned int NfcFrame::sourceId() const
+{
+   return attributes()->sourceId;
+}
+
+void NfcFrame::setSourceId(unsigned int sourceId)
+{
+   attributes()->sourceId = sourceId;
+}
+
+unsigned int NfcFrame::repeatCount() const
+{
+   return attributes()->repeatCount;
+}
+
+void NfcFrame::setRepeatCount(unsigned int repeatCount)
+{
+   attributes()->repeatCount = repeatCount;
+}
+
+double NfcFrame::repeatPeriod() const
+{
+   return attributes()->repeatPeriod;
+}
+
+void NfcFrame::setRepeatPeriod(double repeatPeriod)
+{
+   attributes()->repeatPeriod = repeatPeriod;
+}
+
+bool NfcFrame::isRepeated() const
+{
+   return attributes()->repeatCount > 1;
 }
 
 unsigned long NfcFrame::sampleStart() const
 {
-   return impl->sampleStart;
+   return attributes()->sampleStart;
 }
 
 void NfcFrame::setSampleStart(unsigned long sampleStart)
 {
-   impl->sampleStart = sampleStart;
+   attributes()->sampleStart = sampleStart;
 }
 
 unsigned long NfcFrame::sampleEnd() const
 {
-   return impl->sampleEnd;
+   return attributes()->sampleEnd;
 }
 
 void NfcFrame::setSampleEnd(unsigned long sampleEnd)
 {
-   impl->sampleEnd = sampleEnd;
+   attributes()->sampleEnd = sampleEnd;
 }
 
 }
\ No newline at end of file
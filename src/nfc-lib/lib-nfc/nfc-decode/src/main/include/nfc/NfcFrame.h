@@ -49,8 +49,12 @@ class NfcFrame : public rt::ByteBuffer
 
       NfcFrame(const NfcFrame &other);
 
+      NfcFrame(NfcFrame &&other) noexcept;
+
       NfcFrame &operator=(const NfcFrame &other);
 
+      NfcFrame &operator=(NfcFrame &&other) noexcept;
+
       bool operator==(const NfcFrame &other) const;
 
       bool operator!=(const NfcFrame &other) const;
@@ -121,6 +125,24 @@ class NfcFrame : public rt::ByteBuffer
 
       void setDateTime(double dateTime);
 
+      long long captureTime() const;
+
+      void setCaptureTime(long long captureTime);
+
+      unsigned int sourceId() const;
+
+      void setSourceId(unsigned int sourceId);
+
+      unsigned int repeatCount() const;
+
+      void setRepeatCount(unsigned int repeatCount);
+
+      double repeatPeriod() const;
+
+      void setRepeatPeriod(double repeatPeriod);
+
+      bool isRepeated() const;
+
       unsigned long sampleStart() const;
 
       void setSampleStart(unsigned long sampleStart);
@@ -131,6 +153,11 @@ class NfcFrame : public rt::ByteBuffer
 
    private:
 
+      // moved-from frames have no attributes, they read as empty and get new ones when modified
+      const Impl *attributes() const;
+
+      Impl *attributes();
+
       std::shared_ptr<Impl> impl;
 };
 
@@ -25,11 +25,14 @@
 #ifndef NFC_ABSTRACTTASK_H
 #define NFC_ABSTRACTTASK_H
 
+#include <rt/Context.h>
 #include <rt/Event.h>
 #include <rt/Logger.h>
 #include <rt/Map.h>
+#include <rt/Metrics.h>
 #include <rt/BlockingQueue.h>
 #include <rt/Subject.h>
+#include <rt/Worker.h>
 
 #include <nlohmann/json.hpp>
 
@@ -39,6 +42,9 @@ namespace nfc {
 
 struct AbstractTask
 {
+   // pipeline context, declared first so subjects outlive task subscriptions
+   rt::Context context;
+
    rt::Logger log;
 
    // task status stream subject
@@ -53,16 +59,31 @@ struct AbstractTask
    // command stream queue buffer
    rt::BlockingQueue<rt::Event> commandQueue;
 
-   AbstractTask(const std::string &name, const std::string &subject) : log(name)
+   // task worker, notified on each incoming command
+   rt::Worker *worker;
+
+   AbstractTask(rt::Worker *worker, const std::string &name, const std::string &subject, const rt::Context &context = {}) : context(context), log(context.qualify(name)), worker(worker)
    {
       // create decoder status subject
-      statusSubject = rt::Subject<rt::Event>::name(subject + ".status");
+      statusSubject = context.subject<rt::Event>(subject + ".status");
 
       // create decoder control subject
-      commandSubject = rt::Subject<rt::Event>::name(subject + ".command");
+      commandSubject = context.subject<rt::Event>(subject + ".command");
 
       // subscribe to control events
-      commandSubscription = commandSubject->subscribe([this](const rt::Event &command) { commandQueue.add(command); });
+      commandSubscription = commandSubject->subscribe([this](const rt::Event &command) {
+         commandQueue.add(command);
+         this->worker->notify();
+      });
+   }
+
+   // metric labels, series of non global pipelines are tagged with the pipeline name
+   rt::Metrics::Labels labels(rt::Metrics::Labels values = {}) const
+   {
+      if (!context.isGlobal())
+         values["pipeline"] = context.name();
+
+      return values;
    }
 
    void updateStatus(int code, const json &data) const
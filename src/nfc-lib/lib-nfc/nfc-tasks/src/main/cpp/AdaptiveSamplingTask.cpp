@@ -26,6 +26,8 @@
 
 #include <rt/Logger.h>
 #include <rt/BlockingQueue.h>
+#include <rt/Metrics.h>
+#include <rt/Qos.h>
 
 #include <nfc/AdaptiveSamplingTask.h>
 
@@ -56,17 +58,27 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
    // stream lock
    std::mutex signalMutex;
 
-   explicit Impl() : AbstractTask("AdaptiveSamplingTask", "adaptive")
+   // exported metrics
+   rt::Metrics::Gauge *queueDepth = rt::Metrics::gauge("nfc_adaptive_queue_depth", "Signal buffers pending in adaptive sampling queue", labels());
+
+   // best-effort consumer, decimated or skipped when critical tasks fall behind
+   rt::Qos::Gate gate {"adaptive", labels()};
+
+   explicit Impl(const rt::Context &context) : AdaptiveSamplingTask(context), AbstractTask(this, "AdaptiveSamplingTask", "adaptive", context)
    {
       // access to signal subject stream
-      signalRawStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
+      signalRawStream = context.subject<sdr::SignalBuffer>("signal.raw");
 
       // access to signal subject stream
-      signalAdpStream = rt::Subject<sdr::SignalBuffer>::name("signal.adp");
+      signalAdpStream = context.subject<sdr::SignalBuffer>("signal.adp");
 
       // subscribe to signal events
       signalSubscription = signalRawStream->subscribe([=](const sdr::SignalBuffer &buffer) {
-         signalQueue.add(buffer);
+         if (gate.admit())
+         {
+            signalQueue.add(buffer);
+            notify();
+         }
       });
    }
 
@@ -90,7 +102,9 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
          log.debug("adaptive command [{}]", {command->code});
       }
 
-      if (auto buffer = signalQueue.get(50))
+      queueDepth->set(signalQueue.size());
+
+      if (auto buffer = signalQueue.get())
       {
          if (buffer->isValid())
          {
@@ -98,6 +112,14 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
          }
       }
 
+      /*
+       * sleep until new commands or signal buffers are received
+       */
+      if (!commandQueue.size() && !signalQueue.size())
+      {
+         wait();
+      }
+
       return true;
    }
 
@@ -163,13 +185,13 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
    }
 };
 
-AdaptiveSamplingTask::AdaptiveSamplingTask() : rt::Worker("AdaptiveSamplingTask")
+AdaptiveSamplingTask::AdaptiveSamplingTask(const rt::Context &context) : rt::Worker(context.qualify("AdaptiveSamplingTask"))
 {
 }
 
-rt::Worker *AdaptiveSamplingTask::construct()
+rt::Worker *AdaptiveSamplingTask::construct(const rt::Context &context)
 {
-   return new AdaptiveSamplingTask::Impl;
+   return new AdaptiveSamplingTask::Impl(context);
 }
 
 }
\ No newline at end of file
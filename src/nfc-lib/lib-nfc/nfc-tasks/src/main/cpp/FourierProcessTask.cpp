@@ -33,6 +33,8 @@
 
 #include <rt/Logger.h>
 #include <rt/BlockingQueue.h>
+#include <rt/Qos.h>
+#include <rt/Tracer.h>
 
 #include <nfc/NfcDecoder.h>
 #include <nfc/FourierProcessTask.h>
@@ -75,13 +77,19 @@ struct FourierProcessTask::Impl : FourierProcessTask, AbstractTask
    // last status sent
    std::chrono::time_point<std::chrono::steady_clock> lastStatus;
 
+   // next FFT frame time
+   std::chrono::time_point<std::chrono::steady_clock> nextFrame;
+
    // last signal buffer
    sdr::SignalBuffer signalBuffer;
 
    // stream lock
    std::mutex signalMutex;
 
-   explicit Impl(int length = 1024) : AbstractTask("FourierProcessTask", "fourier"), status(FourierProcessTask::Idle), length(length)
+   // best-effort consumer, decimated or skipped when critical tasks fall behind
+   rt::Qos::Gate gate {"fourier", labels()};
+
+   explicit Impl(const rt::Context &context, int length = 1024) : FourierProcessTask(context), AbstractTask(this, "FourierProcessTask", "fourier", context), status(FourierProcessTask::Idle), length(length)
    {
       // create fft buffers
       fftIn = static_cast<float *>(mufft_alloc(length * sizeof(float) * 2));
@@ -93,18 +101,23 @@ struct FourierProcessTask::Impl : FourierProcessTask, AbstractTask
       fftC2C = mufft_create_plan_1d_c2c(length, MUFFT_FORWARD, MUFFT_FLAG_CPU_NO_AVX);
 
       // access to signal subject stream
-      signalIqStream = rt::Subject<sdr::SignalBuffer>::name("signal.iq");
+      signalIqStream = context.subject<sdr::SignalBuffer>("signal.iq");
 
       // access to signal subject stream
-      frequencyStream = rt::Subject<sdr::SignalBuffer>::name("signal.fft");
+      frequencyStream = context.subject<sdr::SignalBuffer>("signal.fft");
 
       // subscribe to signal events
       signalIqSubscription = signalIqStream->subscribe([=](const sdr::SignalBuffer &buffer) {
-         if (signalMutex.try_lock())
+         if (!gate.admit())
+            return;
+
          {
+            std::lock_guard<std::mutex> lock(signalMutex);
+
             signalBuffer = buffer;
-            signalMutex.unlock();
          }
+
+         notify();
       });
    }
 
@@ -132,14 +145,28 @@ struct FourierProcessTask::Impl : FourierProcessTask, AbstractTask
 
    bool loop() override
    {
-      // process FFT at 50 fps (20ms / frame)
-      wait(20);
+      auto now = std::chrono::steady_clock::now();
+
+      // process FFT at 50 fps (20ms / frame), buffers received meanwhile replace the pending one
+      if (now < nextFrame)
+      {
+         wait(int(std::chrono::duration_cast<std::chrono::milliseconds>(nextFrame - now).count()) + 1);
+
+         return true;
+      }
+
+      // compute fast fourier transform, or sleep until next signal buffer
+      if (!process())
+      {
+         wait();
+
+         return true;
+      }
 
-      // compute fast fourier transform
-      process();
+      nextFrame = now + std::chrono::milliseconds(20);
 
       // update recorder status
-      if ((std::chrono::steady_clock::now() - lastStatus) > std::chrono::milliseconds(500))
+      if ((now - lastStatus) > std::chrono::milliseconds(500))
       {
          updateFourierStatus();
       }
@@ -147,17 +174,26 @@ struct FourierProcessTask::Impl : FourierProcessTask, AbstractTask
       return true;
    }
 
-   void process()
+   bool process()
    {
-      std::lock_guard<std::mutex> lock(signalMutex);
+      sdr::SignalBuffer buffer;
+
+      // take last received buffer
+      {
+         std::lock_guard<std::mutex> lock(signalMutex);
+
+         std::swap(buffer, signalBuffer);
+      }
 
       // IQ complex signal to real FFT transform
-      if (signalBuffer.isValid() && signalBuffer.type() == sdr::SignalType::SAMPLE_IQ)
+      if (buffer.isValid() && buffer.type() == sdr::SignalType::SAMPLE_IQ)
       {
-         float *data = signalBuffer.data();
+         rt::Tracer::Scope scope("fft", "fourier", buffer.id(), rt::Tracer::FlowIn);
+
+         float *data = buffer.data();
 
          // calculate decimation for required bandwith
-         decimation = int(signalBuffer.sampleRate() / bandwith);
+         decimation = int(buffer.sampleRate() / bandwith);
 
          // apply signal windowing and decimation
 #if defined(__SSE2__) && defined(USE_SSE2)
@@ -253,14 +289,18 @@ struct FourierProcessTask::Impl : FourierProcessTask, AbstractTask
 #endif
 
          // create output buffer
-         sdr::SignalBuffer result(length, 1, signalBuffer.sampleRate(), 0, decimation, sdr::SignalType::FREQUENCY_BIN);
+         sdr::SignalBuffer result(length, 1, buffer.sampleRate(), 0, decimation, sdr::SignalType::FREQUENCY_BIN);
 
          // add data width negative / positive frequency shift
          result.put(fftMag + (length >> 1), (length >> 1)).put(fftMag, (length >> 1)).flip();
 
          // publish to observers
          frequencyStream->next(result);
+
+         return true;
       }
+
+      return false;
    }
 
    void updateFourierStatus()
@@ -268,13 +308,13 @@ struct FourierProcessTask::Impl : FourierProcessTask, AbstractTask
    }
 };
 
-FourierProcessTask::FourierProcessTask() : rt::Worker("FourierProcessTask")
+FourierProcessTask::FourierProcessTask(const rt::Context &context) : rt::Worker(context.qualify("FourierProcessTask"))
 {
 }
 
-rt::Worker *FourierProcessTask::construct()
+rt::Worker *FourierProcessTask::construct(const rt::Context &context)
 {
-   return new FourierProcessTask::Impl;
+   return new FourierProcessTask::Impl(context);
 }
 
 }
\ No newline at end of file
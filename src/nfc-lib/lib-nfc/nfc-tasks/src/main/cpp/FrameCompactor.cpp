@@ -0,0 +1,471 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include <nfc/Nfc.h>
+#include <nfc/FrameCompactor.h>
+
+// longest polling cycle recognized, in frames
+#define MAX_PERIOD 16
+
+namespace nfc {
+
+struct FrameCompactor::Impl
+{
+   // cycle member with statistics of suppressed occurrences since last report
+   struct Member
+   {
+      NfcFrame frame;
+      unsigned int count = 0;
+      double referenceStart = 0;
+      double firstStart = 0;
+      double firstDateTime = 0;
+      double lastStart = 0;
+      double lastEnd = 0;
+      unsigned long firstSampleStart = 0;
+      unsigned long lastSampleEnd = 0;
+   };
+
+   bool enabled = false;
+   int minimumRepeats = 3;
+   double summaryInterval = 10;
+   long long suppressedCount = 0;
+
+   // recent frames and consecutive matches against the frame p positions back
+   std::deque<NfcFrame> history;
+   unsigned int matchRun[MAX_PERIOD + 1] {};
+
+   // current run, period zero when not in a run
+   int period = 0;
+   unsigned int position = 0;
+   std::vector<Member> members;
+
+   // start of current report window
+   double windowStart = 0;
+
+   // last matching frame, held back until next one confirms the run continues
+   NfcFrame pending;
+   unsigned int pendingIndex = 0;
+   bool hasPending = false;
+
+   void process(const NfcFrame &frame, std::list<NfcFrame> &output)
+   {
+      if (period)
+      {
+         Member &member = members[position % period];
+
+         if (isCompactable(frame) && isSame(frame, member.frame))
+         {
+            if (hasPending)
+               commit();
+
+            if (summaryInterval > 0 && isCounting() && frame.timeStart() - windowStart >= summaryInterval)
+               report(output);
+
+            pending = frame;
+            pendingIndex = position % period;
+            hasPending = true;
+            position++;
+            return;
+         }
+
+         // run ends, held back frame is released as is and starts a new cycle history
+         report(output);
+
+         NfcFrame last = pending;
+         bool release = hasPending;
+
+         endRun();
+
+         if (release)
+            detect(last, output);
+      }
+
+      detect(frame, output);
+   }
+
+   void detect(const NfcFrame &frame, std::list<NfcFrame> &output)
+   {
+      output.push_back(frame);
+
+      if (!isCompactable(frame))
+      {
+         clearHistory();
+         return;
+      }
+
+      for (int p = 1; p <= MAX_PERIOD; p++)
+      {
+         if (p <= (int) history.size() && isSame(frame, history[history.size() - p]))
+            matchRun[p]++;
+         else
+            matchRun[p] = 0;
+      }
+
+      history.push_back(frame);
+
+      if (history.size() > MAX_PERIOD)
+         history.pop_front();
+
+      // shortest cycle seen minimumRepeats times in a row
+      for (int p = 1; p <= MAX_PERIOD; p++)
+      {
+         if (matchRun[p] >= (unsigned int) (p * (minimumRepeats - 1)))
+         {
+            startRun(p);
+            break;
+         }
+      }
+   }
+
+   void startRun(int p)
+   {
+      period = p;
+      position = 0;
+      members.resize(p);
+
+      for (int i = 0; i < p; i++)
+      {
+         members[i] = {};
+         members[i].frame = history[history.size() - p + i];
+         members[i].referenceStart = members[i].frame.timeStart();
+      }
+   }
+
+   void commit()
+   {
+      Member &member = members[pendingIndex];
+
+      if (!isCounting())
+         windowStart = pending.timeStart();
+
+      if (!member.count)
+      {
+         member.firstStart = pending.timeStart();
+         member.firstDateTime = pending.dateTime();
+         member.firstSampleStart = pending.sampleStart();
+      }
+
+      member.count++;
+      member.lastStart = pending.timeStart();
+      member.lastEnd = pending.timeEnd();
+      member.lastSampleEnd = pending.sampleEnd();
+
+      suppressedCount++;
+
+      hasPending = false;
+   }
+
+   bool isCounting() const
+   {
+      for (const auto &member: members)
+      {
+         if (member.count)
+            return true;
+      }
+
+      return false;
+   }
+
+   // emits one summary per member with suppressed occurrences, in order of first occurrence
+   void report(std::list<NfcFrame> &output)
+   {
+      std::vector<Member *> reported;
+
+      for (auto &member: members)
+      {
+         if (member.count)
+            reported.push_back(&member);
+      }
+
+      std::sort(reported.begin(), reported.end(), [](const Member *a, const Member *b) {
+         return a->firstStart < b->firstStart;
+      });
+
+      for (auto member: reported)
+      {
+         NfcFrame summary = copy(member->frame);
+
+         summary.setTimeStart(member->firstStart);
+         summary.setTimeEnd(member->lastEnd);
+         summary.setDateTime(member->firstDateTime);
+         summary.setSampleStart(member->firstSampleStart);
+         summary.setSampleEnd(member->lastSampleEnd);
+
+         if (member->count > 1)
+         {
+            summary.setRepeatCount(member->count);
+            summary.setRepeatPeriod((member->lastStart - member->referenceStart) / member->count);
+         }
+
+         output.push_back(summary);
+
+         member->referenceStart = member->lastStart;
+         member->count = 0;
+      }
+   }
+
+   void endRun()
+   {
+      period = 0;
+      position = 0;
+      members.clear();
+      hasPending = false;
+      pending = {};
+
+      clearHistory();
+   }
+
+   void clearHistory()
+   {
+      history.clear();
+
+      std::fill(std::begin(matchRun), std::end(matchRun), 0);
+   }
+
+   static bool isCompactable(const NfcFrame &frame)
+   {
+      return frame.isPollFrame() || frame.isCarrierOn() || frame.isCarrierOff();
+   }
+
+   static bool isSame(const NfcFrame &a, const NfcFrame &b)
+   {
+      return a.techType() == b.techType() &&
+             a.frameType() == b.frameType() &&
+             a.frameFlags() == b.frameFlags() &&
+             a.framePhase() == b.framePhase() &&
+             a.frameRate() == b.frameRate() &&
+             a.limit() == b.limit() &&
+             (!a.limit() || std::memcmp(a.data(), b.data(), a.limit()) == 0);
+   }
+
+   // frames share attributes on copy, summaries need their own
+   static NfcFrame copy(const NfcFrame &frame)
+   {
+      NfcFrame result = frame.limit() > 256 ? NfcFrame(frame.limit()) : NfcFrame(frame.techType(), frame.frameType());
+
+      result.setTechType(frame.techType());
+      result.setFrameType(frame.frameType());
+      result.setFrameFlags(frame.frameFlags());
+      result.setFramePhase(frame.framePhase());
+      result.setFrameRate(frame.frameRate());
+      result.setTimeStart(frame.timeStart());
+      result.setTimeEnd(frame.timeEnd());
+      result.setDateTime(frame.dateTime());
+      result.setCaptureTime(frame.captureTime());
+      result.setSourceId(frame.sourceId());
+      result.setSampleStart(frame.sampleStart());
+      result.setSampleEnd(frame.sampleEnd());
+      result.setRepeatCount(frame.repeatCount());
+      result.setRepeatPeriod(frame.repeatPeriod());
+
+      if (frame.limit())
+         result.put(frame.data(), frame.limit());
+
+      result.flip();
+
+      return result;
+   }
+};
+
+FrameCompactor::FrameCompactor() : impl(std::make_shared<Impl>())
+{
+}
+
+bool FrameCompactor::isEnabled() const
+{
+   return impl->enabled;
+}
+
+void FrameCompactor::setEnabled(bool enabled)
+{
+   impl->enabled = enabled;
+}
+
+int FrameCompactor::minimumRepeats() const
+{
+   return impl->minimumRepeats;
+}
+
+void FrameCompactor::setMinimumRepeats(int repeats)
+{
+   impl->minimumRepeats = std::max(repeats, 2);
+}
+
+double FrameCompactor::summaryInterval() const
+{
+   return impl->summaryInterval;
+}
+
+void FrameCompactor::setSummaryInterval(double seconds)
+{
+   impl->summaryInterval = std::max(seconds, 0.0);
+}
+
+std::list<NfcFrame> FrameCompactor::nextFrames(const std::list<NfcFrame> &frames)
+{
+   if (!impl->enabled && !impl->period)
+      return frames;
+
+   std::list<NfcFrame> output;
+
+   for (const auto &frame: frames)
+   {
+      if (impl->enabled)
+         impl->process(frame, output);
+      else
+         output.push_back(frame);
+   }
+
+   return output;
+}
+
+std::list<NfcFrame> FrameCompactor::flush()
+{
+   std::list<NfcFrame> output;
+
+   if (impl->hasPending)
+      impl->commit();
+
+   impl->report(output);
+   impl->endRun();
+
+   return output;
+}
+
+void FrameCompactor::reset()
+{
+   impl->endRun();
+}
+
+long long FrameCompactor::suppressed() const
+{
+   return impl->suppressedCount;
+}
+
+std::list<NfcFrame> FrameCompactor::expand(const NfcFrame &frame)
+{
+   if (!frame.isRepeated())
+      return {frame};
+
+   std::list<NfcFrame> result;
+
+   unsigned int count = frame.repeatCount();
+
+   double period = frame.repeatPeriod();
+
+   // duration of a single occurrence, last one ends at summary end
+   double duration = frame.timeEnd() - (frame.timeStart() + (count - 1) * period);
+
+   // samples per second, derived from summary span
+   double span = frame.timeEnd() - frame.timeStart();
+   double rate = span > 0 ? (double) (frame.sampleEnd() - frame.sampleStart()) / span : 0;
+
+   for (unsigned int i = 0; i < count; i++)
+   {
+      NfcFrame occurrence = Impl::copy(frame);
+
+      double offset = i * period;
+
+      occurrence.setTimeStart(frame.timeStart() + offset);
+      occurrence.setTimeEnd(frame.timeStart() + offset + duration);
+      occurrence.setDateTime(frame.dateTime() + offset);
+      occurrence.setSampleStart(frame.sampleStart() + (unsigned long) std::llround(offset * rate));
+      occurrence.setSampleEnd(occurrence.sampleStart() + (unsigned long) std::llround(duration * rate));
+      occurrence.setRepeatCount(0);
+      occurrence.setRepeatPeriod(0);
+
+      result.push_back(occurrence);
+   }
+
+   return result;
+}
+
+struct FrameExpander::Impl
+{
+   // expanded occurrences and frames overlapping them, not yet in time order
+   std::vector<NfcFrame> pending;
+
+   // latest occurrence start among pending summaries
+   double horizon = 0;
+
+   void release(std::list<NfcFrame> &output)
+   {
+      std::stable_sort(pending.begin(), pending.end(), [](const NfcFrame &a, const NfcFrame &b) {
+         return a.timeStart() < b.timeStart();
+      });
+
+      output.insert(output.end(), pending.begin(), pending.end());
+
+      pending.clear();
+   }
+};
+
+FrameExpander::FrameExpander() : impl(std::make_shared<Impl>())
+{
+}
+
+std::list<NfcFrame> FrameExpander::nextFrames(const NfcFrame &frame)
+{
+   std::list<NfcFrame> output;
+
+   // no pending occurrence starts after this frame
+   if (!impl->pending.empty() && frame.timeStart() >= impl->horizon)
+      impl->release(output);
+
+   if (impl->pending.empty() && !frame.isRepeated())
+   {
+      output.push_back(frame);
+      return output;
+   }
+
+   for (auto &occurrence: FrameCompactor::expand(frame))
+   {
+      impl->horizon = impl->pending.empty() ? occurrence.timeStart() : std::max(impl->horizon, occurrence.timeStart());
+      impl->pending.push_back(occurrence);
+   }
+
+   return output;
+}
+
+std::list<NfcFrame> FrameExpander::flush()
+{
+   std::list<NfcFrame> output;
+
+   impl->release(output);
+
+   return output;
+}
+
+void FrameExpander::reset()
+{
+   impl->pending.clear();
+}
+
+}
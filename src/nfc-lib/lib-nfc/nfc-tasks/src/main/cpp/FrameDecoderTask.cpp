@@ -24,9 +24,14 @@
 
 #include <rt/Logger.h>
 #include <rt/BlockingQueue.h>
+#include <rt/Histogram.h>
+#include <rt/Metrics.h>
+#include <rt/Qos.h>
 #include <rt/Throughput.h>
 
+#include <nfc/Nfc.h>
 #include <nfc/NfcDecoder.h>
+#include <nfc/FrameCompactor.h>
 #include <nfc/FrameDecoderTask.h>
 
 #include "AbstractTask.h"
@@ -47,8 +52,8 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
    // signal stream subscription
    rt::Subject<sdr::SignalBuffer>::Subscription signalSubscription;
 
-   // signal stream queue buffer
-   rt::BlockingQueue<sdr::SignalBuffer> signalQueue;
+   // signal stream queue buffer, with time of arrival
+   rt::BlockingQueue<std::pair<sdr::SignalBuffer, std::chrono::steady_clock::time_point>> signalQueue;
 
    // throughput meter
    rt::Throughput taskThroughput;
@@ -56,24 +61,65 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
    // decoder
    std::shared_ptr<nfc::NfcDecoder> decoder;
 
+   // idle polling compactor applied to decoded frames
+   nfc::FrameCompactor compactor;
+
+   // suppressed frames already exported
+   long long compactedCount = 0;
+
    // last status sent
    std::chrono::time_point<std::chrono::steady_clock> lastStatus;
 
    // last Throughput statistics
    std::chrono::time_point<std::chrono::steady_clock> lastThroughput;
 
-   Impl() : AbstractTask("FrameDecoderTask", "decoder"), status(FrameDecoderTask::Halt), decoder(new nfc::NfcDecoder())
+   // latency per pipeline stage in microseconds: capture to queue, queue wait, decode, frame publish and capture to publish
+   rt::Histogram latencyCapture;
+   rt::Histogram latencyQueue;
+   rt::Histogram latencyDecode;
+   rt::Histogram latencyPublish;
+   rt::Histogram latencyTotal;
+
+   // last latency report
+   json latencyStatus;
+
+   // exported metrics
+   rt::Metrics::Counter *samplesDecoded = rt::Metrics::counter("nfc_decoder_samples_total", "Samples processed by frame decoder", labels());
+   rt::Metrics::Gauge *queueDepth = rt::Metrics::gauge("nfc_decoder_queue_depth", "Signal buffers pending in decoder queue", labels());
+   rt::Metrics::Gauge *throughput = rt::Metrics::gauge("nfc_decoder_throughput_msps", "Decoder throughput in million samples per second", labels());
+   rt::Metrics::Counter *crcErrors = rt::Metrics::counter("nfc_decoder_frame_errors_total", "Decoded frames with errors", labels({{"error", "crc"}}));
+   rt::Metrics::Counter *parityErrors = rt::Metrics::counter("nfc_decoder_frame_errors_total", "Decoded frames with errors", labels({{"error", "parity"}}));
+   rt::Metrics::Histogram *decodeLatency = rt::Metrics::histogram("nfc_decoder_latency_microseconds", "Decoder pipeline latency per stage", labels({{"stage", "decode"}}));
+   rt::Metrics::Histogram *totalLatency = rt::Metrics::histogram("nfc_decoder_latency_microseconds", "Decoder pipeline latency per stage", labels({{"stage", "total"}}));
+   rt::Metrics::Counter *compactedFrames = rt::Metrics::counter("nfc_decoder_compacted_frames_total", "Repeated polling frames folded into summaries", labels());
+
+   // pending signal reported to load shedding, decoder is a critical consumer
+   rt::Qos::Backlog *backlog = rt::Qos::backlog(context.qualify("decoder"));
+
+   // decoded frames indexed by tech type
+   rt::Metrics::Counter *techFrames[5] = {
+         rt::Metrics::counter("nfc_decoder_frames_total", "Decoded frames per technology", labels({{"tech", "none"}})),
+         rt::Metrics::counter("nfc_decoder_frames_total", "Decoded frames per technology", labels({{"tech", "nfca"}})),
+         rt::Metrics::counter("nfc_decoder_frames_total", "Decoded frames per technology", labels({{"tech", "nfcb"}})),
+         rt::Metrics::counter("nfc_decoder_frames_total", "Decoded frames per technology", labels({{"tech", "nfcf"}})),
+         rt::Metrics::counter("nfc_decoder_frames_total", "Decoded frames per technology", labels({{"tech", "nfcv"}}))
+   };
+
+   explicit Impl(const rt::Context &context) : FrameDecoderTask(context), AbstractTask(this, "FrameDecoderTask", "decoder", context), status(FrameDecoderTask::Halt), decoder(new nfc::NfcDecoder())
    {
       // access to signal subject stream
-      signalStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
+      signalStream = context.subject<sdr::SignalBuffer>("signal.raw");
 
       // create frame stream subject
-      frameStream = rt::Subject<nfc::NfcFrame>::name("decoder.frame");
+      frameStream = context.subject<nfc::NfcFrame>("decoder.frame");
 
       // subscribe to signal events
       signalSubscription = signalStream->subscribe([this](const sdr::SignalBuffer &buffer) {
          if (status == FrameDecoderTask::Listen)
-            signalQueue.add(buffer);
+         {
+            signalQueue.emplace(buffer, std::chrono::steady_clock::now());
+            notify();
+         }
       });
    }
 
@@ -115,9 +161,13 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
       {
          signalDecode();
       }
-      else
+
+      /*
+       * sleep until new commands or signal buffers are received
+       */
+      if (!commandQueue.size() && (status != FrameDecoderTask::Listen || !signalQueue.size()))
       {
-         wait(50);
+         wait();
       }
 
       return true;
@@ -133,6 +183,8 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
       decoder->initialize();
 
+      compactor.reset();
+
       command.resolve();
 
       updateDecoderStatus(FrameDecoderTask::Listen);
@@ -144,16 +196,31 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
       signalQueue.clear();
 
-      for (const auto &frame: decoder->nextFrames({}))
+      backlog->update(0);
+
+      std::list<nfc::NfcFrame> frames = compactor.nextFrames(decoder->nextFrames({}));
+
+      frames.splice(frames.end(), compactor.flush());
+
+      for (const auto &frame: frames)
       {
          frameStream->next(frame);
       }
 
+      updateCompacted();
+
       command.resolve();
 
       updateDecoderStatus(FrameDecoderTask::Halt);
    }
 
+   void updateCompacted()
+   {
+      compactedFrames->add(compactor.suppressed() - compactedCount);
+
+      compactedCount = compactor.suppressed();
+   }
+
    void configDecoder(rt::Event &command)
    {
       if (auto data = command.get<std::string>("data"))
@@ -254,6 +321,21 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
          if (config.contains("powerLevelThreshold"))
             decoder->setPowerLevelThreshold(config["powerLevelThreshold"]);
 
+         // idle polling compaction
+         if (config.contains("compact"))
+         {
+            auto compact = config["compact"];
+
+            if (compact.contains("enabled"))
+               compactor.setEnabled(compact["enabled"]);
+
+            if (compact.contains("minimumRepeats"))
+               compactor.setMinimumRepeats(compact["minimumRepeats"]);
+
+            if (compact.contains("summaryInterval"))
+               compactor.setSummaryInterval(compact["summaryInterval"]);
+         }
+
          // sample rate must be last value set
          if (config.contains("sampleRate"))
             decoder->setSampleRate(config["sampleRate"]);
@@ -270,18 +352,94 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
    void signalDecode()
    {
-      if (auto buffer = signalQueue.get())
+      queueDepth->set(signalQueue.size());
+
+      if (auto entry = signalQueue.get())
       {
+         auto dequeued = std::chrono::steady_clock::now();
+
+         auto &buffer = entry->first;
+
+         unsigned int elements = buffer.elements();
+
+         long long captureTime = buffer.captureTime();
+
+         bool valid = buffer.isValid();
+
+         // remaining signal in queue, best-effort tasks are degraded when decoder falls behind
+         if (buffer.sampleRate())
+            backlog->update((long long) signalQueue.size() * elements * 1000000LL / buffer.sampleRate());
+
          taskThroughput.begin();
 
-         for (const auto &frame: decoder->nextFrames(buffer.value()))
+         // hand over buffer ownership to decoder, no extra reference needed
+         std::list<nfc::NfcFrame> frames = decoder->nextFrames(std::move(buffer));
+
+         // fold repeated polling cycles, at end of stream report ongoing run
+         std::list<nfc::NfcFrame> compacted = compactor.nextFrames(frames);
+
+         if (!valid)
+            compacted.splice(compacted.end(), compactor.flush());
+
+         auto decoded = std::chrono::steady_clock::now();
+
+         for (const auto &frame: compacted)
          {
             frameStream->next(frame);
          }
 
-         taskThroughput.update(buffer->elements());
+         updateCompacted();
+
+         auto published = std::chrono::steady_clock::now();
+
+         // frame counters per technology and error type
+         for (const auto &frame: frames)
+         {
+            if (frame.isPollFrame() || frame.isListenFrame())
+            {
+               if (frame.techType() <= TechType::NfcV)
+                  techFrames[frame.techType()]->add();
+
+               if (frame.hasCrcError())
+                  crcErrors->add();
+
+               if (frame.hasParityError())
+                  parityErrors->add();
+            }
+         }
+
+         samplesDecoded->add(elements);
+
+         taskThroughput.update(elements);
+
+         // update latency statistics
+         if (valid)
+         {
+            latencyQueue.add(micros(dequeued - entry->second));
+            latencyDecode.add(micros(decoded - dequeued));
+
+            decodeLatency->add(micros(decoded - dequeued));
+
+            if (captureTime)
+               latencyCapture.add(micros(entry->second.time_since_epoch()) - captureTime / 1000);
+
+            if (!frames.empty())
+            {
+               latencyPublish.add(micros(published - decoded));
+
+               if (captureTime)
+               {
+                  long long total = micros(published.time_since_epoch()) - captureTime / 1000;
+
+                  latencyTotal.add(total);
 
-         if (!buffer->isValid())
+                  if (total >= 0)
+                     totalLatency->add(total);
+               }
+            }
+         }
+
+         if (!valid)
          {
             log.info("decoder EOF buffer received, finish!");
 
@@ -294,11 +452,62 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
          {
             log.info("average throughput {.2} Msps", {taskThroughput.average() / 1E6});
 
+            throughput->set(taskThroughput.average() / 1E6);
+
+            reportLatency();
+
             lastThroughput = std::chrono::steady_clock::now();
          }
       }
    }
 
+   void reportLatency()
+   {
+      if (!latencyQueue.count())
+         return;
+
+      latencyStatus = {
+            {"capture", latency(latencyCapture)},
+            {"queue",   latency(latencyQueue)},
+            {"decode",  latency(latencyDecode)},
+            {"publish", latency(latencyPublish)},
+            {"total",   latency(latencyTotal)}
+      };
+
+      log.info("latency p50/p99/max (us) capture {}/{}/{}, queue {}/{}/{}, decode {}/{}/{}, publish {}/{}/{}, total {}/{}/{}", {
+            latencyCapture.percentile(50), latencyCapture.percentile(99), latencyCapture.max(),
+            latencyQueue.percentile(50), latencyQueue.percentile(99), latencyQueue.max(),
+            latencyDecode.percentile(50), latencyDecode.percentile(99), latencyDecode.max(),
+            latencyPublish.percentile(50), latencyPublish.percentile(99), latencyPublish.max(),
+            latencyTotal.percentile(50), latencyTotal.percentile(99), latencyTotal.max()
+      });
+
+      // restart measure window
+      latencyCapture.clear();
+      latencyQueue.clear();
+      latencyDecode.clear();
+      latencyPublish.clear();
+      latencyTotal.clear();
+
+      // periodic status with latency figures
+      updateDecoderStatus(status);
+   }
+
+   static json latency(const rt::Histogram &histogram)
+   {
+      return {
+            {"p50", histogram.percentile(50)},
+            {"p99", histogram.percentile(99)},
+            {"max", histogram.max()}
+      };
+   }
+
+   template<typename D>
+   static long long micros(D duration)
+   {
+      return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+   }
+
    void updateDecoderStatus(int value, bool config = false)
    {
       status = value;
@@ -310,6 +519,11 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
                       {"streamTime", decoder->streamTime()}
                 });
 
+      if (!latencyStatus.is_null())
+      {
+         data["latency"] = latencyStatus;
+      }
+
       if (config)
       {
          data["nfca"] = {
@@ -327,6 +541,12 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
          data["nfcv"] = {
                {"enabled", decoder->isNfcVEnabled()}
          };
+
+         data["compact"] = {
+               {"enabled",         compactor.isEnabled()},
+               {"minimumRepeats",  compactor.minimumRepeats()},
+               {"summaryInterval", compactor.summaryInterval()}
+         };
       }
 
       log.info("updated decoder status: {}", {data.dump()});
@@ -337,13 +557,13 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
    }
 };
 
-FrameDecoderTask::FrameDecoderTask() : rt::Worker("FrameDecoderTask")
+FrameDecoderTask::FrameDecoderTask(const rt::Context &context) : rt::Worker(context.qualify("FrameDecoderTask"))
 {
 }
 
-rt::Worker *FrameDecoderTask::construct()
+rt::Worker *FrameDecoderTask::construct(const rt::Context &context)
 {
-   return new FrameDecoderTask::Impl;
+   return new FrameDecoderTask::Impl(context);
 }
 
 }
@@ -0,0 +1,643 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include <rt/Logger.h>
+
+#include <nfc/FrameLog.h>
+
+// file header magic and format version
+#define LOG_MAGIC "NFL1"
+#define LOG_VERSION 1
+#define LOG_HEADER_SIZE 32
+
+// trailer magic, trailer holds index offset and frame count
+#define LOG_TRAILER "NFLE"
+#define LOG_TRAILER_SIZE 16
+
+// frames between sync blocks
+#define SYNC_INTERVAL 1024
+
+// record tags
+#define TAG_FRAME 0x01
+#define TAG_REPEAT 0x02
+#define TAG_INDEX 0xFD
+#define TAG_SYNC 0xFE
+
+// write buffer size, also minimum read chunk
+#define BUFFER_SIZE (1024 * 1024)
+
+// largest record, tag plus 14 varints plus payload up to 64KB
+#define MAX_RECORD_SIZE (1 + 14 * 10 + 65536)
+
+namespace nfc {
+
+struct FrameLog::Impl
+{
+   rt::Logger log {"FrameLog"};
+
+   std::string fileName;
+   FILE *file = nullptr;
+   int mode = 0;
+   bool eof = false;
+
+   unsigned int sampleRate = 0;
+   double dateTime = 0;
+   long frameCount = 0;
+
+   // file offset of first byte in buffer
+   long long bufferOffset = 0;
+
+   // write buffer, or read window between readPosition and buffer end
+   std::vector<unsigned char> buffer;
+   size_t readPosition = 0;
+
+   // delta encoding base, reset on each sync block
+   long long lastSample = 0;
+   long long lastTime = 0;
+
+   // sync block offsets and frame index, written on close
+   std::vector<std::pair<long long, long>> syncIndex;
+
+   explicit Impl(std::string name) : fileName(std::move(name))
+   {
+   }
+
+   ~Impl()
+   {
+      close();
+   }
+
+   bool open(int openMode)
+   {
+      close();
+
+      mode = openMode;
+      eof = false;
+      frameCount = 0;
+      bufferOffset = 0;
+      readPosition = 0;
+      lastSample = 0;
+      lastTime = 0;
+      buffer.clear();
+      syncIndex.clear();
+
+      if (mode == FrameLog::Write)
+      {
+         if (!(file = fopen(fileName.c_str(), "wb")))
+         {
+            log.warn("unable to create file {}", {fileName});
+            return false;
+         }
+
+         buffer.reserve(BUFFER_SIZE + MAX_RECORD_SIZE);
+
+         dateTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 1000.0;
+
+         writeHeader();
+
+         return true;
+      }
+
+      if (mode == FrameLog::Read)
+      {
+         if (!(file = fopen(fileName.c_str(), "rb")))
+         {
+            log.warn("unable to open file {}", {fileName});
+            return false;
+         }
+
+         if (!fill(LOG_HEADER_SIZE) || std::memcmp(buffer.data(), LOG_MAGIC, 4) != 0)
+         {
+            log.warn("invalid frame log header in file {}", {fileName});
+
+            fclose(file);
+            file = nullptr;
+
+            return false;
+         }
+
+         const unsigned char *header = buffer.data();
+
+         if (getU16(header + 4) > LOG_VERSION)
+            log.warn("frame log version {} is newer than supported", {getU16(header + 4)});
+
+         sampleRate = getU32(header + 8);
+         dateTime = getF64(header + 16);
+         readPosition = getU16(header + 6);
+
+         return true;
+      }
+
+      return false;
+   }
+
+   void close()
+   {
+      if (file)
+      {
+         if (mode == FrameLog::Write)
+            writeTrailer();
+
+         fclose(file);
+
+         file = nullptr;
+      }
+   }
+
+   void flush()
+   {
+      if (file && mode == FrameLog::Write)
+      {
+         if (!buffer.empty())
+         {
+            if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+               log.warn("failed to write {} bytes to {}", {buffer.size(), fileName});
+
+            bufferOffset += (long long) buffer.size();
+
+            buffer.clear();
+         }
+
+         fflush(file);
+      }
+   }
+
+   bool write(const NfcFrame &frame)
+   {
+      if (!file || mode != FrameLog::Write)
+         return false;
+
+      // sync block resets delta encoding
+      if (frameCount % SYNC_INTERVAL == 0)
+         writeSync();
+
+      long long sampleStart = (long long) frame.sampleStart();
+      long long timeStart = std::llround(frame.timeStart() * 1E9);
+      long long timeEnd = std::llround(frame.timeEnd() * 1E9);
+
+      // repeat summaries carry occurrence count and period in nanoseconds
+      buffer.push_back(frame.isRepeated() ? TAG_REPEAT : TAG_FRAME);
+
+      putVarint(frame.techType());
+      putVarint(frame.frameType());
+      putVarint(frame.framePhase());
+      putVarint(frame.frameFlags());
+      putVarint(frame.frameRate());
+      putVarint(frame.sourceId());
+      putVarint(zigzag(sampleStart - lastSample));
+      putVarint(zigzag((long long) frame.sampleEnd() - sampleStart));
+      putVarint(zigzag(timeStart - lastTime));
+      putVarint(zigzag(timeEnd - timeStart));
+
+      if (frame.isRepeated())
+      {
+         putVarint(frame.repeatCount());
+         putVarint(std::llround(frame.repeatPeriod() * 1E9));
+      }
+
+      putVarint(frame.limit());
+
+      buffer.insert(buffer.end(), frame.data(), frame.data() + frame.limit());
+
+      lastSample = sampleStart;
+      lastTime = timeStart;
+
+      frameCount++;
+
+      if (buffer.size() >= BUFFER_SIZE)
+         flush();
+
+      return true;
+   }
+
+   bool read(NfcFrame &frame)
+   {
+      if (!file || mode != FrameLog::Read || eof)
+         return false;
+
+      while (fill(1))
+      {
+         unsigned char tag = buffer[readPosition];
+
+         if (tag == TAG_FRAME || tag == TAG_REPEAT)
+         {
+            fill(MAX_RECORD_SIZE);
+
+            size_t start = readPosition++;
+
+            unsigned long long values[13];
+
+            int count = tag == TAG_REPEAT ? 13 : 11;
+
+            bool valid = true;
+
+            for (int i = 0; i < count; i++)
+               valid = valid && getVarint(values[i]);
+
+            if (valid && values[count - 1] <= buffer.size() - readPosition)
+            {
+               long long sampleStart = lastSample + unzigzag(values[6]);
+               long long timeStart = lastTime + unzigzag(values[8]);
+               long long timeEnd = timeStart + unzigzag(values[9]);
+               unsigned int length = (unsigned int) values[count - 1];
+
+               frame = NfcFrame(std::max(length, 1u));
+
+               frame.setTechType(values[0]);
+               frame.setFrameType(values[1]);
+               frame.setFramePhase(values[2]);
+               frame.setFrameFlags(values[3]);
+               frame.setFrameRate(values[4]);
+               frame.setSourceId(values[5]);
+               frame.setSampleStart(sampleStart);
+               frame.setSampleEnd(sampleStart + unzigzag(values[7]));
+               frame.setTimeStart(timeStart / 1E9);
+               frame.setTimeEnd(timeEnd / 1E9);
+
+               if (tag == TAG_REPEAT)
+               {
+                  frame.setRepeatCount(values[10]);
+                  frame.setRepeatPeriod(values[11] / 1E9);
+               }
+
+               frame.put(buffer.data() + readPosition, length).flip();
+
+               readPosition += length;
+
+               lastSample = sampleStart;
+               lastTime = timeStart;
+
+               frameCount++;
+
+               return true;
+            }
+
+            // truncated or damaged record, look for next sync block
+            log.warn("damaged frame record at offset {}", {bufferOffset + (long long) start});
+
+            readPosition = start + 1;
+
+            resync();
+         }
+         else if (tag == TAG_SYNC && fill(9) && std::memcmp(buffer.data() + readPosition + 1, "SYNC", 4) == 0)
+         {
+            readPosition += 5;
+
+            unsigned long long index;
+
+            if (!getVarint(index))
+               break;
+
+            lastSample = 0;
+            lastTime = 0;
+         }
+         else if (tag == TAG_INDEX)
+         {
+            // index is only used for seeking, marks end of frames
+            break;
+         }
+         else
+         {
+            log.warn("unknown record tag {} at offset {}", {(int) tag, bufferOffset + (long long) readPosition});
+
+            readPosition++;
+
+            resync();
+         }
+      }
+
+      eof = true;
+
+      return false;
+   }
+
+   // skip to next sync block, or end of file
+   void resync()
+   {
+      while (fill(5))
+      {
+         auto begin = buffer.begin() + (long) readPosition;
+
+         static const unsigned char marker[] = {TAG_SYNC, 'S', 'Y', 'N', 'C'};
+
+         auto found = std::search(begin, buffer.end(), marker, marker + sizeof(marker));
+
+         if (found != buffer.end())
+         {
+            readPosition = found - buffer.begin();
+            return;
+         }
+
+         // keep last bytes, marker may be split between chunks
+         readPosition = buffer.size() - 4;
+
+         if (!fill(BUFFER_SIZE))
+            break;
+      }
+
+      readPosition = buffer.size();
+   }
+
+   // make sure at least size bytes are available after read position, unless end of file is reached
+   bool fill(size_t size)
+   {
+      size_t available = buffer.size() - readPosition;
+
+      if (available >= size)
+         return true;
+
+      // discard consumed bytes
+      if (readPosition)
+      {
+         buffer.erase(buffer.begin(), buffer.begin() + (long) readPosition);
+         bufferOffset += (long long) readPosition;
+         readPosition = 0;
+      }
+
+      size_t chunk = std::max(size, (size_t) BUFFER_SIZE);
+
+      buffer.resize(available + chunk);
+
+      size_t count = fread(buffer.data() + available, 1, chunk, file);
+
+      buffer.resize(available + count);
+
+      return buffer.size() >= size;
+   }
+
+   void writeHeader()
+   {
+      unsigned char header[LOG_HEADER_SIZE] {};
+
+      std::memcpy(header, LOG_MAGIC, 4);
+
+      putU16(header + 4, LOG_VERSION);
+      putU16(header + 6, LOG_HEADER_SIZE);
+      putU32(header + 8, sampleRate);
+      putF64(header + 16, dateTime);
+
+      buffer.insert(buffer.end(), header, header + sizeof(header));
+   }
+
+   void writeSync()
+   {
+      syncIndex.emplace_back(bufferOffset + (long long) buffer.size(), frameCount);
+
+      buffer.push_back(TAG_SYNC);
+      buffer.insert(buffer.end(), {'S', 'Y', 'N', 'C'});
+
+      putVarint(frameCount);
+
+      lastSample = 0;
+      lastTime = 0;
+   }
+
+   void writeTrailer()
+   {
+      long long indexOffset = bufferOffset + (long long) buffer.size();
+
+      buffer.push_back(TAG_INDEX);
+
+      putVarint(syncIndex.size());
+
+      long long lastOffset = 0;
+      long lastFrame = 0;
+
+      for (const auto &entry: syncIndex)
+      {
+         putVarint(entry.first - lastOffset);
+         putVarint(entry.second - lastFrame);
+
+         lastOffset = entry.first;
+         lastFrame = entry.second;
+      }
+
+      unsigned char trailer[LOG_TRAILER_SIZE];
+
+      putU64(trailer, indexOffset);
+      putU32(trailer + 8, (unsigned int) frameCount);
+      std::memcpy(trailer + 12, LOG_TRAILER, 4);
+
+      buffer.insert(buffer.end(), trailer, trailer + sizeof(trailer));
+
+      flush();
+   }
+
+   void putVarint(unsigned long long value)
+   {
+      while (value >= 0x80)
+      {
+         buffer.push_back((unsigned char) (value | 0x80));
+         value >>= 7;
+      }
+
+      buffer.push_back((unsigned char) value);
+   }
+
+   bool getVarint(unsigned long long &value)
+   {
+      value = 0;
+
+      for (int shift = 0; shift < 64 && readPosition < buffer.size(); shift += 7)
+      {
+         unsigned char byte = buffer[readPosition++];
+
+         value |= (unsigned long long) (byte & 0x7f) << shift;
+
+         if (!(byte & 0x80))
+            return true;
+      }
+
+      return false;
+   }
+
+   static unsigned long long zigzag(long long value)
+   {
+      return ((unsigned long long) value << 1) ^ (unsigned long long) (value >> 63);
+   }
+
+   static long long unzigzag(unsigned long long value)
+   {
+      return (long long) (value >> 1) ^ -(long long) (value & 1);
+   }
+
+   static void putU16(unsigned char *data, unsigned int value)
+   {
+      data[0] = value;
+      data[1] = value >> 8;
+   }
+
+   static void putU32(unsigned char *data, unsigned int value)
+   {
+      putU16(data, value & 0xffff);
+      putU16(data + 2, value >> 16);
+   }
+
+   static void putU64(unsigned char *data, unsigned long long value)
+   {
+      putU32(data, (unsigned int) value);
+      putU32(data + 4, (unsigned int) (value >> 32));
+   }
+
+   static void putF64(unsigned char *data, double value)
+   {
+      unsigned long long bits;
+
+      std::memcpy(&bits, &value, sizeof(bits));
+
+      putU64(data, bits);
+   }
+
+   static unsigned int getU16(const unsigned char *data)
+   {
+      return data[0] | data[1] << 8;
+   }
+
+   static unsigned int getU32(const unsigned char *data)
+   {
+      return getU16(data) | getU16(data + 2) << 16;
+   }
+
+   static unsigned long long getU64(const unsigned char *data)
+   {
+      return getU32(data) | (unsigned long long) getU32(data + 4) << 32;
+   }
+
+   static double getF64(const unsigned char *data)
+   {
+      double value;
+
+      unsigned long long bits = getU64(data);
+
+      std::memcpy(&value, &bits, sizeof(value));
+
+      return value;
+   }
+};
+
+FrameLog::FrameLog(const std::string &name) : impl(std::make_shared<Impl>(name))
+{
+}
+
+const std::string &FrameLog::name() const
+{
+   return impl->fileName;
+}
+
+bool FrameLog::open(OpenMode mode)
+{
+   return impl->open(mode);
+}
+
+void FrameLog::close()
+{
+   impl->close();
+}
+
+bool FrameLog::isOpen() const
+{
+   return impl->file;
+}
+
+bool FrameLog::isEof() const
+{
+   return impl->eof;
+}
+
+unsigned int FrameLog::sampleRate() const
+{
+   return impl->sampleRate;
+}
+
+void FrameLog::setSampleRate(unsigned int value)
+{
+   impl->sampleRate = value;
+
+   if (impl->file && impl->mode == FrameLog::Write)
+   {
+      // header is still in write buffer until first flush
+      if (impl->bufferOffset == 0 && impl->buffer.size() >= LOG_HEADER_SIZE)
+      {
+         Impl::putU32(impl->buffer.data() + 8, value);
+      }
+
+      // or rewritten in place, records are always appended at end of file
+      else
+      {
+         unsigned char rate[4];
+
+         Impl::putU32(rate, value);
+
+         fflush(impl->file);
+         fseek(impl->file, 8, SEEK_SET);
+         fwrite(rate, 1, sizeof(rate), impl->file);
+         fseek(impl->file, 0, SEEK_END);
+      }
+   }
+}
+
+long FrameLog::frameCount() const
+{
+   return impl->frameCount;
+}
+
+bool FrameLog::read(NfcFrame &frame)
+{
+   return impl->read(frame);
+}
+
+bool FrameLog::write(const NfcFrame &frame)
+{
+   return impl->write(frame);
+}
+
+void FrameLog::flush()
+{
+   impl->flush();
+}
+
+bool FrameLog::isFrameLog(const std::string &name)
+{
+   char magic[4] {};
+
+   if (FILE *file = fopen(name.c_str(), "rb"))
+   {
+      size_t count = fread(magic, 1, sizeof(magic), file);
+
+      fclose(file);
+
+      return count == sizeof(magic) && std::memcmp(magic, LOG_MAGIC, 4) == 0;
+   }
+
+   return false;
+}
+
+}
@@ -22,19 +22,34 @@
 
 */
 
+#include <ctime>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 
 #include <rt/Logger.h>
 #include <rt/BlockingQueue.h>
 #include <rt/FileSystem.h>
+#include <rt/Metrics.h>
 
 #include <nfc/Nfc.h>
 #include <nfc/NfcFrame.h>
+#include <nfc/FrameCompactor.h>
+#include <nfc/FrameLog.h>
 #include <nfc/FrameStorageTask.h>
+#include <nfc/FrameStore.h>
+#include <nfc/FrameTrace.h>
 
 #include "AbstractTask.h"
 
+// frames published per loop iteration while loading a file
+#define LOAD_BATCH_SIZE 1024
+
 namespace nfc {
 
 struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
@@ -48,20 +63,96 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
    // frame stream subscription
    rt::Subject<nfc::NfcFrame>::Subscription decoderSubscription;
 
-   // frame stream queue buffer
-   rt::BlockingQueue<nfc::NfcFrame> frameQueue;
+   // decoder status subscription, provides sample rate for frame logs
+   rt::Subject<rt::Event>::Subscription statusSubscription;
+
+   // sample rate of decoded signal, as reported by decoder
+   std::atomic<unsigned int> sampleRate {0};
+
+   // frames of current capture, columnar store shared by decoder and task threads
+   nfc::FrameStore frameStore;
+
+   // guards frame store
+   std::mutex frameMutex;
+
+   // frames pending to be appended to frame log
+   rt::BlockingQueue<nfc::NfcFrame> logQueue;
+
+   // frame log folder, empty when live logging is disabled
+   std::string logPath;
+
+   // live frame log for current capture, restarted on each clear
+   std::shared_ptr<nfc::FrameLog> frameLog;
+
+   // live log holds individual frames, summaries of repeated polling are expanded
+   nfc::FrameExpander logExpander;
+
+   // set while frame log is open, checked from decoder thread
+   std::atomic_bool logEnabled {false};
+
+   // next forced flush of frame log
+   std::chrono::steady_clock::time_point nextFlush;
+
+   // file being loaded, returns next frame until end of file
+   std::function<bool(nfc::NfcFrame &)> loadReader;
+
+   // read command resolved when load completes
+   std::shared_ptr<rt::Event> loadCommand;
+
+   // frames published from file being loaded
+   long loadCount = 0;
 
-   Impl() : AbstractTask("FrameStorageTask", "storage")
+   // exported metrics
+   rt::Metrics::Counter *framesStored = rt::Metrics::counter("nfc_storage_frames_total", "Frames stored in frame buffer", labels());
+   rt::Metrics::Counter *bytesStored = rt::Metrics::counter("nfc_storage_bytes_total", "Frame payload bytes stored in frame buffer", labels());
+   rt::Metrics::Gauge *framesHeld = rt::Metrics::gauge("nfc_storage_frames", "Frames currently held in frame buffer", labels());
+   rt::Metrics::Gauge *framesResident = rt::Metrics::gauge("nfc_storage_resident_frames", "Frames of frame buffer held in memory", labels());
+   rt::Metrics::Gauge *framesRefused = rt::Metrics::gauge("nfc_storage_refused_frames", "Frames not stored as retention limits were reached without spill file", labels());
+
+   explicit Impl(const rt::Context &context) : FrameStorageTask(context), AbstractTask(this, "FrameStorageTask", "storage", context)
    {
       // create storage stream subject
-      storageStream = rt::Subject<nfc::NfcFrame>::name("storage.frame");
+      storageStream = context.subject<nfc::NfcFrame>("storage.frame");
 
       // create decoder stream subject
-      decoderStream = rt::Subject<nfc::NfcFrame>::name("decoder.frame");
+      decoderStream = context.subject<nfc::NfcFrame>("decoder.frame");
 
       // subscribe to frame events
       decoderSubscription = decoderStream->subscribe([this](const nfc::NfcFrame &frame) {
-         frameQueue.add(frame);
+         std::lock_guard<std::mutex> lock(frameMutex);
+
+         size_t stored = frameStore.size();
+
+         frameStore.append(frame);
+
+         // frames are refused once limits are reached if spill file failed
+         if (frameStore.size() > stored)
+         {
+            framesStored->add();
+            bytesStored->add(frame.limit());
+         }
+
+         framesHeld->set(frameStore.size());
+         framesResident->set(frameStore.residentSize());
+         framesRefused->set(frameStore.refusedSize());
+
+         // frame log is written from task thread
+         if (logEnabled)
+         {
+            logQueue.add(frame);
+            this->worker->notify();
+         }
+      });
+
+      // subscribe to decoder status
+      statusSubscription = context.subject<rt::Event>("decoder.status")->subscribe([this](const rt::Event &event) {
+         if (auto data = event.get<std::string>("data"))
+         {
+            auto status = json::parse(data.value());
+
+            if (status.contains("sampleRate"))
+               sampleRate = status["sampleRate"].get<unsigned int>();
+         }
       });
    }
 
@@ -71,6 +162,9 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
 
    void stop() override
    {
+      cancelLoad();
+
+      closeLog();
    }
 
    bool loop() override
@@ -94,9 +188,53 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
          {
             clearQueue(command.value());
          }
+         else if (command->code == FrameStorageTask::Configure)
+         {
+            configure(command.value());
+         }
       }
 
-      wait(250);
+      /*
+       * append pending frames to live frame log
+       */
+      if (frameLog)
+      {
+         while (auto frame = logQueue.get())
+         {
+            logFrames(*frameLog, logExpander.nextFrames(frame.value()));
+         }
+
+         // decoder may be reconfigured while logging
+         if (frameLog->sampleRate() != sampleRate)
+            frameLog->setSampleRate(sampleRate);
+
+         // bound frames lost on crash to about one second
+         if (std::chrono::steady_clock::now() >= nextFlush)
+         {
+            frameLog->flush();
+
+            nextFlush = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+         }
+      }
+
+      /*
+       * publish next batch of frames from file being loaded
+       */
+      if (loadReader)
+      {
+         loadBatch();
+      }
+
+      /*
+       * sleep until new commands or frames are received
+       */
+      if (!commandQueue.size() && !logQueue.size() && !loadReader)
+      {
+         if (frameLog)
+            wait(1000);
+         else
+            wait();
+      }
 
       return true;
    }
@@ -115,48 +253,39 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
 
             log.info("read frames from file {}", {file});
 
-            json info;
+            // pending load is replaced by new one
+            cancelLoad();
 
-            if (rt::FileSystem::exists(file))
+            // binary frame log
+            if (nfc::FrameLog::isFrameLog(file))
             {
-               // open file
-               std::ifstream input(file);
+               auto input = std::make_shared<nfc::FrameLog>(file);
 
-               // read json
-               input >> info;
-            }
-
-            if (info.contains("frames"))
-            {
-               // read frames from file
-               for (const auto &frame: info["frames"])
+               if (!input->open(nfc::FrameLog::Read))
                {
-                  nfc::NfcFrame nfcFrame(256);
-
-                  nfcFrame.setTechType(frame["techType"]);
-                  nfcFrame.setFrameType(frame["frameType"]);
-                  nfcFrame.setFramePhase(frame["framePhase"]);
-                  nfcFrame.setFrameFlags(frame["frameFlags"]);
-                  nfcFrame.setFrameRate(frame["frameRate"]);
-                  nfcFrame.setTimeStart(frame["timeStart"]);
-                  nfcFrame.setTimeEnd(frame["timeEnd"]);
-                  nfcFrame.setSampleStart(frame["sampleStart"]);
-                  nfcFrame.setSampleEnd(frame["sampleEnd"]);
-
-                  std::string frameData = frame["frameData"];
+                  command.reject();
+                  return;
+               }
 
-                  for (size_t index = 0, size = 0; index < frameData.length(); index += size + 1)
-                  {
-                     nfcFrame.put(std::stoi(frameData.c_str() + index, &size, 16));
-                  }
+               loadReader = [input](nfc::NfcFrame &frame) { return input->read(frame); };
+            }
 
-                  nfcFrame.flip();
+            // JSON frame trace, parsed incrementally
+            else
+            {
+               auto input = std::make_shared<nfc::FrameTrace>(file);
 
-                  storageStream->next(nfcFrame);
+               if (!input->open())
+               {
+                  command.reject();
+                  return;
                }
+
+               loadReader = [input](nfc::NfcFrame &frame) { return input->read(frame); };
             }
 
-            command.resolve();
+            // frames are published from task loop, commands are still processed while loading
+            loadCommand = std::make_shared<rt::Event>(command);
 
             return;
          }
@@ -173,6 +302,67 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
       command.reject();
    }
 
+   void loadBatch()
+   {
+      nfc::NfcFrame frame;
+
+      for (int i = 0; i < LOAD_BATCH_SIZE; i++)
+      {
+         if (!loadReader(frame))
+         {
+            log.info("read file finished, {} frames", {loadCount});
+
+            loadReader = nullptr;
+            loadCommand->resolve();
+            loadCommand.reset();
+
+            return;
+         }
+
+         storageStream->next(frame);
+
+         loadCount++;
+      }
+   }
+
+   void cancelLoad()
+   {
+      if (loadReader)
+      {
+         log.info("read file cancelled after {} frames", {loadCount});
+
+         loadReader = nullptr;
+         loadCommand->reject();
+         loadCommand.reset();
+      }
+
+      loadCount = 0;
+   }
+
+   // visits stored frames, lock is only held while each batch is copied out so decoder is not stalled
+   void forEachFrame(const std::function<void(const nfc::NfcFrame &)> &visitor)
+   {
+      std::vector<nfc::NfcFrame> batch;
+
+      for (size_t next = 0;; next += batch.size())
+      {
+         batch.clear();
+
+         {
+            std::lock_guard<std::mutex> lock(frameMutex);
+
+            for (size_t index = next; index < frameStore.size() && batch.size() < LOAD_BATCH_SIZE; index++)
+               batch.push_back(frameStore.frame(index));
+         }
+
+         if (batch.empty())
+            break;
+
+         for (const auto &frame: batch)
+            visitor(frame);
+      }
+   }
+
    void writeFile(rt::Event &command)
    {
       if (auto data = command.get<std::string>("data"))
@@ -187,32 +377,57 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
 
             log.info("write frames to file {}", {file});
 
+            // binary frame log, live log already holds all frames of current capture
+            if (file.size() > 4 && file.substr(file.size() - 4) == ".nfl")
+            {
+               if (writeLog(file, config.contains("sampleRate") ? (unsigned int) config["sampleRate"] : sampleRate.load()))
+                  command.resolve();
+               else
+                  command.reject();
+
+               return;
+            }
+
             json frames = json::array();
 
-            for (const auto &frame: frameQueue)
-            {
-               if (frame.isPollFrame() || frame.isListenFrame())
+            auto exportFrames = [&frames](const std::list<nfc::NfcFrame> &list) {
+               for (const auto &frame: list)
                {
+                  if (!frame.isPollFrame() && !frame.isListenFrame())
+                     continue;
+
                   char buffer[4096];
 
                   frame.reduce<int>(0, [&buffer](int offset, unsigned char value) {
                      return offset + snprintf(buffer + offset, sizeof(buffer) - offset, offset > 0 ? ":%02X" : "%02X", value);
                   });
 
-                  frames.push_back({
-                                         {"sampleStart", frame.sampleStart()},
-                                         {"sampleEnd",   frame.sampleEnd()},
-                                         {"timeStart",   frame.timeStart()},
-                                         {"timeEnd",     frame.timeEnd()},
-                                         {"techType",    frame.techType()},
-                                         {"frameType",   frame.frameType()},
-                                         {"frameRate",   frame.frameRate()},
-                                         {"frameFlags",  frame.frameFlags()},
-                                         {"framePhase",  frame.framePhase()},
-                                         {"frameData",   buffer}
-                                   });
+                  json entry({
+                                   {"sampleStart", frame.sampleStart()},
+                                   {"sampleEnd",   frame.sampleEnd()},
+                                   {"timeStart",   frame.timeStart()},
+                                   {"timeEnd",     frame.timeEnd()},
+                                   {"techType",    frame.techType()},
+                                   {"frameType",   frame.frameType()},
+                                   {"frameRate",   frame.frameRate()},
+                                   {"frameFlags",  frame.frameFlags()},
+                                   {"framePhase",  frame.framePhase()},
+                                   {"sourceId",    frame.sourceId()},
+                                   {"frameData",   buffer}
+                             });
+
+                  frames.push_back(entry);
                }
-            }
+            };
+
+            // summaries of repeated polling are exported as their individual frames
+            nfc::FrameExpander expander;
+
+            forEachFrame([&exportFrames, &expander](const nfc::NfcFrame &frame) {
+               exportFrames(expander.nextFrames(frame));
+            });
+
+            exportFrames(expander.flush());
 
             json info({{"frames", frames}});
 
@@ -244,19 +459,197 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
    {
       log.info("frame clearQueue");
 
-      frameQueue.clear();
+      cancelLoad();
+
+      {
+         std::lock_guard<std::mutex> lock(frameMutex);
+
+         frameStore.clear();
+      }
+
+      framesHeld->set(0);
+      framesResident->set(0);
+
+      // new capture starts a new frame log
+      if (frameLog)
+         openLog();
 
       event.resolve();
    }
+
+   void configure(rt::Event &command)
+   {
+      if (auto data = command.get<std::string>("data"))
+      {
+         auto config = json::parse(data.value());
+
+         log.info("change config: {}", {config.dump()});
+
+         if (config.contains("logPath"))
+         {
+            logPath = config["logPath"];
+
+            if (logPath.empty())
+               closeLog();
+            else
+               openLog();
+         }
+
+         // folder for frames moved out of memory by retention limits
+         if (config.contains("spillPath"))
+         {
+            std::string spillPath = config["spillPath"];
+
+            if (!spillPath.empty() && !rt::FileSystem::exists(spillPath))
+               rt::FileSystem::createDir(spillPath);
+
+            std::lock_guard<std::mutex> lock(frameMutex);
+
+            frameStore.setSpillPath(spillPath);
+         }
+
+         // resident limits by count, age or size, zero disables each one
+         if (config.contains("retentionFrames") || config.contains("retentionTime") || config.contains("retentionBytes"))
+         {
+            std::lock_guard<std::mutex> lock(frameMutex);
+
+            frameStore.setRetention(config.value("retentionFrames", (size_t) 0), config.value("retentionTime", 0.0), config.value("retentionBytes", (size_t) 0));
+         }
+
+         command.resolve();
+
+         return;
+      }
+
+      command.reject();
+   }
+
+   // start live frame log in configured folder, named after current date
+   void openLog()
+   {
+      closeLog();
+
+      if (!rt::FileSystem::exists(logPath))
+         rt::FileSystem::createDir(logPath);
+
+      char date[32];
+      std::time_t now = std::time(nullptr);
+      std::tm local {};
+
+      localtime_s(&local, &now);
+
+      strftime(date, sizeof(date), "%Y%m%d%H%M%S", &local);
+
+      auto output = std::make_shared<nfc::FrameLog>(logPath + "/frames-" + date + ".nfl");
+
+      output->setSampleRate(sampleRate);
+
+      if (!output->open(nfc::FrameLog::Write))
+      {
+         log.warn("unable to start frame log {}", {output->name()});
+         return;
+      }
+
+      log.info("frame log started {}", {output->name()});
+
+      nextFlush = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+      std::vector<nfc::NfcFrame> held;
+
+      // frames already held are part of current capture, later frames are queued by decoder thread
+      {
+         std::lock_guard<std::mutex> lock(frameMutex);
+
+         held.reserve(frameStore.size());
+
+         for (size_t index = 0; index < frameStore.size(); index++)
+            held.push_back(frameStore.frame(index));
+
+         logQueue.clear();
+
+         logEnabled = true;
+      }
+
+      logExpander.reset();
+
+      for (const auto &frame: held)
+         logFrames(*output, logExpander.nextFrames(frame));
+
+      frameLog = output;
+   }
+
+   void closeLog()
+   {
+      if (frameLog)
+      {
+         logEnabled = false;
+
+         while (auto frame = logQueue.get())
+         {
+            logFrames(*frameLog, logExpander.nextFrames(frame.value()));
+         }
+
+         logFrames(*frameLog, logExpander.flush());
+
+         log.info("frame log finished {}, {} frames", {frameLog->name(), frameLog->frameCount()});
+
+         frameLog->close();
+         frameLog.reset();
+      }
+   }
+
+   static void logFrames(nfc::FrameLog &output, const std::list<nfc::NfcFrame> &frames)
+   {
+      for (const auto &frame: frames)
+         output.write(frame);
+   }
+
+   bool writeLog(const std::string &file, unsigned int rate)
+   {
+      // live log is completed with its index and trailer when capture ends
+      if (frameLog && file == frameLog->name())
+      {
+         while (auto frame = logQueue.get())
+         {
+            logFrames(*frameLog, logExpander.nextFrames(frame.value()));
+         }
+
+         logFrames(*frameLog, logExpander.flush());
+
+         frameLog->flush();
+
+         return true;
+      }
+
+      // saved log is written from stored frames, so it is closed with its index and trailer
+      nfc::FrameLog output(file);
+
+      output.setSampleRate(rate);
+
+      if (!output.open(nfc::FrameLog::Write))
+         return false;
+
+      nfc::FrameExpander expander;
+
+      forEachFrame([&output, &expander](const nfc::NfcFrame &frame) {
+         logFrames(output, expander.nextFrames(frame));
+      });
+
+      logFrames(output, expander.flush());
+
+      output.close();
+
+      return true;
+   }
 };
 
-FrameStorageTask::FrameStorageTask() : rt::Worker("FrameStorageTask")
+FrameStorageTask::FrameStorageTask(const rt::Context &context) : rt::Worker(context.qualify("FrameStorageTask"))
 {
 }
 
-rt::Worker *FrameStorageTask::construct()
+rt::Worker *FrameStorageTask::construct(const rt::Context &context)
 {
-   return new FrameStorageTask::Impl;
+   return new FrameStorageTask::Impl(context);
 }
 
 }
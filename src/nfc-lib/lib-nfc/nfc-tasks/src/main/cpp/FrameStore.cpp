@@ -0,0 +1,759 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include <rt/Logger.h>
+#include <rt/FileSystem.h>
+
+#include <nfc/FrameStore.h>
+
+// frames per block
+#define BLOCK_SIZE 1024
+
+// spilled blocks kept in memory after being read back
+#define PAGE_CACHE_SIZE 8
+
+// summary dimensions, tech and frame types outside these ranges are counted by scanning
+#define TECH_TYPES 8
+#define FRAME_TYPES 4
+#define FRAME_FLAGS 8
+
+namespace nfc {
+
+// spill file sequence within process
+static std::atomic_int spillSequence {0};
+
+struct FrameStore::Impl
+{
+   // frame attribute columns of one block, only appended until block is full
+   struct Columns
+   {
+      std::vector<double> timeStart;
+      std::vector<double> timeEnd;
+      std::vector<double> dateTime;
+      std::vector<unsigned long long> sampleStart;
+      std::vector<unsigned long long> sampleEnd;
+      std::vector<unsigned int> frameRate;
+      std::vector<unsigned int> frameFlags;
+      std::vector<unsigned char> techType;
+      std::vector<unsigned char> frameType;
+      std::vector<unsigned char> framePhase;
+      std::vector<unsigned char> sourceId;
+      std::vector<unsigned int> repeatCount;
+      std::vector<double> repeatPeriod;
+
+      // payload arena, frame i spans dataOffset[i] to dataOffset[i + 1]
+      std::vector<unsigned int> dataOffset {0};
+      std::vector<unsigned char> data;
+
+      void reserve(size_t size)
+      {
+         timeStart.reserve(size);
+         timeEnd.reserve(size);
+         dateTime.reserve(size);
+         sampleStart.reserve(size);
+         sampleEnd.reserve(size);
+         frameRate.reserve(size);
+         frameFlags.reserve(size);
+         techType.reserve(size);
+         frameType.reserve(size);
+         framePhase.reserve(size);
+         sourceId.reserve(size);
+         repeatCount.reserve(size);
+         repeatPeriod.reserve(size);
+         dataOffset.reserve(size + 1);
+      }
+
+      size_t bytes() const
+      {
+         return timeStart.capacity() * (4 * sizeof(double) + 2 * sizeof(unsigned long long) + 4 * sizeof(unsigned int) + 4) + data.capacity();
+      }
+
+      void append(const NfcFrame &frame)
+      {
+         timeStart.push_back(frame.timeStart());
+         timeEnd.push_back(frame.timeEnd());
+         dateTime.push_back(frame.dateTime());
+         sampleStart.push_back(frame.sampleStart());
+         sampleEnd.push_back(frame.sampleEnd());
+         frameRate.push_back(frame.frameRate());
+         frameFlags.push_back(frame.frameFlags());
+         techType.push_back(frame.techType());
+         frameType.push_back(frame.frameType());
+         framePhase.push_back(frame.framePhase());
+         sourceId.push_back(frame.sourceId());
+         repeatCount.push_back(frame.repeatCount());
+         repeatPeriod.push_back(frame.repeatPeriod());
+
+         data.insert(data.end(), frame.data(), frame.data() + frame.limit());
+         dataOffset.push_back(data.size());
+      }
+
+      NfcFrame frame(size_t index) const
+      {
+         unsigned int length = dataOffset[index + 1] - dataOffset[index];
+
+         NfcFrame frame(std::max(length, 1u));
+
+         frame.setTimeStart(timeStart[index]);
+         frame.setTimeEnd(timeEnd[index]);
+         frame.setDateTime(dateTime[index]);
+         frame.setSampleStart(sampleStart[index]);
+         frame.setSampleEnd(sampleEnd[index]);
+         frame.setFrameRate(frameRate[index]);
+         frame.setFrameFlags(frameFlags[index]);
+         frame.setTechType(techType[index]);
+         frame.setFrameType(frameType[index]);
+         frame.setFramePhase(framePhase[index]);
+         frame.setSourceId(sourceId[index]);
+         frame.setRepeatCount(repeatCount[index]);
+         frame.setRepeatPeriod(repeatPeriod[index]);
+
+         frame.put(data.data() + dataOffset[index], length).flip();
+
+         return frame;
+      }
+
+      // columns are stored back to back, sizes are known from block header
+      template <typename T>
+      static void write(std::fstream &file, const std::vector<T> &column)
+      {
+         file.write(reinterpret_cast<const char *>(column.data()), column.size() * sizeof(T));
+      }
+
+      template <typename T>
+      static void read(std::fstream &file, std::vector<T> &column, size_t size)
+      {
+         column.resize(size);
+         file.read(reinterpret_cast<char *>(column.data()), size * sizeof(T));
+      }
+
+      void write(std::fstream &file) const
+      {
+         write(file, timeStart);
+         write(file, timeEnd);
+         write(file, dateTime);
+         write(file, sampleStart);
+         write(file, sampleEnd);
+         write(file, frameRate);
+         write(file, frameFlags);
+         write(file, techType);
+         write(file, frameType);
+         write(file, framePhase);
+         write(file, sourceId);
+         write(file, repeatCount);
+         write(file, repeatPeriod);
+         write(file, dataOffset);
+         write(file, data);
+      }
+
+      void read(std::fstream &file, size_t size, size_t dataSize)
+      {
+         read(file, timeStart, size);
+         read(file, timeEnd, size);
+         read(file, dateTime, size);
+         read(file, sampleStart, size);
+         read(file, sampleEnd, size);
+         read(file, frameRate, size);
+         read(file, frameFlags, size);
+         read(file, techType, size);
+         read(file, frameType, size);
+         read(file, framePhase, size);
+         read(file, sourceId, size);
+         read(file, repeatCount, size);
+         read(file, repeatPeriod, size);
+         read(file, dataOffset, size + 1);
+         read(file, data, dataSize);
+      }
+   };
+
+   // block header and summary stay in memory, columns may be spilled to disk
+   struct Block
+   {
+      size_t size = 0;
+
+      // time bounds of frames in block
+      double minStart = 0;
+      double maxStart = 0;
+      double lastStart = 0;
+      double lastEnd = 0;
+
+      // frames in block are in time order, so it can be binary searched
+      bool sorted = true;
+
+      // highest start up to this block and lowest start from this block on, monotonic across blocks
+      double prefixMax = 0;
+      double suffixMin = 0;
+
+      // summary counts
+      unsigned int typeCount[TECH_TYPES][FRAME_TYPES] {};
+      unsigned int flagCount[FRAME_FLAGS] {};
+
+      // resident or paged in columns, null while spilled
+      std::shared_ptr<Columns> columns;
+
+      // spill file location, negative if never spilled
+      long long spillOffset = -1;
+      size_t dataSize = 0;
+
+      void append(const NfcFrame &frame)
+      {
+         if (size == 0)
+         {
+            minStart = maxStart = frame.timeStart();
+         }
+         else
+         {
+            sorted = sorted && frame.timeStart() >= lastStart;
+
+            minStart = std::min(minStart, frame.timeStart());
+            maxStart = std::max(maxStart, frame.timeStart());
+         }
+
+         lastStart = frame.timeStart();
+         lastEnd = std::max(lastEnd, frame.timeEnd());
+
+         columns->append(frame);
+
+         if (frame.techType() < TECH_TYPES && frame.frameType() < FRAME_TYPES)
+            typeCount[frame.techType()][frame.frameType()]++;
+
+         for (int bit = 0; bit < FRAME_FLAGS; bit++)
+         {
+            if (frame.frameFlags() & (1 << bit))
+               flagCount[bit]++;
+         }
+
+         size++;
+      }
+
+      size_t count(const Columns &columns, size_t first, size_t last, int tech, int type) const
+      {
+         size_t total = 0;
+
+         for (size_t i = first; i < last; i++)
+         {
+            if ((tech < 0 || tech == columns.techType[i]) && (type < 0 || type == columns.frameType[i]))
+               total++;
+         }
+
+         return total;
+      }
+
+      // whole block from summary, false if it must be scanned
+      bool summaryCount(int tech, int type, size_t &total) const
+      {
+         if (tech >= TECH_TYPES || type >= FRAME_TYPES)
+            return false;
+
+         for (int t = 0; t < TECH_TYPES; t++)
+         {
+            for (int f = 0; f < FRAME_TYPES; f++)
+            {
+               if ((tech < 0 || tech == t) && (type < 0 || type == f))
+                  total += typeCount[t][f];
+            }
+         }
+
+         return true;
+      }
+
+      size_t countFlags(const Columns &columns, size_t first, size_t last, unsigned int flags) const
+      {
+         size_t total = 0;
+
+         for (size_t i = first; i < last; i++)
+         {
+            if (columns.frameFlags[i] & flags)
+               total++;
+         }
+
+         return total;
+      }
+
+      // whole block from summary, exact for single flag or when none of them is present
+      bool summaryFlags(unsigned int flags, size_t &total) const
+      {
+         if (flags >= (1 << FRAME_FLAGS))
+            return false;
+
+         size_t found = 0;
+         int bits = 0;
+
+         for (int bit = 0; bit < FRAME_FLAGS; bit++)
+         {
+            if (flags & (1 << bit))
+            {
+               found += flagCount[bit];
+               bits++;
+            }
+         }
+
+         if (bits != 1 && found != 0)
+            return false;
+
+         total += found;
+
+         return true;
+      }
+   };
+
+   rt::Logger log {"FrameStore"};
+
+   std::vector<std::shared_ptr<Block>> blocks;
+
+   size_t frameCount = 0;
+
+   // resident limits, zero disables each one
+   size_t retentionFrames = 0;
+   double retentionTime = 0;
+   size_t retentionBytes = 0;
+
+   // first block still resident, older ones are spilled
+   size_t residentBlock = 0;
+   size_t residentFrames = 0;
+   size_t residentBytes = 0;
+
+   // spill file, created on first spill
+   std::string spillPath;
+   std::string spillName;
+   std::fstream spillFile;
+   long long spillSize = 0;
+
+   // spill file could not be created or written, frames over limits are refused instead
+   bool spillFailed = false;
+   size_t refusedFrames = 0;
+
+   // spilled blocks read back, most recent last
+   mutable std::vector<size_t> pagedBlocks;
+
+   ~Impl()
+   {
+      closeSpill();
+   }
+
+   void append(const NfcFrame &frame)
+   {
+      // without spill file memory stays bounded only by not storing new frames
+      if (spillFailed && exceeded(frame.timeStart()))
+      {
+         refusedFrames++;
+         return;
+      }
+
+      if (frameCount % BLOCK_SIZE == 0)
+      {
+         auto block = std::make_shared<Block>();
+
+         block->columns = std::make_shared<Columns>();
+         block->columns->reserve(BLOCK_SIZE);
+
+         blocks.push_back(block);
+
+         residentBytes += block->columns->bytes();
+      }
+
+      auto &block = blocks.back();
+
+      size_t bytes = block->columns->data.capacity();
+
+      block->append(frame);
+
+      // cross block bounds, an out of order frame only updates the blocks it reaches back to
+      block->prefixMax = blocks.size() > 1 ? std::max(blocks[blocks.size() - 2]->prefixMax, block->maxStart) : block->maxStart;
+
+      if (block->size == 1)
+         block->suffixMin = frame.timeStart();
+
+      for (auto it = blocks.rbegin(); it != blocks.rend() && (*it)->suffixMin > frame.timeStart(); ++it)
+         (*it)->suffixMin = frame.timeStart();
+
+      residentBytes += block->columns->data.capacity() - bytes;
+      residentFrames++;
+
+      frameCount++;
+
+      // retention is applied each time a block is completed
+      if (frameCount % BLOCK_SIZE == 0)
+         retain(frame.timeStart());
+   }
+
+   void clear()
+   {
+      blocks.clear();
+      pagedBlocks.clear();
+
+      frameCount = 0;
+      residentBlock = 0;
+      residentFrames = 0;
+      residentBytes = 0;
+      refusedFrames = 0;
+
+      closeSpill();
+
+      spillFailed = false;
+   }
+
+   // any limit exceeded by resident frames, age is taken from oldest resident block
+   bool exceeded(double now) const
+   {
+      return (retentionFrames && residentFrames > retentionFrames) ||
+             (retentionBytes && residentBytes > retentionBytes) ||
+             (retentionTime > 0 && residentBlock < blocks.size() && now - blocks[residentBlock]->lastEnd > retentionTime);
+   }
+
+   // moves oldest full blocks to spill file while any limit is exceeded
+   void retain(double now)
+   {
+      while (residentBlock + 1 < blocks.size())
+      {
+         const auto &block = blocks[residentBlock];
+
+         if (!exceeded(now) || !spill(*block))
+            break;
+
+         residentFrames -= block->size;
+         residentBytes -= std::min(residentBytes, block->columns->bytes());
+
+         block->columns.reset();
+
+         residentBlock++;
+      }
+   }
+
+   bool spill(Block &block)
+   {
+      if (spillFailed)
+         return false;
+
+      if (!spillFile.is_open() && !openSpill())
+      {
+         spillFailed = true;
+         return false;
+      }
+
+      spillFile.clear();
+      spillFile.seekp(spillSize);
+
+      block.columns->write(spillFile);
+
+      if (!spillFile.good())
+      {
+         log.error("failed to write spill file {}, frames over retention limits are refused", {spillName});
+
+         spillFailed = true;
+
+         return false;
+      }
+
+      block.spillOffset = spillSize;
+      block.dataSize = block.columns->data.size();
+
+      spillSize = spillFile.tellp();
+
+      return true;
+   }
+
+   bool openSpill()
+   {
+      char name[64];
+
+      snprintf(name, sizeof(name), "frames-%lld-%d.spill", (long long) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), spillSequence++);
+
+      spillName = (spillPath.empty() ? std::string(".") : spillPath) + "/" + name;
+
+      if (!spillPath.empty())
+         rt::FileSystem::createDir(spillPath);
+
+      spillFile.open(spillName, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+      if (!spillFile.is_open())
+      {
+         log.error("unable to create spill file {}, frames over retention limits are refused", {spillName});
+         return false;
+      }
+
+      log.info("frame spill started {}", {spillName});
+
+      spillSize = 0;
+
+      return true;
+   }
+
+   void closeSpill()
+   {
+      if (spillFile.is_open())
+      {
+         spillFile.close();
+
+         std::remove(spillName.c_str());
+      }
+
+      spillSize = 0;
+   }
+
+   // columns for block, paged in from spill file if needed
+   const Columns &columns(size_t index) const
+   {
+      auto &block = blocks[index];
+
+      if (!block->columns)
+      {
+         auto columns = std::make_shared<Columns>();
+
+         auto &file = const_cast<std::fstream &>(spillFile);
+
+         file.clear();
+         file.seekg(block->spillOffset);
+
+         columns->read(file, block->size, block->dataSize);
+
+         if (!file.good())
+            log.warn("failed to read block {} from spill file {}", {index, spillName});
+
+         block->columns = columns;
+
+         pagedBlocks.push_back(index);
+
+         // release least recently paged block
+         if (pagedBlocks.size() > PAGE_CACHE_SIZE)
+         {
+            blocks[pagedBlocks.front()]->columns.reset();
+            pagedBlocks.erase(pagedBlocks.begin());
+         }
+      }
+
+      return *block->columns;
+   }
+
+   inline const Columns &columnsOf(size_t frame) const
+   {
+      return columns(frame / BLOCK_SIZE);
+   }
+
+   size_t lowerBound(double time) const
+   {
+      // first block holding a frame at or after time, then position inside block
+      auto it = std::partition_point(blocks.begin(), blocks.end(), [time](const std::shared_ptr<Block> &block) {
+         return block->prefixMax < time;
+      });
+
+      if (it == blocks.end())
+         return frameCount;
+
+      size_t index = it - blocks.begin();
+
+      // whole block starts after time, no need to read its columns
+      if ((*it)->minStart >= time)
+         return index * BLOCK_SIZE;
+
+      const auto &column = columns(index).timeStart;
+
+      if ((*it)->sorted)
+         return index * BLOCK_SIZE + (std::lower_bound(column.begin(), column.end(), time) - column.begin());
+
+      return index * BLOCK_SIZE + (std::find_if(column.begin(), column.end(), [time](double start) { return start >= time; }) - column.begin());
+   }
+
+   size_t upperBound(double time) const
+   {
+      // first block from which all frames start after time, last frame at or before time is in the previous one
+      auto it = std::partition_point(blocks.begin(), blocks.end(), [time](const std::shared_ptr<Block> &block) {
+         return block->suffixMin <= time;
+      });
+
+      if (it == blocks.begin())
+         return 0;
+
+      size_t index = --it - blocks.begin();
+
+      // whole block starts at or before time, no need to read its columns
+      if ((*it)->maxStart <= time)
+         return index * BLOCK_SIZE + (*it)->size;
+
+      const auto &column = columns(index).timeStart;
+
+      if ((*it)->sorted)
+         return index * BLOCK_SIZE + (std::upper_bound(column.begin(), column.end(), time) - column.begin());
+
+      return index * BLOCK_SIZE + (column.rend() - std::find_if(column.rbegin(), column.rend(), [time](double start) { return start <= time; }));
+   }
+
+   // out of order frames widen the range to the blocks they were appended to
+   std::pair<size_t, size_t> range(double from, double to) const
+   {
+      size_t first = lowerBound(from);
+      size_t last = upperBound(to);
+
+      return {first, std::max(first, last)};
+   }
+
+   // visits blocks overlapping [first, last), whole blocks are offered to summary first
+   template <typename Summary, typename Scanner>
+   size_t count(size_t first, size_t last, Summary summary, Scanner scanner) const
+   {
+      size_t total = 0;
+
+      last = std::min(last, frameCount);
+
+      while (first < last)
+      {
+         size_t index = first / BLOCK_SIZE;
+         size_t offset = first % BLOCK_SIZE;
+         size_t end = std::min(last - first + offset, blocks[index]->size);
+
+         const Block &block = *blocks[index];
+
+         if (offset != 0 || end != block.size || !summary(block, total))
+            total += scanner(block, columns(index), offset, end);
+
+         first += end - offset;
+      }
+
+      return total;
+   }
+};
+
+FrameStore::FrameStore() : impl(std::make_shared<Impl>())
+{
+}
+
+void FrameStore::append(const NfcFrame &frame)
+{
+   impl->append(frame);
+}
+
+void FrameStore::clear()
+{
+   impl->clear();
+}
+
+size_t FrameStore::size() const
+{
+   return impl->frameCount;
+}
+
+bool FrameStore::isEmpty() const
+{
+   return impl->frameCount == 0;
+}
+
+size_t FrameStore::bytes() const
+{
+   return impl->residentBytes;
+}
+
+size_t FrameStore::residentSize() const
+{
+   return impl->residentFrames;
+}
+
+size_t FrameStore::refusedSize() const
+{
+   return impl->refusedFrames;
+}
+
+void FrameStore::setRetention(size_t frames, double seconds, size_t bytes)
+{
+   impl->retentionFrames = frames;
+   impl->retentionTime = seconds;
+   impl->retentionBytes = bytes;
+}
+
+void FrameStore::setSpillPath(const std::string &path)
+{
+   impl->spillPath = path;
+   impl->spillFailed = false;
+}
+
+NfcFrame FrameStore::frame(size_t index) const
+{
+   return impl->columnsOf(index).frame(index % BLOCK_SIZE);
+}
+
+double FrameStore::timeStart(size_t index) const
+{
+   return impl->columnsOf(index).timeStart[index % BLOCK_SIZE];
+}
+
+double FrameStore::timeEnd(size_t index) const
+{
+   return impl->columnsOf(index).timeEnd[index % BLOCK_SIZE];
+}
+
+unsigned int FrameStore::techType(size_t index) const
+{
+   return impl->columnsOf(index).techType[index % BLOCK_SIZE];
+}
+
+unsigned int FrameStore::frameType(size_t index) const
+{
+   return impl->columnsOf(index).frameType[index % BLOCK_SIZE];
+}
+
+unsigned int FrameStore::frameFlags(size_t index) const
+{
+   return impl->columnsOf(index).frameFlags[index % BLOCK_SIZE];
+}
+
+size_t FrameStore::lowerBound(double time) const
+{
+   return impl->lowerBound(time);
+}
+
+size_t FrameStore::upperBound(double time) const
+{
+   return impl->upperBound(time);
+}
+
+std::pair<size_t, size_t> FrameStore::range(double from, double to) const
+{
+   return impl->range(from, to);
+}
+
+size_t FrameStore::count(size_t first, size_t last, int techType, int frameType) const
+{
+   return impl->count(first, last, [=](const Impl::Block &block, size_t &total) {
+      return block.summaryCount(techType, frameType, total);
+   }, [=](const Impl::Block &block, const Impl::Columns &columns, size_t begin, size_t end) {
+      return block.count(columns, begin, end, techType, frameType);
+   });
+}
+
+size_t FrameStore::countFlags(size_t first, size_t last, unsigned int flags) const
+{
+   return impl->count(first, last, [=](const Impl::Block &block, size_t &total) {
+      return block.summaryFlags(flags, total);
+   }, [=](const Impl::Block &block, const Impl::Columns &columns, size_t begin, size_t end) {
+      return block.countFlags(columns, begin, end, flags);
+   });
+}
+
+}
@@ -0,0 +1,500 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include <rt/Logger.h>
+
+#include <nfc/FrameTrace.h>
+
+// input chunk size
+#define BUFFER_SIZE (1024 * 1024)
+
+// minimum frame buffer capacity
+#define FRAME_CAPACITY 256
+
+// longest number token accepted
+#define MAX_NUMBER_SIZE 64
+
+namespace nfc {
+
+// hex digit values, -1 for other characters
+static const struct HexTable
+{
+   signed char value[256];
+
+   HexTable() : value()
+   {
+      std::memset(value, -1, sizeof(value));
+
+      for (int i = 0; i < 10; i++)
+         value['0' + i] = (signed char) i;
+
+      for (int i = 0; i < 6; i++)
+         value['a' + i] = value['A' + i] = (signed char) (10 + i);
+   }
+} hexTable;
+
+struct FrameTrace::Impl
+{
+   rt::Logger log {"FrameTrace"};
+
+   std::string fileName;
+   FILE *file = nullptr;
+   bool eof = false;
+   long frameCount = 0;
+
+   // input window
+   std::vector<char> buffer;
+   size_t position = 0;
+   size_t length = 0;
+
+   // frame members, reused between frames
+   std::string key;
+   std::vector<unsigned char> frameData;
+
+   explicit Impl(std::string name) : fileName(std::move(name))
+   {
+   }
+
+   ~Impl()
+   {
+      close();
+   }
+
+   bool open()
+   {
+      close();
+
+      eof = false;
+      frameCount = 0;
+      position = 0;
+      length = 0;
+
+      if (!(file = fopen(fileName.c_str(), "rb")))
+      {
+         log.warn("unable to open file {}", {fileName});
+         return false;
+      }
+
+      buffer.resize(BUFFER_SIZE);
+
+      if (!skipSpace() || next() != '{')
+      {
+         log.warn("invalid frame trace in file {}", {fileName});
+
+         close();
+
+         return false;
+      }
+
+      // locate frames array, other top level members are skipped
+      while (skipSpace() && peek() != '}')
+      {
+         if (peek() == ',')
+            next();
+
+         if (!readKey())
+            break;
+
+         if (key == "frames")
+         {
+            if (skipSpace() && next() == '[')
+               return true;
+
+            break;
+         }
+
+         if (!skipValue())
+            break;
+      }
+
+      log.warn("no frames found in file {}", {fileName});
+
+      eof = true;
+
+      return true;
+   }
+
+   void close()
+   {
+      if (file)
+      {
+         fclose(file);
+
+         file = nullptr;
+      }
+   }
+
+   bool read(NfcFrame &frame)
+   {
+      if (!file || eof)
+         return false;
+
+      if (!skipSpace() || peek() == ']')
+         return finish();
+
+      // separator between frames
+      if (peek() == ',')
+      {
+         next();
+
+         if (!skipSpace())
+            return finish();
+      }
+
+      if (next() != '{')
+         return malformed();
+
+      unsigned long long sampleStart = 0, sampleEnd = 0;
+      double timeStart = 0, timeEnd = 0;
+      long long techType = 0, frameType = 0, framePhase = 0, frameFlags = 0, frameRate = 0, sourceId = 0, repeatCount = 0;
+      double repeatPeriod = 0;
+
+      frameData.clear();
+
+      while (skipSpace() && peek() != '}')
+      {
+         if (peek() == ',')
+            next();
+
+         if (!readKey() || !skipSpace())
+            return malformed();
+
+         bool valid;
+
+         if (key == "frameData")
+            valid = readHex();
+         else if (key == "sampleStart")
+            valid = readInteger(sampleStart);
+         else if (key == "sampleEnd")
+            valid = readInteger(sampleEnd);
+         else if (key == "timeStart")
+            valid = readDouble(timeStart);
+         else if (key == "timeEnd")
+            valid = readDouble(timeEnd);
+         else if (key == "techType")
+            valid = readInteger(techType);
+         else if (key == "frameType")
+            valid = readInteger(frameType);
+         else if (key == "framePhase")
+            valid = readInteger(framePhase);
+         else if (key == "frameFlags")
+            valid = readInteger(frameFlags);
+         else if (key == "frameRate")
+            valid = readInteger(frameRate);
+         else if (key == "sourceId")
+            valid = readInteger(sourceId);
+         else if (key == "repeatCount")
+            valid = readInteger(repeatCount);
+         else if (key == "repeatPeriod")
+            valid = readDouble(repeatPeriod);
+         else
+            valid = skipValue();
+
+         if (!valid)
+            return malformed();
+      }
+
+      if (next() != '}')
+         return malformed();
+
+      // same capacity as decoded frames, so both compare equal
+      frame = NfcFrame(std::max((int) frameData.size(), FRAME_CAPACITY));
+
+      frame.setTechType(techType);
+      frame.setFrameType(frameType);
+      frame.setFramePhase(framePhase);
+      frame.setFrameFlags(frameFlags);
+      frame.setFrameRate(frameRate);
+      frame.setSourceId(sourceId);
+      frame.setSampleStart(sampleStart);
+      frame.setSampleEnd(sampleEnd);
+      frame.setTimeStart(timeStart);
+      frame.setTimeEnd(timeEnd);
+      frame.setRepeatCount(repeatCount);
+      frame.setRepeatPeriod(repeatPeriod);
+
+      frame.put(frameData.data(), frameData.size()).flip();
+
+      frameCount++;
+
+      return true;
+   }
+
+   bool finish()
+   {
+      eof = true;
+
+      return false;
+   }
+
+   bool malformed()
+   {
+      log.warn("malformed frame trace after {} frames in file {}", {frameCount, fileName});
+
+      return finish();
+   }
+
+   // next character without consuming it, -1 at end of input
+   inline int peek()
+   {
+      if (position == length && !fill())
+         return -1;
+
+      return (unsigned char) buffer[position];
+   }
+
+   inline int next()
+   {
+      if (position == length && !fill())
+         return -1;
+
+      return (unsigned char) buffer[position++];
+   }
+
+   bool fill()
+   {
+      position = 0;
+      length = file ? fread(buffer.data(), 1, buffer.size(), file) : 0;
+
+      return length > 0;
+   }
+
+   // skips white space, false at end of input
+   bool skipSpace()
+   {
+      for (int c = peek(); c != -1; c = peek())
+      {
+         if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+            return true;
+
+         position++;
+      }
+
+      return false;
+   }
+
+   // reads member name and following colon
+   bool readKey()
+   {
+      key.clear();
+
+      if (!skipSpace() || next() != '"')
+         return false;
+
+      for (int c = next(); c != '"'; c = next())
+      {
+         if (c == -1)
+            return false;
+
+         if (c == '\\')
+            c = next();
+
+         key.push_back((char) c);
+      }
+
+      return skipSpace() && next() == ':';
+   }
+
+   // frame bytes as hex groups separated by any other character, "0A:1B:2C"
+   bool readHex()
+   {
+      if (next() != '"')
+         return false;
+
+      int value = 0;
+      bool digits = false;
+
+      for (int c = next(); c != '"'; c = next())
+      {
+         if (c == -1)
+            return false;
+
+         int nibble = hexTable.value[c];
+
+         if (nibble >= 0)
+         {
+            value = (value << 4) | nibble;
+            digits = true;
+         }
+         else if (digits)
+         {
+            frameData.push_back((unsigned char) value);
+            value = 0;
+            digits = false;
+         }
+      }
+
+      if (digits)
+         frameData.push_back((unsigned char) value);
+
+      return true;
+   }
+
+   // copies number token to null terminated buffer
+   bool readNumber(char *token, bool &integer)
+   {
+      int size = 0;
+
+      integer = true;
+
+      for (int c = peek(); c != -1; c = peek())
+      {
+         if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E')
+            break;
+
+         if (size == MAX_NUMBER_SIZE - 1)
+            return false;
+
+         if (c == '.' || c == 'e' || c == 'E')
+            integer = false;
+
+         token[size++] = (char) c;
+         position++;
+      }
+
+      token[size] = 0;
+
+      return size > 0;
+   }
+
+   template <typename T>
+   bool readInteger(T &value)
+   {
+      char token[MAX_NUMBER_SIZE];
+      bool integer;
+
+      if (!readNumber(token, integer))
+         return false;
+
+      if (integer)
+         value = (T) std::strtoll(token, nullptr, 10);
+      else
+         value = (T) std::strtod(token, nullptr);
+
+      return true;
+   }
+
+   bool readDouble(double &value)
+   {
+      char token[MAX_NUMBER_SIZE];
+      bool integer;
+
+      if (!readNumber(token, integer))
+         return false;
+
+      value = std::strtod(token, nullptr);
+
+      return true;
+   }
+
+   // skips any value, nested objects and arrays included
+   bool skipValue()
+   {
+      int depth = 0;
+
+      do
+      {
+         if (!skipSpace())
+            return false;
+
+         int c = next();
+
+         if (c == '"')
+         {
+            for (c = next(); c != '"'; c = next())
+            {
+               if (c == -1)
+                  return false;
+
+               if (c == '\\')
+                  next();
+            }
+         }
+         else if (c == '{' || c == '[')
+         {
+            depth++;
+         }
+         else if (c == '}' || c == ']')
+         {
+            depth--;
+         }
+         else if (depth == 0)
+         {
+            // number or literal ends at next delimiter
+            for (c = peek(); c != -1 && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\n' && c != '\r' && c != '\t'; c = peek())
+               position++;
+         }
+
+      } while (depth > 0);
+
+      return true;
+   }
+};
+
+FrameTrace::FrameTrace(const std::string &name) : impl(std::make_shared<Impl>(name))
+{
+}
+
+const std::string &FrameTrace::name() const
+{
+   return impl->fileName;
+}
+
+bool FrameTrace::open()
+{
+   return impl->open();
+}
+
+void FrameTrace::close()
+{
+   impl->close();
+}
+
+bool FrameTrace::isOpen() const
+{
+   return impl->file;
+}
+
+bool FrameTrace::isEof() const
+{
+   return impl->eof;
+}
+
+long FrameTrace::frameCount() const
+{
+   return impl->frameCount;
+}
+
+bool FrameTrace::read(NfcFrame &frame)
+{
+   return impl->read(frame);
+}
+
+}
@@ -0,0 +1,168 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+
+#include <rt/Logger.h>
+#include <rt/FileSystem.h>
+#include <rt/Metrics.h>
+
+#include <nfc/MetricsExportTask.h>
+
+#include "AbstractTask.h"
+
+namespace nfc {
+
+struct MetricsExportTask::Impl : MetricsExportTask, AbstractTask
+{
+   // export status
+   int status = MetricsExportTask::Exporting;
+
+   // prometheus text file, suitable for node_exporter textfile collector
+   std::string exportPath = "metrics/nfc-lab.prom";
+
+   // export interval in milliseconds
+   int exportInterval = 5000;
+
+   // next export time
+   std::chrono::time_point<std::chrono::steady_clock> nextExport;
+
+   Impl() : AbstractTask(this, "MetricsExportTask", "metrics")
+   {
+   }
+
+   void start() override
+   {
+      nextExport = std::chrono::steady_clock::now() + std::chrono::milliseconds(exportInterval);
+   }
+
+   void stop() override
+   {
+      // final export with last values
+      if (status == MetricsExportTask::Exporting)
+         exportMetrics();
+   }
+
+   bool loop() override
+   {
+      /*
+       * first process pending commands
+       */
+      if (auto command = commandQueue.get())
+      {
+         log.debug("metrics command [{}]", {command->code});
+
+         if (command->code == MetricsExportTask::Configure)
+         {
+            configure(command.value());
+         }
+         else if (command->code == MetricsExportTask::Export)
+         {
+            exportMetrics();
+
+            command->resolve();
+         }
+      }
+
+      /*
+       * periodic export
+       */
+      auto now = std::chrono::steady_clock::now();
+
+      if (status == MetricsExportTask::Exporting && now >= nextExport)
+      {
+         exportMetrics();
+
+         nextExport = now + std::chrono::milliseconds(exportInterval);
+      }
+
+      /*
+       * sleep until next export or new command is received
+       */
+      if (!commandQueue.size())
+      {
+         if (status == MetricsExportTask::Exporting)
+            wait(std::max(1, (int) std::chrono::duration_cast<std::chrono::milliseconds>(nextExport - std::chrono::steady_clock::now()).count()));
+         else
+            wait();
+      }
+
+      return true;
+   }
+
+   void configure(const rt::Event &command)
+   {
+      if (auto data = command.get<std::string>("data"))
+      {
+         auto config = json::parse(data.value());
+
+         log.info("change config: {}", {config.dump()});
+
+         if (config.contains("enabled"))
+            status = config["enabled"] ? MetricsExportTask::Exporting : MetricsExportTask::Disabled;
+
+         if (config.contains("path"))
+            exportPath = config["path"];
+
+         if (config.contains("interval"))
+            exportInterval = std::max(100, (int) config["interval"]);
+
+         nextExport = std::chrono::steady_clock::now() + std::chrono::milliseconds(exportInterval);
+
+         command.resolve();
+
+         return;
+      }
+
+      command.reject();
+   }
+
+   void exportMetrics()
+   {
+      auto separator = exportPath.find_last_of("/\\");
+
+      if (separator != std::string::npos)
+      {
+         std::string folder = exportPath.substr(0, separator);
+
+         if (!rt::FileSystem::exists(folder))
+            rt::FileSystem::createDir(folder);
+      }
+
+      if (!rt::Metrics::dump(exportPath))
+         log.warn("unable to write metrics to {}", {exportPath});
+   }
+};
+
+MetricsExportTask::MetricsExportTask() : rt::Worker("MetricsExportTask")
+{
+}
+
+rt::Worker *MetricsExportTask::construct()
+{
+   return new MetricsExportTask::Impl;
+}
+
+}
@@ -0,0 +1,595 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <chrono>
+
+#include <rt/Logger.h>
+#include <rt/Metrics.h>
+#include <rt/BlockingQueue.h>
+
+#include <sdr/SignalBuffer.h>
+
+#include <nfc/NfcFrame.h>
+#include <nfc/FrameDecoderTask.h>
+#include <nfc/SignalReceiverTask.h>
+#include <nfc/PipelineGroupTask.h>
+
+#include "AbstractTask.h"
+
+namespace nfc {
+
+// time a frame waits for frames of other pipelines before merge, in milliseconds
+#define MERGE_WINDOW 50
+
+// group status update interval, in milliseconds
+#define STATUS_INTERVAL 1000
+
+struct PipelineGroupTask::Impl : PipelineGroupTask, AbstractTask
+{
+   typedef std::chrono::steady_clock::time_point Arrival;
+
+   struct Pipeline
+   {
+      rt::Context context;
+
+      // pipeline command subjects
+      rt::Subject<rt::Event> *receiverCommand = nullptr;
+      rt::Subject<rt::Event> *decoderCommand = nullptr;
+
+      // frames pending merge in decoding order, with time of arrival
+      std::deque<std::pair<nfc::NfcFrame, Arrival>> frames;
+
+      // stream start in steady clock seconds, estimated from frame capture times
+      double origin = NAN;
+
+      // last receiver status and measured throughput, updated from receiver thread
+      json receiverStatus;
+      double throughput = 0;
+      Arrival lastStatus;
+
+      // receiver parameters applied to pipeline decoder
+      long sampleRate = 0;
+      long streamTime = 0;
+
+      // merged frames
+      long merged = 0;
+
+      rt::Metrics::Counter *mergedFrames = nullptr;
+   };
+
+   // declared before subscriptions so pipeline subjects outlive them
+   std::vector<Pipeline> pipelines;
+
+   // global status subjects, updated from primary pipeline
+   rt::Subject<rt::Event> *receiverStatus = nullptr;
+   rt::Subject<rt::Event> *decoderStatus = nullptr;
+
+   // global signal subjects, updated from primary pipeline
+   rt::Subject<sdr::SignalBuffer> *signalRvStream = nullptr;
+   rt::Subject<sdr::SignalBuffer> *signalIqStream = nullptr;
+
+   // merged frame stream
+   rt::Subject<nfc::NfcFrame> *frameStream = nullptr;
+
+   // pipeline and global command subscriptions
+   std::vector<rt::Subject<rt::Event>::Subscription> subscriptions;
+
+   // global commands pending to forward to pipelines
+   rt::BlockingQueue<rt::Event> receiverQueue;
+   rt::BlockingQueue<rt::Event> decoderQueue;
+
+   // frames received from decoder threads, by pipeline index
+   std::mutex inboxMutex;
+   std::vector<std::tuple<unsigned int, nfc::NfcFrame, Arrival>> inbox;
+
+   // receiver status access from receiver threads
+   std::mutex statusMutex;
+
+   // last decoder configuration received from global context
+   json decoderConfig;
+
+   // merge window in milliseconds
+   int mergeWindow = MERGE_WINDOW;
+
+   // time of last merged frame, to detect ordering violations
+   double lastMerged = -INFINITY;
+
+   // last group status sent
+   Arrival lastStatus;
+
+   // exported metrics
+   rt::Metrics::Gauge *pendingFrames = rt::Metrics::gauge("nfc_group_pending_frames", "Frames waiting for merge", labels());
+   rt::Metrics::Counter *lateFrames = rt::Metrics::counter("nfc_group_late_frames_total", "Frames merged out of time order", labels());
+
+   explicit Impl(const std::vector<rt::Context> &contexts) : AbstractTask(this, "PipelineGroupTask", "group")
+   {
+      receiverStatus = context.subject<rt::Event>("receiver.status");
+      decoderStatus = context.subject<rt::Event>("decoder.status");
+      signalRvStream = context.subject<sdr::SignalBuffer>("signal.raw");
+      signalIqStream = context.subject<sdr::SignalBuffer>("signal.iq");
+      frameStream = context.subject<nfc::NfcFrame>("decoder.frame");
+
+      // pipeline list must be complete before subscriptions are made
+      for (const auto &pipeline: contexts)
+      {
+         Pipeline entry;
+
+         entry.context = pipeline;
+         entry.receiverCommand = pipeline.subject<rt::Event>("receiver.command");
+         entry.decoderCommand = pipeline.subject<rt::Event>("decoder.command");
+         entry.mergedFrames = rt::Metrics::counter("nfc_group_frames_total", "Frames merged per pipeline", labels({{"pipeline", pipeline.name()}}));
+
+         pipelines.push_back(entry);
+      }
+
+      for (unsigned int index = 0; index < pipelines.size(); index++)
+      {
+         const auto &pipeline = pipelines[index].context;
+
+         subscriptions.push_back(pipeline.subject<nfc::NfcFrame>("decoder.frame")->subscribe([this, index](const nfc::NfcFrame &frame) {
+            {
+               std::lock_guard<std::mutex> lock(inboxMutex);
+               inbox.emplace_back(index, frame, std::chrono::steady_clock::now());
+            }
+            notify();
+         }));
+
+         subscriptions.push_back(pipeline.subject<rt::Event>("receiver.status")->subscribe([this, index](const rt::Event &event) {
+            updatePipelineStatus(index, event);
+
+            // primary receiver is the one shown in user interface
+            if (index == 0)
+               receiverStatus->next(event, true);
+
+            notify();
+         }));
+
+         if (index == 0)
+         {
+            subscriptions.push_back(pipeline.subject<rt::Event>("decoder.status")->subscribe([this](const rt::Event &event) {
+               decoderStatus->next(event, true);
+            }));
+
+            subscriptions.push_back(pipeline.subject<sdr::SignalBuffer>("signal.raw")->subscribe([this](const sdr::SignalBuffer &buffer) {
+               signalRvStream->next(buffer);
+            }));
+
+            subscriptions.push_back(pipeline.subject<sdr::SignalBuffer>("signal.iq")->subscribe([this](const sdr::SignalBuffer &buffer) {
+               signalIqStream->next(buffer);
+            }));
+         }
+      }
+
+      // commands for global receiver and decoder are forwarded to all pipelines
+      subscriptions.push_back(context.subject<rt::Event>("receiver.command")->subscribe([this](const rt::Event &command) {
+         receiverQueue.add(command);
+         notify();
+      }));
+
+      subscriptions.push_back(context.subject<rt::Event>("decoder.command")->subscribe([this](const rt::Event &command) {
+         decoderQueue.add(command);
+         notify();
+      }));
+   }
+
+   void start() override
+   {
+      log.info("group started with {} pipelines", {(int) pipelines.size()});
+   }
+
+   void stop() override
+   {
+      subscriptions.clear();
+   }
+
+   bool loop() override
+   {
+      /*
+       * process pending commands
+       */
+      if (auto command = commandQueue.get())
+      {
+         log.debug("group command [{}]", {command->code});
+
+         if (command->code == PipelineGroupTask::Query)
+         {
+            command->resolve();
+
+            updateGroupStatus();
+         }
+         else if (command->code == PipelineGroupTask::Configure)
+         {
+            configGroup(command.value());
+         }
+      }
+
+      /*
+       * forward global commands to pipelines
+       */
+      if (auto command = receiverQueue.get())
+      {
+         forwardReceiver(command.value());
+      }
+
+      if (auto command = decoderQueue.get())
+      {
+         forwardDecoder(command.value());
+      }
+
+      /*
+       * follow receiver changes and merge decoded frames
+       */
+      refreshDecoders();
+
+      collectFrames();
+
+      mergeFrames();
+
+      auto now = std::chrono::steady_clock::now();
+
+      if (now - lastStatus > std::chrono::milliseconds(STATUS_INTERVAL))
+      {
+         updateGroupStatus();
+      }
+
+      /*
+       * sleep until new commands, frames, merge window expiration or next status
+       */
+      if (!commandQueue.size() && !receiverQueue.size() && !decoderQueue.size())
+      {
+         auto timeout = lastStatus + std::chrono::milliseconds(STATUS_INTERVAL);
+
+         for (const auto &pipeline: pipelines)
+         {
+            if (!pipeline.frames.empty() && pipeline.frames.front().second + std::chrono::milliseconds(mergeWindow) < timeout)
+               timeout = pipeline.frames.front().second + std::chrono::milliseconds(mergeWindow);
+         }
+
+         wait(int(std::max<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(timeout - now).count(), 0)) + 1);
+      }
+
+      return true;
+   }
+
+   void configGroup(const rt::Event &command)
+   {
+      if (auto data = command.get<std::string>("data"))
+      {
+         auto config = json::parse(data.value());
+
+         log.info("change group config: {}", {config.dump()});
+
+         if (config.contains("mergeWindow"))
+            mergeWindow = std::max(0, (int) config["mergeWindow"]);
+
+         command.resolve();
+
+         updateGroupStatus();
+
+         return;
+      }
+
+      command.reject();
+   }
+
+   // pipeline command, only primary pipeline resolves the original command
+   static rt::Event forward(const rt::Event &command, bool primary, const std::string &data = {})
+   {
+      rt::Event event = primary ? rt::Event(command.code, [command] { command.resolve(); }, [command] { command.reject(); }) : rt::Event(command.code);
+
+      if (!data.empty())
+         event.put("data", data);
+      else if (auto value = command.get<std::string>("data"))
+         event.put("data", value.value());
+
+      return event;
+   }
+
+   void forwardReceiver(const rt::Event &command)
+   {
+      for (unsigned int index = 0; index < pipelines.size(); index++)
+      {
+         // device settings are type specific, secondary receivers keep their defaults
+         if (command.code == SignalReceiverTask::Configure && index > 0)
+            continue;
+
+         pipelines[index].receiverCommand->next(forward(command, index == 0));
+      }
+   }
+
+   void forwardDecoder(const rt::Event &command)
+   {
+      if (command.code == FrameDecoderTask::Configure)
+      {
+         if (auto data = command.get<std::string>("data"))
+         {
+            auto config = json::parse(data.value());
+
+            if (decoderConfig.is_object())
+               decoderConfig.update(config);
+            else
+               decoderConfig = config;
+         }
+
+         for (unsigned int index = 0; index < pipelines.size(); index++)
+         {
+            pipelines[index].decoderCommand->next(forward(command, index == 0, decoderConfigFor(index)));
+         }
+
+         return;
+      }
+
+      // new decoding session, stream times start again
+      if (command.code == FrameDecoderTask::Start)
+      {
+         for (auto &pipeline: pipelines)
+            pipeline.origin = NAN;
+
+         lastMerged = -INFINITY;
+      }
+
+      for (unsigned int index = 0; index < pipelines.size(); index++)
+      {
+         pipelines[index].decoderCommand->next(forward(command, index == 0));
+      }
+   }
+
+   // decoder configuration for a pipeline, secondary decoders follow their own receiver parameters
+   std::string decoderConfigFor(unsigned int index)
+   {
+      json config = decoderConfig;
+
+      auto &pipeline = pipelines[index];
+
+      if (index > 0)
+      {
+         std::lock_guard<std::mutex> lock(statusMutex);
+
+         auto &status = pipeline.receiverStatus;
+
+         if (status.contains("sampleRate") && status["sampleRate"] > 0)
+            config["sampleRate"] = status["sampleRate"];
+
+         if (status.contains("streamTime"))
+            config["streamTime"] = status["streamTime"];
+      }
+
+      if (config.contains("sampleRate"))
+         pipeline.sampleRate = config["sampleRate"];
+
+      if (config.contains("streamTime"))
+         pipeline.streamTime = config["streamTime"];
+
+      return config.dump();
+   }
+
+   // reconfigure secondary decoders when their receiver parameters change
+   void refreshDecoders()
+   {
+      if (!decoderConfig.is_object())
+         return;
+
+      for (unsigned int index = 1; index < pipelines.size(); index++)
+      {
+         auto &pipeline = pipelines[index];
+
+         long sampleRate, streamTime;
+
+         {
+            std::lock_guard<std::mutex> lock(statusMutex);
+
+            sampleRate = pipeline.receiverStatus.value("sampleRate", 0L);
+            streamTime = pipeline.receiverStatus.value("streamTime", 0L);
+         }
+
+         if ((sampleRate > 0 && sampleRate != pipeline.sampleRate) || streamTime != pipeline.streamTime)
+         {
+            log.info("pipeline {} receiver changed, sample rate {} stream time {}", {pipeline.context.name(), sampleRate, streamTime});
+
+            pipeline.decoderCommand->next({FrameDecoderTask::Configure, {{"data", decoderConfigFor(index)}}});
+         }
+      }
+   }
+
+   void updatePipelineStatus(unsigned int index, const rt::Event &event)
+   {
+      if (auto data = event.get<std::string>("data"))
+      {
+         auto status = json::parse(data.value());
+         auto now = std::chrono::steady_clock::now();
+
+         std::lock_guard<std::mutex> lock(statusMutex);
+
+         auto &pipeline = pipelines[index];
+
+         // throughput between consecutive receiver reports
+         if (status.contains("samplesReceived") && pipeline.receiverStatus.contains("samplesReceived"))
+         {
+            long samples = (long) status["samplesReceived"] - (long) pipeline.receiverStatus["samplesReceived"];
+            double elapsed = std::chrono::duration<double>(now - pipeline.lastStatus).count();
+
+            if (samples >= 0 && elapsed > 0)
+               pipeline.throughput = samples / elapsed;
+         }
+
+         pipeline.receiverStatus = status;
+         pipeline.lastStatus = now;
+      }
+   }
+
+   void collectFrames()
+   {
+      std::vector<std::tuple<unsigned int, nfc::NfcFrame, Arrival>> incoming;
+
+      {
+         std::lock_guard<std::mutex> lock(inboxMutex);
+         incoming.swap(inbox);
+      }
+
+      for (auto &entry: incoming)
+      {
+         auto &pipeline = pipelines[std::get<0>(entry)];
+         auto &frame = std::get<1>(entry);
+
+         // capture time is taken when the buffer completing the frame arrives, lowest delay gives best stream start estimation
+         if (frame.captureTime())
+         {
+            double origin = double(frame.captureTime()) / 1E9 - frame.timeEnd();
+
+            if (std::isnan(pipeline.origin) || origin < pipeline.origin)
+               pipeline.origin = origin;
+         }
+
+         pipeline.frames.emplace_back(std::move(frame), std::get<2>(entry));
+      }
+   }
+
+   // frame time in steady clock seconds, common to all pipelines
+   static double frameTime(const Pipeline &pipeline, const nfc::NfcFrame &frame, const Arrival &arrival)
+   {
+      if (!std::isnan(pipeline.origin))
+         return pipeline.origin + frame.timeStart();
+
+      return std::chrono::duration<double>(arrival.time_since_epoch()).count();
+   }
+
+   void mergeFrames()
+   {
+      auto now = std::chrono::steady_clock::now();
+
+      while (true)
+      {
+         unsigned int next = 0;
+         double nextTime = INFINITY;
+         bool complete = true;
+         bool expired = false;
+
+         // earliest frame from pipeline heads, frames within each pipeline are already ordered
+         for (unsigned int index = 0; index < pipelines.size(); index++)
+         {
+            auto &pipeline = pipelines[index];
+
+            if (pipeline.frames.empty())
+            {
+               complete = false;
+               continue;
+            }
+
+            auto &head = pipeline.frames.front();
+
+            double time = frameTime(pipeline, head.first, head.second);
+
+            if (time < nextTime)
+            {
+               next = index;
+               nextTime = time;
+            }
+
+            if (now - head.second >= std::chrono::milliseconds(mergeWindow))
+               expired = true;
+         }
+
+         // wait for all pipelines to have frames, or for merge window expiration
+         if (std::isinf(nextTime) || (!complete && !expired))
+            break;
+
+         auto &pipeline = pipelines[next];
+
+         nfc::NfcFrame frame = std::move(pipeline.frames.front().first);
+
+         pipeline.frames.pop_front();
+
+         if (nextTime < lastMerged)
+            lateFrames->add();
+         else
+            lastMerged = nextTime;
+
+         frame.setSourceId(next);
+
+         pipeline.merged++;
+         pipeline.mergedFrames->add();
+
+         frameStream->next(frame);
+      }
+
+      long pending = 0;
+
+      for (const auto &pipeline: pipelines)
+         pending += (long) pipeline.frames.size();
+
+      pendingFrames->set(pending);
+   }
+
+   void updateGroupStatus()
+   {
+      json data;
+
+      data["mergeWindow"] = mergeWindow;
+      data["pipelines"] = json::array();
+
+      std::lock_guard<std::mutex> lock(statusMutex);
+
+      for (unsigned int index = 0; index < pipelines.size(); index++)
+      {
+         auto &pipeline = pipelines[index];
+         auto &status = pipeline.receiverStatus;
+
+         json entry = {
+               {"sourceId",   index},
+               {"pipeline",   pipeline.context.name()},
+               {"device",     status.value("name", "")},
+               {"status",     status.value("status", "absent")},
+               {"sampleRate", status.value("sampleRate", 0L)},
+               {"throughput", pipeline.throughput},
+               {"samplesReceived", status.value("samplesReceived", 0L)},
+               {"samplesDropped", status.value("samplesDropped", 0L)},
+               {"framesMerged", pipeline.merged},
+               {"framesPending", pipeline.frames.size()}
+         };
+
+         if (status.contains("jitter"))
+            entry["jitter"] = status["jitter"];
+
+         data["pipelines"].push_back(entry);
+      }
+
+      updateStatus(PipelineGroupTask::Update, data);
+
+      lastStatus = std::chrono::steady_clock::now();
+   }
+};
+
+PipelineGroupTask::PipelineGroupTask() : rt::Worker("PipelineGroupTask")
+{
+}
+
+rt::Worker *PipelineGroupTask::construct(const std::vector<rt::Context> &pipelines)
+{
+   return new PipelineGroupTask::Impl(pipelines);
+}
+
+}
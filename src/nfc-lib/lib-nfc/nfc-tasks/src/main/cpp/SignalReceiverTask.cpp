@@ -28,14 +28,21 @@
 
 #endif
 
+#include <cmath>
+#include <mutex>
+
 #include <rt/Logger.h>
 #include <rt/Format.h>
 #include <rt/BlockingQueue.h>
 #include <rt/Throughput.h>
+#include <rt/Metrics.h>
+#include <rt/Tracer.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
+#include <sdr/AirspyDevice.h>
 #include <sdr/DeviceFactory.h>
+#include <sdr/RealtekDevice.h>
 
 #include <nfc/SignalReceiverTask.h>
 
@@ -51,6 +58,9 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
    // radio device
    std::shared_ptr<sdr::RadioDevice> receiver;
 
+   // device name prefix, empty for any device
+   std::string deviceFilter;
+
    // signal stream subject for raw data
    rt::Subject<sdr::SignalBuffer> *signalRvStream = nullptr;
 
@@ -75,10 +85,31 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
    // last control offset
    unsigned int receiverGainChange = 0;
 
-   Impl() : AbstractTask("SignalReceiverTask", "receiver")
+   // buffer arrival jitter statistics, updated from device thread
+   struct Jitter
    {
-      signalRvStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
-      signalIqStream = rt::Subject<sdr::SignalBuffer>::name("signal.iq");
+      std::mutex mutex;
+      std::chrono::time_point<std::chrono::steady_clock> lastArrival;
+      double sum = 0;
+      double max = 0;
+      long count = 0;
+      long dropped = 0;
+   } jitter;
+
+   // last jitter report for status
+   json jitterStatus;
+
+   // exported metrics
+   rt::Metrics::Counter *samplesReceived = rt::Metrics::counter("nfc_receiver_samples_total", "Samples received from radio device", labels());
+   rt::Metrics::Counter *samplesDropped = rt::Metrics::counter("nfc_receiver_samples_dropped_total", "Samples dropped by radio device", labels());
+   rt::Metrics::Gauge *queueDepth = rt::Metrics::gauge("nfc_receiver_queue_depth", "Signal buffers pending in receiver queue", labels());
+   rt::Metrics::Gauge *throughput = rt::Metrics::gauge("nfc_receiver_throughput_msps", "Receiver processing throughput in million samples per second", labels());
+   rt::Metrics::Histogram *arrivalJitter = rt::Metrics::histogram("nfc_receiver_jitter_microseconds", "Deviation between buffer arrival interval and buffer duration", labels());
+
+   explicit Impl(const rt::Context &context, std::string device) : SignalReceiverTask(context), AbstractTask(this, "SignalReceiverTask", "receiver", context), deviceFilter(std::move(device))
+   {
+      signalRvStream = context.subject<sdr::SignalBuffer>("signal.raw");
+      signalIqStream = context.subject<sdr::SignalBuffer>("signal.iq");
    }
 
    void start() override
@@ -132,10 +163,22 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
          if (receiver && receiver->isStreaming())
          {
             log.info("average throughput {.2} Msps", {taskThroughput.average() / 1E6});
+
+            reportJitter();
          }
       }
 
-      processQueue(50);
+      processQueue();
+
+      /*
+       * sleep until new commands, signal buffers or next device refresh
+       */
+      if (!commandQueue.size() && !signalQueue.size())
+      {
+         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastSearch).count();
+
+         wait(int(std::max<long long>(5000 - elapsed, 0)) + 1);
+      }
 
       return true;
    }
@@ -146,8 +189,20 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
 
       if (!receiver)
       {
-         // open first available receiver
+         std::vector<std::string> candidates;
+
          for (const auto &name: sdr::DeviceFactory::deviceList())
+         {
+            if (name.rfind(deviceFilter, 0) == 0)
+               candidates.push_back(name);
+         }
+
+         // devices that can not be discovered, like recordings, are opened by full name
+         if (candidates.empty() && deviceFilter.find("://") != std::string::npos)
+            candidates.push_back(deviceFilter);
+
+         // open first available receiver
+         for (const auto &name: candidates)
          {
             // create device instance
             receiver.reset(sdr::DeviceFactory::newInstance(name));
@@ -235,8 +290,22 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
          log.info("gain mode {} gain value {}", {receiverGainMode, receiverGainValue});
 
          // start receiving
+         // reset jitter statistics
+         {
+            std::lock_guard<std::mutex> lock(jitter.mutex);
+
+            jitter.lastArrival = {};
+            jitter.sum = 0;
+            jitter.max = 0;
+            jitter.count = 0;
+            jitter.dropped = receiver->samplesDropped();
+         }
+
          receiver->start([this](sdr::SignalBuffer &buffer) {
+            updateJitter(buffer);
+            samplesReceived->add(buffer.elements());
             signalQueue.add(buffer);
+            notify();
          });
 
          command.resolve();
@@ -323,6 +392,23 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
                   receiver->setGainValue(receiverGainValue);
                }
             }
+
+            // async transfer setup, only for local RTL-SDR devices
+            if (auto realtek = std::dynamic_pointer_cast<sdr::RealtekDevice>(receiver))
+            {
+               if (config.contains("transferCount"))
+                  realtek->setTransferCount(config["transferCount"]);
+
+               if (config.contains("transferSize"))
+                  realtek->setTransferSize(config["transferSize"]);
+            }
+
+            // raw or packed transfers, only for Airspy devices
+            if (auto airspy = std::dynamic_pointer_cast<sdr::AirspyDevice>(receiver))
+            {
+               if (config.contains("transferMode"))
+                  airspy->setTransferMode(config["transferMode"]);
+            }
          }
       }
 
@@ -331,6 +417,64 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
       updateReceiverStatus(SignalReceiverTask::Config);
    }
 
+   void updateJitter(const sdr::SignalBuffer &buffer)
+   {
+      auto now = std::chrono::steady_clock::now();
+
+      std::lock_guard<std::mutex> lock(jitter.mutex);
+
+      if (jitter.lastArrival.time_since_epoch().count() && buffer.sampleRate())
+      {
+         // deviation between real arrival interval and buffer duration, in microseconds
+         double interval = std::chrono::duration<double, std::micro>(now - jitter.lastArrival).count();
+         double expected = 1E6 * buffer.elements() / buffer.sampleRate();
+         double deviation = std::abs(interval - expected);
+
+         jitter.sum += deviation;
+         jitter.count++;
+
+         arrivalJitter->add((unsigned long long) deviation);
+
+         if (deviation > jitter.max)
+            jitter.max = deviation;
+      }
+
+      jitter.lastArrival = now;
+   }
+
+   void reportJitter()
+   {
+      double average, maximum;
+      long dropped;
+
+      {
+         std::lock_guard<std::mutex> lock(jitter.mutex);
+
+         average = jitter.count ? jitter.sum / jitter.count : 0;
+         maximum = jitter.max;
+         dropped = receiver->samplesDropped() - jitter.dropped;
+
+         // restart measure window
+         jitter.sum = 0;
+         jitter.max = 0;
+         jitter.count = 0;
+         jitter.dropped = receiver->samplesDropped();
+      }
+
+      log.info("buffer jitter average {.1} us, maximum {.1} us, dropped {} samples", {average, maximum, dropped});
+
+      if (dropped > 0)
+         samplesDropped->add(dropped);
+
+      throughput->set(taskThroughput.average() / 1E6);
+
+      jitterStatus = {
+            {"average", average},
+            {"maximum", maximum},
+            {"dropped", dropped}
+      };
+   }
+
    void updateReceiverStatus(int event)
    {
       json data;
@@ -357,6 +501,10 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
          data["samplesReceived"] = receiver->samplesReceived();
          data["samplesDropped"] = receiver->samplesDropped();
 
+         // last jitter report
+         if (!jitterStatus.is_null())
+            data["jitter"] = jitterStatus;
+
          // send capabilities on data attach
          if (event == SignalReceiverTask::Attach)
          {
@@ -403,13 +551,22 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
       updateStatus(event, data);
    }
 
-   void processQueue(int timeout)
+   void processQueue()
    {
-      if (auto entry = signalQueue.get(timeout))
+      queueDepth->set(signalQueue.size());
+
+      if (auto entry = signalQueue.get())
       {
-         sdr::SignalBuffer buffer = entry.value();
+         sdr::SignalBuffer buffer = std::move(entry.value());
          sdr::SignalBuffer result(buffer.elements(), 1, buffer.sampleRate(), buffer.offset(), 0, sdr::SignalType::SAMPLE_REAL);
 
+         // real value buffer keeps capture time and id of source samples
+         result.setCaptureTime(buffer.captureTime());
+         result.setId(buffer.id());
+
+         // buffer consumers are linked to this span by buffer id
+         rt::Tracer::Scope scope("convert", "receiver", buffer.id(), rt::Tracer::FlowOut);
+
          float *src = buffer.data();
          float *dst = result.pull(buffer.elements());
          float avrg = 0;
@@ -521,13 +678,13 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
    }
 };
 
-SignalReceiverTask::SignalReceiverTask() : rt::Worker("SignalReceiverTask")
+SignalReceiverTask::SignalReceiverTask(const rt::Context &context) : rt::Worker(context.qualify("SignalReceiverTask"))
 {
 }
 
-rt::Worker *SignalReceiverTask::construct()
+rt::Worker *SignalReceiverTask::construct(const rt::Context &context, const std::string &device)
 {
-   return new SignalReceiverTask::Impl;
+   return new SignalReceiverTask::Impl(context, device);
 }
 
 }
\ No newline at end of file
@@ -29,6 +29,9 @@
 #endif
 
 #include <rt/Logger.h>
+#include <rt/Metrics.h>
+#include <rt/Qos.h>
+#include <rt/Tracer.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
@@ -38,6 +41,9 @@
 
 #include "AbstractTask.h"
 
+// signal buffers written per loop before checking commands again
+#define WRITE_BATCH_SIZE 32
+
 namespace nfc {
 
 struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
@@ -62,11 +68,28 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
    // record device
    std::shared_ptr<sdr::RecordDevice> device;
 
-   Impl() : AbstractTask("SignalRecorderTask", "recorder"), status(SignalRecorderTask::Idle)
+   // exported metrics
+   rt::Metrics::Gauge *queueDepth = rt::Metrics::gauge("nfc_recorder_queue_depth", "Signal buffers pending in recorder queue", labels());
+   rt::Metrics::Counter *samplesWritten = rt::Metrics::counter("nfc_recorder_samples_total", "Samples written to record file", labels());
+   rt::Metrics::Counter *bytesWritten = rt::Metrics::counter("nfc_recorder_write_bytes_total", "Bytes stored in record file", labels());
+   rt::Metrics::Counter *writeStalls = rt::Metrics::counter("nfc_recorder_write_stall_microseconds_total", "Time spent waiting for record file writer", labels());
+   rt::Metrics::Gauge *writeBandwidth = rt::Metrics::gauge("nfc_recorder_write_bandwidth_mbps", "Record file write bandwidth in megabytes per second", labels());
+   rt::Metrics::Gauge *writeBacklog = rt::Metrics::gauge("nfc_recorder_write_backlog_bytes", "Bytes pending in record file writer", labels());
+   rt::Metrics::Gauge *compressionRatio = rt::Metrics::gauge("nfc_recorder_compression_ratio", "Sample bytes per stored byte in record file", labels());
+
+   // last write statistics
+   std::chrono::time_point<std::chrono::steady_clock> lastThroughput;
+   long long lastBytes = 0;
+   long long lastStall = 0;
+
+   // pending signal reported to load shedding, recorder is a critical consumer
+   rt::Qos::Backlog *backlog = rt::Qos::backlog(context.qualify("recorder"));
+
+   explicit Impl(const rt::Context &context) : SignalRecorderTask(context), AbstractTask(this, "SignalRecorderTask", "recorder", context), status(SignalRecorderTask::Idle)
    {
       // access to signal subject stream
-      signalIqStream = rt::Subject<sdr::SignalBuffer>::name("signal.iq");
-      signalRvStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
+      signalIqStream = context.subject<sdr::SignalBuffer>("signal.iq");
+      signalRvStream = context.subject<sdr::SignalBuffer>("signal.raw");
 
       // subscribe to signal events
 //      signalIqSubscription = signalIqStream->subscribe([this](const sdr::SignalBuffer &buffer) {
@@ -76,7 +99,10 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
 
       signalRvSubscription = signalRvStream->subscribe([this](const sdr::SignalBuffer &buffer) {
          if (status == SignalRecorderTask::Writing || status == SignalRecorderTask::Capture)
+         {
             signalQueue.add(buffer);
+            notify();
+         }
       });
    }
 
@@ -139,9 +165,13 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
       {
          signalReplay();
       }
-      else
+
+      /*
+       * file reading runs free, other states sleep until new commands or signal buffers are received
+       */
+      if (status != SignalRecorderTask::Reading && !commandQueue.size() && (status != SignalRecorderTask::Writing || !signalQueue.size()))
       {
-         wait(50);
+         wait();
       }
 
       /*
@@ -173,6 +203,15 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
             {
                if (device->channelCount() <= 2)
                {
+                  // optional start position in seconds from beginning of file
+                  if (config.contains("startTime"))
+                  {
+                     double startTime = config["startTime"];
+
+                     if (!device->seek((long long) (startTime * device->sampleRate())))
+                        log.warn("unable to seek file [{}] to {} seconds", {device->name(), startTime});
+                  }
+
                   log.info("streaming started for file [{}]", {device->name()});
 
                   command.resolve();
@@ -232,10 +271,54 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
             else
                device->setChannelCount(1);
 
+            // sample format, u8, s16, s24, s32 or f32, default s16
+            if (config.contains("sampleFormat"))
+            {
+               std::string format = config["sampleFormat"];
+
+               if (format == "f32")
+               {
+                  device->setSampleType(sdr::SignalDevice::Float);
+                  device->setSampleSize(32);
+               }
+               else if (format == "u8" || format == "s16" || format == "s24" || format == "s32")
+               {
+                  device->setSampleType(sdr::SignalDevice::Integer);
+                  device->setSampleSize(std::stoi(format.substr(1)));
+               }
+               else
+               {
+                  log.warn("unknown sample format {}, using s16", {format});
+               }
+            }
+
+            if (config.contains("dither"))
+               device->setDitherEnabled(config["dither"]);
+
+            // optional rotation into numbered files, size in megabytes and time in seconds
+            if (config.contains("segmentSize"))
+               device->setSegmentSize((long long) config["segmentSize"] * 1024 * 1024);
+
+            if (config.contains("segmentTime"))
+               device->setSegmentTime(config["segmentTime"]);
+
+            // lossless compressed container instead of WAV, integer samples up to 24 bits only
+            if (config.contains("compress") && config["compress"])
+            {
+               if (device->sampleType() == sdr::SignalDevice::Integer && device->sampleSize() <= 24)
+                  device->setCompressed(true);
+               else
+                  log.warn("compressed recording does not support {} bit {} samples, recording WAV", {device->sampleSize(), device->sampleType() == sdr::SignalDevice::Float ? "float" : "integer"});
+            }
+
             signalQueue.clear();
 
             if (device->open(sdr::SignalDevice::Write))
             {
+               lastBytes = 0;
+               lastStall = 0;
+               lastThroughput = std::chrono::steady_clock::now();
+
                log.info("enable recording {}", {device->name()});
 
                command.resolve();
@@ -295,7 +378,7 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
       {
          int sampleRate = device->sampleRate();
          int channelCount = device->channelCount();
-         int sampleOffset = device->sampleOffset();
+         long long sampleOffset = device->sampleOffset();
 
          switch (channelCount)
          {
@@ -405,16 +488,62 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
    {
       if (device && device->isOpen())
       {
-         if (auto buffer = signalQueue.get())
+         queueDepth->set(signalQueue.size());
+
+         // drain pending buffers in batches, device only copies into writer blocks
+         for (int i = 0; i < WRITE_BATCH_SIZE; i++)
          {
+            auto buffer = signalQueue.get();
+
+            if (!buffer)
+               break;
+
+            if (buffer->sampleRate())
+               backlog->update((long long) signalQueue.size() * buffer->elements() * 1000000LL / buffer->sampleRate());
+
             if (!buffer->isEmpty())
             {
+               rt::Tracer::Scope scope("write", "recorder", buffer->id(), rt::Tracer::FlowIn);
+
                device->write(buffer.value());
+
+               samplesWritten->add(buffer->elements());
             }
          }
+
+         if ((std::chrono::steady_clock::now() - lastThroughput) > std::chrono::milliseconds(1000))
+         {
+            updateWriteStatistics();
+         }
       }
    }
 
+   void updateWriteStatistics()
+   {
+      auto now = std::chrono::steady_clock::now();
+
+      long long bytes = device->writeBytes();
+      long long stall = device->writeStallTime();
+
+      double elapsed = std::chrono::duration<double>(now - lastThroughput).count();
+
+      if (bytes >= lastBytes && stall >= lastStall)
+      {
+         bytesWritten->add(bytes - lastBytes);
+         writeStalls->add(stall - lastStall);
+         writeBandwidth->set((bytes - lastBytes) / elapsed / 1E6);
+      }
+
+      writeBacklog->set(device->writeBacklog());
+      compressionRatio->set(device->compressionRatio());
+
+      log.info("write bandwidth {.2} MB/s, backlog {} bytes, stalled {} ms, compression ratio {.2}", {(bytes - lastBytes) / elapsed / 1E6, device->writeBacklog(), (stall - lastStall) / 1000, device->compressionRatio()});
+
+      lastBytes = bytes;
+      lastStall = stall;
+      lastThroughput = now;
+   }
+
    void signalCapture()
    {
    }
@@ -425,7 +554,17 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
 
    void close()
    {
+      // account data flushed on close
+      if (device && status == SignalRecorderTask::Writing)
+      {
+         device->close();
+
+         updateWriteStatistics();
+      }
+
       device.reset();
+
+      backlog->update(0);
    }
 
    void updateRecorderStatus(int value)
@@ -464,6 +603,8 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
          data["sampleSize"] = device->sampleSize();
          data["sampleType"] = device->sampleType();
          data["streamTime"] = device->streamTime();
+         data["segmentCount"] = device->segmentCount();
+         data["compressed"] = device->isCompressed();
       }
 
       log.info("updated recorder status: {}", {data.dump()});
@@ -474,13 +615,13 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
    }
 };
 
-SignalRecorderTask::SignalRecorderTask() : rt::Worker("SignalRecorderTask")
+SignalRecorderTask::SignalRecorderTask(const rt::Context &context) : rt::Worker(context.qualify("SignalRecorderTask"))
 {
 }
 
-rt::Worker *SignalRecorderTask::construct()
+rt::Worker *SignalRecorderTask::construct(const rt::Context &context)
 {
-   return new SignalRecorderTask::Impl;
+   return new SignalRecorderTask::Impl(context);
 }
 
 }
@@ -25,6 +25,7 @@
 #ifndef NFC_LAB_ADAPTIVESAMPLINGTASK_H
 #define NFC_LAB_ADAPTIVESAMPLINGTASK_H
 
+#include <rt/Context.h>
 #include <rt/Worker.h>
 
 namespace nfc {
@@ -35,11 +36,12 @@ class AdaptiveSamplingTask : public rt::Worker
 
       struct Impl;
 
-      AdaptiveSamplingTask();
+      explicit AdaptiveSamplingTask(const rt::Context &context);
 
    public:
 
-      static rt::Worker *construct();
+      // tasks built with the same context are connected together, default is the global context
+      static rt::Worker *construct(const rt::Context &context = {});
 };
 
 }
@@ -25,6 +25,7 @@
 #ifndef NFC_FOURIERPROCESSTASK_H
 #define NFC_FOURIERPROCESSTASK_H
 
+#include <rt/Context.h>
 #include <rt/Worker.h>
 
 namespace nfc {
@@ -50,11 +51,12 @@ class FourierProcessTask : public rt::Worker
 
       struct Impl;
 
-      FourierProcessTask();
+      explicit FourierProcessTask(const rt::Context &context);
 
    public:
 
-      static rt::Worker *construct();
+      // tasks built with the same context are connected together, default is the global context
+      static rt::Worker *construct(const rt::Context &context = {});
 };
 
 }
@@ -0,0 +1,114 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_FRAMECOMPACTOR_H
+#define NFC_FRAMECOMPACTOR_H
+
+#include <list>
+#include <memory>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Streaming run-length compactor for idle polling. Readers with no card in field repeat the same cycle of
+ * poll and carrier frames indefinitely; once a cycle of up to 16 frames has been seen minimumRepeats times
+ * in a row, further repetitions are suppressed and reported as one summary frame per cycle member, with
+ * repeatCount occurrences spanning from first to last suppressed one at mean repeatPeriod. Any listen frame
+ * or change in the cycle ends the run, so card responses and the polls preceding them pass unchanged.
+ * Disabled by default, consumers of the frame stream receive summaries in place of the suppressed frames and
+ * use FrameExpander where the individual frames are needed.
+ */
+class FrameCompactor
+{
+      struct Impl;
+
+   public:
+
+      FrameCompactor();
+
+      bool isEnabled() const;
+
+      void setEnabled(bool enabled);
+
+      int minimumRepeats() const;
+
+      void setMinimumRepeats(int repeats);
+
+      // seconds of signal time after which an ongoing run is reported, zero reports only when run ends
+      double summaryInterval() const;
+
+      void setSummaryInterval(double seconds);
+
+      // process decoded frames, returns frames to publish
+      std::list<NfcFrame> nextFrames(const std::list<NfcFrame> &frames);
+
+      // ends current run, returns pending summaries
+      std::list<NfcFrame> flush();
+
+      // drops current run and cycle history
+      void reset();
+
+      // frames suppressed since creation
+      long long suppressed() const;
+
+      // expands summary frame into its individual occurrences, other frames are returned as is
+      static std::list<NfcFrame> expand(const NfcFrame &frame);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+/*
+ * Restores the individual frames of a compacted stream. Summaries reported together overlap in time, so
+ * expanded occurrences and later frames are held until no pending occurrence can precede them, and are
+ * returned in time order.
+ */
+class FrameExpander
+{
+      struct Impl;
+
+   public:
+
+      FrameExpander();
+
+      // next frames in time order, frames overlapping pending summaries are held back
+      std::list<NfcFrame> nextFrames(const NfcFrame &frame);
+
+      // returns all held frames
+      std::list<NfcFrame> flush();
+
+      // drops held frames
+      void reset();
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -25,6 +25,7 @@
 #ifndef NFC_SIGNALDECODERTASK_H
 #define NFC_SIGNALDECODERTASK_H
 
+#include <rt/Context.h>
 #include <rt/Worker.h>
 
 namespace nfc {
@@ -52,11 +53,12 @@ class FrameDecoderTask : public rt::Worker
 
       struct Impl;
 
-      FrameDecoderTask();
+      explicit FrameDecoderTask(const rt::Context &context);
 
    public:
 
-      static rt::Worker *construct();
+      // tasks built with the same context are connected together, default is the global context
+      static rt::Worker *construct(const rt::Context &context = {});
 };
 
 }
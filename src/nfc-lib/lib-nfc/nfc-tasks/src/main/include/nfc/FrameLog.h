@@ -0,0 +1,92 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_FRAMELOG_H
+#define NFC_FRAMELOG_H
+
+#include <memory>
+#include <string>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Append-only binary frame log, fixed header followed by delta encoded frame records. A sync block every
+ * SYNC_INTERVAL frames resets delta encoding so readers can resume after a damaged record, and an index of
+ * sync blocks plus a fixed trailer are appended on close. Files not closed properly are still readable.
+ */
+class FrameLog
+{
+      struct Impl;
+
+   public:
+
+      enum OpenMode
+      {
+         Read = 1,
+         Write = 2
+      };
+
+   public:
+
+      explicit FrameLog(const std::string &name);
+
+      const std::string &name() const;
+
+      bool open(OpenMode mode);
+
+      void close();
+
+      bool isOpen() const;
+
+      bool isEof() const;
+
+      // sample rate of source signal, stored in header and updated in place while writing
+      unsigned int sampleRate() const;
+
+      void setSampleRate(unsigned int value);
+
+      // number of frames written or read so far
+      long frameCount() const;
+
+      // reads next frame, false at end of file
+      bool read(NfcFrame &frame);
+
+      bool write(const NfcFrame &frame);
+
+      // push buffered records to disk
+      void flush();
+
+      // returns true if file starts with a frame log header
+      static bool isFrameLog(const std::string &name);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -25,6 +25,7 @@
 #ifndef NFC_FRAMESTORAGETASK_H
 #define NFC_FRAMESTORAGETASK_H
 
+#include <rt/Context.h>
 #include <rt/Worker.h>
 
 namespace nfc {
@@ -37,7 +38,8 @@ class FrameStorageTask : public rt::Worker
       {
          Clear,
          Read,
-         Write
+         Write,
+         Configure
       };
 
       enum Status
@@ -48,11 +50,12 @@ class FrameStorageTask : public rt::Worker
 
       struct Impl;
 
-      FrameStorageTask();
+      explicit FrameStorageTask(const rt::Context &context);
 
    public:
 
-      static rt::Worker *construct();
+      // tasks built with the same context are connected together, default is the global context
+      static rt::Worker *construct(const rt::Context &context = {});
 };
 
 }
@@ -0,0 +1,112 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_FRAMESTORE_H
+#define NFC_FRAMESTORE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Columnar in-memory frame store. Frames are kept in fixed size blocks, one array per attribute plus a
+ * payload arena, with per-block summaries of tech / type / flags counts. Frames are expected in time
+ * order, so time range lookups are binary searches; out of order appends only slow down lookups in the
+ * blocks they were appended to.
+ * With retention limits set, oldest full blocks are moved to a spill file and read back on access, so
+ * resident memory stays bounded while all frames remain addressable by index. If the spill file can't be
+ * created or written, new frames are refused while limits are exceeded and counted by refusedSize.
+ * Not thread safe, callers sharing a store between threads must serialize access.
+ */
+class FrameStore
+{
+      struct Impl;
+
+   public:
+
+      FrameStore();
+
+      void append(const NfcFrame &frame);
+
+      void clear();
+
+      size_t size() const;
+
+      bool isEmpty() const;
+
+      // approximate memory held by resident columns and payload
+      size_t bytes() const;
+
+      // frames held in memory, excluding blocks read back from spill file
+      size_t residentSize() const;
+
+      // frames not stored because limits were exceeded and spill file failed
+      size_t refusedSize() const;
+
+      // resident limits by frame count, seconds behind newest frame and bytes, zero disables each one
+      void setRetention(size_t frames, double seconds, size_t bytes);
+
+      // folder for spill file, created if missing, current folder if empty
+      void setSpillPath(const std::string &path);
+
+      // materializes frame at index
+      NfcFrame frame(size_t index) const;
+
+      double timeStart(size_t index) const;
+
+      double timeEnd(size_t index) const;
+
+      unsigned int techType(size_t index) const;
+
+      unsigned int frameType(size_t index) const;
+
+      unsigned int frameFlags(size_t index) const;
+
+      // first frame starting at or after time
+      size_t lowerBound(double time) const;
+
+      // first frame starting after time
+      size_t upperBound(double time) const;
+
+      // frames starting between from and to, as [first, last) index range
+      std::pair<size_t, size_t> range(double from, double to) const;
+
+      // frames in [first, last) with given tech and frame type, -1 matches any
+      size_t count(size_t first, size_t last, int techType = -1, int frameType = -1) const;
+
+      // frames in [first, last) with any of given flags
+      size_t countFlags(size_t first, size_t last, unsigned int flags) const;
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_FRAMETRACE_H
+#define NFC_FRAMETRACE_H
+
+#include <memory>
+#include <string>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Streaming reader for JSON frame traces, {"frames": [{...}, ...]} as written by frame storage. Input is
+ * scanned in fixed size chunks and frames are returned one by one, so memory use does not depend on file
+ * size and first frames are available without parsing the whole document. Unknown members are skipped.
+ */
+class FrameTrace
+{
+      struct Impl;
+
+   public:
+
+      explicit FrameTrace(const std::string &name);
+
+      const std::string &name() const;
+
+      bool open();
+
+      void close();
+
+      bool isOpen() const;
+
+      bool isEof() const;
+
+      // number of frames read so far
+      long frameCount() const;
+
+      // reads next frame, false at end of frames array or on malformed input
+      bool read(NfcFrame &frame);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
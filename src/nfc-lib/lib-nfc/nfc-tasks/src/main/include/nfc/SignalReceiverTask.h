@@ -25,6 +25,7 @@
 #ifndef NFC_SIGNALRECEIVERTASK_H
 #define NFC_SIGNALRECEIVERTASK_H
 
+#include <rt/Context.h>
 #include <rt/Worker.h>
 
 namespace nfc {
@@ -54,11 +55,13 @@ class SignalReceiverTask : public rt::Worker
 
       struct Impl;
 
-      SignalReceiverTask();
+      explicit SignalReceiverTask(const rt::Context &context);
 
    public:
 
-      static rt::Worker *construct();
+      // tasks built with the same context are connected together, default is the global context
+      // device selects the receiver by name prefix, like "rtlsdr://" or "sim://capture.wav", default is first available
+      static rt::Worker *construct(const rt::Context &context = {}, const std::string &device = {});
 };
 
 }
@@ -25,6 +25,7 @@
 #ifndef NFC_SIGNALRECORDERTASK_H
 #define NFC_SIGNALRECORDERTASK_H
 
+#include <rt/Context.h>
 #include <rt/Worker.h>
 
 namespace nfc {
@@ -55,11 +56,12 @@ class SignalRecorderTask : public rt::Worker
 
       struct Impl;
 
-      SignalRecorderTask();
+      explicit SignalRecorderTask(const rt::Context &context);
 
    public:
 
-      static rt::Worker *construct();
+      // tasks built with the same context are connected together, default is the global context
+      static rt::Worker *construct(const rt::Context &context = {});
 };
 
 }
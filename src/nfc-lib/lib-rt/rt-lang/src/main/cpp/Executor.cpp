@@ -23,10 +23,11 @@
 */
 
 #include <atomic>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <list>
 #include <thread>
+#include <vector>
 #include <condition_variable>
 
 #include <rt/Logger.h>
@@ -37,6 +38,34 @@ namespace rt {
 
 struct Executor::Impl
 {
+   struct JobQueue
+   {
+      std::mutex mutex;
+      std::deque<Job> jobs;
+   };
+
+   struct ParallelRange
+   {
+      long begin;
+      long end;
+      long grain;
+      long chunks;
+
+      // next chunk to claim and number of finished chunks
+      std::atomic<long> next {0};
+      std::atomic<long> done {0};
+
+      // completion signal
+      std::mutex mutex;
+      std::condition_variable sync;
+
+      // first exception raised by any chunk
+      std::exception_ptr error;
+
+      // caller function, only accessed while holding a claimed chunk
+      const std::function<void(long, long)> *function;
+   };
+
    rt::Logger log {"Executor"};
 
    // max number of tasks in pool (waiting + running)
@@ -48,8 +77,14 @@ struct Executor::Impl
    // waiting group
    std::condition_variable threadSync;
 
-   // waiting tasks pool
-   BlockingQueue<std::shared_ptr<Task>> waitingTasks;
+   // per-thread job deques, owner pops from back, thieves steal from front
+   std::vector<std::unique_ptr<JobQueue>> localQueues;
+
+   // jobs submitted from outside the pool
+   JobQueue globalQueue;
+
+   // number of jobs waiting in any queue
+   std::atomic<int> pendingJobs;
 
    // current running tasks
    BlockingQueue<std::shared_ptr<Task>> runningTasks;
@@ -60,74 +95,244 @@ struct Executor::Impl
    // sync mutex
    std::mutex syncMutex;
 
-   Impl(int poolSize, int coreSize) : poolSize(poolSize), shutdown(false)
+   // pool and queue index of current thread
+   static thread_local Impl *currentPool;
+   static thread_local int currentIndex;
+
+   Impl(int poolSize, int coreSize) : poolSize(poolSize), pendingJobs(0), shutdown(false)
    {
       log.info("executor service starting width {} threads", {coreSize});
 
+      // create job queues before any thread can steal from them
+      for (int i = 0; i < coreSize; i++)
+      {
+         localQueues.emplace_back(new JobQueue());
+      }
+
       // create new thread group
       for (int i = 0; i < coreSize; i++)
       {
-         threadList.emplace_back([this] { this->exec(); });
+         threadList.emplace_back([this, i] { this->exec(i); });
       }
    }
 
-   void exec()
+   void exec(int index)
    {
       // get current thread id
       std::thread::id id = std::this_thread::get_id();
 
+      currentPool = this;
+      currentIndex = index;
+
       log.debug("worker thread {} started", {id});
 
       // main thread loop
       while (!shutdown)
       {
-         if (auto next = waitingTasks.get())
+         if (auto job = next(index))
          {
-            auto task = next.value();
-
-            runningTasks.add(task);
-
-            try
-            {
-               log.debug("task {} started in thread {}", {task->name(), id});
-
-               next.value()->run(); // call next handler
-
-               log.debug("task {} finished in thread {}", {task->name(), id});
-            }
-            catch (...)
-            {
-               log.error("unhandled task {} exception in thread {}", {task->name(), id});
-            }
-
-            // on shutdown process do not remove from list to avoid concurrent modification
-            if (!shutdown)
-            {
-               runningTasks.remove(task);
-            }
+            run(job);
          }
          else if (!shutdown)
          {
             // lock mutex before wait in condition variable
             std::unique_lock<std::mutex> lock(syncMutex);
 
-            // stop thread until is notified
-            threadSync.wait(lock);
+            // stop thread until new jobs are available
+            threadSync.wait(lock, [this] { return pendingJobs > 0 || shutdown; });
          }
       }
 
       log.debug("executor thread {} terminated", {id});
    }
 
+   Job next(int index)
+   {
+      if (!pendingJobs)
+         return nullptr;
+
+      // first local jobs in LIFO order, they are hot in cache
+      if (index >= 0)
+      {
+         if (auto job = take(*localQueues[index], true))
+            return job;
+      }
+
+      // then jobs submitted from outside
+      if (auto job = take(globalQueue, false))
+         return job;
+
+      // finally steal oldest job from other threads
+      for (int i = 1, n = (int) localQueues.size(); i <= n; i++)
+      {
+         int victim = (index + i) % n;
+
+         if (victim != index)
+         {
+            if (auto job = take(*localQueues[victim], false))
+               return job;
+         }
+      }
+
+      return nullptr;
+   }
+
+   Job take(JobQueue &queue, bool back)
+   {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+
+      if (queue.jobs.empty())
+         return nullptr;
+
+      Job job;
+
+      if (back)
+      {
+         job = std::move(queue.jobs.back());
+         queue.jobs.pop_back();
+      }
+      else
+      {
+         job = std::move(queue.jobs.front());
+         queue.jobs.pop_front();
+      }
+
+      pendingJobs--;
+
+      return job;
+   }
+
+   void run(Job &job)
+   {
+      try
+      {
+         job();
+      }
+      catch (...)
+      {
+         log.error("unhandled job exception in thread {}", {std::this_thread::get_id()});
+      }
+   }
+
+   void execute(Job job)
+   {
+      if (shutdown)
+         return;
+
+      JobQueue &queue = currentPool == this ? *localQueues[currentIndex] : globalQueue;
+
+      {
+         std::lock_guard<std::mutex> lock(queue.mutex);
+
+         queue.jobs.push_back(std::move(job));
+
+         pendingJobs++;
+      }
+
+      // sync with waiting threads to avoid lost wake-ups
+      {
+         std::lock_guard<std::mutex> lock(syncMutex);
+      }
+
+      // only one thread is needed for one job
+      threadSync.notify_one();
+   }
+
    void submit(Task *task)
    {
-      if (!shutdown)
+      std::shared_ptr<Task> shared(task);
+
+      execute([this, shared] {
+
+         std::thread::id id = std::this_thread::get_id();
+
+         runningTasks.add(shared);
+
+         try
+         {
+            log.debug("task {} started in thread {}", {shared->name(), id});
+
+            shared->run(); // call next handler
+
+            log.debug("task {} finished in thread {}", {shared->name(), id});
+         }
+         catch (...)
+         {
+            log.error("unhandled task {} exception in thread {}", {shared->name(), id});
+         }
+
+         // on shutdown process do not remove from list to avoid concurrent modification
+         if (!shutdown)
+         {
+            runningTasks.remove(shared);
+         }
+      });
+   }
+
+   void parallelFor(long begin, long end, long grain, const std::function<void(long, long)> &function)
+   {
+      if (end <= begin)
+         return;
+
+      if (grain < 1)
+         grain = 1;
+
+      auto range = std::make_shared<ParallelRange>();
+
+      range->begin = begin;
+      range->end = end;
+      range->grain = grain;
+      range->chunks = (end - begin + grain - 1) / grain;
+      range->function = &function;
+
+      // single chunk runs inline
+      if (range->chunks > 1 && !shutdown)
       {
-         // add task to wait pool
-         waitingTasks.add(task);
+         long helpers = std::min<long>(range->chunks - 1, (long) localQueues.size());
 
-         // notify waiting threads
-         threadSync.notify_all();
+         for (long i = 0; i < helpers; i++)
+         {
+            execute([range] { process(*range); });
+         }
+      }
+
+      // calling thread participates, so waiting never depends on free pool threads
+      process(*range);
+
+      // wait for chunks claimed by other threads
+      std::unique_lock<std::mutex> lock(range->mutex);
+
+      range->sync.wait(lock, [&range] { return range->done == range->chunks; });
+
+      if (range->error)
+         std::rethrow_exception(range->error);
+   }
+
+   static void process(ParallelRange &range)
+   {
+      for (long chunk = range.next++; chunk < range.chunks; chunk = range.next++)
+      {
+         long from = range.begin + chunk * range.grain;
+         long to = std::min(range.end, from + range.grain);
+
+         try
+         {
+            (*range.function)(from, to);
+         }
+         catch (...)
+         {
+            std::lock_guard<std::mutex> lock(range.mutex);
+
+            if (!range.error)
+               range.error = std::current_exception();
+         }
+
+         if (++range.done == range.chunks)
+         {
+            std::lock_guard<std::mutex> lock(range.mutex);
+
+            range.sync.notify_all();
+         }
       }
    }
 
@@ -147,7 +352,11 @@ struct Executor::Impl
       }
 
       // notify waiting threads
-      threadSync.notify_all();
+      {
+         std::lock_guard<std::mutex> lock(syncMutex);
+
+         threadSync.notify_all();
+      }
 
       log.info("waiting for completion of all threads");
 
@@ -162,13 +371,30 @@ struct Executor::Impl
          }
       }
 
-      // finally remove waiting tasks
-      waitingTasks.clear();
+      // finally remove waiting jobs
+      for (auto &queue : localQueues)
+      {
+         std::lock_guard<std::mutex> lock(queue->mutex);
+
+         queue->jobs.clear();
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(globalQueue.mutex);
+
+         globalQueue.jobs.clear();
+      }
+
+      pendingJobs = 0;
 
       log.info("all threads terminated, executor service shutdown completed!");
    }
 };
 
+thread_local Executor::Impl *Executor::Impl::currentPool = nullptr;
+
+thread_local int Executor::Impl::currentIndex = -1;
+
 Executor::Executor(int poolSize, int coreSize) : impl(std::make_shared<Impl>(poolSize, coreSize))
 {
 }
@@ -183,9 +409,40 @@ void Executor::submit(Task *task)
    impl->submit(task);
 }
 
+void Executor::execute(Job job)
+{
+   impl->execute(std::move(job));
+}
+
+void Executor::execute(Job job, Promise promise)
+{
+   impl->execute([job = std::move(job), promise = std::move(promise)] {
+      try
+      {
+         job();
+
+         promise.resolve();
+      }
+      catch (...)
+      {
+         promise.reject();
+      }
+   });
+}
+
+void Executor::parallelFor(long begin, long end, long grain, const std::function<void(long, long)> &function)
+{
+   impl->parallelFor(begin, end, grain, function);
+}
+
+int Executor::concurrency() const
+{
+   return (int) impl->localQueues.size();
+}
+
 void Executor::shutdown()
 {
    impl->terminate(0);
 }
 
-}
\ No newline at end of file
+}
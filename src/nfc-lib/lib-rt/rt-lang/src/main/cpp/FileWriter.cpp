@@ -0,0 +1,429 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include <rt/Logger.h>
+#include <rt/FileWriter.h>
+
+// block address, size and file offset alignment required by direct I/O
+#define IO_ALIGNMENT 4096
+
+namespace rt {
+
+struct FileWriter::Impl
+{
+   struct Block
+   {
+      unsigned char *data;
+      unsigned int size;
+   };
+
+   Logger log {"FileWriter"};
+
+   std::string name;
+   unsigned int blockSize;
+   unsigned int blockCount;
+
+   // block storage, raw allocations are kept for release
+   std::vector<void *> memory;
+   std::vector<Block> blocks;
+
+   // blocks ready for new data and blocks waiting for I/O thread
+   std::mutex mutex;
+   std::condition_variable freeCondition;
+   std::condition_variable fullCondition;
+   std::deque<Block *> freeBlocks;
+   std::deque<Block *> fullBlocks;
+
+   // block being filled by writer
+   Block *current = nullptr;
+
+   // state is also read from other threads through isOpen, isDirect and hasError
+   std::thread thread;
+   std::atomic<bool> running {false};
+   std::atomic<bool> direct {false};
+   std::atomic<bool> error {false};
+
+   std::atomic<long long> accepted {0};
+   std::atomic<long long> stored {0};
+   std::atomic<long long> stall {0};
+   std::atomic<long long> busy {0};
+
+#ifdef __linux__
+   int fd = -1;
+#else
+   FILE *file = nullptr;
+#endif
+
+   Impl(std::string name, unsigned int blockSize, unsigned int blockCount) :
+         name(std::move(name)),
+         blockSize(std::max((blockSize + IO_ALIGNMENT - 1) & ~(IO_ALIGNMENT - 1), (unsigned int) IO_ALIGNMENT)),
+         blockCount(std::max(blockCount, 2u))
+   {
+   }
+
+   ~Impl()
+   {
+      close();
+   }
+
+   bool open()
+   {
+      close();
+
+#ifdef __linux__
+      fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+
+      // filesystems such as tmpfs reject direct I/O
+      if (!(direct = fd >= 0))
+         fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+      if (fd < 0)
+      {
+         log.warn("unable to open file [{}]: {}", {name, std::string(strerror(errno))});
+         return false;
+      }
+#else
+      if (!(file = fopen(name.c_str(), "wb")))
+      {
+         log.warn("unable to open file [{}]", {name});
+         return false;
+      }
+#endif
+
+      accepted = 0;
+      stored = 0;
+      stall = 0;
+      busy = 0;
+      error = false;
+
+      blocks.resize(blockCount);
+
+      for (auto &block: blocks)
+      {
+         void *raw = malloc(blockSize + IO_ALIGNMENT);
+
+         memory.push_back(raw);
+
+         block.data = (unsigned char *) ((((uintptr_t) raw) + IO_ALIGNMENT - 1) & ~(uintptr_t) (IO_ALIGNMENT - 1));
+         block.size = 0;
+
+         freeBlocks.push_back(&block);
+      }
+
+      current = freeBlocks.front();
+
+      freeBlocks.pop_front();
+
+      running = true;
+
+      thread = std::thread([this] { run(); });
+
+      log.debug("opened file [{}] with {} blocks of {} bytes, direct I/O {}", {name, blockCount, blockSize, direct.load()});
+
+      return true;
+   }
+
+   void close()
+   {
+      if (!running)
+         return;
+
+      // hand over last partial block and wait for I/O thread to drain queue
+      if (current && current->size)
+         submit(current);
+
+      current = nullptr;
+
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+
+         running = false;
+      }
+
+      fullCondition.notify_one();
+
+      thread.join();
+
+#ifdef __linux__
+      // last direct write was padded to alignment
+      if (direct && ftruncate(fd, stored) != 0)
+         log.warn("unable to truncate file [{}]: {}", {name, std::string(strerror(errno))});
+
+      ::close(fd);
+
+      fd = -1;
+#else
+      fclose(file);
+
+      file = nullptr;
+#endif
+
+      for (auto raw: memory)
+         free(raw);
+
+      memory.clear();
+      blocks.clear();
+      freeBlocks.clear();
+      fullBlocks.clear();
+
+      log.debug("closed file [{}], {} bytes written", {name, stored.load()});
+   }
+
+   bool write(const void *data, unsigned int size)
+   {
+      if (!running || error)
+         return false;
+
+      const unsigned char *src = static_cast<const unsigned char *>(data);
+
+      while (size)
+      {
+         unsigned int length = std::min(size, blockSize - current->size);
+
+         std::memcpy(current->data + current->size, src, length);
+
+         current->size += length;
+         accepted += length;
+         src += length;
+         size -= length;
+
+         if (current->size == blockSize)
+         {
+            submit(current);
+
+            current = acquire();
+         }
+      }
+
+      return true;
+   }
+
+   void submit(Block *block)
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+
+         fullBlocks.push_back(block);
+      }
+
+      fullCondition.notify_one();
+   }
+
+   Block *acquire()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      if (freeBlocks.empty())
+      {
+         auto start = std::chrono::steady_clock::now();
+
+         freeCondition.wait(lock, [this] { return !freeBlocks.empty(); });
+
+         stall += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+      }
+
+      Block *block = freeBlocks.front();
+
+      freeBlocks.pop_front();
+
+      return block;
+   }
+
+   void run()
+   {
+      while (true)
+      {
+         Block *block;
+
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            fullCondition.wait(lock, [this] { return !fullBlocks.empty() || !running; });
+
+            if (fullBlocks.empty())
+               break;
+
+            block = fullBlocks.front();
+
+            fullBlocks.pop_front();
+         }
+
+         auto start = std::chrono::steady_clock::now();
+
+         // after an error blocks are only recycled so writers never wait forever
+         if (!error && !store(block))
+         {
+            log.error("write failed on file [{}] after {} bytes", {name, stored.load()});
+
+            error = true;
+         }
+
+         busy += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            block->size = 0;
+
+            freeBlocks.push_back(block);
+         }
+
+         freeCondition.notify_one();
+      }
+   }
+
+   bool store(Block *block)
+   {
+#ifdef __linux__
+      unsigned int length = block->size;
+
+      // only the last block may be partial, direct writes need aligned size
+      if (direct && length % IO_ALIGNMENT)
+      {
+         length = (length + IO_ALIGNMENT - 1) & ~(IO_ALIGNMENT - 1);
+
+         std::memset(block->data + block->size, 0, length - block->size);
+      }
+
+      unsigned int offset = 0;
+
+      while (offset < length)
+      {
+         ssize_t result = pwrite(fd, block->data + offset, length - offset, stored + offset);
+
+         if (result < 0 && errno == EINTR)
+            continue;
+
+         // some filesystems accept direct open but not the write, continue through page cache
+         if (result < 0 && errno == EINVAL && direct)
+         {
+            log.warn("direct I/O rejected for file [{}], using buffered writes", {name});
+
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+
+            direct = false;
+            length = block->size;
+
+            continue;
+         }
+
+         if (result <= 0)
+            return false;
+
+         offset += result;
+      }
+#else
+      if (fwrite(block->data, 1, block->size, file) != block->size)
+         return false;
+#endif
+
+      stored += block->size;
+
+      return true;
+   }
+};
+
+FileWriter::FileWriter(const std::string &name, unsigned int blockSize, unsigned int blockCount) : impl(std::make_shared<Impl>(name, blockSize, blockCount))
+{
+}
+
+const std::string &FileWriter::name() const
+{
+   return impl->name;
+}
+
+bool FileWriter::open()
+{
+   return impl->open();
+}
+
+void FileWriter::close()
+{
+   impl->close();
+}
+
+bool FileWriter::isOpen() const
+{
+   return impl->running;
+}
+
+bool FileWriter::isDirect() const
+{
+   return impl->direct;
+}
+
+bool FileWriter::hasError() const
+{
+   return impl->error;
+}
+
+bool FileWriter::write(const void *data, unsigned int size)
+{
+   return impl->write(data, size);
+}
+
+long long FileWriter::size() const
+{
+   return impl->accepted;
+}
+
+long long FileWriter::written() const
+{
+   return impl->stored;
+}
+
+long long FileWriter::backlog() const
+{
+   return impl->accepted - impl->stored;
+}
+
+long long FileWriter::stallTime() const
+{
+   return impl->stall;
+}
+
+long long FileWriter::busyTime() const
+{
+   return impl->busy;
+}
+
+}
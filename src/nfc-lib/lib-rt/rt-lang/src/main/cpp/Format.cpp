@@ -22,107 +22,168 @@
 
 */
 
-#include <regex>
-#include <iostream>
+#include <cstdio>
 
 #include <rt/Format.h>
 
-std::string rt::Format::format(const std::string &fmt, const std::vector<Variant> &parameters)
+namespace rt {
+
+Format::Pattern::Pattern(const std::string &fmt)
 {
-   std::regex token(R"(\{([\.0-9]*)?\})");
+   std::string literal;
+
+   for (size_t i = 0; i < fmt.length(); i++)
+   {
+      if (fmt[i] == '{')
+      {
+         size_t end = fmt.find_first_not_of(".0123456789", i + 1);
+
+         if (end != std::string::npos && fmt[end] == '}')
+         {
+            if (!literal.empty())
+               tokens.push_back({std::move(literal), false});
+
+            tokens.push_back({fmt.substr(i + 1, end - i - 1), true});
+
+            literal.clear();
+
+            i = end;
 
-   std::string content = fmt;
+            continue;
+         }
+      }
+
+      literal += fmt[i];
+   }
+
+   if (!literal.empty())
+      tokens.push_back({std::move(literal), false});
+}
+
+void Format::Pattern::format(std::string &output, const Variant *parameters, int count) const
+{
+   char spec[32], buffer[4096];
 
-   char buffer[4096];
+   int next = 0;
 
-   for (const auto &parameter : parameters)
+   for (const auto &token: tokens)
    {
-      buffer[0] = 0;
+      if (!token.placeholder)
+      {
+         output.append(token.text);
+         continue;
+      }
+
+      if (next >= count)
+      {
+         output.append("{").append(token.text).append("}");
+         continue;
+      }
 
-      std::smatch match;
+      const Variant &parameter = parameters[next++];
 
-      if (!std::regex_search(content, match, token))
-         break;
+      // printf spec is built from placeholder options plus conversion for parameter type
+      auto conversion = [&](const char *type) -> const char * {
+         snprintf(spec, sizeof(spec), "%%%s%s", token.text.c_str(), type);
+         return spec;
+      };
 
-      std::string opts = match[1];
+      buffer[0] = 0;
 
       if (auto value = std::get_if<bool>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "s").c_str(), *value ? "true" : "false");
+         snprintf(buffer, sizeof(buffer), conversion("s"), *value ? "true" : "false");
       }
       else if (auto value = std::get_if<char>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "c").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("c"), *value);
       }
       else if (auto value = std::get_if<short>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "d").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("d"), *value);
       }
       else if (auto value = std::get_if<int>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "d").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("d"), *value);
       }
       else if (auto value = std::get_if<long>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "d").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("ld"), *value);
       }
       else if (auto value = std::get_if<long long>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "ll").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("lld"), *value);
       }
       else if (auto value = std::get_if<unsigned char>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "u").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("u"), *value);
       }
       else if (auto value = std::get_if<unsigned short>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "u").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("u"), *value);
       }
       else if (auto value = std::get_if<unsigned int>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "u").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("u"), *value);
       }
       else if (auto value = std::get_if<unsigned long>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "u").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("lu"), *value);
       }
       else if (auto value = std::get_if<unsigned long long>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "ll").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("llu"), *value);
       }
       else if (auto value = std::get_if<float>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "f").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("f"), *value);
       }
       else if (auto value = std::get_if<double>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "f").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("f"), *value);
       }
       else if (auto value = std::get_if<char *>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "s").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("s"), *value);
       }
       else if (auto value = std::get_if<void *>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), "0x%08x", *value);
+         snprintf(buffer, sizeof(buffer), "%p", *value);
       }
       else if (auto value = std::get_if<std::string>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "s").c_str(), value->c_str());
+         snprintf(buffer, sizeof(buffer), conversion("s"), value->c_str());
       }
       else if (auto value = std::get_if<std::thread::id>(&parameter))
       {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "d").c_str(), *value);
+         snprintf(buffer, sizeof(buffer), conversion("d"), *value);
       }
       else if (auto value = std::get_if<ByteBuffer>(&parameter))
       {
          value->reduce<int>(0, [&buffer](int offset, unsigned char value) {
+            if (offset + 4 > (int) sizeof(buffer))
+               return offset;
+
             return offset + snprintf(buffer + offset, sizeof(buffer) - offset, "%02X ", value);
          });
       }
 
-      content.replace(match.position(), match.length(), buffer);
+      output.append(buffer);
    }
+}
+
+std::string Format::Pattern::format(const std::vector<Variant> &parameters) const
+{
+   std::string content;
+
+   format(content, parameters.data(), (int) parameters.size());
 
    return content;
 }
+
+std::string Format::format(const std::string &fmt, const std::vector<Variant> &parameters)
+{
+   return Pattern(fmt).format(parameters);
+}
+
+}
@@ -26,22 +26,33 @@
 #include <pthread.h>
 
 #include <map>
+#include <mutex>
 #include <string>
-#include <fstream>
 #include <cmath>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
 #include <thread>
 #include <chrono>
 #include <cstring>
-#include <iostream>
+#include <unordered_map>
 
 #include <rt/Logger.h>
 #include <rt/Format.h>
 #include <rt/FileSystem.h>
-#include <rt/BlockingQueue.h>
 
 #ifndef LOG_OUTPUT
 #define LOG_OUTPUT 3
 #endif
+
+// number of preallocated events, must be power of two
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 1024
+#endif
+
+// maximum number of parameters per event, extra ones are discarded
+#define LOG_MAX_PARAMS 16
+
 namespace rt {
 
 const char *tags[] = {
@@ -55,137 +66,158 @@ const char *tags[] = {
       "" // 7
 };
 
-// log event for store debugging information
-struct LogEvent
+struct Logger::Impl
 {
-   std::string level;
-   std::string logger;
-   std::string format;
-   std::vector<Variant> params;
-
-   std::thread::id thread;
-   std::chrono::time_point<std::chrono::system_clock> time;
+   int level;
+   std::string name;
 
-   LogEvent(std::string level, std::string logger, std::string format, std::vector<Variant> params) :
-         level(std::move(level)),
-         logger(std::move(logger)),
-         format(std::move(format)),
-         params(std::move(params)),
-         thread(std::this_thread::get_id()),
-         time(std::chrono::system_clock::now())
+   Impl(std::string name, int level) : name(std::move(name)), level(level)
    {
    }
 };
 
-// threaded logger to console stdout, runs on low priority thread
-#if LOG_OUTPUT == 1
-struct LogWriter
+// log event for store debugging information, preallocated and reused so the caller never allocates
+struct LogEvent
 {
-   // writer thread
-   std::thread thread;
+   // ring position, tells if event is free for producers or ready for writer
+   std::atomic<unsigned int> sequence {0};
 
-   // shutdown flag
-   std::atomic<bool> shutdown;
+   int level = 0;
+
+   // loggers are never released, so it is safe to keep the pointer
+   const Logger::Impl *logger = nullptr;
+
+   // static format string stored by address, or null when format has been copied to text
+   const char *format = nullptr;
 
-   // events queue
-   BlockingQueue<LogEvent *> queue;
+   // copy of non static format, keeps its capacity between uses
+   std::string text;
 
-   LogWriter() : thread([this] { this->exec(); }), shutdown(false)
+   // parameters in binary form, formatted later by writer thread
+   Variant params[LOG_MAX_PARAMS];
+
+   int count = 0;
+
+   std::thread::id thread;
+   std::chrono::time_point<std::chrono::system_clock> time;
+
+   void fill(int value, const Logger::Impl *impl, const char *fmt, const std::string *copy, std::initializer_list<Variant> list)
    {
-      sched_param param {0};
+      level = value;
+      logger = impl;
+      format = fmt;
+      count = 0;
 
-      if (pthread_setschedparam(thread.native_handle(), SCHED_OTHER, &param))
+      if (copy)
+         text.assign(*copy);
+
+      for (const auto &param: list)
       {
-         printf("error setting logger thread priority: %s\n", std::strerror(errno));
+         if (count == LOG_MAX_PARAMS)
+            break;
+
+         params[count++] = param;
       }
+
+      thread = std::this_thread::get_id();
+      time = std::chrono::system_clock::now();
    }
+};
 
-   ~LogWriter()
-   {
-      // signal shutdown
-      shutdown = true;
+// renders events as text lines, formats are parsed once and cached by address
+struct LogFormatter
+{
+   std::unordered_map<const char *, Format::Pattern> patterns;
 
-      // wait for thread to finish
-      thread.join();
-   }
+   // current second and its date prefix, only refreshed when it changes
+   long long second = -1;
+   char date[32] {};
 
-   void push(LogEvent *event)
-   {
-      queue.add(event);
-   }
+   // reused to avoid allocations
+   std::string line;
 
-   void exec()
+   const std::string &format(const LogEvent *event)
    {
-      while (!shutdown)
+      char prefix[256];
+
+      auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(event->time.time_since_epoch()).count();
+
+      time_t seconds = millis / 1000;
+
+      if (seconds != second)
       {
-         while (auto event = queue.get(50))
-         {
-            write(event.value());
-         }
+         struct tm timeinfo {};
+
+         localtime_s(&timeinfo, &seconds);
+
+         strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+         second = seconds;
       }
-   }
 
-   void write(LogEvent *event)
-   {
-      char date[32];
-      struct tm timeinfo {};
+      snprintf(prefix, sizeof(prefix), "%s.%03d %s (thread-%lu) [%s] ", date, (int) (millis % 1000), tags[event->level & 0x7], (unsigned long) std::hash<std::thread::id>()(event->thread), event->logger->name.c_str());
 
-      auto seconds = std::chrono::duration_cast<std::chrono::seconds>(event->time.time_since_epoch()).count();
-      auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(event->time.time_since_epoch()).count() % 1000;
+      line.assign(prefix);
 
-      localtime_s(&timeinfo, &seconds);
+      if (event->format)
+      {
+         auto it = patterns.find(event->format);
 
-      strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
+         if (it == patterns.end())
+            it = patterns.emplace(event->format, Format::Pattern(event->format)).first;
 
-      fprintf(stdout, "%s.%03d %s (thread-%d) [%s] %s\n", date, millis, event->level.c_str(), event->thread, event->logger.c_str(), Format::format(event->format, event->params).c_str());
+         it->second.format(line, event->params, event->count);
+      }
+      else
+      {
+         Format::Pattern(event->text).format(line, event->params, event->count);
+      }
 
-      delete event;
-   }
+      line.append("\n");
 
-} writer;
+      return line;
+   }
+};
 
-// direct to stderr logger, warning, performance impact! use only for strange debugging when others logger do not work!
-#elif LOG_OUTPUT == 2
+// threaded logger to stdout or file, producers push into a lock-free ring and never wait for the writer
+#if LOG_OUTPUT == 1 || LOG_OUTPUT == 3
 struct LogWriter
 {
-   void push(LogEvent *event)
-   {
-      char date[32];
-      struct tm timeinfo {};
+   // preallocated events
+   LogEvent events[LOG_RING_SIZE];
 
-      auto seconds = std::chrono::duration_cast<std::chrono::seconds>(event->time.time_since_epoch()).count();
-      auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(event->time.time_since_epoch()).count() % 1000;
+   // next position to be claimed by producers
+   alignas(64) std::atomic<unsigned int> tail {0};
 
-      localtime_s(&timeinfo, &seconds);
+   // next position to be written, only used by writer thread
+   alignas(64) unsigned int head = 0;
 
-      strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
+   // events discarded because ring was full
+   std::atomic<unsigned int> dropped {0};
 
-      fprintf(stderr, "%s.%03d %s (thread-%d) [%s] %s\n", date, millis, event->level.c_str(), event->thread, event->logger.c_str(), Format::format(event->format, event->params).c_str());
+   // shutdown flag
+   std::atomic<bool> shutdown {false};
 
-      delete event;
-   }
+   // set by writer before waiting, producers that find it set wake the writer
+   std::atomic<bool> sleeping {false};
 
-} writer;
+   // writer wait when idle
+   std::mutex mutex;
+   std::condition_variable signal;
 
+   // output stream
+   FILE *output = nullptr;
 
-// threaded logger to file stream, runs on low priority thread
-#elif LOG_OUTPUT == 3
-struct LogWriter
-{
-   // writer thread
+   // writer thread, started last so all members are ready
    std::thread thread;
 
-   // shutdown flag
-   std::atomic<bool> shutdown;
-
-   // output file
-   std::ofstream stream;
+   LogWriter()
+   {
+      for (unsigned int i = 0; i < LOG_RING_SIZE; i++)
+         events[i].sequence.store(i, std::memory_order_relaxed);
 
-   // events queue
-   BlockingQueue<LogEvent *> queue;
+      thread = std::thread([this] { this->exec(); });
 
-   LogWriter() : thread([this] { this->exec(); }), shutdown(false)
-   {
       sched_param param {0};
 
       if (pthread_setschedparam(thread.native_handle(), SCHED_OTHER, &param))
@@ -197,126 +229,243 @@ struct LogWriter
    ~LogWriter()
    {
       // signal shutdown
-      shutdown = true;
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+
+         shutdown = true;
+      }
+
+      signal.notify_one();
 
       // wait for thread to finish
       thread.join();
    }
 
-   void push(LogEvent *event)
+   void push(int level, const Logger::Impl *logger, const char *format, const std::string *text, std::initializer_list<Variant> params)
    {
-      queue.add(event);
+      unsigned int position = tail.load(std::memory_order_relaxed);
+
+      while (true)
+      {
+         LogEvent *event = events + (position & (LOG_RING_SIZE - 1));
+
+         int diff = (int) (event->sequence.load(std::memory_order_acquire) - position);
+
+         if (diff == 0)
+         {
+            // claim event
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+               event->fill(level, logger, format, text, params);
+
+               // publish to writer, sequentially consistent so it can not be reordered with the sleeping check
+               event->sequence.store(position + 1);
+
+               // wake writer only when it is waiting, keeps the hot path free of locks
+               if (sleeping.load() && sleeping.exchange(false))
+               {
+                  std::lock_guard<std::mutex> lock(mutex);
+
+                  signal.notify_one();
+               }
+
+               return;
+            }
+         }
+         else if (diff < 0)
+         {
+            // ring full, writer is behind
+            dropped.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+         }
+         else
+         {
+            position = tail.load(std::memory_order_relaxed);
+         }
+      }
+   }
+
+   // next event is ready to be written
+   bool pending()
+   {
+      return events[head & (LOG_RING_SIZE - 1)].sequence.load() == head + 1;
    }
 
    void exec()
    {
+      Logger::Impl self {"Logger", Logger::WARN};
+
+      LogFormatter formatter;
+
+#if LOG_OUTPUT == 1
+      output = stdout;
+#else
       rt::FileSystem::createDir("log");
 
       // open log file
-      stream.open("log/nfc-lab.log", std::ios::out | std::ios::app);
+      output = fopen("log/nfc-lab.log", "a");
+#endif
 
-      while (!shutdown)
+      while (true)
       {
-         while (auto event = queue.get(100))
+         // read flag before draining, so events pushed before shutdown are written
+         bool finish = shutdown.load();
+
+         int written = 0;
+
+         while (true)
          {
-            if (stream)
-            {
-               write(event.value());
-            }
+            LogEvent *event = events + (head & (LOG_RING_SIZE - 1));
+
+            if (event->sequence.load(std::memory_order_acquire) != head + 1)
+               break;
+
+            if (output)
+               fputs(formatter.format(event).c_str(), output);
+
+            // release event for producers
+            event->sequence.store(head + LOG_RING_SIZE, std::memory_order_release);
+
+            head++;
+            written++;
+         }
+
+         if (unsigned int lost = dropped.exchange(0))
+         {
+            LogEvent notice;
+
+            notice.fill(Logger::WARN, &self, "{} log events discarded, ring is full", nullptr, {lost});
+
+            if (output)
+               fputs(formatter.format(&notice).c_str(), output);
+         }
+
+         if (finish)
+            break;
+
+         // flush when idle and wait for new events
+         if (!written)
+         {
+            if (output)
+               fflush(output);
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            sleeping = true;
+
+            // check again after publishing the flag, a producer that missed it has already published its event
+            if (!pending() && !shutdown)
+               signal.wait(lock, [this] { return !sleeping || shutdown; });
+
+            sleeping = false;
          }
       }
 
       // close file
-      stream.close();
+      if (output && output != stdout)
+         fclose(output);
+      else if (output)
+         fflush(output);
    }
+};
 
-   void write(LogEvent *event)
-   {
-      struct tm timeinfo {};
-      char date[32], buffer[4096];
-
-      auto seconds = std::chrono::duration_cast<std::chrono::seconds>(event->time.time_since_epoch()).count();
-      auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(event->time.time_since_epoch()).count() % 1000;
+// direct to stderr logger, warning, performance impact! use only for strange debugging when others logger do not work!
+#elif LOG_OUTPUT == 2
+struct LogWriter
+{
+   std::mutex mutex;
 
-      localtime_s(&timeinfo, &seconds);
+   LogFormatter formatter;
 
-      strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
+   void push(int level, const Logger::Impl *logger, const char *format, const std::string *text, std::initializer_list<Variant> params)
+   {
+      LogEvent event;
 
-      snprintf(buffer, sizeof(buffer), "%s.%03d %s (thread-%d) [%s] %s\n", date, millis, event->level.c_str(), event->thread, event->logger.c_str(), Format::format(event->format, event->params).c_str());
+      event.fill(level, logger, format, text, params);
 
-      stream << buffer;
+      std::lock_guard<std::mutex> lock(mutex);
 
-      delete event;
+      fputs(formatter.format(&event).c_str(), stderr);
    }
-
-} writer;
+};
 
 // null logger for discard all messages
 #else
 struct LogWriter
 {
-   void push(LogEvent *event)
+   void push(int level, const Logger::Impl *logger, const char *format, const std::string *text, std::initializer_list<Variant> params)
    {
-      delete event;
    }
-} writer;
+};
 #endif
 
-struct Logger::Impl
+// constructed on first use, so loggers can be used from static initializers
+static LogWriter &writer()
 {
-   int level;
-   std::string name;
+   static LogWriter instance;
 
-   Impl(std::string name, int level) : name(std::move(name)), level(level)
-   {
-   }
-};
-
-// loggers map
-static std::map<std::string, std::shared_ptr<Logger::Impl>> loggers;
+   return instance;
+}
 
 Logger::Logger(const std::string &name, int level)
 {
-   if (loggers.find(name) == loggers.end())
-      loggers[name] = std::make_shared<Logger::Impl>(name, level);
+   // loggers map, constructed on first use as loggers are created from static initializers of other units
+   static std::map<std::string, std::shared_ptr<Logger::Impl>> loggers;
 
-   impl = loggers[name];
+   // pipeline contexts create loggers from any thread
+   static std::mutex mutex;
+
+   std::lock_guard<std::mutex> lock(mutex);
+
+   auto &entry = loggers[name];
+
+   if (!entry)
+      entry = std::make_shared<Logger::Impl>(name, level);
+
+   impl = entry;
 }
 
-void Logger::trace(const std::string &format, std::vector<Variant> params) const
+void Logger::trace(const std::string &format, std::initializer_list<Variant> params) const
 {
    if (impl->level >= TRACE)
-      writer.push(new LogEvent(tags[TRACE], impl->name, format, std::move(params)));
+      writer().push(TRACE, impl.get(), nullptr, &format, params);
 }
 
-void Logger::debug(const std::string &format, std::vector<Variant> params) const
+void Logger::debug(const std::string &format, std::initializer_list<Variant> params) const
 {
    if (impl->level >= DEBUG)
-      writer.push(new LogEvent(tags[DEBUG], impl->name, format, std::move(params)));
+      writer().push(DEBUG, impl.get(), nullptr, &format, params);
 }
 
-void Logger::info(const std::string &format, std::vector<Variant> params) const
+void Logger::info(const std::string &format, std::initializer_list<Variant> params) const
 {
    if (impl->level >= INFO)
-      writer.push(new LogEvent(tags[INFO], impl->name, format, std::move(params)));
+      writer().push(INFO, impl.get(), nullptr, &format, params);
 }
 
-void Logger::warn(const std::string &format, std::vector<Variant> params) const
+void Logger::warn(const std::string &format, std::initializer_list<Variant> params) const
 {
    if (impl->level >= WARN)
-      writer.push(new LogEvent(tags[WARN], impl->name, format, std::move(params)));
+      writer().push(WARN, impl.get(), nullptr, &format, params);
 }
 
-void Logger::error(const std::string &format, std::vector<Variant> params) const
+void Logger::error(const std::string &format, std::initializer_list<Variant> params) const
 {
    if (impl->level >= ERROR)
-      writer.push(new LogEvent(tags[ERROR], impl->name, format, std::move(params)));
+      writer().push(ERROR, impl.get(), nullptr, &format, params);
 }
 
-void Logger::print(int level, const std::string &format, std::vector<Variant> params) const
+void Logger::print(int level, const std::string &format, std::initializer_list<Variant> params) const
 {
    if (impl->level >= level)
-      writer.push(new LogEvent(tags[level & 0x7], impl->name, format, std::move(params)));
+      writer().push(level, impl.get(), nullptr, &format, params);
+}
+
+void Logger::push(int level, const char *format, std::initializer_list<Variant> params) const
+{
+   if (impl->level >= level)
+      writer().push(level, impl.get(), format, nullptr, params);
 }
 
 void Logger::setLevel(int value)
@@ -324,4 +473,4 @@ void Logger::setLevel(int value)
    impl->level = value;
 }
 
-}
\ No newline at end of file
+}
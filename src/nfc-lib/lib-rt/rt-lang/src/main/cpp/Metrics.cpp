@@ -0,0 +1,361 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include <rt/Logger.h>
+#include <rt/Metrics.h>
+
+namespace rt {
+
+enum MetricType
+{
+   CounterType = 0,
+   GaugeType = 1,
+   HistogramType = 2
+};
+
+struct Family
+{
+   int type = 0;
+   std::string help;
+   std::map<std::string, std::unique_ptr<Metrics::Counter>> counters;
+   std::map<std::string, std::unique_ptr<Metrics::Gauge>> gauges;
+   std::map<std::string, std::unique_ptr<Metrics::Histogram>> histograms;
+};
+
+struct Registry
+{
+   std::mutex mutex;
+
+   // families sorted by name
+   std::map<std::string, Family> families;
+
+   // series requested with a conflicting type, kept alive but not exported
+   std::list<std::shared_ptr<void>> orphans;
+};
+
+// constructed on first use so tasks may register series from static initializers
+static Registry &registry()
+{
+   static Registry instance;
+
+   return instance;
+}
+
+static std::string escape(const std::string &value)
+{
+   std::string result;
+
+   for (char c: value)
+   {
+      if (c == '\\' || c == '"')
+         result += '\\';
+
+      if (c == '\n')
+         result += "\\n";
+      else
+         result += c;
+   }
+
+   return result;
+}
+
+// serialize labels as {a="1",b="2"}, extra label appended at the end (used for histogram "le")
+static std::string labelString(const std::string &labels, const std::string &extra = {})
+{
+   if (labels.empty() && extra.empty())
+      return {};
+
+   if (labels.empty())
+      return "{" + extra + "}";
+
+   if (extra.empty())
+      return "{" + labels + "}";
+
+   return "{" + labels + "," + extra + "}";
+}
+
+static std::string labelKey(const Metrics::Labels &labels)
+{
+   std::string key;
+
+   for (const auto &entry: labels)
+   {
+      if (!key.empty())
+         key += ",";
+
+      key += entry.first + "=\"" + escape(entry.second) + "\"";
+   }
+
+   return key;
+}
+
+template<typename S>
+static S *lookup(int type, std::map<std::string, std::unique_ptr<S>> Family::*series, const std::string &name, const std::string &help, const Metrics::Labels &labels)
+{
+   Registry &reg = registry();
+
+   std::lock_guard<std::mutex> lock(reg.mutex);
+
+   auto it = reg.families.find(name);
+
+   if (it == reg.families.end())
+   {
+      it = reg.families.try_emplace(name).first;
+
+      it->second.type = type;
+      it->second.help = help;
+   }
+
+   if (it->second.type != type)
+   {
+      Logger log {"Metrics"};
+
+      log.error("metric {} already registered with different type", {name});
+
+      auto orphan = std::make_shared<S>();
+
+      reg.orphans.push_back(orphan);
+
+      return orphan.get();
+   }
+
+   auto &entries = it->second.*series;
+
+   auto &entry = entries[labelKey(labels)];
+
+   if (!entry)
+      entry = std::make_unique<S>();
+
+   return entry.get();
+}
+
+static std::string number(double value)
+{
+   char buffer[32];
+
+   snprintf(buffer, sizeof(buffer), "%.10g", value);
+
+   return buffer;
+}
+
+void Metrics::Counter::add(unsigned long long count)
+{
+   static std::atomic<int> threads {0};
+
+   // each thread sticks to one stripe
+   static thread_local int stripe = threads.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+
+   stripes[stripe].value.fetch_add(count, std::memory_order_relaxed);
+}
+
+unsigned long long Metrics::Counter::value() const
+{
+   unsigned long long result = 0;
+
+   for (const auto &entry: stripes)
+      result += entry.value.load(std::memory_order_relaxed);
+
+   return result;
+}
+
+void Metrics::Gauge::set(double value)
+{
+   current.store(value, std::memory_order_relaxed);
+}
+
+void Metrics::Gauge::add(double value)
+{
+   double expected = current.load(std::memory_order_relaxed);
+
+   while (!current.compare_exchange_weak(expected, expected + value, std::memory_order_relaxed))
+   {
+   }
+}
+
+double Metrics::Gauge::value() const
+{
+   return current.load(std::memory_order_relaxed);
+}
+
+void Metrics::Histogram::add(unsigned long long value)
+{
+   buckets[rt::Histogram::index(value)].fetch_add(1, std::memory_order_relaxed);
+
+   samples.fetch_add(1, std::memory_order_relaxed);
+
+   accumulated.fetch_add(value, std::memory_order_relaxed);
+
+   unsigned long long current = highest.load(std::memory_order_relaxed);
+
+   while (value > current && !highest.compare_exchange_weak(current, value, std::memory_order_relaxed))
+   {
+   }
+}
+
+rt::Histogram Metrics::Histogram::snapshot() const
+{
+   rt::Histogram result;
+
+   for (int i = 0; i < rt::Histogram::BUCKETS; i++)
+   {
+      if (unsigned long long count = buckets[i].load(std::memory_order_relaxed))
+         result.add(rt::Histogram::lower(i), count);
+   }
+
+   // restore exact maximum
+   result.add(highest.load(std::memory_order_relaxed), 0);
+
+   return result;
+}
+
+unsigned long long Metrics::Histogram::count() const
+{
+   return samples.load(std::memory_order_relaxed);
+}
+
+unsigned long long Metrics::Histogram::sum() const
+{
+   return accumulated.load(std::memory_order_relaxed);
+}
+
+Metrics::Counter *Metrics::counter(const std::string &name, const std::string &help, const Labels &labels)
+{
+   return lookup(CounterType, &Family::counters, name, help, labels);
+}
+
+Metrics::Gauge *Metrics::gauge(const std::string &name, const std::string &help, const Labels &labels)
+{
+   return lookup(GaugeType, &Family::gauges, name, help, labels);
+}
+
+Metrics::Histogram *Metrics::histogram(const std::string &name, const std::string &help, const Labels &labels)
+{
+   return lookup(HistogramType, &Family::histograms, name, help, labels);
+}
+
+std::string Metrics::format()
+{
+   Registry &reg = registry();
+
+   std::lock_guard<std::mutex> lock(reg.mutex);
+
+   std::ostringstream out;
+
+   for (const auto &entry: reg.families)
+   {
+      const std::string &name = entry.first;
+      const Family &family = entry.second;
+
+      out << "# HELP " << name << " " << family.help << "\n";
+
+      switch (family.type)
+      {
+         case CounterType:
+         {
+            out << "# TYPE " << name << " counter\n";
+
+            for (const auto &series: family.counters)
+               out << name << labelString(series.first) << " " << series.second->value() << "\n";
+
+            break;
+         }
+
+         case GaugeType:
+         {
+            out << "# TYPE " << name << " gauge\n";
+
+            for (const auto &series: family.gauges)
+               out << name << labelString(series.first) << " " << number(series.second->value()) << "\n";
+
+            break;
+         }
+
+         case HistogramType:
+         {
+            out << "# TYPE " << name << " histogram\n";
+
+            for (const auto &series: family.histograms)
+            {
+               rt::Histogram histogram = series.second->snapshot();
+
+               unsigned long long cumulative = 0;
+
+               int bucket = 0;
+
+               // cumulative counts at power of two boundaries, which fall on bucket edges of the log-linear layout
+               for (int k = 1; k <= 32; k++)
+               {
+                  unsigned long long limit = (1ULL << k) - 1;
+
+                  for (; bucket < rt::Histogram::BUCKETS && rt::Histogram::upper(bucket) <= limit; bucket++)
+                     cumulative += histogram.bucketCount(bucket);
+
+                  out << name << "_bucket" << labelString(series.first, "le=\"" + std::to_string(limit) + "\"") << " " << cumulative << "\n";
+               }
+
+               out << name << "_bucket" << labelString(series.first, "le=\"+Inf\"") << " " << histogram.count() << "\n";
+               out << name << "_sum" << labelString(series.first) << " " << series.second->sum() << "\n";
+               out << name << "_count" << labelString(series.first) << " " << histogram.count() << "\n";
+            }
+
+            break;
+         }
+      }
+   }
+
+   return out.str();
+}
+
+bool Metrics::dump(const std::string &path)
+{
+   std::string temp = path + ".tmp";
+
+   {
+      std::ofstream output(temp, std::ios::trunc);
+
+      if (!output)
+         return false;
+
+      output << format();
+
+      if (!output)
+         return false;
+   }
+
+#ifdef _WIN32
+   // rename does not replace existing files on windows
+   std::remove(path.c_str());
+#endif
+
+   return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+}
@@ -0,0 +1,182 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <list>
+#include <mutex>
+#include <tuple>
+
+#include <rt/Logger.h>
+#include <rt/Qos.h>
+
+namespace rt {
+
+struct QosState
+{
+   Logger log {"Qos"};
+
+   std::mutex mutex;
+
+   // registered critical consumers, never removed
+   std::list<std::pair<std::string, Qos::Backlog>> backlogs;
+
+   // backlog threshold in microseconds
+   std::atomic<long long> threshold {50000};
+
+   // admitted buffers while degraded, 1 of N
+   std::atomic<int> decimation {4};
+
+   // multiple of threshold to skip best-effort consumers
+   std::atomic<int> overload {4};
+
+   // current level
+   std::atomic<int> level {Qos::Normal};
+
+   Metrics::Gauge *levelGauge = Metrics::gauge("nfc_qos_level", "Load shedding level, 0 normal, 1 degraded, 2 overload");
+
+   Metrics::Gauge *backlogGauge = Metrics::gauge("nfc_qos_backlog_microseconds", "Highest backlog reported by critical consumers");
+};
+
+static QosState &state()
+{
+   static QosState instance;
+
+   return instance;
+}
+
+void Qos::Backlog::update(long long micros)
+{
+   QosState &qos = state();
+
+   value.store(micros, std::memory_order_relaxed);
+
+   // level follows the worst critical consumer
+   long long worst = 0;
+
+   {
+      std::lock_guard<std::mutex> lock(qos.mutex);
+
+      for (const auto &entry: qos.backlogs)
+      {
+         long long current = entry.second.value.load(std::memory_order_relaxed);
+
+         if (current > worst)
+            worst = current;
+      }
+   }
+
+   long long threshold = qos.threshold.load(std::memory_order_relaxed);
+
+   int next = Normal;
+
+   if (threshold > 0 && worst > threshold * qos.overload.load(std::memory_order_relaxed))
+      next = Overload;
+   else if (threshold > 0 && worst > threshold)
+      next = Degraded;
+
+   int previous = qos.level.exchange(next, std::memory_order_relaxed);
+
+   if (previous != next)
+      qos.log.warn("load shedding level changed from {} to {}, critical backlog {} us", {previous, next, worst});
+
+   qos.levelGauge->set(next);
+   qos.backlogGauge->set(double(worst));
+}
+
+// series labels for consumer, merged with caller labels
+static Metrics::Labels consumer(const std::string &name, Metrics::Labels labels)
+{
+   labels["consumer"] = name;
+
+   return labels;
+}
+
+Qos::Gate::Gate(const std::string &name, const Metrics::Labels &labels) :
+      admitted(Metrics::counter("nfc_qos_admitted_total", "Buffers processed by best-effort consumers", consumer(name, labels))),
+      shed(Metrics::counter("nfc_qos_shed_total", "Buffers dropped by best-effort consumers due to load shedding", consumer(name, labels)))
+{
+}
+
+bool Qos::Gate::admit()
+{
+   QosState &qos = state();
+
+   bool accept;
+
+   switch (qos.level.load(std::memory_order_relaxed))
+   {
+      case Normal:
+         accept = true;
+         break;
+
+      case Degraded:
+         accept = (sequence++ % qos.decimation.load(std::memory_order_relaxed)) == 0;
+         break;
+
+      default:
+         accept = false;
+         break;
+   }
+
+   if (accept)
+      admitted->add();
+   else
+      shed->add();
+
+   return accept;
+}
+
+Qos::Backlog *Qos::backlog(const std::string &name)
+{
+   QosState &qos = state();
+
+   std::lock_guard<std::mutex> lock(qos.mutex);
+
+   for (auto &entry: qos.backlogs)
+   {
+      if (entry.first == name)
+         return &entry.second;
+   }
+
+   qos.backlogs.emplace_back(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple());
+
+   return &qos.backlogs.back().second;
+}
+
+void Qos::configure(long long threshold, int decimation, int overload)
+{
+   QosState &qos = state();
+
+   qos.threshold = threshold;
+   qos.decimation = decimation > 0 ? decimation : 1;
+   qos.overload = overload > 1 ? overload : 1;
+
+   qos.log.info("load shedding threshold {} us, decimation 1/{}, overload at {}x", {threshold, qos.decimation.load(), qos.overload.load()});
+}
+
+int Qos::level()
+{
+   return state().level.load(std::memory_order_relaxed);
+}
+
+}
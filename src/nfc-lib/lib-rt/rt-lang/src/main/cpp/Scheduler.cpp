@@ -0,0 +1,236 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#undef ERROR
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#include <rt/Logger.h>
+#include <rt/Scheduler.h>
+
+namespace rt {
+
+Scheduler::Profile Scheduler::parse(const std::string &cpuSet, const std::string &policy, int priority)
+{
+   Logger log {"Scheduler"};
+
+   Profile profile;
+
+   std::stringstream ss(cpuSet);
+   std::string item;
+
+   // cpu list with ranges, "0,2-3"
+   while (std::getline(ss, item, ','))
+   {
+      size_t dash = item.find('-');
+
+      try
+      {
+         if (dash != std::string::npos)
+         {
+            int first = std::stoi(item.substr(0, dash));
+            int last = std::stoi(item.substr(dash + 1));
+
+            for (int cpu = first; cpu <= last; cpu++)
+               profile.cpuSet.push_back(cpu);
+         }
+         else if (!item.empty())
+         {
+            profile.cpuSet.push_back(std::stoi(item));
+         }
+      }
+      catch (...)
+      {
+         log.warn("invalid cpu set entry [{}]", {item});
+      }
+   }
+
+   if (policy == "batch")
+      profile.policy = Batch;
+   else if (policy == "idle")
+      profile.policy = Idle;
+   else if (policy == "fifo")
+      profile.policy = Fifo;
+   else if (policy == "rr")
+      profile.policy = RoundRobin;
+   else
+      profile.policy = Default;
+
+   profile.priority = priority;
+
+   return profile;
+}
+
+bool Scheduler::apply(const Profile &profile)
+{
+   Logger log {"Scheduler"};
+
+   bool result = true;
+
+#ifdef _WIN32
+   if (!profile.cpuSet.empty())
+   {
+      DWORD_PTR mask = 0;
+
+      for (int cpu: profile.cpuSet)
+      {
+         if (cpu >= 0 && cpu < (int) sizeof(DWORD_PTR) * 8)
+            mask |= DWORD_PTR(1) << cpu;
+      }
+
+      if (!SetThreadAffinityMask(GetCurrentThread(), mask))
+      {
+         log.warn("error setting thread affinity: {}", {(int) GetLastError()});
+         result = false;
+      }
+   }
+
+   // windows has no policies, map them to thread priority classes
+   int priority = THREAD_PRIORITY_NORMAL;
+
+   switch (profile.policy)
+   {
+      case Fifo:
+      case RoundRobin:
+         priority = profile.priority >= 50 ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+         break;
+      case Idle:
+         priority = THREAD_PRIORITY_IDLE;
+         break;
+      case Batch:
+         priority = THREAD_PRIORITY_BELOW_NORMAL;
+         break;
+      default:
+         priority = std::max(-2, std::min(2, profile.priority));
+         break;
+   }
+
+   if (priority != THREAD_PRIORITY_NORMAL && !SetThreadPriority(GetCurrentThread(), priority))
+   {
+      log.warn("error setting thread priority: {}", {(int) GetLastError()});
+      result = false;
+   }
+#else
+   if (!profile.cpuSet.empty())
+   {
+      cpu_set_t set;
+
+      CPU_ZERO(&set);
+
+      for (int cpu: profile.cpuSet)
+      {
+         if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+      }
+
+      if (int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+      {
+         log.warn("error setting thread affinity: {}", {std::strerror(error)});
+         result = false;
+      }
+   }
+
+   int policy = SCHED_OTHER;
+
+   switch (profile.policy)
+   {
+      case Batch:
+         policy = SCHED_BATCH;
+         break;
+      case Idle:
+         policy = SCHED_IDLE;
+         break;
+      case Fifo:
+         policy = SCHED_FIFO;
+         break;
+      case RoundRobin:
+         policy = SCHED_RR;
+         break;
+   }
+
+   if (policy == SCHED_FIFO || policy == SCHED_RR)
+   {
+      sched_param param {std::max(sched_get_priority_min(policy), std::min(sched_get_priority_max(policy), profile.priority))};
+
+      // requires CAP_SYS_NICE or a rtprio limit
+      if (int error = pthread_setschedparam(pthread_self(), policy, &param))
+      {
+         log.warn("error setting thread policy: {}", {std::strerror(error)});
+         result = false;
+      }
+   }
+   else
+   {
+      sched_param param {0};
+
+      if (profile.policy != Default)
+      {
+         if (int error = pthread_setschedparam(pthread_self(), policy, &param))
+         {
+            log.warn("error setting thread policy: {}", {std::strerror(error)});
+            result = false;
+         }
+      }
+
+      // non real-time priority is the inverted per-thread nice value
+      if (profile.priority != 0 && setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), -profile.priority) < 0)
+      {
+         log.warn("error setting thread nice value: {}", {std::strerror(errno)});
+         result = false;
+      }
+   }
+#endif
+
+   return result;
+}
+
+std::string Scheduler::describe(const Profile &profile)
+{
+   static const char *policies[] = {"default", "batch", "idle", "fifo", "rr"};
+
+   std::stringstream ss;
+
+   ss << "cpuSet [";
+
+   for (size_t i = 0; i < profile.cpuSet.size(); i++)
+      ss << (i ? "," : "") << profile.cpuSet[i];
+
+   ss << "] policy " << policies[profile.policy % 5] << " priority " << profile.priority;
+
+   return ss.str();
+}
+
+}
@@ -0,0 +1,312 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <rt/Tracer.h>
+
+// spans kept per thread, must be power of two
+#ifndef TRACE_THREAD_SPANS
+#define TRACE_THREAD_SPANS 32768
+#endif
+
+// finished threads whose spans are kept for export, older rings are reused by new threads
+#ifndef TRACE_FINISHED_THREADS
+#define TRACE_FINISHED_THREADS 16
+#endif
+
+namespace rt {
+
+struct TraceSpan
+{
+   const char *name;
+   const char *category;
+   long long begin;
+   long long end;
+   unsigned long long id;
+   int flow;
+};
+
+// single writer ring owned by one thread
+struct TraceBuffer
+{
+   int tid;
+
+   std::string name;
+
+   std::vector<TraceSpan> spans;
+
+   // total spans written, only increased by owner thread
+   std::atomic<unsigned long long> written {0};
+
+   explicit TraceBuffer(int tid) : tid(tid)
+   {
+   }
+};
+
+struct TraceRegistry
+{
+   std::mutex mutex;
+
+   // buffers exported by dump, kept after their threads finish so spans can still be exported
+   std::list<std::unique_ptr<TraceBuffer>> buffers;
+
+   // exported buffers of finished threads, oldest first
+   std::deque<TraceBuffer *> finished;
+
+   // buffers evicted from export, rings reused by new threads
+   std::vector<std::unique_ptr<TraceBuffer>> spare;
+
+   // timeline id of next thread
+   int nextTid = 1;
+
+   // interned names
+   std::set<std::string> names;
+
+   // time origin for exported timestamps
+   long long epoch = 0;
+};
+
+static TraceRegistry &registry()
+{
+   static TraceRegistry instance;
+
+   return instance;
+}
+
+// buffer of calling thread, handed back to registry when thread finishes
+struct TraceLocal
+{
+   TraceBuffer *buffer = nullptr;
+
+   ~TraceLocal()
+   {
+      if (!buffer)
+         return;
+
+      TraceRegistry &reg = registry();
+
+      std::lock_guard<std::mutex> lock(reg.mutex);
+
+      reg.finished.push_back(buffer);
+
+      // evict oldest finished threads from export, their rings go to spare list
+      while (reg.finished.size() > TRACE_FINISHED_THREADS)
+      {
+         TraceBuffer *oldest = reg.finished.front();
+
+         reg.finished.pop_front();
+
+         for (auto it = reg.buffers.begin(); it != reg.buffers.end(); ++it)
+         {
+            if (it->get() == oldest)
+            {
+               reg.spare.push_back(std::move(*it));
+               reg.buffers.erase(it);
+               break;
+            }
+         }
+      }
+
+      buffer = nullptr;
+   }
+};
+
+static thread_local TraceLocal local;
+
+static TraceBuffer *buffer()
+{
+   if (!local.buffer)
+   {
+      TraceRegistry &reg = registry();
+
+      std::lock_guard<std::mutex> lock(reg.mutex);
+
+      if (reg.spare.empty())
+      {
+         reg.buffers.push_back(std::make_unique<TraceBuffer>(reg.nextTid++));
+      }
+      else
+      {
+         // ring keeps its allocation, previous spans are discarded
+         reg.buffers.push_back(std::move(reg.spare.back()));
+         reg.spare.pop_back();
+
+         reg.buffers.back()->tid = reg.nextTid++;
+         reg.buffers.back()->name.clear();
+         reg.buffers.back()->written.store(0, std::memory_order_relaxed);
+      }
+
+      local.buffer = reg.buffers.back().get();
+   }
+
+   return local.buffer;
+}
+
+static void escape(FILE *file, const char *value)
+{
+   for (const char *c = value; *c; c++)
+   {
+      if (*c == '"' || *c == '\\')
+         fputc('\\', file);
+
+      fputc(*c, file);
+   }
+}
+
+std::atomic<bool> Tracer::active {false};
+
+void Tracer::enable(bool value)
+{
+   TraceRegistry &reg = registry();
+
+   {
+      std::lock_guard<std::mutex> lock(reg.mutex);
+
+      if (!reg.epoch)
+         reg.epoch = now();
+   }
+
+   active.store(value, std::memory_order_relaxed);
+}
+
+long long Tracer::now()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::span(const char *name, const char *category, long long begin, long long end, unsigned long long id, int flow)
+{
+   TraceBuffer *target = buffer();
+
+   // ring is allocated on first span, so naming threads costs nothing while tracing is disabled
+   if (target->spans.empty())
+      target->spans.resize(TRACE_THREAD_SPANS);
+
+   unsigned long long index = target->written.load(std::memory_order_relaxed);
+
+   target->spans[index & (TRACE_THREAD_SPANS - 1)] = {name, category, begin, end, id, flow};
+
+   target->written.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::thread(const std::string &name)
+{
+   TraceBuffer *target = buffer();
+
+   std::lock_guard<std::mutex> lock(registry().mutex);
+
+   target->name = name;
+}
+
+const char *Tracer::intern(const std::string &value)
+{
+   TraceRegistry &reg = registry();
+
+   std::lock_guard<std::mutex> lock(reg.mutex);
+
+   return reg.names.insert(value).first->c_str();
+}
+
+bool Tracer::dump(const std::string &path)
+{
+   TraceRegistry &reg = registry();
+
+   std::lock_guard<std::mutex> lock(reg.mutex);
+
+   FILE *file = fopen(path.c_str(), "w");
+
+   if (!file)
+      return false;
+
+   std::vector<TraceSpan> spans;
+
+   bool first = true;
+
+   fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+   for (const auto &entry: reg.buffers)
+   {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", first ? "" : ",\n", entry->tid);
+      escape(file, entry->name.empty() ? "thread" : entry->name.c_str());
+      fputs("\"}}", file);
+
+      first = false;
+
+      // copy spans first, then discard those overwritten by the owner thread while copying
+      unsigned long long end = entry->written.load(std::memory_order_acquire);
+      unsigned long long start = end > TRACE_THREAD_SPANS ? end - TRACE_THREAD_SPANS : 0;
+
+      spans.clear();
+
+      for (unsigned long long i = start; i < end; i++)
+         spans.push_back(entry->spans[i & (TRACE_THREAD_SPANS - 1)]);
+
+      unsigned long long after = entry->written.load(std::memory_order_acquire);
+      unsigned long long valid = after > TRACE_THREAD_SPANS ? after - TRACE_THREAD_SPANS : 0;
+
+      for (unsigned long long i = start; i < end; i++)
+      {
+         const TraceSpan &span = spans[i - start];
+
+         if (i < valid)
+            continue;
+
+         fputs(",\n{\"name\":\"", file);
+         escape(file, span.name);
+         fputs("\",\"cat\":\"", file);
+         escape(file, span.category);
+         fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", entry->tid, double(span.begin - reg.epoch) / 1E3, double(span.end - span.begin) / 1E3);
+
+         if (span.id)
+         {
+            fprintf(file, ",\"args\":{\"buffer\":%llu}", span.id);
+
+            if (span.flow)
+               fprintf(file, ",\"bind_id\":\"0x%llx\"", span.id);
+
+            if (span.flow & FlowIn)
+               fputs(",\"flow_in\":true", file);
+
+            if (span.flow & FlowOut)
+               fputs(",\"flow_out\":true", file);
+         }
+
+         fputs("}", file);
+      }
+   }
+
+   fputs("\n]}\n", file);
+
+   return fclose(file) == 0;
+}
+
+}
@@ -29,6 +29,7 @@
 #include <utility>
 
 #include <rt/Logger.h>
+#include <rt/Tracer.h>
 #include <rt/Worker.h>
 
 namespace rt {
@@ -55,6 +56,12 @@ struct Worker::Impl
    // terminate flag
    std::atomic<int> terminated {0};
 
+   // pending notification flag, guarded by sleepMutex
+   bool signaled = false;
+
+   // thread scheduling profile, applied when worker starts
+   Scheduler::Profile profile;
+
    explicit Impl(const std::string &name, int interval) : log(name), name(name), interval(interval)
    {
    }
@@ -64,19 +71,34 @@ struct Worker::Impl
       terminate();
    }
 
-   // wait and wait for notification
-   inline void wait(int milliseconds)
+   // wait until notified, timeout expired or terminated, pending notifications return immediately
+   inline bool wait(int milliseconds)
    {
+      Tracer::Scope scope("wait", "worker");
+
       std::unique_lock<std::mutex> lock(sleepMutex);
 
       if (milliseconds > 0)
-         sync.wait_for(lock, std::chrono::milliseconds(milliseconds));
+         sync.wait_for(lock, std::chrono::milliseconds(milliseconds), [this] { return signaled || terminated; });
       else
-         sync.wait(lock);
+         sync.wait(lock, [this] { return signaled || terminated; });
+
+      bool notified = signaled;
+
+      signaled = false;
+
+      return notified;
    }
 
+   // flag is kept until next wait, so notifications sent while worker is busy are not lost
    inline void notify()
    {
+      {
+         std::lock_guard<std::mutex> lock(sleepMutex);
+
+         signaled = true;
+      }
+
       sync.notify_one();
    }
 
@@ -87,6 +109,10 @@ struct Worker::Impl
       if (!terminated.fetch_add(1))
       {
          // notify
+         {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+         }
+
          sync.notify_one();
 
          // wait until worker finish
@@ -109,9 +135,9 @@ bool Worker::alive()
    return !impl->terminated;
 }
 
-void Worker::wait(int milliseconds)
+bool Worker::wait(int milliseconds)
 {
-   impl->wait(milliseconds);
+   return impl->wait(milliseconds);
 }
 
 void Worker::notify()
@@ -119,6 +145,11 @@ void Worker::notify()
    impl->notify();
 }
 
+void Worker::setProfile(const Scheduler::Profile &profile)
+{
+   impl->profile = profile;
+}
+
 void Worker::terminate()
 {
    impl->terminate();
@@ -130,12 +161,27 @@ void Worker::run()
 
    impl->log.info("started worker for task {}", {impl->name});
 
+   // setup thread affinity and priority
+   if (!impl->profile.cpuSet.empty() || impl->profile.policy != Scheduler::Default || impl->profile.priority)
+   {
+      impl->log.info("apply scheduling profile {}", {Scheduler::describe(impl->profile)});
+
+      Scheduler::apply(impl->profile);
+   }
+
+   // name thread in timeline, each loop iteration is traced as one span
+   Tracer::thread(impl->name);
+
+   const char *span = Tracer::intern(impl->name);
+
    // call workert start
    this->start();
 
    // run until worker terminated
    while (!impl->terminated)
    {
+      Tracer::Scope scope(span, "loop");
+
       if (!this->loop())
       {
          break;
@@ -29,6 +29,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <optional>
+#include <utility>
 
 namespace rt {
 
@@ -74,7 +75,7 @@ class BlockingQueue
 
       BlockingQueue() = default;
 
-      inline void add(T e)
+      inline void add(const T &e)
       {
          std::lock_guard<std::mutex> lock(mutex);
 
@@ -82,19 +83,30 @@ class BlockingQueue
          queue.push_back(e);
 
          // notify for unlock wait
-         sync.notify_all();
+         sync.notify_one();
+      }
+
+      inline void add(T &&e)
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+
+         // move element to list
+         queue.push_back(std::move(e));
+
+         // notify for unlock wait
+         sync.notify_one();
       }
 
       template<typename... A>
-      inline void add(A &&... args)
+      inline void emplace(A &&... args)
       {
          std::lock_guard<std::mutex> lock(mutex);
 
-         // add element to list
+         // construct element in place
          queue.emplace_back(std::forward<A>(args)...);
 
          // notify for unlock wait
-         sync.notify_all();
+         sync.notify_one();
       }
 
       inline std::optional<T> get(int milliseconds = 0)
@@ -118,9 +130,10 @@ class BlockingQueue
             }
          }
 
-         auto value = queue.front();
+         // move element out of the list, avoids copy of shared payloads
+         std::optional<T> value {std::move(queue.front())};
 
-         queue.erase(queue.begin());
+         queue.pop_front();
 
          return value;
       }
@@ -99,6 +99,12 @@ class Buffer
             alloc->attach();
       }
 
+      Buffer(Buffer &&other) noexcept : state(other.state), alloc(other.alloc)
+      {
+         other.state = {0, 0, 0};
+         other.alloc = nullptr;
+      }
+
       explicit Buffer(T *data, unsigned int capacity, unsigned int type = 0, unsigned int stride = 1, void *context = nullptr) : state(0, capacity, capacity), alloc(new Alloc(type, capacity, stride, context))
       {
          if (data && capacity)
@@ -132,6 +138,23 @@ class Buffer
          return *this;
       }
 
+      inline Buffer &operator=(Buffer &&other) noexcept
+      {
+         if (&other == this)
+            return *this;
+
+         if (alloc && alloc->detach() == 0)
+            delete alloc;
+
+         state = other.state;
+         alloc = other.alloc;
+
+         other.state = {0, 0, 0};
+         other.alloc = nullptr;
+
+         return *this;
+      }
+
       inline bool operator==(const Buffer &other) const
       {
          if (this == &other)
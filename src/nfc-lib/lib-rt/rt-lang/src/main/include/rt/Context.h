@@ -0,0 +1,104 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_CONTEXT_H
+#define LANG_CONTEXT_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+
+#include <rt/Subject.h>
+
+namespace rt {
+
+/*
+ * Pipeline context, a namespace for the subjects that connect a set of tasks
+ */
+class Context
+{
+      struct Impl
+      {
+         std::string name;
+
+         std::mutex mutex;
+
+         // subjects owned by this context, by name and type
+         std::map<std::string, std::shared_ptr<void>> subjects;
+
+         explicit Impl(std::string name) : name(std::move(name))
+         {
+         }
+      };
+
+      std::shared_ptr<Impl> impl;
+
+   public:
+
+      // global context, subjects are shared by the whole process through Subject<T>::name
+      Context() = default;
+
+      // isolated context, subjects are released with the last copy of the context
+      explicit Context(const std::string &name) : impl(std::make_shared<Impl>(name))
+      {
+      }
+
+      bool isGlobal() const
+      {
+         return !impl;
+      }
+
+      std::string name() const
+      {
+         return impl ? impl->name : std::string();
+      }
+
+      // name of per context resources like loggers, unchanged for global context
+      std::string qualify(const std::string &value) const
+      {
+         return impl ? value + "@" + impl->name : value;
+      }
+
+      template<typename T>
+      Subject<T> *subject(const std::string &id) const
+      {
+         if (!impl)
+            return Subject<T>::name(id);
+
+         std::lock_guard<std::mutex> lock(impl->mutex);
+
+         auto &entry = impl->subjects[id + ":" + typeid(T).name()];
+
+         if (!entry)
+            entry = std::make_shared<Subject<T>>(impl->name + "." + id);
+
+         return static_cast<Subject<T> *>(entry.get());
+      }
+};
+
+}
+
+#endif
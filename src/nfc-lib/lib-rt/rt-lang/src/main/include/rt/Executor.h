@@ -25,7 +25,14 @@
 #ifndef LANG_EXECUTOR_H
 #define LANG_EXECUTOR_H
 
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include <rt/Task.h>
+#include <rt/Promise.h>
 
 namespace rt {
 
@@ -35,12 +42,68 @@ class Executor
 
    public:
 
+      typedef std::function<void()> Job;
+
       explicit Executor(int poolSize = 100, int coreSize = 4);
 
       ~Executor();
 
+      // submit long-lived task, runs until terminated
       void submit(Task *task);
 
+      // schedule short job, from a pool thread goes to the local queue
+      void execute(Job job);
+
+      // schedule short job and resolve / reject promise when finished
+      void execute(Job job, Promise promise);
+
+      // schedule short job and return future for its result
+      template<typename F>
+      auto async(F function) -> std::future<decltype(function())>
+      {
+         typedef decltype(function()) R;
+
+         auto task = std::make_shared<std::packaged_task<R()>>(std::move(function));
+
+         auto result = task->get_future();
+
+         execute([task] { (*task)(); });
+
+         return result;
+      }
+
+      // split range [begin, end) in chunks of grain size and run them in parallel, calling thread participates
+      void parallelFor(long begin, long end, long grain, const std::function<void(long, long)> &function);
+
+      // parallel map of each chunk and ordered reduction of partial results
+      template<typename T, typename M, typename R>
+      T parallelReduce(long begin, long end, long grain, T identity, M map, R reduce)
+      {
+         if (end <= begin)
+            return identity;
+
+         if (grain < 1)
+            grain = 1;
+
+         std::vector<T> partial((end - begin + grain - 1) / grain, identity);
+
+         parallelFor(begin, end, grain, [&](long from, long to) {
+            partial[(from - begin) / grain] = map(from, to);
+         });
+
+         T result = identity;
+
+         for (auto &value : partial)
+         {
+            result = reduce(result, value);
+         }
+
+         return result;
+      }
+
+      // number of threads in pool
+      int concurrency() const;
+
       void shutdown();
 
    private:
@@ -0,0 +1,88 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_FILEWRITER_H
+#define LANG_FILEWRITER_H
+
+#include <memory>
+#include <string>
+
+namespace rt {
+
+/*
+ * Sequential file writer with its own I/O thread. Data is copied into large aligned blocks which are handed
+ * to the thread when full, so callers only block when all blocks are in flight. On Linux the file is opened
+ * with O_DIRECT when the filesystem supports it, bypassing page cache for long captures; other systems use
+ * buffered stdio writes, still issued from the I/O thread.
+ */
+class FileWriter
+{
+      struct Impl;
+
+   public:
+
+      explicit FileWriter(const std::string &name, unsigned int blockSize = 4 * 1024 * 1024, unsigned int blockCount = 3);
+
+      const std::string &name() const;
+
+      // create or truncate file and start I/O thread
+      bool open();
+
+      // write pending data, stop I/O thread and set final file size
+      void close();
+
+      bool isOpen() const;
+
+      // true if page cache is bypassed
+      bool isDirect() const;
+
+      // true after any failed write, further data is discarded
+      bool hasError() const;
+
+      // queue data for writing, blocks only while no free block is available
+      bool write(const void *data, unsigned int size);
+
+      // bytes accepted by write
+      long long size() const;
+
+      // bytes stored in file
+      long long written() const;
+
+      // bytes accepted and not yet stored
+      long long backlog() const;
+
+      // microseconds spent by writers waiting for a free block
+      long long stallTime() const;
+
+      // microseconds spent by I/O thread in write calls
+      long long busyTime() const;
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #define LANG_FORMAT_H
 
 #include <string>
+#include <vector>
 #include <initializer_list>
 
 #include <rt/Variant.h>
@@ -35,6 +36,33 @@ namespace rt
 
 class Format
 {
+   public:
+
+      /*
+       * Format string parsed once into literal and placeholder tokens, reusable for any number of calls
+       */
+      class Pattern
+      {
+            struct Token
+            {
+               // literal text, or placeholder options such as ".2"
+               std::string text;
+
+               bool placeholder;
+            };
+
+            std::vector<Token> tokens;
+
+         public:
+
+            explicit Pattern(const std::string &fmt);
+
+            // append formatted content to output, unused placeholders are kept as is
+            void format(std::string &output, const Variant *parameters, int count) const;
+
+            std::string format(const std::vector<Variant> &parameters) const;
+      };
+
    public:
 
       static std::string format(const std::string &fmt, const std::vector<Variant> &parameters);
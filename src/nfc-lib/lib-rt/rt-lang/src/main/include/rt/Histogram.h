@@ -0,0 +1,165 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_LAB_HISTOGRAM_H
+#define NFC_LAB_HISTOGRAM_H
+
+#include <algorithm>
+#include <vector>
+
+namespace rt {
+
+/*
+ * Log-linear histogram, values below 64 are exact and larger ones are kept with 5 bits of precision (~3% error)
+ */
+class Histogram
+{
+   public:
+
+      static constexpr int LINEAR = 64;
+      static constexpr int PRECISION = 5;
+      static constexpr int BUCKETS = LINEAR + (64 - 6) * (1 << PRECISION);
+
+   private:
+
+      // counts per bucket
+      std::vector<unsigned long long> buckets;
+
+      // total count
+      unsigned long long total = 0;
+
+      // max value
+      unsigned long long highest = 0;
+
+   public:
+
+      Histogram() : buckets(BUCKETS)
+      {
+      }
+
+      inline void add(unsigned long long value, unsigned long long count = 1)
+      {
+         buckets[index(value)] += count;
+
+         total += count;
+
+         if (value > highest)
+            highest = value;
+      }
+
+      inline void merge(const Histogram &other)
+      {
+         for (int i = 0; i < BUCKETS; i++)
+            buckets[i] += other.buckets[i];
+
+         total += other.total;
+
+         if (other.highest > highest)
+            highest = other.highest;
+      }
+
+      inline void clear()
+      {
+         std::fill(buckets.begin(), buckets.end(), 0);
+
+         total = 0;
+         highest = 0;
+      }
+
+      // value at given percentile (0 to 100), mid point of the bucket
+      inline unsigned long long percentile(double p) const
+      {
+         if (!total)
+            return 0;
+
+         unsigned long long rank = (unsigned long long) (p / 100.0 * double(total) + 0.5);
+
+         if (rank < 1)
+            rank = 1;
+
+         unsigned long long seen = 0;
+
+         for (int i = 0; i < BUCKETS; i++)
+         {
+            seen += buckets[i];
+
+            if (seen >= rank)
+            {
+               unsigned long long value = lower(i) + (upper(i) - lower(i)) / 2;
+
+               return value < highest ? value : highest;
+            }
+         }
+
+         return highest;
+      }
+
+      inline unsigned long long count() const
+      {
+         return total;
+      }
+
+      inline unsigned long long max() const
+      {
+         return highest;
+      }
+
+      inline unsigned long long bucketCount(int i) const
+      {
+         return buckets[i];
+      }
+
+      static inline int index(unsigned long long value)
+      {
+         if (value < LINEAR)
+            return (int) value;
+
+         int msb = 63 - __builtin_clzll(value);
+         int shift = msb - PRECISION;
+
+         return LINEAR + (msb - 6) * (1 << PRECISION) + (int) ((value >> shift) & ((1 << PRECISION) - 1));
+      }
+
+      // lowest value of bucket
+      static inline unsigned long long lower(int i)
+      {
+         if (i < LINEAR)
+            return i;
+
+         int msb = (i - LINEAR) / (1 << PRECISION) + 6;
+         int sub = (i - LINEAR) % (1 << PRECISION);
+
+         return ((unsigned long long) ((1 << PRECISION) + sub)) << (msb - PRECISION);
+      }
+
+      // highest value of bucket
+      static inline unsigned long long upper(int i)
+      {
+         return i + 1 < BUCKETS ? lower(i + 1) - 1 : ~0ULL;
+      }
+};
+
+}
+
+#endif //NFC_LAB_HISTOGRAM_H
@@ -26,6 +26,8 @@
 #define LANG_LOGGER_H
 
 #include <cstdio>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 #include <initializer_list>
@@ -52,22 +54,102 @@ class Logger
 
       explicit Logger(const std::string &name, int level = INFO);
 
-      void trace(const std::string &format, std::vector<Variant> params = {}) const;
+      /*
+       * String literals are stored by address and only parsed by the writer thread, so they must
+       * match the const array overloads. Any other format, including const char * pointers and
+       * mutable char arrays, goes through the std::string overloads and is copied.
+       */
+      template <std::size_t N>
+      void trace(const char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         push(TRACE, format, params);
+      }
 
-      void debug(const std::string &format, std::vector<Variant> params = {}) const;
+      template <std::size_t N>
+      void trace(char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         print(TRACE, std::string(format), params);
+      }
 
-      void info(const std::string &format, std::vector<Variant> params = {}) const;
+      void trace(const std::string &format, std::initializer_list<Variant> params = {}) const;
 
-      void warn(const std::string &format, std::vector<Variant> params = {}) const;
+      template <std::size_t N>
+      void debug(const char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         push(DEBUG, format, params);
+      }
 
-      void error(const std::string &format, std::vector<Variant> params = {}) const;
+      template <std::size_t N>
+      void debug(char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         print(DEBUG, std::string(format), params);
+      }
+
+      void debug(const std::string &format, std::initializer_list<Variant> params = {}) const;
+
+      template <std::size_t N>
+      void info(const char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         push(INFO, format, params);
+      }
 
-      void print(int level, const std::string &format, std::vector<Variant> params = {}) const;
+      template <std::size_t N>
+      void info(char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         print(INFO, std::string(format), params);
+      }
+
+      void info(const std::string &format, std::initializer_list<Variant> params = {}) const;
+
+      template <std::size_t N>
+      void warn(const char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         push(WARN, format, params);
+      }
+
+      template <std::size_t N>
+      void warn(char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         print(WARN, std::string(format), params);
+      }
+
+      void warn(const std::string &format, std::initializer_list<Variant> params = {}) const;
+
+      template <std::size_t N>
+      void error(const char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         push(ERROR, format, params);
+      }
+
+      template <std::size_t N>
+      void error(char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         print(ERROR, std::string(format), params);
+      }
+
+      void error(const std::string &format, std::initializer_list<Variant> params = {}) const;
+
+      template <std::size_t N>
+      void print(int level, const char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         push(level, format, params);
+      }
+
+      template <std::size_t N>
+      void print(int level, char (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         print(level, std::string(format), params);
+      }
+
+      void print(int level, const std::string &format, std::initializer_list<Variant> params = {}) const;
 
       void setLevel(int value);
 
    private:
 
+      // literal format path, stored by address
+      void push(int level, const char *format, std::initializer_list<Variant> params) const;
+
       std::shared_ptr<Impl> impl;
 };
 
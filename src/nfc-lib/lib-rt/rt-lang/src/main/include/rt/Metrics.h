@@ -0,0 +1,116 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_METRICS_H
+#define LANG_METRICS_H
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#include <rt/Histogram.h>
+
+namespace rt {
+
+/*
+ * Process wide registry of named series, exported in Prometheus text format
+ */
+class Metrics
+{
+   public:
+
+      typedef std::map<std::string, std::string> Labels;
+
+      // monotonic counter, striped across cache lines so concurrent writers do not contend
+      class Counter
+      {
+            static constexpr int STRIPES = 16;
+
+            struct alignas(64) Stripe
+            {
+               std::atomic<unsigned long long> value {0};
+            };
+
+            Stripe stripes[STRIPES];
+
+         public:
+
+            void add(unsigned long long count = 1);
+
+            unsigned long long value() const;
+      };
+
+      // last value
+      class Gauge
+      {
+            std::atomic<double> current {0};
+
+         public:
+
+            void set(double value);
+
+            void add(double value);
+
+            double value() const;
+      };
+
+      // concurrent log-linear histogram with the same bucket layout as rt::Histogram
+      class Histogram
+      {
+            std::atomic<unsigned long long> buckets[rt::Histogram::BUCKETS] {};
+            std::atomic<unsigned long long> samples {0};
+            std::atomic<unsigned long long> highest {0};
+            std::atomic<unsigned long long> accumulated {0};
+
+         public:
+
+            void add(unsigned long long value);
+
+            // copy of current values, safe to call while other threads are adding
+            rt::Histogram snapshot() const;
+
+            unsigned long long count() const;
+
+            unsigned long long sum() const;
+      };
+
+   public:
+
+      // find or create series, returned pointers remain valid for the process lifetime
+      static Counter *counter(const std::string &name, const std::string &help, const Labels &labels = {});
+
+      static Gauge *gauge(const std::string &name, const std::string &help, const Labels &labels = {});
+
+      static Histogram *histogram(const std::string &name, const std::string &help, const Labels &labels = {});
+
+      // render all series in Prometheus text exposition format
+      static std::string format();
+
+      // write all series to file, replaced atomically so scrapers never read partial content
+      static bool dump(const std::string &path);
+};
+
+}
+
+#endif
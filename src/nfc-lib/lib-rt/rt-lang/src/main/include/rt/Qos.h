@@ -0,0 +1,91 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_QOS_H
+#define LANG_QOS_H
+
+#include <atomic>
+#include <string>
+
+#include <rt/Metrics.h>
+
+namespace rt {
+
+/*
+ * Load shedding for best-effort consumers, driven by the backlog reported by critical consumers
+ */
+class Qos
+{
+   public:
+
+      enum Level
+      {
+         Normal = 0, // all buffers admitted
+         Degraded = 1, // best-effort consumers are decimated
+         Overload = 2 // best-effort consumers are skipped
+      };
+
+      // pending work of one critical consumer, in microseconds of signal
+      class Backlog
+      {
+            std::atomic<long long> value {0};
+
+            friend class Qos;
+
+         public:
+
+            void update(long long micros);
+      };
+
+      // admission control for one best-effort consumer
+      class Gate
+      {
+            unsigned int sequence = 0;
+
+            Metrics::Counter *admitted;
+
+            Metrics::Counter *shed;
+
+         public:
+
+            explicit Gate(const std::string &name, const Metrics::Labels &labels = {});
+
+            // true if buffer must be processed, otherwise it is counted as shed
+            bool admit();
+      };
+
+   public:
+
+      // find or create backlog for critical consumer
+      static Backlog *backlog(const std::string &name);
+
+      // backlog above threshold degrades best-effort consumers to 1 of decimation buffers, above overload factor they are skipped
+      static void configure(long long threshold, int decimation, int overload);
+
+      static int level();
+};
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_SCHEDULER_H
+#define LANG_SCHEDULER_H
+
+#include <string>
+#include <vector>
+
+namespace rt {
+
+class Scheduler
+{
+   public:
+
+      enum Policy
+      {
+         Default = 0,
+         Batch = 1,
+         Idle = 2,
+         Fifo = 3,
+         RoundRobin = 4
+      };
+
+      struct Profile
+      {
+         // allowed CPUs, empty for any
+         std::vector<int> cpuSet;
+
+         // scheduling policy
+         int policy = Default;
+
+         // real-time priority for Fifo / RoundRobin, higher is more priority (nice value inverted for others)
+         int priority = 0;
+      };
+
+   public:
+
+      // build profile from config values, cpu set as "0,2-3" and policy as default, batch, idle, fifo or rr
+      static Profile parse(const std::string &cpuSet, const std::string &policy, int priority);
+
+      // apply profile to calling thread, returns false if any setting is rejected by the system
+      static bool apply(const Profile &profile);
+
+      static std::string describe(const Profile &profile);
+};
+
+}
+
+#endif
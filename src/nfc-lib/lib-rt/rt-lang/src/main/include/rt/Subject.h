@@ -28,6 +28,7 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <utility>
 
@@ -43,7 +44,7 @@ class Subject
    public:
 
       typedef Finally Subscription;
-      typedef std::function<void(T)> NextHandler;
+      typedef std::function<void(const T &)> NextHandler;
       typedef std::function<void(int, std::string)> ErrorHandler;
       typedef std::function<void()> CloseHandler;
 
@@ -107,7 +108,7 @@ class Subject
       inline Subscription subscribe(NextHandler next, ErrorHandler error = nullptr, CloseHandler close = nullptr)
       {
          // append observer to list
-         auto &observer = observers.emplace_back(observers.size() + 1, next, error, close);
+         auto &observer = observers.emplace_back(observers.size() + 1, std::move(next), std::move(error), std::move(close));
          log.info("created subscription {} ({}) on subject {}", {observer.index, (void*) &observer, id});
 
          // emit retained values
@@ -0,0 +1,101 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_TRACER_H
+#define LANG_TRACER_H
+
+#include <atomic>
+#include <string>
+
+namespace rt {
+
+/*
+ * Opt-in timeline tracer, spans are recorded in per-thread rings and exported as Chrome trace-event JSON (Perfetto)
+ */
+class Tracer
+{
+   public:
+
+      // link spans that share a buffer id, producer uses FlowOut and consumers FlowIn (or both if they forward it)
+      enum Flow
+      {
+         NoFlow = 0,
+         FlowIn = 1,
+         FlowOut = 2
+      };
+
+      // span from construction to destruction, name and category must have static storage
+      class Scope
+      {
+            const char *name;
+            const char *category;
+            unsigned long long id;
+            int flow;
+            long long begin;
+
+         public:
+
+            explicit Scope(const char *name, const char *category, unsigned long long id = 0, int flow = NoFlow) : name(name), category(category), id(id), flow(flow), begin(enabled() ? now() : -1)
+            {
+            }
+
+            ~Scope()
+            {
+               if (begin >= 0)
+                  span(name, category, begin, now(), id, flow);
+            }
+      };
+
+   private:
+
+      static std::atomic<bool> active;
+
+   public:
+
+      static inline bool enabled()
+      {
+         return active.load(std::memory_order_relaxed);
+      }
+
+      static void enable(bool value);
+
+      // monotonic time in nanoseconds
+      static long long now();
+
+      // record completed span for calling thread, oldest spans are overwritten when thread ring is full
+      static void span(const char *name, const char *category, long long begin, long long end, unsigned long long id = 0, int flow = NoFlow);
+
+      // set timeline name for calling thread
+      static void thread(const std::string &name);
+
+      // stable copy of dynamic strings for use as span names
+      static const char *intern(const std::string &value);
+
+      // write recorded spans in trace-event format, safe to call while other threads are recording
+      static bool dump(const std::string &path);
+};
+
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include <mutex>
 
 #include <rt/Task.h>
+#include <rt/Scheduler.h>
 
 namespace rt {
 
@@ -41,10 +42,12 @@ class Worker : public rt::Task
 
       bool alive();
 
-      void wait(int milliseconds = 0);
+      bool wait(int milliseconds = 0);
 
       void notify();
 
+      void setProfile(const Scheduler::Profile &profile);
+
       std::string name() override;
 
       void terminate() override;
@@ -22,13 +22,31 @@
 
 */
 
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+#include <x86intrin.h>
+
+#endif
+
 #include <queue>
 #include <mutex>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstring>
 
 #include <airspy.h>
 
+extern "C" {
+#include <filters.h>
+#include <iqconverter_float.h>
+}
+
 #include <rt/Logger.h>
+#include <rt/Buffer.h>
+#include <rt/Scheduler.h>
+#include <rt/BlockingQueue.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
@@ -36,6 +54,15 @@
 
 #define MAX_QUEUE_SIZE 4
 
+// raw blocks waiting for conversion, about 100ms at 10 Msps
+#define MAX_RAW_QUEUE_SIZE 16
+
+// raw blocks kept for reuse, must cover queued blocks plus the one being converted
+#define MAX_RAW_POOL_SIZE 20
+
+// 12 bit samples scale, same as libairspy float conversion
+#define RAW_SAMPLE_SCALE (1.0f / 2048.0f)
+
 namespace sdr {
 
 int process_transfer(airspy_transfer *transfer);
@@ -68,8 +95,24 @@ struct AirspyDevice::Impl
    std::queue<SignalBuffer> streamQueue;
    RadioDevice::StreamHandler streamCallback;
 
-   long samplesReceived = 0;
-   long samplesDropped = 0;
+   // raw transfer block, as copied from libairspy consumer thread
+   struct RawBlock
+   {
+      rt::Buffer<unsigned char> data;
+      long long captureTime;
+   };
+
+   // raw transfers are converted in stream worker, away from libairspy consumer thread
+   int transferMode = AirspyDevice::Converted;
+   std::atomic_bool workerStreaming {false};
+   std::thread workerThread;
+   rt::BlockingQueue<RawBlock> rawQueue;
+   std::vector<rt::Buffer<unsigned char>> rawPool;
+   std::vector<uint16_t> rawUnpacked;
+   iqconverter_float_t *rawConverter = nullptr;
+
+   std::atomic<long> samplesReceived {0};
+   std::atomic<long> samplesDropped {0};
 
    explicit Impl(std::string name) : deviceName(std::move(name))
    {
@@ -86,6 +129,9 @@ struct AirspyDevice::Impl
       log.debug("destroy AirspyDevice");
 
       close();
+
+      if (rawConverter)
+         iqconverter_float_free(rawConverter);
    }
 
    static std::vector<std::string> listDevices()
@@ -156,9 +202,8 @@ struct AirspyDevice::Impl
          if ((airspyResult = airspy_board_partid_serialno_read(handle, &airspySerial)) != AIRSPY_SUCCESS)
             log.warn("failed airspy_board_partid_serialno_read: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
 
-         // set sample type
-         if ((airspyResult = airspy_set_sample_type(handle, airspySample)) != AIRSPY_SUCCESS)
-            log.warn("failed airspy_set_sample_type: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
+         // set sample type and packing
+         setTransferMode(transferMode);
 
          // set version string
          deviceVersion = std::string(tmp);
@@ -225,13 +270,32 @@ struct AirspyDevice::Impl
          streamCallback = std::move(handler);
          streamQueue = std::queue<SignalBuffer>();
 
+         // start conversion worker for raw transfers
+         if (transferMode != AirspyDevice::Converted)
+         {
+            if (!rawConverter)
+               rawConverter = iqconverter_float_create(HB_KERNEL_FLOAT, HB_KERNEL_FLOAT_LEN);
+            else
+               iqconverter_float_reset(rawConverter);
+
+            rawQueue.clear();
+
+            workerStreaming = true;
+
+            workerThread = std::thread([this] { streamWorker(); });
+         }
+
          // start reception
          if ((airspyResult = airspy_start_rx(airspyHandle, reinterpret_cast<airspy_sample_block_cb_fn>(process_transfer), this)) != AIRSPY_SUCCESS)
             log.warn("failed airspy_start_rx: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
 
          // clear callback to disable receiver
          if (airspyResult != AIRSPY_SUCCESS)
+         {
+            stopWorker();
+
             streamCallback = nullptr;
+         }
 
          // sets stream start time
          streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
@@ -244,7 +308,7 @@ struct AirspyDevice::Impl
 
    int stop()
    {
-      if (airspyHandle && streamCallback)
+      if (airspyHandle && (streamCallback || workerThread.joinable()))
       {
          log.info("stop streaming for device {}", {deviceName});
 
@@ -252,6 +316,9 @@ struct AirspyDevice::Impl
          if ((airspyResult = airspy_stop_rx(airspyHandle)) != AIRSPY_SUCCESS)
             log.warn("failed airspy_stop_rx: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
 
+         // stop conversion worker, once no more transfers are received
+         stopWorker();
+
          // disable stream callback and queue
          streamCallback = nullptr;
          streamQueue = std::queue<SignalBuffer>();
@@ -414,6 +481,41 @@ struct AirspyDevice::Impl
       return 0;
    }
 
+   int setTransferMode(int value)
+   {
+      if (value < AirspyDevice::Converted || value > AirspyDevice::Packed)
+         return -1;
+
+      // sample type and packing can only be changed with reception stopped, restart stream with same handler
+      if (airspyHandle && airspy_is_streaming(airspyHandle))
+      {
+         auto handler = streamCallback;
+
+         stop();
+
+         setTransferMode(value);
+
+         return start(handler);
+      }
+
+      transferMode = value;
+      airspySample = transferMode == AirspyDevice::Converted ? AIRSPY_SAMPLE_FLOAT32_IQ : AIRSPY_SAMPLE_RAW;
+
+      if (airspyHandle)
+      {
+         if ((airspyResult = airspy_set_sample_type(airspyHandle, airspySample)) != AIRSPY_SUCCESS)
+            log.warn("failed airspy_set_sample_type: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
+
+         // packed transfers carry 12 bit samples, reduces USB bandwidth by 25%
+         if ((airspyResult = airspy_set_packing(airspyHandle, transferMode == AirspyDevice::Packed)) != AIRSPY_SUCCESS)
+            log.warn("failed airspy_set_packing: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
+
+         return airspyResult;
+      }
+
+      return 0;
+   }
+
    int setDecimation(int value)
    {
       decimation = value;
@@ -483,6 +585,187 @@ struct AirspyDevice::Impl
       return result;
    }
 
+   void stopWorker()
+   {
+      if (workerThread.joinable())
+      {
+         workerStreaming = false;
+
+         // empty block wakes up the worker waiting on queue
+         rawQueue.add({});
+
+         workerThread.join();
+
+         rawQueue.clear();
+         rawPool.clear();
+      }
+   }
+
+   // called from libairspy consumer thread, only copies transfer payload
+   void streamRaw(const airspy_transfer *transfer)
+   {
+      unsigned int length = transferMode == AirspyDevice::Packed ? transfer->sample_count * 3 / 2 : transfer->sample_count * 2;
+
+      // discard new transfer if worker can not keep up, so queued samples stay contiguous
+      if (rawQueue.size() >= MAX_RAW_QUEUE_SIZE)
+      {
+         samplesDropped += transfer->sample_count / 2;
+         return;
+      }
+
+      RawBlock block {acquireBlock(length), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()};
+
+      std::memcpy(block.data.pull(length), transfer->samples, length);
+
+      block.data.flip();
+
+      rawQueue.add(std::move(block));
+   }
+
+   // take a block no longer referenced by worker, or allocate a new one when all are in use
+   rt::Buffer<unsigned char> acquireBlock(unsigned int length)
+   {
+      for (auto &block: rawPool)
+      {
+         if (block.references() == 1 && block.capacity() >= length)
+            return block.clear();
+      }
+
+      rt::Buffer<unsigned char> block(length);
+
+      if (rawPool.size() < MAX_RAW_POOL_SIZE)
+         rawPool.push_back(block);
+
+      return block;
+   }
+
+   void streamWorker()
+   {
+      // raise worker priority over decoding threads, cpu set is inherited from receiver thread
+      rt::Scheduler::Profile profile;
+
+      profile.policy = rt::Scheduler::Fifo;
+      profile.priority = 20;
+
+      if (!rt::Scheduler::apply(profile))
+         log.warn("unable to raise stream worker priority, samples may be dropped under load");
+
+      log.info("stream worker started for device {}", {deviceName});
+
+      while (workerStreaming)
+      {
+         auto block = rawQueue.get(-1);
+
+         if (workerStreaming && block->data.isValid())
+         {
+            const auto *data = block->data.data();
+
+            unsigned int count = transferMode == AirspyDevice::Packed ? block->data.limit() * 2 / 3 : block->data.limit() / 2;
+
+            // unpack 12 bit samples
+            if (transferMode == AirspyDevice::Packed)
+            {
+               rawUnpacked.resize(count);
+
+               unpackSamples(reinterpret_cast<const uint32_t *>(data), rawUnpacked.data(), count);
+
+               data = reinterpret_cast<const unsigned char *>(rawUnpacked.data());
+            }
+
+            SignalBuffer buffer = SignalBuffer(count, 2, sampleRate, samplesReceived, 0, SignalType::SAMPLE_IQ);
+
+            float *samples = buffer.pull(count);
+
+            // scale real samples, then remove DC and translate to IQ at half rate
+            convertSamples(reinterpret_cast<const uint16_t *>(data), samples, count);
+
+            iqconverter_float_process(rawConverter, samples, (int) count);
+
+            buffer.flip();
+
+            // stamp buffer with transfer completion time
+            buffer.setCaptureTime(block->captureTime);
+
+            // update counters
+            samplesReceived += count / 2;
+
+            streamBuffer(buffer);
+         }
+      }
+
+      log.info("stream worker finished for device {}", {deviceName});
+   }
+
+   // same layout as libairspy packed transfers, 8 samples in 3 words
+   static void unpackSamples(const uint32_t *input, uint16_t *output, unsigned int length)
+   {
+      for (unsigned int i = 0, j = 0; j < length; i += 3, j += 8)
+      {
+         output[j + 0] = (input[i] >> 20) & 0xfff;
+         output[j + 1] = (input[i] >> 8) & 0xfff;
+         output[j + 2] = ((input[i] & 0xff) << 4) | ((input[i + 1] >> 28) & 0xf);
+         output[j + 3] = ((input[i + 1] & 0xfff0000) >> 16);
+         output[j + 4] = ((input[i + 1] & 0xfff0) >> 4);
+         output[j + 5] = ((input[i + 1] & 0xf) << 8) | ((input[i + 2] & 0xff000000) >> 24);
+         output[j + 6] = ((input[i + 2] >> 12) & 0xfff);
+         output[j + 7] = ((input[i + 2] & 0xfff));
+      }
+   }
+
+   // convert unsigned 12 bit samples to float
+   static void convertSamples(const uint16_t *src, float *dst, unsigned int length)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128i zero = _mm_setzero_si128();
+      const __m128 scale = _mm_set1_ps(RAW_SAMPLE_SCALE);
+      const __m128 offset = _mm_set1_ps(2048.0f);
+
+      for (; i + 8 <= length; i += 8)
+      {
+         __m128i w = _mm_loadu_si128((const __m128i *) (src + i));
+
+         // widen to 32 bits and convert to float
+         __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w, zero));
+         __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w, zero));
+
+         // center and scale
+         _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_sub_ps(f0, offset), scale));
+         _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_sub_ps(f1, offset), scale));
+      }
+#endif
+
+      for (; i < length; i++)
+         dst[i] = float(src[i] - 2048) * RAW_SAMPLE_SCALE;
+   }
+
+   void streamBuffer(SignalBuffer &buffer)
+   {
+      // stream to buffer callback
+      if (streamCallback)
+      {
+         streamCallback(buffer);
+      }
+
+         // or store buffer in receive queue
+      else
+      {
+         // lock buffer access
+         std::lock_guard<std::mutex> lock(streamMutex);
+
+         // discard oldest buffers
+         if (streamQueue.size() >= MAX_QUEUE_SIZE)
+         {
+            samplesDropped += streamQueue.front().elements();
+            streamQueue.pop();
+         }
+
+         // queue new sample buffer
+         streamQueue.push(buffer);
+      }
+   }
+
    int read(SignalBuffer &buffer)
    {
       // lock buffer access
@@ -522,6 +805,16 @@ std::vector<std::string> AirspyDevice::listDevices()
    return Impl::listDevices();
 }
 
+int AirspyDevice::transferMode() const
+{
+   return impl->transferMode;
+}
+
+int AirspyDevice::setTransferMode(int value)
+{
+   return impl->setTransferMode(value);
+}
+
 const std::string &AirspyDevice::name()
 {
    return impl->deviceName;
@@ -748,49 +1041,47 @@ int process_transfer(airspy_transfer *transfer)
    // check device validity
    if (auto *device = static_cast<AirspyDevice::Impl *>(transfer->ctx))
    {
-      SignalBuffer buffer;
-
-      switch (transfer->sample_type)
+      // raw samples, count real samples dropped by libairspy as IQ samples
+      if (transfer->sample_type == AIRSPY_SAMPLE_RAW)
       {
-         case AIRSPY_SAMPLE_FLOAT32_REAL:
-            buffer = SignalBuffer((float *) transfer->samples, transfer->sample_count, 1, device->sampleRate, device->samplesReceived, 0, SignalType::SAMPLE_REAL);
-            break;
+         device->samplesDropped += transfer->dropped_samples / 2;
 
-         case AIRSPY_SAMPLE_FLOAT32_IQ:
-            buffer = SignalBuffer((float *) transfer->samples, transfer->sample_count * 2, 2, device->sampleRate, device->samplesReceived, 0, SignalType::SAMPLE_IQ);
-            break;
+         device->streamRaw(transfer);
       }
-
-      // update counters
-      device->samplesReceived += transfer->sample_count;
-      device->samplesDropped += transfer->dropped_samples;
-
-      // stream to buffer callback
-      if (device->streamCallback)
-      {
-         device->streamCallback(buffer);
-      }
-
-         // or store buffer in receive queue
       else
       {
-         // lock buffer access
-         std::lock_guard<std::mutex> lock(device->streamMutex);
+         // transfer completion time, for latency measures
+         auto captureTime = std::chrono::steady_clock::now().time_since_epoch();
 
-         // discard oldest buffers
-         if (device->streamQueue.size() >= MAX_QUEUE_SIZE)
+         SignalBuffer buffer;
+
+         switch (transfer->sample_type)
          {
-            device->samplesDropped += device->streamQueue.front().elements();
-            device->streamQueue.pop();
+            case AIRSPY_SAMPLE_FLOAT32_REAL:
+               buffer = SignalBuffer((float *) transfer->samples, transfer->sample_count, 1, device->sampleRate, device->samplesReceived, 0, SignalType::SAMPLE_REAL);
+               break;
+
+            case AIRSPY_SAMPLE_FLOAT32_IQ:
+               buffer = SignalBuffer((float *) transfer->samples, transfer->sample_count * 2, 2, device->sampleRate, device->samplesReceived, 0, SignalType::SAMPLE_IQ);
+               break;
+
+            default:
+               break;
          }
 
-         // queue new sample buffer
-         device->streamQueue.push(buffer);
+         // stamp buffer
+         buffer.setCaptureTime(std::chrono::duration_cast<std::chrono::nanoseconds>(captureTime).count());
+
+         // update counters
+         device->samplesReceived += transfer->sample_count;
+         device->samplesDropped += transfer->dropped_samples;
+
+         device->streamBuffer(buffer);
       }
 
       // trace dropped samples
       if (transfer->dropped_samples > 0)
-         device->log.warn("dropped samples {}", {device->samplesDropped});
+         device->log.warn("dropped samples {}", {device->samplesDropped.load()});
 
       // continue streaming
       return 0;
@@ -799,4 +1090,4 @@ int process_transfer(airspy_transfer *transfer)
    return -1;
 }
 
-}
\ No newline at end of file
+}
@@ -24,6 +24,8 @@
 
 #include <sdr/AirspyDevice.h>
 #include <sdr/RealtekDevice.h>
+#include <sdr/RtlTcpDevice.h>
+#include <sdr/SimulatedDevice.h>
 #include <sdr/DeviceFactory.h>
 
 namespace sdr {
@@ -51,6 +53,13 @@ RadioDevice *DeviceFactory::newInstance(const std::string &name)
    if (name.rfind("rtlsdr://", 0) == 0)
       return new RealtekDevice(name);
 
+   // network devices and recording replay are not listed as they are not discoverable
+   if (name.rfind("rtltcp://", 0) == 0)
+      return new RtlTcpDevice(name);
+
+   if (name.rfind("sim://", 0) == 0)
+      return new SimulatedDevice(name);
+
    //   if (name.startsWith("lime://"))
 //      return new LimeDevice(name, parent);
 
@@ -0,0 +1,1468 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <deque>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#include <rt/Logger.h>
+#include <rt/Executor.h>
+#include <rt/FileWriter.h>
+
+#include <sdr/PackedFile.h>
+
+// container format version
+#define PACK_VERSION 1
+
+// sample frames per block, unit for parallel coding and seek
+#define BLOCK_FRAMES 65536
+
+// sample frames sharing same predictor within a block
+#define SUBBLOCK_FRAMES 4096
+
+// residuals sharing same Rice parameter
+#define PARTITION_SIZE 256
+
+// predictor limits, LPC order is stored in 3 bits and coefficients with LPC_PRECISION bits including sign
+#define MAX_FIXED_ORDER 4
+#define MAX_LPC_ORDER 8
+#define LPC_PRECISION 14
+
+// residuals beyond this magnitude can't be Rice coded, subframe is stored verbatim
+#define MAX_RESIDUAL (1LL << 30)
+
+// subframe coding modes
+#define MODE_CONSTANT 0
+#define MODE_VERBATIM 1
+#define MODE_FIXED 2
+#define MODE_LPC 3
+
+// asynchronous writer blocks for container output
+#define WRITE_BLOCK_SIZE (4 * 1024 * 1024)
+#define WRITE_BLOCK_COUNT 3
+
+namespace sdr {
+
+struct PackHeader
+{
+   char magic[4]; // 4 bytes
+   unsigned int version; // 4 bytes
+   unsigned int sampleRate; // 4 bytes
+   unsigned int sampleSize; // 4 bytes
+   unsigned int channelCount; // 4 bytes
+   unsigned int streamTime; // 4 bytes
+   unsigned int blockFrames; // 4 bytes
+   unsigned int blockCount; // 4 bytes, zero until file is finished
+   unsigned int frameCountLow; // 4 bytes
+   unsigned int frameCountHigh; // 4 bytes
+   unsigned int indexOffsetLow; // 4 bytes
+   unsigned int indexOffsetHigh; // 4 bytes
+};
+
+struct PackBlock
+{
+   char magic[4]; // 4 bytes
+   unsigned int frames; // 4 bytes
+   unsigned int size; // 4 bytes, coded payload following this header
+};
+
+struct PackIndex
+{
+   char magic[4]; // 4 bytes
+   unsigned int count; // 4 bytes, followed by 64 bit offset of each block
+};
+
+// MSB first bit packing
+struct BitWriter
+{
+   std::vector<unsigned char> &data;
+   unsigned long long value = 0;
+   int count = 0;
+
+   explicit BitWriter(std::vector<unsigned char> &data) : data(data)
+   {
+   }
+
+   // append up to 32 bits
+   inline void put(unsigned int bits, int length)
+   {
+      value = (value << length) | (bits & ((1ULL << length) - 1));
+      count += length;
+
+      while (count >= 8)
+      {
+         count -= 8;
+         data.push_back((unsigned char) (value >> count));
+      }
+   }
+
+   inline void putSigned(int bits, int length)
+   {
+      put((unsigned int) bits, length);
+   }
+
+   // quotient in unary, ones terminated, followed by k low bits
+   inline void putRice(unsigned long long u, int k)
+   {
+      unsigned long long q = u >> k;
+
+      if (q + 1 + k <= 32)
+      {
+         put((unsigned int) ((1ULL << k) | (u & ((1ULL << k) - 1))), (int) q + 1 + k);
+         return;
+      }
+
+      for (; q >= 32; q -= 32)
+         put(0, 32);
+
+      put(0, (int) q);
+      put((unsigned int) ((1ULL << k) | (u & ((1ULL << k) - 1))), k + 1);
+   }
+
+   void flush()
+   {
+      if (count > 0)
+         put(0, 8 - count);
+   }
+};
+
+struct BitReader
+{
+   const unsigned char *data;
+   size_t size;
+   size_t offset = 0;
+   unsigned long long value = 0; // MSB aligned
+   int count = 0;
+
+   BitReader(const unsigned char *data, size_t size) : data(data), size(size)
+   {
+   }
+
+   inline void refill()
+   {
+      while (count <= 56)
+      {
+         value |= (unsigned long long) (offset < size ? data[offset] : 0) << (56 - count);
+         offset++;
+         count += 8;
+      }
+   }
+
+   inline unsigned int get(int length)
+   {
+      if (!length)
+         return 0;
+
+      refill();
+
+      auto bits = (unsigned int) (value >> (64 - length));
+
+      value <<= length;
+      count -= length;
+
+      return bits;
+   }
+
+   inline int getSigned(int length)
+   {
+      unsigned int bits = get(length);
+      unsigned int sign = 1u << (length - 1);
+
+      return (int) ((bits ^ sign) - sign);
+   }
+
+   inline long long getRice(int k)
+   {
+      unsigned long long q = 0;
+
+      for (;;)
+      {
+         refill();
+
+         if (value)
+            break;
+
+         q += count;
+         count = 0;
+
+         // no terminating bit before end of data
+         if (overrun())
+            return 0;
+      }
+
+      int zeros = __builtin_clzll(value);
+
+      q += zeros;
+      value = zeros < 63 ? value << (zeros + 1) : 0;
+      count -= zeros + 1;
+
+      unsigned long long u = (q << k) | get(k);
+
+      return (long long) (u >> 1) ^ -(long long) (u & 1);
+   }
+
+   bool overrun() const
+   {
+      return offset > size + 8;
+   }
+};
+
+struct PackedFile::Impl
+{
+   rt::Logger log {"PackedFile"};
+
+   std::string name;
+
+   Format format {};
+
+   int threads;
+   int openMode = 0;
+   bool error = false;
+
+   // bytes per sample frame
+   unsigned int frameSize = 0;
+
+   // blocks are coded on pool threads
+   std::shared_ptr<rt::Executor> executor;
+
+   // time spent coding, updated from pool threads
+   std::shared_ptr<std::atomic<long long>> busyCounter = std::make_shared<std::atomic<long long>>(0);
+
+   // file offset of each block
+   std::vector<long long> index;
+
+   long long frameCount = 0;
+   long long rawCount = 0;
+   long long packedCount = 0;
+   long long stallCount = 0;
+
+   // write mode, PCM of block being filled and blocks being coded in file order
+   std::shared_ptr<rt::FileWriter> writer;
+   std::vector<unsigned char> pending;
+   std::deque<std::pair<unsigned int, std::future<std::vector<unsigned char>>>> coding;
+
+   // read mode, blocks decoded ahead and current one
+   std::ifstream file;
+   std::deque<std::future<std::vector<unsigned char>>> decoding;
+   std::vector<unsigned char> decoded;
+   size_t decodedOffset = 0;
+   size_t nextBlock = 0;
+   size_t skipBytes = 0;
+   unsigned int blockFrames = BLOCK_FRAMES;
+
+   explicit Impl(std::string name, int threads) : name(std::move(name)), threads(threads > 0 ? threads : std::max(1, (int) std::thread::hardware_concurrency() - 1))
+   {
+   }
+
+   ~Impl()
+   {
+      close();
+   }
+
+   bool create(const Format &value)
+   {
+      close();
+
+      if (value.sampleSize != 8 && value.sampleSize != 16 && value.sampleSize != 24)
+      {
+         log.warn("unsupported sample size {} for packed file [{}]", {value.sampleSize, name});
+         return false;
+      }
+
+      if (value.channelCount < 1)
+         return false;
+
+      reset(value);
+
+      writer = std::make_shared<rt::FileWriter>(name, WRITE_BLOCK_SIZE, WRITE_BLOCK_COUNT);
+
+      if (!writer->open())
+      {
+         log.warn("unable to create packed file [{}]", {name});
+         writer.reset();
+         return false;
+      }
+
+      // placeholder, counters and index location are updated on close
+      PackHeader header = buildHeader();
+
+      writer->write(&header, sizeof(header));
+
+      packedCount = sizeof(header);
+
+      pending.reserve(blockFrames * frameSize);
+
+      executor = std::make_shared<rt::Executor>(128, threads);
+
+      openMode = 2;
+
+      log.info("created packed file [{}] using {} threads", {name, threads});
+
+      return true;
+   }
+
+   bool open()
+   {
+      close();
+
+      file.open(name, std::ios::in | std::ios::binary);
+
+      if (!file.is_open())
+         return false;
+
+      PackHeader header {};
+
+      if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.magic, "IQZF", 4) != 0 || header.version != PACK_VERSION)
+      {
+         log.warn("invalid packed file [{}]", {name});
+         file.close();
+         return false;
+      }
+
+      Format value {(int) header.sampleRate, (int) header.sampleSize, (int) header.channelCount, (long) header.streamTime};
+
+      if ((value.sampleSize != 8 && value.sampleSize != 16 && value.sampleSize != 24) || value.channelCount < 1 || !header.blockFrames)
+      {
+         log.warn("unsupported format in packed file [{}]", {name});
+         file.close();
+         return false;
+      }
+
+      reset(value);
+
+      blockFrames = header.blockFrames;
+
+      long long indexOffset = (long long) header.indexOffsetHigh << 32 | header.indexOffsetLow;
+
+      // unfinished files have no index, blocks are located by walking their headers
+      if (!indexOffset || !readIndex(indexOffset, header.blockCount))
+      {
+         if (!scanBlocks())
+         {
+            file.close();
+            return false;
+         }
+
+         log.info("recovered {} blocks from unfinished packed file [{}]", {index.size(), name});
+      }
+      else
+      {
+         frameCount = (long long) header.frameCountHigh << 32 | header.frameCountLow;
+      }
+
+      executor = std::make_shared<rt::Executor>(128, threads);
+
+      openMode = 1;
+
+      return true;
+   }
+
+   void close()
+   {
+      if (openMode == 2)
+      {
+         // code remaining frames and wait for all blocks
+         submitBlock();
+
+         storeBlocks(true);
+
+         // append index
+         PackIndex entry {{'I', 'N', 'D', 'X'}, (unsigned int) index.size()};
+
+         long long indexOffset = packedCount;
+
+         writer->write(&entry, sizeof(entry));
+         writer->write(index.data(), index.size() * sizeof(long long));
+
+         packedCount += sizeof(entry) + index.size() * sizeof(long long);
+
+         writer->close();
+
+         error |= writer->hasError();
+
+         // rewrite header in place once counters are known
+         PackHeader header = buildHeader();
+
+         header.blockCount = index.size();
+         header.frameCountLow = (unsigned int) frameCount;
+         header.frameCountHigh = (unsigned int) (frameCount >> 32);
+         header.indexOffsetLow = (unsigned int) indexOffset;
+         header.indexOffsetHigh = (unsigned int) (indexOffset >> 32);
+
+         std::fstream output(name, std::ios::in | std::ios::out | std::ios::binary);
+
+         output.write(reinterpret_cast<char *>(&header), sizeof(header));
+
+         error |= !output.good();
+
+         log.info("closed packed file [{}], {} frames in {} blocks, ratio {.2}", {name, frameCount, index.size(), packedCount ? (double) rawCount / packedCount : 0.0});
+      }
+
+      decoding.clear();
+      coding.clear();
+
+      if (file.is_open())
+         file.close();
+
+      executor.reset();
+
+      openMode = 0;
+   }
+
+   void reset(const Format &value)
+   {
+      format = value;
+      frameSize = format.channelCount * format.sampleSize / 8;
+      blockFrames = BLOCK_FRAMES;
+      error = false;
+      index.clear();
+      pending.clear();
+      decoded.clear();
+      decodedOffset = 0;
+      nextBlock = 0;
+      skipBytes = 0;
+      frameCount = 0;
+      rawCount = 0;
+      packedCount = 0;
+      stallCount = 0;
+      busyCounter->store(0);
+   }
+
+   bool write(const void *data, unsigned int size)
+   {
+      if (openMode != 2 || error)
+         return false;
+
+      auto src = static_cast<const unsigned char *>(data);
+
+      size_t blockSize = (size_t) blockFrames * frameSize;
+
+      while (size)
+      {
+         unsigned int length = std::min<size_t>(size, blockSize - pending.size());
+
+         pending.insert(pending.end(), src, src + length);
+
+         src += length;
+         size -= length;
+
+         if (pending.size() == blockSize)
+            submitBlock();
+      }
+
+      storeBlocks(false);
+
+      return !error;
+   }
+
+   // queue filled block for coding, whole frames only
+   void submitBlock()
+   {
+      unsigned int frames = pending.size() / frameSize;
+
+      if (!frames)
+         return;
+
+      if (pending.size() % frameSize)
+         log.warn("discarding {} bytes of incomplete sample frame", {pending.size() % frameSize});
+
+      Format value = format;
+      auto busy = busyCounter;
+
+      coding.emplace_back(frames, executor->async([pcm = std::move(pending), frames, value, busy] {
+         auto start = std::chrono::steady_clock::now();
+
+         std::vector<unsigned char> payload = encodeBlock(pcm.data(), frames, value.sampleSize, value.channelCount);
+
+         busy->fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+         return payload;
+      }));
+
+      frameCount += frames;
+
+      pending = {};
+      pending.reserve((size_t) blockFrames * frameSize);
+
+      // bound memory in flight, wait for oldest block once every thread has work queued
+      if (coding.size() > (size_t) threads * 2)
+      {
+         auto start = std::chrono::steady_clock::now();
+
+         coding.front().second.wait();
+
+         stallCount += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+      }
+   }
+
+   // write coded blocks in order, optionally waiting for all of them
+   void storeBlocks(bool wait)
+   {
+      while (!coding.empty() && (wait || coding.front().second.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+      {
+         unsigned int frames = coding.front().first;
+
+         std::vector<unsigned char> payload = coding.front().second.get();
+
+         coding.pop_front();
+
+         PackBlock block {{'B', 'L', 'C', 'K'}, frames, (unsigned int) payload.size()};
+
+         index.push_back(packedCount);
+
+         // raw bytes are counted with their block so the ratio only covers stored data
+         rawCount += (long long) frames * frameSize;
+
+         if (!writer->write(&block, sizeof(block)) || !writer->write(payload.data(), payload.size()))
+            error = true;
+
+         packedCount += sizeof(block) + payload.size();
+      }
+   }
+
+   unsigned int read(void *data, unsigned int size)
+   {
+      if (openMode != 1)
+         return 0;
+
+      auto dst = static_cast<unsigned char *>(data);
+
+      unsigned int length = 0;
+
+      while (length < size)
+      {
+         if (decodedOffset >= decoded.size())
+         {
+            if (!loadBlock())
+               break;
+
+            continue;
+         }
+
+         unsigned int chunk = std::min<size_t>(size - length, decoded.size() - decodedOffset);
+
+         std::memcpy(dst + length, decoded.data() + decodedOffset, chunk);
+
+         decodedOffset += chunk;
+         length += chunk;
+      }
+
+      rawCount += length;
+
+      return length;
+   }
+
+   // take next decoded block, keeping one block per thread decoding ahead
+   bool loadBlock()
+   {
+      fetchBlocks();
+
+      if (decoding.empty())
+         return false;
+
+      auto start = std::chrono::steady_clock::now();
+
+      decoded = decoding.front().get();
+
+      stallCount += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+      decoding.pop_front();
+
+      if (decoded.empty())
+      {
+         log.error("corrupted block in packed file [{}]", {name});
+
+         error = true;
+         decoding.clear();
+         nextBlock = index.size();
+
+         return false;
+      }
+
+      decodedOffset = std::min(skipBytes, decoded.size());
+      skipBytes = 0;
+
+      fetchBlocks();
+
+      return true;
+   }
+
+   void fetchBlocks()
+   {
+      while (decoding.size() < (size_t) threads && nextBlock < index.size())
+      {
+         PackBlock block {};
+
+         std::vector<unsigned char> payload;
+
+         file.clear();
+
+         if (file.seekg(index[nextBlock]) && file.read(reinterpret_cast<char *>(&block), sizeof(block)) && std::memcmp(block.magic, "BLCK", 4) == 0)
+         {
+            payload.resize(block.size);
+
+            if (!file.read(reinterpret_cast<char *>(payload.data()), block.size))
+               payload.clear();
+         }
+
+         packedCount += sizeof(block) + payload.size();
+
+         Format value = format;
+         auto busy = busyCounter;
+         unsigned int frames = block.frames;
+
+         decoding.push_back(executor->async([payload = std::move(payload), frames, value, busy] {
+            auto start = std::chrono::steady_clock::now();
+
+            std::vector<unsigned char> pcm = decodeBlock(payload.data(), payload.size(), frames, value.sampleSize, value.channelCount);
+
+            busy->fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+            return pcm;
+         }));
+
+         nextBlock++;
+      }
+   }
+
+   bool seek(long long frame)
+   {
+      if (openMode != 1 || frame < 0)
+         return false;
+
+      frame = std::min(frame, frameCount);
+
+      // pending blocks are dropped, their results are discarded when finished
+      decoding.clear();
+      decoded.clear();
+      decodedOffset = 0;
+
+      nextBlock = std::min<size_t>(frame / blockFrames, index.size());
+      skipBytes = (size_t) (frame - (long long) nextBlock * blockFrames) * frameSize;
+
+      return true;
+   }
+
+   bool isEof() const
+   {
+      return openMode == 1 && nextBlock >= index.size() && decoding.empty() && decodedOffset >= decoded.size();
+   }
+
+   long long backlog() const
+   {
+      long long queued = pending.size();
+
+      for (const auto &entry: coding)
+         queued += (long long) entry.first * frameSize;
+
+      return queued + (writer ? writer->backlog() : 0);
+   }
+
+   bool readIndex(long long offset, unsigned int count)
+   {
+      PackIndex entry {};
+
+      file.clear();
+
+      if (!file.seekg(offset) || !file.read(reinterpret_cast<char *>(&entry), sizeof(entry)))
+         return false;
+
+      if (std::memcmp(entry.magic, "INDX", 4) != 0 || entry.count != count)
+         return false;
+
+      index.resize(count);
+
+      return (bool) file.read(reinterpret_cast<char *>(index.data()), count * sizeof(long long));
+   }
+
+   bool scanBlocks()
+   {
+      file.clear();
+      file.seekg(0, std::ios::end);
+
+      long long fileSize = file.tellg();
+      long long offset = sizeof(PackHeader);
+
+      index.clear();
+      frameCount = 0;
+
+      PackBlock block {};
+
+      // stop at first truncated or invalid block
+      while (offset + (long long) sizeof(block) <= fileSize)
+      {
+         file.seekg(offset);
+
+         if (!file.read(reinterpret_cast<char *>(&block), sizeof(block)) || std::memcmp(block.magic, "BLCK", 4) != 0)
+            break;
+
+         if (offset + (long long) sizeof(block) + block.size > fileSize || block.frames > blockFrames)
+            break;
+
+         index.push_back(offset);
+
+         frameCount += block.frames;
+         offset += sizeof(block) + block.size;
+
+         // only last block may be partial
+         if (block.frames < blockFrames)
+            break;
+      }
+
+      return true;
+   }
+
+   PackHeader buildHeader() const
+   {
+      PackHeader header {};
+
+      std::memcpy(header.magic, "IQZF", 4);
+
+      header.version = PACK_VERSION;
+      header.sampleRate = format.sampleRate;
+      header.sampleSize = format.sampleSize;
+      header.channelCount = format.channelCount;
+      header.streamTime = format.streamTime;
+      header.blockFrames = blockFrames;
+
+      // set on close once blocks and index are written
+      header.blockCount = 0;
+      header.frameCountLow = 0;
+      header.frameCountHigh = 0;
+      header.indexOffsetLow = 0;
+      header.indexOffsetHigh = 0;
+
+      return header;
+   }
+
+   /*
+    * block coding, channels are split and coded in subblocks choosing best of constant, verbatim,
+    * fixed polynomial or quantized LPC prediction, residuals are Rice coded by partitions
+    */
+   static std::vector<unsigned char> encodeBlock(const unsigned char *pcm, unsigned int frames, int sampleSize, int channelCount)
+   {
+      std::vector<int> samples((size_t) frames * channelCount);
+
+      unpack(pcm, samples.data(), frames, sampleSize, channelCount);
+
+      std::vector<unsigned char> payload;
+
+      payload.reserve((size_t) frames * channelCount * sampleSize / 8 + 1024);
+
+      BitWriter writer(payload);
+
+      std::vector<long long> residual(SUBBLOCK_FRAMES);
+      std::vector<long long> candidate(SUBBLOCK_FRAMES);
+
+      for (unsigned int start = 0; start < frames; start += SUBBLOCK_FRAMES)
+      {
+         unsigned int length = std::min(frames - start, (unsigned int) SUBBLOCK_FRAMES);
+
+         for (int channel = 0; channel < channelCount; channel++)
+         {
+            encodeSubframe(writer, samples.data() + (size_t) channel * frames + start, length, sampleSize, residual.data(), candidate.data());
+         }
+      }
+
+      writer.flush();
+
+      return payload;
+   }
+
+   static std::vector<unsigned char> decodeBlock(const unsigned char *payload, size_t size, unsigned int frames, int sampleSize, int channelCount)
+   {
+      if (!frames || !size)
+         return {};
+
+      std::vector<int> samples((size_t) frames * channelCount);
+
+      BitReader reader(payload, size);
+
+      for (unsigned int start = 0; start < frames; start += SUBBLOCK_FRAMES)
+      {
+         unsigned int length = std::min(frames - start, (unsigned int) SUBBLOCK_FRAMES);
+
+         for (int channel = 0; channel < channelCount; channel++)
+         {
+            if (!decodeSubframe(reader, samples.data() + (size_t) channel * frames + start, length, sampleSize))
+               return {};
+         }
+      }
+
+      std::vector<unsigned char> pcm((size_t) frames * channelCount * sampleSize / 8);
+
+      pack(samples.data(), pcm.data(), frames, sampleSize, channelCount);
+
+      return pcm;
+   }
+
+   static void encodeSubframe(BitWriter &writer, const int *x, unsigned int n, int bits, long long *residual, long long *candidate)
+   {
+      bool constant = true;
+
+      for (unsigned int i = 1; i < n && constant; i++)
+         constant = x[i] == x[0];
+
+      if (constant)
+      {
+         writer.put(MODE_CONSTANT, 2);
+         writer.putSigned(x[0], bits);
+         return;
+      }
+
+      long long bestSize = 2 + (long long) n * bits;
+      int bestMode = MODE_VERBATIM;
+      int bestOrder = 0;
+      int bestShift = 0;
+      int coefficients[MAX_LPC_ORDER] {};
+      int candidateCoefficients[MAX_LPC_ORDER] {};
+
+      // short tails are not worth predicting
+      if (n > 2 * MAX_LPC_ORDER)
+      {
+         // fixed polynomial predictor with lowest absolute error
+         int order = fixedOrder(x, n);
+
+         if (fixedResidual(x, n, order, residual))
+         {
+            long long size = 2 + 3 + (long long) order * bits + riceSize(residual + order, n - order);
+
+            if (size < bestSize)
+            {
+               bestSize = size;
+               bestMode = MODE_FIXED;
+               bestOrder = order;
+            }
+         }
+
+         // linear prediction from windowed autocorrelation
+         int shift = 0;
+
+         if (int lpcOrder = lpcCoefficients(x, n, bits, candidateCoefficients, shift))
+         {
+            if (lpcResidual(x, n, lpcOrder, candidateCoefficients, shift, candidate))
+            {
+               long long size = 2 + 3 + 5 + (long long) lpcOrder * (LPC_PRECISION + bits) + riceSize(candidate + lpcOrder, n - lpcOrder);
+
+               if (size < bestSize)
+               {
+                  bestSize = size;
+                  bestMode = MODE_LPC;
+                  bestOrder = lpcOrder;
+                  bestShift = shift;
+
+                  std::swap(residual, candidate);
+                  std::copy(candidateCoefficients, candidateCoefficients + lpcOrder, coefficients);
+               }
+            }
+         }
+      }
+
+      writer.put(bestMode, 2);
+
+      switch (bestMode)
+      {
+         case MODE_VERBATIM:
+         {
+            for (unsigned int i = 0; i < n; i++)
+               writer.putSigned(x[i], bits);
+
+            break;
+         }
+
+         case MODE_FIXED:
+         {
+            writer.put(bestOrder, 3);
+
+            for (int i = 0; i < bestOrder; i++)
+               writer.putSigned(x[i], bits);
+
+            riceEncode(writer, residual + bestOrder, n - bestOrder);
+
+            break;
+         }
+
+         case MODE_LPC:
+         {
+            writer.put(bestOrder - 1, 3);
+            writer.put(bestShift, 5);
+
+            for (int i = 0; i < bestOrder; i++)
+               writer.putSigned(coefficients[i], LPC_PRECISION);
+
+            for (int i = 0; i < bestOrder; i++)
+               writer.putSigned(x[i], bits);
+
+            riceEncode(writer, residual + bestOrder, n - bestOrder);
+
+            break;
+         }
+      }
+   }
+
+   static bool decodeSubframe(BitReader &reader, int *x, unsigned int n, int bits)
+   {
+      switch (reader.get(2))
+      {
+         case MODE_CONSTANT:
+         {
+            std::fill(x, x + n, reader.getSigned(bits));
+            break;
+         }
+
+         case MODE_VERBATIM:
+         {
+            for (unsigned int i = 0; i < n; i++)
+               x[i] = reader.getSigned(bits);
+
+            break;
+         }
+
+         case MODE_FIXED:
+         {
+            int order = reader.get(3);
+
+            if (order > MAX_FIXED_ORDER || order > n)
+               return false;
+
+            for (int i = 0; i < order; i++)
+               x[i] = reader.getSigned(bits);
+
+            unsigned int i = order;
+
+            for (unsigned int start = order; start < n; start += PARTITION_SIZE)
+            {
+               int k = reader.get(5);
+
+               for (unsigned int end = std::min(n, start + PARTITION_SIZE); i < end; i++)
+               {
+                  long long r = reader.getRice(k);
+
+                  switch (order)
+                  {
+                     case 0:
+                        x[i] = (int) r;
+                        break;
+                     case 1:
+                        x[i] = (int) (r + x[i - 1]);
+                        break;
+                     case 2:
+                        x[i] = (int) (r + 2LL * x[i - 1] - x[i - 2]);
+                        break;
+                     case 3:
+                        x[i] = (int) (r + 3LL * x[i - 1] - 3LL * x[i - 2] + x[i - 3]);
+                        break;
+                     case 4:
+                        x[i] = (int) (r + 4LL * x[i - 1] - 6LL * x[i - 2] + 4LL * x[i - 3] - x[i - 4]);
+                        break;
+                  }
+               }
+            }
+
+            break;
+         }
+
+         case MODE_LPC:
+         {
+            int order = reader.get(3) + 1;
+            int shift = reader.get(5);
+            int coefficients[MAX_LPC_ORDER];
+
+            if (order > n)
+               return false;
+
+            for (int i = 0; i < order; i++)
+               coefficients[i] = reader.getSigned(LPC_PRECISION);
+
+            for (int i = 0; i < order; i++)
+               x[i] = reader.getSigned(bits);
+
+            unsigned int i = order;
+
+            for (unsigned int start = order; start < n; start += PARTITION_SIZE)
+            {
+               int k = reader.get(5);
+
+               for (unsigned int end = std::min(n, start + PARTITION_SIZE); i < end; i++)
+               {
+                  long long sum = 0;
+
+                  for (int j = 0; j < order; j++)
+                     sum += (long long) coefficients[j] * x[i - 1 - j];
+
+                  x[i] = (int) (reader.getRice(k) + (sum >> shift));
+               }
+            }
+
+            break;
+         }
+      }
+
+      return !reader.overrun();
+   }
+
+   // order with lowest sum of absolute residuals, as estimated by FLAC
+   static int fixedOrder(const int *x, unsigned int n)
+   {
+      unsigned long long error[MAX_FIXED_ORDER + 1] {};
+
+      for (unsigned int i = MAX_FIXED_ORDER; i < n; i++)
+      {
+         long long e0 = x[i];
+         long long e1 = e0 - x[i - 1];
+         long long e2 = e1 - ((long long) x[i - 1] - x[i - 2]);
+         long long e3 = e2 - ((long long) x[i - 1] - 2LL * x[i - 2] + x[i - 3]);
+         long long e4 = e3 - ((long long) x[i - 1] - 3LL * x[i - 2] + 3LL * x[i - 3] - x[i - 4]);
+
+         error[0] += std::llabs(e0);
+         error[1] += std::llabs(e1);
+         error[2] += std::llabs(e2);
+         error[3] += std::llabs(e3);
+         error[4] += std::llabs(e4);
+      }
+
+      return (int) (std::min_element(error, error + MAX_FIXED_ORDER + 1) - error);
+   }
+
+   static bool fixedResidual(const int *x, unsigned int n, int order, long long *residual)
+   {
+      long long peak = 0;
+
+      for (unsigned int i = order; i < n; i++)
+      {
+         long long r;
+
+         switch (order)
+         {
+            case 0:
+               r = x[i];
+               break;
+            case 1:
+               r = (long long) x[i] - x[i - 1];
+               break;
+            case 2:
+               r = (long long) x[i] - 2LL * x[i - 1] + x[i - 2];
+               break;
+            case 3:
+               r = (long long) x[i] - 3LL * x[i - 1] + 3LL * x[i - 2] - x[i - 3];
+               break;
+            default:
+               r = (long long) x[i] - 4LL * x[i - 1] + 6LL * x[i - 2] - 4LL * x[i - 3] + x[i - 4];
+               break;
+         }
+
+         residual[i] = r;
+         peak |= std::llabs(r);
+      }
+
+      return peak < MAX_RESIDUAL;
+   }
+
+   static bool lpcResidual(const int *x, unsigned int n, int order, const int *coefficients, int shift, long long *residual)
+   {
+      long long peak = 0;
+
+      for (unsigned int i = order; i < n; i++)
+      {
+         long long sum = 0;
+
+         for (int j = 0; j < order; j++)
+            sum += (long long) coefficients[j] * x[i - 1 - j];
+
+         long long r = x[i] - (sum >> shift);
+
+         residual[i] = r;
+         peak |= std::llabs(r);
+      }
+
+      return peak < MAX_RESIDUAL;
+   }
+
+   // Levinson-Durbin on Welch windowed autocorrelation, returns chosen order or zero
+   static int lpcCoefficients(const int *x, unsigned int n, int bits, int *coefficients, int &shift)
+   {
+      double autoc[MAX_LPC_ORDER + 1] {};
+      double window[SUBBLOCK_FRAMES];
+
+      double half = (n - 1) / 2.0;
+
+      for (unsigned int i = 0; i < n; i++)
+      {
+         double t = (i - half) / (half + 1);
+
+         window[i] = x[i] * (1.0 - t * t);
+      }
+
+      for (int lag = 0; lag <= MAX_LPC_ORDER; lag++)
+      {
+         double sum = 0;
+
+         for (unsigned int i = lag; i < n; i++)
+            sum += window[i] * window[i - lag];
+
+         autoc[lag] = sum;
+      }
+
+      if (autoc[0] <= 0)
+         return 0;
+
+      double lpc[MAX_LPC_ORDER] {};
+      double models[MAX_LPC_ORDER][MAX_LPC_ORDER] {};
+      double errors[MAX_LPC_ORDER] {};
+
+      double error = autoc[0];
+      int orders = 0;
+
+      for (int i = 0; i < MAX_LPC_ORDER; i++)
+      {
+         double r = -autoc[i + 1];
+
+         for (int j = 0; j < i; j++)
+            r -= lpc[j] * autoc[i - j];
+
+         r /= error;
+
+         lpc[i] = r;
+
+         int j = 0;
+
+         for (; j < i / 2; j++)
+         {
+            double tmp = lpc[j];
+            lpc[j] += r * lpc[i - 1 - j];
+            lpc[i - 1 - j] += r * tmp;
+         }
+
+         if (i & 1)
+            lpc[j] += lpc[j] * r;
+
+         error *= 1.0 - r * r;
+
+         for (j = 0; j <= i; j++)
+            models[i][j] = -lpc[j];
+
+         errors[i] = error;
+
+         orders = i + 1;
+
+         if (error <= 0)
+            break;
+      }
+
+      // order with lowest estimated size, residual bits from prediction error
+      int order = 0;
+      double bestSize = 0;
+
+      for (int i = 0; i < orders; i++)
+      {
+         double residualBits = errors[i] > 0 ? std::max(0.0, 0.5 * std::log2(errors[i] * 0.5 / n)) : 0;
+         double size = residualBits * (n - i - 1) + (i + 1) * (LPC_PRECISION + bits);
+
+         if (!order || size < bestSize)
+         {
+            order = i + 1;
+            bestSize = size;
+         }
+      }
+
+      // quantize with error feedback so rounding doesn't accumulate
+      const double *model = models[order - 1];
+
+      double peak = 0;
+
+      for (int i = 0; i < order; i++)
+         peak = std::max(peak, std::fabs(model[i]));
+
+      if (peak <= 0 || !std::isfinite(peak))
+         return 0;
+
+      int exponent;
+
+      std::frexp(peak, &exponent);
+
+      shift = std::clamp(LPC_PRECISION - 1 - exponent, 0, 31);
+
+      int limit = (1 << (LPC_PRECISION - 1)) - 1;
+
+      double carry = 0;
+
+      for (int i = 0; i < order; i++)
+      {
+         carry += model[i] * (1 << shift);
+
+         int value = std::clamp((int) std::lround(carry), -limit - 1, limit);
+
+         coefficients[i] = value;
+
+         carry -= value;
+      }
+
+      return order;
+   }
+
+   static inline unsigned long long zigzag(long long value)
+   {
+      return ((unsigned long long) value << 1) ^ (unsigned long long) (value >> 63);
+   }
+
+   // best Rice parameter for a partition and its coded size in bits
+   static int riceParameter(const long long *residual, unsigned int n, long long &size)
+   {
+      unsigned long long sum = 0;
+
+      for (unsigned int i = 0; i < n; i++)
+         sum += zigzag(residual[i]);
+
+      int k = 0;
+
+      // optimal parameter is close to log2 of mean value
+      while (k < 30 && (unsigned long long) n << (k + 1) <= sum)
+         k++;
+
+      int low = std::max(k - 1, 0);
+      int high = std::min(k + 1, 30);
+
+      unsigned long long quotients[3] {};
+
+      for (unsigned int i = 0; i < n; i++)
+      {
+         unsigned long long u = zigzag(residual[i]);
+
+         for (int p = low; p <= high; p++)
+            quotients[p - low] += u >> p;
+      }
+
+      int best = low;
+
+      size = -1;
+
+      for (int p = low; p <= high; p++)
+      {
+         long long bits = 5 + (long long) n * (p + 1) + (long long) quotients[p - low];
+
+         if (size < 0 || bits < size)
+         {
+            size = bits;
+            best = p;
+         }
+      }
+
+      return best;
+   }
+
+   static long long riceSize(const long long *residual, unsigned int n)
+   {
+      long long total = 0;
+
+      for (unsigned int start = 0; start < n; start += PARTITION_SIZE)
+      {
+         long long size;
+
+         riceParameter(residual + start, std::min(n - start, (unsigned int) PARTITION_SIZE), size);
+
+         total += size;
+      }
+
+      return total;
+   }
+
+   static void riceEncode(BitWriter &writer, const long long *residual, unsigned int n)
+   {
+      for (unsigned int start = 0; start < n; start += PARTITION_SIZE)
+      {
+         unsigned int length = std::min(n - start, (unsigned int) PARTITION_SIZE);
+
+         long long size;
+
+         int k = riceParameter(residual + start, length, size);
+
+         writer.put(k, 5);
+
+         for (unsigned int i = 0; i < length; i++)
+            writer.putRice(zigzag(residual[start + i]), k);
+      }
+   }
+
+   // little endian PCM to planar signed samples, 8 bit WAV samples are unsigned
+   static void unpack(const unsigned char *src, int *dst, unsigned int frames, int sampleSize, int channelCount)
+   {
+      for (unsigned int i = 0; i < frames; i++)
+      {
+         for (int c = 0; c < channelCount; c++)
+         {
+            int *out = dst + (size_t) c * frames + i;
+
+            switch (sampleSize)
+            {
+               case 8:
+                  *out = src[0] - 128;
+                  src += 1;
+                  break;
+               case 16:
+                  *out = (short) (src[0] | src[1] << 8);
+                  src += 2;
+                  break;
+               case 24:
+                  *out = (int) ((unsigned int) (src[0] | src[1] << 8 | src[2] << 16) << 8) >> 8;
+                  src += 3;
+                  break;
+            }
+         }
+      }
+   }
+
+   static void pack(const int *src, unsigned char *dst, unsigned int frames, int sampleSize, int channelCount)
+   {
+      for (unsigned int i = 0; i < frames; i++)
+      {
+         for (int c = 0; c < channelCount; c++)
+         {
+            int value = src[(size_t) c * frames + i];
+
+            switch (sampleSize)
+            {
+               case 8:
+                  *dst++ = (unsigned char) (value + 128);
+                  break;
+               case 16:
+                  *dst++ = (unsigned char) value;
+                  *dst++ = (unsigned char) (value >> 8);
+                  break;
+               case 24:
+                  *dst++ = (unsigned char) value;
+                  *dst++ = (unsigned char) (value >> 8);
+                  *dst++ = (unsigned char) (value >> 16);
+                  break;
+            }
+         }
+      }
+   }
+};
+
+PackedFile::PackedFile(const std::string &name, int threads) : impl(std::make_shared<Impl>(name, threads))
+{
+}
+
+bool PackedFile::probe(const std::string &name)
+{
+   char magic[4] {};
+
+   std::ifstream input(name, std::ios::in | std::ios::binary);
+
+   return input.read(magic, sizeof(magic)) && std::memcmp(magic, "IQZF", 4) == 0;
+}
+
+const std::string &PackedFile::name() const
+{
+   return impl->name;
+}
+
+bool PackedFile::create(const Format &format)
+{
+   return impl->create(format);
+}
+
+bool PackedFile::open()
+{
+   return impl->open();
+}
+
+void PackedFile::close()
+{
+   impl->close();
+}
+
+bool PackedFile::isOpen() const
+{
+   return impl->openMode != 0;
+}
+
+bool PackedFile::isEof() const
+{
+   return impl->isEof();
+}
+
+bool PackedFile::hasError() const
+{
+   return impl->error || (impl->writer && impl->writer->hasError());
+}
+
+const PackedFile::Format &PackedFile::format() const
+{
+   return impl->format;
+}
+
+bool PackedFile::write(const void *data, unsigned int size)
+{
+   return impl->write(data, size);
+}
+
+unsigned int PackedFile::read(void *data, unsigned int size)
+{
+   return impl->read(data, size);
+}
+
+bool PackedFile::seek(long long frame)
+{
+   return impl->seek(frame);
+}
+
+long long PackedFile::frameCount() const
+{
+   return impl->frameCount;
+}
+
+long long PackedFile::rawBytes() const
+{
+   return impl->rawCount;
+}
+
+long long PackedFile::packedBytes() const
+{
+   return impl->packedCount;
+}
+
+long long PackedFile::backlog() const
+{
+   return impl->backlog();
+}
+
+long long PackedFile::stallTime() const
+{
+   return impl->stallCount + (impl->writer ? impl->writer->stallTime() : 0);
+}
+
+long long PackedFile::busyTime() const
+{
+   return impl->busyCounter->load();
+}
+
+}
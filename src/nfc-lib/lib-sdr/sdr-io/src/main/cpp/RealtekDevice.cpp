@@ -29,23 +29,39 @@
 #undef ERROR
 #endif
 
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+#include <x86intrin.h>
+
+#endif
+
 #include <queue>
 #include <mutex>
+#include <chrono>
 #include <thread>
+#include <vector>
+#include <atomic>
 
 #include <rtl-sdr.h>
 
 #include <rt/Logger.h>
+#include <rt/Scheduler.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
 #include <sdr/RealtekDevice.h>
 
-#define READER_SAMPLES 2048
 #define BUFFER_SAMPLES 65536
 
+// default async transfers, about 80ms of samples queued in USB stack at 3.2 Msps
+#define TRANSFER_COUNT 8
+#define TRANSFER_SIZE 65536
+
 #define MAX_QUEUE_SIZE 4
 
+// buffers kept for reuse, must cover queued buffers plus the ones held by decoder pipeline
+#define MAX_POOL_SIZE 16
+
 typedef struct rtlsdr_dev *rtldev;
 
 namespace sdr {
@@ -78,6 +94,17 @@ struct RealtekDevice::Impl
    std::atomic_bool workerStreaming {false};
    std::thread workerThread;
 
+   // async reader configuration, changes restart running reader
+   std::atomic<int> transferCount {TRANSFER_COUNT};
+   std::atomic<int> transferSize {TRANSFER_SIZE};
+
+   // buffer being filled by async reader and storage pool to avoid per-buffer allocations
+   SignalBuffer streamBuffer;
+   std::vector<SignalBuffer> bufferPool;
+
+   // sample conversion table
+   float convert[256];
+
    std::mutex streamMutex;
    std::queue<SignalBuffer> streamQueue;
    RadioDevice::StreamHandler streamCallback;
@@ -88,11 +115,17 @@ struct RealtekDevice::Impl
    explicit Impl(std::string name) : deviceName(std::move(name))
    {
       log.debug("created RealtekDevice for name [{}]", {this->deviceName});
+
+      for (int i = 0; i < 256; i++)
+         convert[i] = float(i - 128) / 256.0f + 0.0025f;
    }
 
    explicit Impl(int fileDesc) : fileDesc(fileDesc)
    {
       log.debug("created RealtekDevice for file descriptor [{}]", {fileDesc});
+
+      for (int i = 0; i < 256; i++)
+         convert[i] = float(i - 128) / 256.0f + 0.0025f;
    }
 
    ~Impl()
@@ -250,13 +283,16 @@ struct RealtekDevice::Impl
 
    int stop()
    {
-      if (rtlsdrHandle && workerStreaming)
+      if (rtlsdrHandle && workerThread.joinable())
       {
          log.info("stop streaming for device {}", {deviceName});
 
          // signal finish to running thread
          workerStreaming = false;
 
+         // unblock async reader
+         rtlsdr_cancel_async(rtldev(rtlsdrHandle));
+
          // wait until worker is finished
          std::lock_guard<std::mutex> lock(workerMutex);
 
@@ -266,6 +302,8 @@ struct RealtekDevice::Impl
          // disable stream callback and queue
          streamCallback = nullptr;
          streamQueue = std::queue<SignalBuffer>();
+         streamBuffer = {};
+         bufferPool.clear();
          streamTime = 0;
 
          return 0;
@@ -551,83 +589,193 @@ struct RealtekDevice::Impl
       return -1;
    }
 
+   int setTransferCount(int value)
+   {
+      if (value < 1)
+         return -1;
+
+      transferCount = value;
+
+      // restart async reader with new transfers
+      if (rtlsdrHandle && workerStreaming)
+         rtlsdr_cancel_async(rtldev(rtlsdrHandle));
+
+      return 0;
+   }
+
+   int setTransferSize(int value)
+   {
+      // libusb bulk transfers must be multiple of 512 bytes
+      if (value < 512 || value % 512)
+         return -1;
+
+      transferSize = value;
+
+      // restart async reader with new transfers
+      if (rtlsdrHandle && workerStreaming)
+         rtlsdr_cancel_async(rtldev(rtlsdrHandle));
+
+      return 0;
+   }
+
    void streamWorker()
    {
-      float scaled[READER_SAMPLES * 2];
-      unsigned char data[READER_SAMPLES * 2];
+      // raise reader priority over decoding threads, cpu set is inherited from receiver thread
+      rt::Scheduler::Profile profile;
 
-#ifdef _WIN32
-      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
-#elif
-      sched_param param {20};
+      profile.policy = rt::Scheduler::Fifo;
+      profile.priority = 20;
 
-      if (pthread_setschedparam(workerThread.native_handle(), SCHED_MAX, &param))
-         log.warn("error setting logger thread priority: {}", {std::strerror(errno)});
-#endif
+      if (!rt::Scheduler::apply(profile))
+         log.warn("unable to raise stream worker priority, samples may be dropped under load");
 
       std::lock_guard<std::mutex> lock(workerMutex);
 
       log.info("stream worker started for device {}", {deviceName});
 
+      // async reader returns when cancelled, restart it while streaming is enabled so transfer changes are applied
       while (workerStreaming)
       {
-         int length;
+         log.info("async reader started with {} transfers of {} bytes", {transferCount.load(), transferSize.load()});
 
-         SignalBuffer buffer = SignalBuffer(BUFFER_SAMPLES * 2, 2, sampleRate, samplesReceived, 0, SignalType::SAMPLE_IQ);
-
-         while (buffer.available() > READER_SAMPLES && (rtlsdr_read_sync(rtldev(rtlsdrHandle), data, sizeof(data), &length) == 0))
+         if ((rtlsdrResult = rtlsdr_read_async(rtldev(rtlsdrHandle), streamTransfer, this, transferCount, transferSize)) < 0)
          {
-            int dropped = sizeof(data) - length;
+            log.warn("failed rtlsdr_read_async: [{}]", {rtlsdrResult});
 
-#pragma GCC ivdep
-            for (int i = 0; i < length; i += 4)
-            {
-               scaled[i + 0] = float((data[i + 0] - 128) / 256.0) + 0.0025f;
-               scaled[i + 1] = float((data[i + 1] - 128) / 256.0) + 0.0025f;
-               scaled[i + 2] = float((data[i + 2] - 128) / 256.0) + 0.0025f;
-               scaled[i + 3] = float((data[i + 3] - 128) / 256.0) + 0.0025f;
-            }
+            workerStreaming = false;
+         }
+      }
+
+      log.info("stream worker finished for device {}", {deviceName});
+   }
+
+   static void streamTransfer(unsigned char *data, uint32_t length, void *context)
+   {
+      static_cast<Impl *>(context)->streamData(data, (int) length);
+   }
+
+   // called from libusb event thread for each completed transfer
+   void streamData(const unsigned char *data, int length)
+   {
+      // stop requested before reader was running, cancel from here
+      if (!workerStreaming)
+      {
+         rtlsdr_cancel_async(rtldev(rtlsdrHandle));
+         return;
+      }
 
-            // add data to buffer
-            buffer.put(scaled, length);
+      while (workerStreaming && length > 0)
+      {
+         if (!streamBuffer)
+            streamBuffer = acquireBuffer();
 
-            // update counters
-            samplesReceived += length >> 1;
-            samplesDropped += dropped >> 1;
+         int size = std::min<int>(length, streamBuffer.available());
 
-            // trace dropped samples
-            if (dropped > 0)
-               log.warn("dropped samples {}", {samplesDropped});
-         }
+         // convert samples straight into buffer storage
+         convertSamples(data, streamBuffer.pull(size), size);
 
-         // flip buffer contents
-         buffer.flip();
+         data += size;
+         length -= size;
 
-         // stream to buffer callback
-         if (streamCallback)
+         // update counters
+         samplesReceived += size >> 1;
+
+         if (!streamBuffer.available())
+            streamFlush();
+      }
+   }
+
+   void streamFlush()
+   {
+      SignalBuffer buffer = std::move(streamBuffer);
+
+      // flip buffer contents
+      buffer.flip();
+
+      // stamp buffer with last transfer completion time for latency measures
+      buffer.setCaptureTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+      // stream to buffer callback
+      if (streamCallback)
+      {
+         streamCallback(buffer);
+      }
+
+         // or store buffer in receive queue
+      else
+      {
+         // lock buffer access
+         std::lock_guard<std::mutex> lock(streamMutex);
+
+         // discard oldest buffers
+         if (streamQueue.size() >= MAX_QUEUE_SIZE)
          {
-            streamCallback(buffer);
+            samplesDropped += streamQueue.front().elements();
+            streamQueue.pop();
+
+            // trace dropped samples
+            log.warn("dropped samples {}", {samplesDropped});
          }
 
-            // or store buffer in receive queue
-         else
-         {
-            // lock buffer access
-            std::lock_guard<std::mutex> lock(streamMutex);
+         // queue new sample buffer
+         streamQueue.push(buffer);
+      }
+   }
 
-            // discard oldest buffers
-            if (streamQueue.size() >= MAX_QUEUE_SIZE)
-            {
-               samplesDropped += streamQueue.front().elements();
-               streamQueue.pop();
-            }
+   // take a buffer no longer referenced by consumers, or allocate a new one when all are in use
+   SignalBuffer acquireBuffer()
+   {
+      unsigned int offset = samplesReceived;
 
-            // queue new sample buffer
-            streamQueue.push(buffer);
-         }
+      for (auto &buffer: bufferPool)
+      {
+         if (buffer.references() == 1)
+            return buffer.recycle(offset);
       }
 
-      log.info("stream worker finished for device {}", {deviceName});
+      SignalBuffer buffer = SignalBuffer(BUFFER_SAMPLES * 2, 2, sampleRate, offset, 0, SignalType::SAMPLE_IQ);
+
+      if (bufferPool.size() < MAX_POOL_SIZE)
+         bufferPool.push_back(buffer);
+
+      return buffer;
+   }
+
+   // convert unsigned 8 bit samples to float
+   void convertSamples(const unsigned char *src, float *dst, int length) const
+   {
+      int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128i zero = _mm_setzero_si128();
+      const __m128 scale = _mm_set1_ps(1.0f / 256.0f);
+      const __m128 offset = _mm_set1_ps(-128.0f / 256.0f + 0.0025f);
+
+      for (; i + 16 <= length; i += 16)
+      {
+         // load 16 unsigned bytes, I0, Q0 ... I7, Q7
+         __m128i b = _mm_loadu_si128((const __m128i *) (src + i));
+
+         // widen to 16 bits
+         __m128i w0 = _mm_unpacklo_epi8(b, zero);
+         __m128i w1 = _mm_unpackhi_epi8(b, zero);
+
+         // widen to 32 bits and convert to float
+         __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w0, zero));
+         __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w0, zero));
+         __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w1, zero));
+         __m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w1, zero));
+
+         // scale and center
+         _mm_storeu_ps(dst + i + 0, _mm_add_ps(_mm_mul_ps(f0, scale), offset));
+         _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_mul_ps(f1, scale), offset));
+         _mm_storeu_ps(dst + i + 8, _mm_add_ps(_mm_mul_ps(f2, scale), offset));
+         _mm_storeu_ps(dst + i + 12, _mm_add_ps(_mm_mul_ps(f3, scale), offset));
+      }
+#endif
+
+      for (; i < length; i++)
+         dst[i] = convert[src[i]];
    }
 };
 
@@ -644,6 +792,26 @@ std::vector<std::string> RealtekDevice::listDevices()
    return Impl::listDevices();
 }
 
+int RealtekDevice::transferCount() const
+{
+   return impl->transferCount;
+}
+
+int RealtekDevice::setTransferCount(int value)
+{
+   return impl->setTransferCount(value);
+}
+
+int RealtekDevice::transferSize() const
+{
+   return impl->transferSize;
+}
+
+int RealtekDevice::setTransferSize(int value)
+{
+   return impl->setTransferSize(value);
+}
+
 const std::string &RealtekDevice::name()
 {
    return impl->deviceName;
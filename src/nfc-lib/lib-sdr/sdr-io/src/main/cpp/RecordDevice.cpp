@@ -22,23 +22,48 @@
 
 */
 
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+#include <x86intrin.h>
+
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#undef ERROR
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <cmath>
 #include <queue>
 #include <fstream>
 #include <iostream>
 #include <cstring>
 #include <utility>
+#include <algorithm>
 
 #include <rt/Logger.h>
+#include <rt/FileWriter.h>
 
 #include <sdr/SignalBuffer.h>
+#include <sdr/PackedFile.h>
 #include <sdr/RecordDevice.h>
 
 #define BUFFER_SIZE (1024)
 
+// asynchronous writer blocks, large enough to amortize I/O calls at full capture rate
+#define WRITE_BLOCK_SIZE (4 * 1024 * 1024)
+#define WRITE_BLOCK_COUNT 3
+
+// bytes prefetched after a seek on mapped files
+#define PREFETCH_SIZE (16 * 1024 * 1024)
+
 namespace sdr {
 
 struct chunk
@@ -59,6 +84,19 @@ struct RIFFChunk
    char type[4]; // 4 bytes
 };
 
+// RF64 64 bit sizes, reserved as JUNK chunk until file exceeds 4GB (EBU Tech 3306)
+struct DS64Chunk
+{
+   chunk desc; // 8 bytes
+   unsigned int riffSizeLow; // 4 bytes
+   unsigned int riffSizeHigh; // 4 bytes
+   unsigned int dataSizeLow; // 4 bytes
+   unsigned int dataSizeHigh; // 4 bytes
+   unsigned int sampleCountLow; // 4 bytes
+   unsigned int sampleCountHigh; // 4 bytes
+   unsigned int tableLength; // 4 bytes
+};
+
 struct WAVEChunk
 {
    chunk desc; // 8 bytes
@@ -84,11 +122,33 @@ struct DATAChunk
 struct FILEHeader
 {
    RIFFChunk riff; // 12 bytes
+   DS64Chunk ds64; // 36 bytes
    WAVEChunk wave; // 24 bytes
    LISTChunk list; // 8 bytes
    DATAChunk data; // 8 bytes
 };
 
+// one file of a recording, long captures are split in consecutive segments
+struct Segment
+{
+   std::string path;
+   int sampleRate = 0;
+   int sampleSize = 0;
+   int sampleType = 0;
+   int channelCount = 0;
+   int streamTime = 0;
+
+   // sample data location within file
+   size_t dataOffset = 0;
+   size_t dataSize = 0;
+
+   // 8 bit samples stored as signed values, as written by releases before unsigned WAV layout
+   bool signedBytes = false;
+
+   // first sample frame of this segment within recording
+   long long sampleStart = 0;
+};
+
 struct RecordDevice::Impl
 {
    rt::Logger log {"RecordDevice"};
@@ -101,13 +161,59 @@ struct RecordDevice::Impl
    int sampleRate {};
    int sampleSize {};
    int sampleType {};
-   int sampleCount {};
-   int sampleOffset {};
+   long long sampleCount {};
+   long long sampleOffset {};
    int channelCount {};
    int streamTime {};
 
    std::fstream file;
 
+   // file path without scheme
+   std::string fileName;
+
+   // samples are written from a dedicated I/O thread
+   std::shared_ptr<rt::FileWriter> writer;
+
+   // lossless compressed container used instead of WAV data
+   bool compressEnabled = false;
+   std::shared_ptr<PackedFile> packed;
+
+   // statistics of writers from previous segments
+   long long writtenBytes = 0;
+   long long writtenStall = 0;
+   long long writtenBusy = 0;
+
+   // rotation limits for new recordings, zero disables
+   long long segmentSize = 0;
+   long segmentTime = 0;
+
+   // values per segment and sample offset where current one starts
+   long long segmentLimit = 0;
+   long long segmentOffset = 0;
+
+   // files of recording being read and current one
+   std::vector<Segment> segments;
+   int segmentIndex = 0;
+
+   // sample data location within current file
+   size_t dataOffset = 0;
+   size_t dataSize = 0;
+
+   // current file holds signed 8 bit samples
+   bool signedBytes = false;
+
+   // read-only file mapping, samples are converted straight from mapped pages
+   bool mapEnabled = true;
+   const unsigned char *mapData = nullptr;
+   size_t mapSize = 0;
+
+   // read position within sample data, in bytes
+   size_t readPosition = 0;
+
+   // dither on integer conversion, noise generator state per SIMD lane
+   bool ditherEnabled = false;
+   unsigned int ditherState[4] = {0x9e3779b9, 0x7f4a7c15, 0x85ebca6b, 0xc2b2ae35};
+
    explicit Impl(std::string name) : name(std::move(name)), sampleSize(16), sampleRate(44100), sampleType(1), channelCount(1)
    {
       log.debug("created RecordDevice for name [{}]", {this->name});
@@ -134,44 +240,96 @@ struct RecordDevice::Impl
 
       close();
 
+      writer.reset();
+      packed.reset();
+
       openMode = mode;
 
       // initialize
       sampleCount = 0;
       sampleOffset = 0;
+      dataOffset = 0;
+      dataSize = 0;
+      readPosition = 0;
+      writtenBytes = 0;
+      writtenStall = 0;
+      writtenBusy = 0;
+      segmentOffset = 0;
+      segmentIndex = 0;
+      segments.clear();
 
       switch (mode)
       {
          case SignalDevice::Write:
          {
-            file.open(id, std::ios::out | std::ios::binary | std::ios::trunc);
+            // float samples are stored as 32 bit IEEE values
+            if (sampleType == SignalDevice::Float)
+               sampleSize = 32;
 
-            if (file.is_open())
+            if (sampleSize != 8 && sampleSize != 16 && sampleSize != 24 && sampleSize != 32)
             {
-               streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-
-               if (!writeHeader())
-               {
-                  file.close();
-               }
+               log.warn("unsupported sample size {}", {sampleSize});
+               return false;
             }
 
-            return file.is_open();
+            // rotation point in sample frames, first limit reached wins
+            long long frames = 0;
+
+            if (segmentSize > 0)
+               frames = std::max(segmentSize / (channelCount * sampleSize / 8), 1LL);
+
+            if (segmentTime > 0 && (!frames || (long long) segmentTime * sampleRate < frames))
+               frames = (long long) segmentTime * sampleRate;
+
+            segmentLimit = frames * channelCount;
+
+            fileName = id;
+
+            streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+            if (compressEnabled)
+               return openPacked();
+
+            return openWriter();
          }
 
          case SignalDevice::Read:
          {
-            file.open(id, std::ios::in | std::ios::binary);
-
-            if (file.is_open())
+            // compressed recordings are recognized by their signature, compress setting only applies to writes
+            if (PackedFile::probe(id))
             {
-               if (!readHeader())
+               packed = std::make_shared<PackedFile>(id);
+
+               if (!packed->open())
                {
-                  file.close();
+                  packed.reset();
+                  return false;
                }
+
+               const PackedFile::Format &format = packed->format();
+
+               sampleRate = format.sampleRate;
+               sampleSize = format.sampleSize;
+               sampleType = SignalDevice::Integer;
+               channelCount = format.channelCount;
+               streamTime = format.streamTime;
+               sampleCount = packed->frameCount();
+
+               return true;
             }
 
-            return file.is_open();
+            if (!scanSegments(id))
+               return false;
+
+            const Segment &first = segments.front();
+
+            sampleRate = first.sampleRate;
+            sampleSize = first.sampleSize;
+            sampleType = first.sampleType;
+            channelCount = first.channelCount;
+            streamTime = first.streamTime;
+
+            return openSegment(0);
          }
 
          case SignalDevice::Duplex:
@@ -184,32 +342,58 @@ struct RecordDevice::Impl
 
    void close()
    {
-      if (file.is_open())
+      unmap();
+
+      // writer is kept until next open so final statistics remain available
+      if (writer && writer->isOpen())
       {
          log.debug("close RecordDevice for name [{}]", {name});
 
-         if (openMode == SignalDevice::Write)
-         {
-            writeHeader();
-         }
+         closeWriter();
+      }
+
+      if (packed && packed->isOpen())
+      {
+         log.debug("close RecordDevice for name [{}]", {name});
+
+         packed->close();
+      }
+
+      if (file.is_open())
+      {
+         log.debug("close RecordDevice for name [{}]", {name});
 
          file.close();
       }
+
+      signedBytes = false;
    }
 
    bool isOpen() const
    {
-      return file.is_open();
+      if (packed)
+         return packed->isOpen();
+
+      return writer ? writer->isOpen() : file.is_open();
    }
 
    bool isEof() const
    {
-      return file.eof();
+      if (packed)
+         return packed->isEof();
+
+      if (segmentIndex + 1 < segments.size())
+         return false;
+
+      return readPosition >= dataSize || (!mapData && file.eof());
    }
 
    bool isReady() const
    {
-      return file.good();
+      if (packed)
+         return !packed->hasError();
+
+      return writer ? !writer->hasError() : file.good();
    }
 
    bool isStreaming() const
@@ -219,160 +403,845 @@ struct RecordDevice::Impl
 
    int read(SignalBuffer &buffer)
    {
-      switch (sampleSize)
+      unsigned char block[BUFFER_SIZE * 4];
+
+      int bytesPerSample = sampleSize / 8;
+
+      while (buffer.available())
       {
-         case 8:
-            return readSamples<char>(buffer);
+         if (packed)
+         {
+            unsigned int length = packed->read(block, std::min(buffer.available(), (unsigned int) BUFFER_SIZE) * bytesPerSample);
 
-         case 16:
-            return readSamples<short>(buffer);
+            unsigned int samples = length / bytesPerSample;
 
-         case 32:
-            return readSamples<int>(buffer);
+            if (!samples)
+               break;
+
+            decode(block, buffer.pull(samples), samples);
+
+            continue;
+         }
+
+         // samples left in current file, whole values only
+         size_t remaining = (dataSize - std::min(readPosition, dataSize)) / bytesPerSample;
+
+         // continue on next segment when current is exhausted
+         if (!remaining)
+         {
+            if (segmentIndex + 1 < segments.size() && openSegment(segmentIndex + 1))
+               continue;
+
+            break;
+         }
+
+         unsigned int samples;
+
+         if (mapData)
+         {
+            samples = (unsigned int) std::min<size_t>(buffer.available(), remaining);
+
+            // convert directly from mapped pages into buffer
+            decode(mapData + dataOffset + readPosition, buffer.pull(samples), samples);
+         }
+         else
+         {
+            // read one block of samples up to BUFFER_SIZE
+            file.read(reinterpret_cast<char *>(block), std::min<size_t>(std::min(buffer.available(), (unsigned int) BUFFER_SIZE), remaining) * bytesPerSample);
+
+            // number of samples readed
+            samples = file.gcount() / bytesPerSample;
+
+            if (!samples)
+               break;
+
+            // convert readed samples to float and store in buffer
+            decode(block, buffer.pull(samples), samples);
+         }
+
+         readPosition += samples * bytesPerSample;
       }
 
       buffer.flip();
 
+      sampleOffset += buffer.limit();
+
       return buffer.limit();
    }
 
    int write(SignalBuffer &buffer)
    {
+      if (packed)
+      {
+         if (!packed->isOpen())
+            return -1;
+      }
+      else if (!writer || !writer->isOpen())
+      {
+         return -1;
+      }
+
+      unsigned char block[BUFFER_SIZE * 4];
+
+      int bytesPerSample = sampleSize / 8;
+
+      // buffer values are contiguous, stride only groups channels
+      const float *data = buffer.data() + buffer.position();
+
+      unsigned int values = buffer.limit() - buffer.position();
+
+      for (unsigned int i = 0; i < values;)
+      {
+         unsigned int samples = std::min(values - i, (unsigned int) BUFFER_SIZE);
+
+         if (segmentLimit && !packed)
+         {
+            // segments end on sample frame boundaries, so the set plays back seamlessly
+            if (sampleOffset - segmentOffset >= segmentLimit && !rotate())
+               return -1;
+
+            samples = (unsigned int) std::min<long long>(samples, segmentLimit - (sampleOffset - segmentOffset));
+         }
+
+         // convert float samples to WAV samples and write block
+         encode(data + i, block, samples);
+
+         if (packed)
+            packed->write(block, samples * bytesPerSample);
+         else
+            writer->write(block, samples * bytesPerSample);
+
+         sampleOffset += samples;
+
+         i += samples;
+      }
+
+      sampleCount = sampleOffset / channelCount;
+
+      return values;
+   }
+
+   // convert samples from file format to float
+   void decode(const unsigned char *src, float *dst, unsigned int length) const
+   {
+      if (sampleType == SignalDevice::Float)
+      {
+         std::memcpy(dst, src, length * sizeof(float));
+         return;
+      }
+
       switch (sampleSize)
       {
          case 8:
-            return writeSamples<char>(buffer);
+            if (signedBytes)
+               decodeS8(reinterpret_cast<const signed char *>(src), dst, length);
+            else
+               decodeU8(src, dst, length);
+            break;
 
          case 16:
-            return writeSamples<short>(buffer);
+            decodeS16(reinterpret_cast<const short *>(src), dst, length);
+            break;
+
+         case 24:
+            decodeS24(src, dst, length);
+            break;
 
          case 32:
-            return writeSamples<int>(buffer);
+            decodeS32(reinterpret_cast<const int *>(src), dst, length);
+            break;
+      }
+   }
+
+   // convert float samples to file format, with optional triangular dither of one LSB
+   void encode(const float *src, unsigned char *dst, unsigned int length)
+   {
+      if (sampleType == SignalDevice::Float)
+      {
+         std::memcpy(dst, src, length * sizeof(float));
+         return;
       }
 
-      return buffer.position();
+      const float *input = src;
+
+      float dithered[BUFFER_SIZE];
+
+      if (ditherEnabled && sampleSize < 32)
+      {
+         addDither(src, dithered, length, 1.0f / float(1 << (sampleSize - 1)));
+
+         input = dithered;
+      }
+
+      switch (sampleSize)
+      {
+         case 8:
+            encodeU8(input, dst, length);
+            break;
+
+         case 16:
+            encodeS16(input, reinterpret_cast<short *>(dst), length);
+            break;
+
+         case 24:
+            encodeS24(input, dst, length);
+            break;
+
+         case 32:
+            encodeS32(input, reinterpret_cast<int *>(dst), length);
+            break;
+      }
    }
 
-   template<typename T>
-   int readSamples(SignalBuffer &buffer)
+   static void decodeU8(const unsigned char *src, float *dst, unsigned int length)
    {
-      T block[BUFFER_SIZE];
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i offset = _mm_set1_epi16(128);
+      const __m128 scale = _mm_set1_ps(1.0f / 128);
+
+      for (; i + 16 <= length; i += 16)
+      {
+         __m128i b = _mm_loadu_si128((const __m128i *) (src + i));
 
-      // converted samples
-      float vector[BUFFER_SIZE];
+         // widen to 16 bits and remove offset
+         __m128i w0 = _mm_sub_epi16(_mm_unpacklo_epi8(b, zero), offset);
+         __m128i w1 = _mm_sub_epi16(_mm_unpackhi_epi8(b, zero), offset);
 
-      // sample scale from float
-      float scale = 1 << (8 * sizeof(T) - 1);
+         // sign extend to 32 bits, convert and scale
+         _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w0, w0), 16)), scale));
+         _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(w0, w0), 16)), scale));
+         _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w1, w1), 16)), scale));
+         _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(w1, w1), 16)), scale));
+      }
+#endif
+
+      for (; i < length; i++)
+         dst[i] = float(src[i] - 128) * (1.0f / 128);
+   }
 
-      while (buffer.available() && file)
+   static void decodeS8(const signed char *src, float *dst, unsigned int length)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 scale = _mm_set1_ps(1.0f / 128);
+
+      for (; i + 16 <= length; i += 16)
       {
-         // read one block of samples up to BUFFER_SIZE
-         file.read(reinterpret_cast<char *>(block), (buffer.available() < BUFFER_SIZE ? buffer.available() : BUFFER_SIZE) * sizeof(T));
+         __m128i b = _mm_loadu_si128((const __m128i *) (src + i));
 
-         // number of samples readed
-         int samples = file.gcount() / sizeof(T);
+         // widen to 16 bits with sign in upper byte
+         __m128i w0 = _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8);
+         __m128i w1 = _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8);
 
-         // convert readed samples to float
-         for (int i = 0; i < samples; i++)
-         {
-            vector[i] = fromLittleEndian<T>(block[i]) / scale;
-         }
+         // sign extend to 32 bits, convert and scale
+         _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w0, w0), 16)), scale));
+         _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(w0, w0), 16)), scale));
+         _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w1, w1), 16)), scale));
+         _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(w1, w1), 16)), scale));
+      }
+#endif
+
+      for (; i < length; i++)
+         dst[i] = float(src[i]) * (1.0f / 128);
+   }
 
-         // and store in buffer
-         buffer.put(vector, samples);
+   static void decodeS16(const short *src, float *dst, unsigned int length)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 scale = _mm_set1_ps(1.0f / 32768);
+
+      for (; i + 8 <= length; i += 8)
+      {
+         __m128i w = _mm_loadu_si128((const __m128i *) (src + i));
+
+         // sign extend to 32 bits, convert and scale
+         _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16)), scale));
+         _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16)), scale));
       }
+#endif
 
-      buffer.flip();
+      for (; i < length; i++)
+         dst[i] = float(src[i]) * (1.0f / 32768);
+   }
 
-      sampleOffset += buffer.limit();
+   static void decodeS24(const unsigned char *src, float *dst, unsigned int length)
+   {
+      // packed 3 byte samples, value placed in upper bytes so shift extends sign
+      for (unsigned int i = 0; i < length; i++, src += 3)
+         dst[i] = float(int((unsigned int) src[0] << 8 | (unsigned int) src[1] << 16 | (unsigned int) src[2] << 24) >> 8) * (1.0f / 8388608);
+   }
 
-      return buffer.limit();
+   static void decodeS32(const int *src, float *dst, unsigned int length)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+
+      for (; i + 4 <= length; i += 4)
+         _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (src + i))), scale));
+#endif
+
+      for (; i < length; i++)
+         dst[i] = float(src[i]) * (1.0f / 2147483648.0f);
    }
 
-   template<typename T>
-   int writeSamples(SignalBuffer &buffer)
+   static void encodeU8(const float *src, unsigned char *dst, unsigned int length)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 scale = _mm_set1_ps(128);
+      const __m128i offset = _mm_set1_epi16(128);
+
+      for (; i + 16 <= length; i += 16)
+      {
+         // scale and round, out of range values saturate on pack
+         __m128i i0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 0), scale));
+         __m128i i1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+         __m128i i2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 8), scale));
+         __m128i i3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 12), scale));
+
+         __m128i w0 = _mm_adds_epi16(_mm_packs_epi32(i0, i1), offset);
+         __m128i w1 = _mm_adds_epi16(_mm_packs_epi32(i2, i3), offset);
+
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(w0, w1));
+      }
+#endif
+
+      for (; i < length; i++)
+         dst[i] = (unsigned char) (clamp(src[i] * 128, -128, 127) + 128);
+   }
+
+   static void encodeS16(const float *src, short *dst, unsigned int length)
    {
-      T block[BUFFER_SIZE];
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 scale = _mm_set1_ps(32768);
 
-      // sample scale to float
-      float scale = 1 << (8 * sizeof(T) - 1);
+      for (; i + 8 <= length; i += 8)
+      {
+         // scale and round, out of range values saturate on pack
+         __m128i i0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 0), scale));
+         __m128i i1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
 
-      // number of samples converted
-      int converted = 0;
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_packs_epi32(i0, i1));
+      }
+#endif
 
-      // process all buffer contents
-      buffer.stream([this, &scale, &converted, &block](const float *value, int stride) {
+      for (; i < length; i++)
+         dst[i] = (short) clamp(src[i] * 32768, -32768, 32767);
+   }
 
-         for (int c = 0; c < stride; c++)
+   static void encodeS24(const float *src, unsigned char *dst, unsigned int length)
+   {
+      for (unsigned int i = 0; i < length; i++, dst += 3)
+      {
+         int value = clamp(src[i] * 8388608, -8388608, 8388607);
+
+         dst[0] = value & 0xff;
+         dst[1] = (value >> 8) & 0xff;
+         dst[2] = (value >> 16) & 0xff;
+      }
+   }
+
+   static void encodeS32(const float *src, int *dst, unsigned int length)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 scale = _mm_set1_ps(2147483648.0f);
+      const __m128 upper = _mm_set1_ps(2147483520.0f);
+      const __m128 lower = _mm_set1_ps(-2147483648.0f);
+
+      // conversion does not saturate, clamp to largest float below 2^31 first
+      for (; i + 4 <= length; i += 4)
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), upper), lower)));
+#endif
+
+      for (; i < length; i++)
+         dst[i] = (int) std::lrint(std::max(std::min(src[i] * 2147483648.0f, 2147483520.0f), -2147483648.0f));
+   }
+
+   // round to nearest integer within limits
+   static inline int clamp(float value, int lower, int upper)
+   {
+      return (int) std::max(std::min(std::lrint(value), (long) upper), (long) lower);
+   }
+
+   // triangular noise from two uniform values, amplitude one LSB
+   void addDither(const float *src, float *dst, unsigned int length, float lsb)
+   {
+      unsigned int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128 unit = _mm_set1_ps(lsb / 16777216.0f);
+
+      __m128i state = _mm_loadu_si128((const __m128i *) ditherState);
+
+      for (; i + 4 <= length; i += 4)
+      {
+         __m128i a = state = xorshift(state);
+         __m128i b = state = xorshift(state);
+
+         // 24 bit uniform values, difference is triangular in (-1, 1)
+         __m128 noise = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(a, 8), _mm_srli_epi32(b, 8)));
+
+         _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(src + i), _mm_mul_ps(noise, unit)));
+      }
+
+      _mm_storeu_si128((__m128i *) ditherState, state);
+#endif
+
+      for (; i < length; i++)
+      {
+         unsigned int &state = ditherState[i & 3];
+
+         int a = int((state = xorshift(state)) >> 8);
+         int b = int((state = xorshift(state)) >> 8);
+
+         dst[i] = src[i] + float(a - b) * (lsb / 16777216.0f);
+      }
+   }
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+   static inline __m128i xorshift(__m128i x)
+   {
+      x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+      x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+      return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+   }
+#endif
+
+   static inline unsigned int xorshift(unsigned int x)
+   {
+      x ^= x << 13;
+      x ^= x >> 17;
+      return x ^ (x << 5);
+   }
+
+   bool seek(long long sample)
+   {
+      if (openMode != SignalDevice::Read || sample < 0)
+         return false;
+
+      if (packed)
+      {
+         if (!packed->seek(sample))
+            return false;
+
+         sampleOffset = std::min(sample, sampleCount) * channelCount;
+
+         return true;
+      }
+
+      if (!file.is_open())
+         return false;
+
+      // locate segment holding requested sample, positions past the end stop at last one
+      int index = 0;
+
+      while (index + 1 < segments.size() && segments[index + 1].sampleStart <= sample)
+         index++;
+
+      if (index != segmentIndex && !openSegment(index))
+         return false;
+
+      size_t blockAlign = channelCount * sampleSize / 8;
+
+      size_t position = std::min((size_t) (sample - segments[index].sampleStart) * blockAlign, dataSize - dataSize % blockAlign);
+
+      readPosition = position;
+
+      if (mapData)
+      {
+         prefetch();
+      }
+      else
+      {
+         file.clear();
+
+         if (!file.seekg((std::streamoff) (dataOffset + position)))
+            return false;
+      }
+
+      sampleOffset = segments[index].sampleStart * channelCount + position / (sampleSize / 8);
+
+      return true;
+   }
+
+   // collect files of a recording, each following segment must continue previous one
+   bool scanSegments(const std::string &path)
+   {
+      long long sampleStart = 0;
+
+      for (int index = 0;; index++)
+      {
+         Segment segment {segmentName(path, index)};
+
+         std::fstream stream(segment.path, std::ios::in | std::ios::binary);
+
+         if (!stream.is_open())
+            break;
+
+         if (!readHeader(stream, segment))
          {
-            // convert float sample to WAV sample
-            block[converted++] = toLittleEndian<T>((T) (value[c] * scale));
+            log.warn("invalid header in file [{}]", {segment.path});
+            break;
+         }
+
+         if (index > 0)
+         {
+            const Segment &first = segments.front();
 
-            // write buffered block
-            if (converted == BUFFER_SIZE)
+            // stale files from an older recording with same name are not joined
+            long expected = first.streamTime + (long) (sampleStart / first.sampleRate);
+
+            if (segment.sampleRate != first.sampleRate || segment.sampleSize != first.sampleSize || segment.sampleType != first.sampleType || segment.channelCount != first.channelCount || std::abs(segment.streamTime - expected) > 1)
             {
-               file.write(reinterpret_cast<const char *>(block), sizeof(block));
-               converted = 0;
+               log.warn("file [{}] does not continue recording, ignored", {segment.path});
+               break;
             }
          }
-      });
 
-      // write last remaining block
-      if (converted)
+         segment.sampleStart = sampleStart;
+
+         sampleStart += segment.dataSize / (segment.channelCount * segment.sampleSize / 8);
+
+         segments.push_back(segment);
+      }
+
+      if (segments.empty())
+         return false;
+
+      if (segments.size() > 1)
+         log.info("recording [{}] continues in {} segments", {path, segments.size() - 1});
+
+      sampleCount = sampleStart;
+
+      return true;
+   }
+
+   // switch reading to given segment of recording
+   bool openSegment(int index)
+   {
+      unmap();
+
+      if (file.is_open())
+         file.close();
+
+      const Segment &segment = segments[index];
+
+      file.open(segment.path, std::ios::in | std::ios::binary);
+
+      if (!file.is_open())
+      {
+         log.warn("unable to open file [{}]", {segment.path});
+         return false;
+      }
+
+      segmentIndex = index;
+      dataOffset = segment.dataOffset;
+      dataSize = segment.dataSize;
+      signedBytes = segment.signedBytes;
+      readPosition = 0;
+
+      if (!mapEnabled || !map(segment.path))
+         file.seekg((std::streamoff) dataOffset);
+
+      return true;
+   }
+
+   // start file for current segment, header time is adjusted to its first sample
+   bool openWriter()
+   {
+      std::string path = segmentName(fileName, segmentIndex);
+
+      writer = std::make_shared<rt::FileWriter>(path, WRITE_BLOCK_SIZE, WRITE_BLOCK_COUNT);
+
+      if (writer->open())
+      {
+         // placeholder, sizes are updated on close
+         FILEHeader header = buildHeader(0);
+
+         if (writer->write(&header, sizeof(header)))
+            return true;
+
+         writer->close();
+      }
+
+      log.warn("unable to open file [{}]", {path});
+
+      writer.reset();
+
+      return false;
+   }
+
+   // compressed recordings are written as a single file, segment limits don't apply
+   bool openPacked()
+   {
+      if (sampleType != SignalDevice::Integer || sampleSize > 24)
       {
-         file.write(reinterpret_cast<const char *>(block), converted * sizeof(T));
+         log.warn("compressed recording requires integer samples up to 24 bits");
+         return false;
       }
 
-      sampleCount += buffer.position();
-      sampleOffset += buffer.position();
+      if (segmentLimit)
+         log.warn("segment limits are ignored for compressed recording");
+
+      packed = std::make_shared<PackedFile>(fileName);
+
+      if (packed->create({sampleRate, sampleSize, channelCount, streamTime}))
+         return true;
+
+      packed.reset();
 
-      return buffer.position();
+      return false;
    }
 
-   bool readHeader()
+   void closeWriter()
    {
-      log.debug("read RecordDevice header for name [{}]", {name});
+      writer->close();
+
+      writeHeader(segmentName(fileName, segmentIndex), writer->size());
+   }
+
+   // finish current segment and continue recording on next one
+   bool rotate()
+   {
+      closeWriter();
+
+      writtenBytes += writer->written();
+      writtenStall += writer->stallTime();
+      writtenBusy += writer->busyTime();
+
+      segmentIndex++;
+      segmentOffset = sampleOffset;
+
+      log.info("recording continues on file [{}]", {segmentName(fileName, segmentIndex)});
+
+      return openWriter();
+   }
+
+   // first segment keeps given name, next ones are numbered before extension: capture.wav, capture.0001.wav...
+   static std::string segmentName(const std::string &path, int index)
+   {
+      if (index == 0)
+         return path;
+
+      char number[16];
+
+      snprintf(number, sizeof(number), ".%04d", index);
+
+      size_t dot = path.find_last_of('.');
+      size_t slash = path.find_last_of("/\\");
+
+      if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+         return path + number;
+
+      return path.substr(0, dot) + number + path.substr(dot);
+   }
+
+   bool map(const std::string &path)
+   {
+      size_t size = 0;
+
+#ifdef _WIN32
+      HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+      if (handle == INVALID_HANDLE_VALUE)
+         return false;
+
+      LARGE_INTEGER length;
+
+      if (GetFileSizeEx(handle, &length) && length.QuadPart > 0 && (unsigned long long) length.QuadPart <= SIZE_MAX)
+      {
+         size = (size_t) length.QuadPart;
+
+         // view keeps mapping alive after handles are closed
+         if (HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr))
+         {
+            mapData = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+            CloseHandle(mapping);
+         }
+      }
+
+      CloseHandle(handle);
+#else
+      int fd = ::open(path.c_str(), O_RDONLY);
+
+      if (fd < 0)
+         return false;
 
       struct stat st {};
 
-      file.seekg(0);
+      if (fstat(fd, &st) == 0 && st.st_size > 0 && (unsigned long long) st.st_size <= SIZE_MAX)
+      {
+         size = (size_t) st.st_size;
+
+         void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+         if (data != MAP_FAILED)
+         {
+            mapData = static_cast<const unsigned char *>(data);
+
+            // samples are consumed front to back, let kernel read ahead aggressively
+            madvise(data, size, MADV_SEQUENTIAL);
+         }
+      }
+
+      ::close(fd);
+#endif
+
+      if (!mapData)
+      {
+         log.warn("unable to map file [{}], using stream reads", {path});
+         return false;
+      }
+
+      mapSize = size;
+
+      // file may have shrunk since header was read
+      if (dataOffset > mapSize)
+         dataSize = 0;
+      else if (dataSize > mapSize - dataOffset)
+         dataSize = mapSize - dataOffset;
+
+      log.debug("mapped {} bytes of file [{}]", {mapSize, path});
+
+      return true;
+   }
+
+   void unmap()
+   {
+      if (!mapData)
+         return;
+
+#ifdef _WIN32
+      UnmapViewOfFile(mapData);
+#else
+      munmap(const_cast<unsigned char *>(mapData), mapSize);
+#endif
+
+      mapData = nullptr;
+      mapSize = 0;
+   }
+
+   // request pages ahead of current read position after random access
+   void prefetch() const
+   {
+#ifndef _WIN32
+      long pageSize = sysconf(_SC_PAGESIZE);
+
+      size_t start = (dataOffset + readPosition) & ~(size_t) (pageSize - 1);
+
+      if (start < mapSize)
+         madvise(const_cast<unsigned char *>(mapData) + start, std::min<size_t>(PREFETCH_SIZE, mapSize - start), MADV_WILLNEED);
+#endif
+   }
+
+   bool readHeader(std::fstream &stream, Segment &segment) const
+   {
+      log.debug("read RecordDevice header for file [{}]", {segment.path});
+
+      stream.seekg(0);
 
       RIFFChunk riff {};
 
-      if (!file.read(reinterpret_cast<char *>(&riff), sizeof(riff)))
+      if (!stream.read(reinterpret_cast<char *>(&riff), sizeof(riff)))
          return false;
 
-      if (std::memcmp(&riff.desc.id, "RIFF", 4) != 0)
+      // RF64 and BW64 files keep real sizes in ds64 chunk
+      bool rf64 = std::memcmp(&riff.desc.id, "RF64", 4) == 0 || std::memcmp(&riff.desc.id, "BW64", 4) == 0;
+
+      if (!rf64 && std::memcmp(&riff.desc.id, "RIFF", 4) != 0)
          return false;
 
       if (std::memcmp(&riff.type, "WAVE", 4) != 0)
          return false;
 
+      unsigned long long dataSize64 = 0;
+
+      // files from releases before unsigned 8 bit layout carry a date list but no reserved ds64 space
+      bool reserved = false;
+      bool dated = false;
+
       chunk entry {};
 
-      while (file.read(reinterpret_cast<char *>(&entry), sizeof(chunk)))
+      while (stream.read(reinterpret_cast<char *>(&entry), sizeof(chunk)))
       {
-         // process FMT chuck
-         if (std::memcmp(&entry.id, "fmt ", 4) == 0)
+         // process DS64 chuck
+         if (std::memcmp(&entry.id, "ds64", 4) == 0)
+         {
+            DS64Chunk ds64 {};
+
+            if (entry.size < sizeof(ds64) - 8)
+               return false;
+
+            stream.seekg(-(int) sizeof(chunk), std::ios_base::cur);
+
+            if (!stream.read(reinterpret_cast<char *>(&ds64), sizeof(ds64)))
+               return false;
+
+            dataSize64 = (unsigned long long) fromLittleEndian<unsigned int>(ds64.dataSizeHigh) << 32 | fromLittleEndian<unsigned int>(ds64.dataSizeLow);
+
+            reserved = true;
+
+            // skip chunk size table
+            if (!stream.seekg(entry.size - (sizeof(ds64) - 8) + (entry.size & 1), std::ios_base::cur))
+               return false;
+         }
+            // process FMT chuck
+         else if (std::memcmp(&entry.id, "fmt ", 4) == 0)
          {
             WAVEChunk wave {};
 
-            if (entry.size != sizeof(wave) - 8)
+            if (entry.size < sizeof(wave) - 8)
                return false;
 
-            file.seekg(-(int) sizeof(chunk), std::ios_base::cur);
+            stream.seekg(-(int) sizeof(chunk), std::ios_base::cur);
 
-            if (!file.read(reinterpret_cast<char *>(&wave), sizeof(wave)))
+            if (!stream.read(reinterpret_cast<char *>(&wave), sizeof(wave)))
                return false;
 
-            if (wave.audioFormat != 1)
+            unsigned int audioFormat = fromLittleEndian<unsigned short>(wave.audioFormat);
+
+            // extensible format, real format code is at start of sub format GUID
+            if (audioFormat == 0xfffe && entry.size >= 40)
+            {
+               unsigned char extension[24];
+
+               if (!stream.read(reinterpret_cast<char *>(extension), sizeof(extension)))
+                  return false;
+
+               audioFormat = extension[8] | extension[9] << 8;
+
+               entry.size -= sizeof(extension);
+            }
+
+            // skip remaining format extension
+            if (!stream.seekg(entry.size - (sizeof(wave) - 8) + (entry.size & 1), std::ios_base::cur))
                return false;
 
-            // Establish format
-            sampleType = SignalDevice::Integer;
-            sampleRate = fromLittleEndian<unsigned int>(wave.sampleRate);
-            sampleSize = fromLittleEndian<unsigned short>(wave.bitsPerSample);
-            channelCount = fromLittleEndian<unsigned short>(wave.numChannels);
+            // Establish format, integer PCM or IEEE float
+            segment.sampleRate = fromLittleEndian<unsigned int>(wave.sampleRate);
+            segment.sampleSize = fromLittleEndian<unsigned short>(wave.bitsPerSample);
+            segment.channelCount = fromLittleEndian<unsigned short>(wave.numChannels);
+
+            if (audioFormat == 1 && (segment.sampleSize == 8 || segment.sampleSize == 16 || segment.sampleSize == 24 || segment.sampleSize == 32))
+               segment.sampleType = SignalDevice::Integer;
+            else if (audioFormat == 3 && segment.sampleSize == 32)
+               segment.sampleType = SignalDevice::Float;
+            else
+               return false;
          }
             // process LIST chuck
          else if (std::memcmp(&entry.id, "LIST", 4) == 0)
@@ -381,112 +1250,168 @@ struct RecordDevice::Impl
             {
                char type[4];
 
-               if (!file.read(reinterpret_cast<char *>(type), sizeof(type)))
+               if (!stream.read(reinterpret_cast<char *>(type), sizeof(type)))
                   return false;
 
                // recover previous file offset
-               file.seekg(-(int) sizeof(type), std::ios_base::cur);
+               stream.seekg(-(int) sizeof(type), std::ios_base::cur);
 
                // check if date information is present
                if (std::memcmp(&type, "date", 4) == 0)
                {
                   DATEInfo date {};
 
-                  if (!file.read(reinterpret_cast<char *>(&date), sizeof(date)))
+                  if (!stream.read(reinterpret_cast<char *>(&date), sizeof(date)))
                      return false;
 
-                  if (!file.seekg(entry.size - sizeof(date), std::ios_base::cur))
+                  if (!stream.seekg(entry.size - sizeof(date), std::ios_base::cur))
                      return false;
 
-                  streamTime = fromLittleEndian<unsigned int>(date.epoch);
+                  segment.streamTime = fromLittleEndian<unsigned int>(date.epoch);
+
+                  dated = true;
 
                   continue;
                }
             }
 
             // if not date found, skip remain list chuck
-            if (!file.seekg(entry.size, std::ios_base::cur))
+            if (!stream.seekg(entry.size, std::ios_base::cur))
                return false;
          }
             // process DATA chuck
          else if (std::memcmp(&entry.id, "data", 4) == 0)
          {
-            // initialize values
-            sampleCount = entry.size / (channelCount * sampleSize / 8);
-            sampleOffset = 0;
+            if (!segment.channelCount)
+               return false;
+
+            // sample data starts here
+            segment.dataOffset = stream.tellg();
+            segment.dataSize = rf64 && entry.size == 0xffffffff ? dataSize64 : entry.size;
+
+            // data chunk may be truncated or declare zero size if recording was interrupted
+            stream.seekg(0, std::ios_base::end);
+
+            size_t fileSize = stream.tellg();
+
+            if (segment.dataOffset > fileSize)
+               segment.dataSize = 0;
+            else if (segment.dataSize == 0 || segment.dataSize > fileSize - segment.dataOffset)
+               segment.dataSize = fileSize - segment.dataOffset;
+
+            if (segment.sampleSize == 8 && segment.sampleType == SignalDevice::Integer && dated && !reserved)
+            {
+               log.info("file [{}] holds signed 8 bit samples from a previous release", {segment.path});
+
+               segment.signedBytes = true;
+            }
 
-            if (streamTime == 0)
+            if (segment.streamTime == 0)
             {
+               struct stat st {};
+
                log.info("the file does not have a timestamp stored, it will default to the creation date");
 
                // read default stream time from file creation date
-               if (stat(name.c_str(), &st) == 0)
-                  streamTime = st.st_ctime;
+               if (stat(segment.path.c_str(), &st) == 0)
+                  segment.streamTime = st.st_ctime;
             }
 
             return true;
          }
 
-            // unknown chuck
+            // unknown chuck, such as JUNK or fact, skip it
          else
          {
-            break;
+            if (std::memcmp(&entry.id, "JUNK", 4) == 0)
+               reserved = true;
+
+            if (!stream.seekg(entry.size + (entry.size & 1), std::ios_base::cur))
+               return false;
          }
       }
 
       return false;
    }
 
-   bool writeHeader()
+   FILEHeader buildHeader(long long length) const
    {
       FILEHeader header = {
             {{{'R', 'I', 'F', 'F'}, 0}, {'W', 'A', 'V', 'E'}},
+            {{{'J', 'U', 'N', 'K'}, 0}, 0, 0, 0, 0, 0, 0, 0},
             {{{'f', 'm', 't', ' '}, 0}, 0, 0, 0, 0, 0, 0},
             {{{'L', 'I', 'S', 'T'}, 0}, {{'d', 'a', 't', 'e'}, 0}},
             {{{'d', 'a', 't', 'a'}, 0}}
       };
 
-      log.debug("write RecordDevice header for name [{}]", {name});
+      unsigned long long riffSize = length > sizeof(RIFFChunk) ? length - sizeof(RIFFChunk) + 4 : 0;
+      unsigned long long dataSize = length > sizeof(FILEHeader) ? length - sizeof(FILEHeader) : 0;
 
-      // get current file offset written
-      int length = file.tellp();
+      // past 4GB the reserved JUNK chunk becomes ds64 and 32 bit sizes are set to -1
+      bool rf64 = riffSize > 0xffffffff;
+
+      if (rf64)
+      {
+         unsigned long long frames = dataSize / (channelCount * sampleSize / 8);
+
+         std::memcpy(header.riff.desc.id, "RF64", 4);
+         std::memcpy(header.ds64.desc.id, "ds64", 4);
+
+         header.ds64.riffSizeLow = toLittleEndian<unsigned int>(riffSize);
+         header.ds64.riffSizeHigh = toLittleEndian<unsigned int>(riffSize >> 32);
+         header.ds64.dataSizeLow = toLittleEndian<unsigned int>(dataSize);
+         header.ds64.dataSizeHigh = toLittleEndian<unsigned int>(dataSize >> 32);
+         header.ds64.sampleCountLow = toLittleEndian<unsigned int>(frames);
+         header.ds64.sampleCountHigh = toLittleEndian<unsigned int>(frames >> 32);
+      }
 
       // calculate overall file size
-      header.riff.desc.size = toLittleEndian<unsigned int>(length > sizeof(RIFFChunk) ? length - sizeof(RIFFChunk) + 4 : 0);
+      header.riff.desc.size = toLittleEndian<unsigned int>(rf64 ? 0xffffffff : riffSize);
+
+      // reserved space for 64 bit sizes
+      header.ds64.desc.size = toLittleEndian<unsigned int>(sizeof(DS64Chunk) - sizeof(chunk));
 
       // update wave format chunk
       header.wave.desc.size = toLittleEndian<unsigned int>(16);
-      header.wave.audioFormat = toLittleEndian<unsigned short>(1);
+      header.wave.audioFormat = toLittleEndian<unsigned short>(sampleType == SignalDevice::Float ? 3 : 1);
       header.wave.numChannels = toLittleEndian<unsigned short>(channelCount);
       header.wave.sampleRate = toLittleEndian<unsigned int>(sampleRate);
       header.wave.byteRate = toLittleEndian<unsigned int>(channelCount * sampleRate * sampleSize / 8);
       header.wave.blockAlign = toLittleEndian<unsigned short>(channelCount * sampleSize / 8);
       header.wave.bitsPerSample = toLittleEndian<unsigned short>(sampleSize);
 
-      // update list info chunk
+      // update list info chunk, each segment is stamped with time of its first sample
       header.list.desc.size = toLittleEndian<unsigned int>(sizeof(DATEInfo));
-      header.list.time.epoch = toLittleEndian<unsigned int>(streamTime);
+      header.list.time.epoch = toLittleEndian<unsigned int>(streamTime + segmentOffset / channelCount / sampleRate);
 
       // update data format chunk
-      header.data.desc.size = toLittleEndian<unsigned int>(length > sizeof(FILEHeader) ? length - sizeof(FILEHeader) : 0);
+      header.data.desc.size = toLittleEndian<unsigned int>(rf64 ? 0xffffffff : dataSize);
+
+      return header;
+   }
 
-      // jump to file start
-      file.seekp(0);
+   // rewrite header in place once the final file length is known
+   bool writeHeader(const std::string &path, long long length)
+   {
+      log.debug("write RecordDevice header for file [{}]", {path});
+
+      FILEHeader header = buildHeader(length);
 
-      // write file header
-      file.write(reinterpret_cast<char *>(&header), sizeof(header));
+      std::fstream output(path, std::ios::in | std::ios::out | std::ios::binary);
 
-      return file.good();
+      output.write(reinterpret_cast<char *>(&header), sizeof(header));
+
+      return output.good();
    }
 
    template<typename T>
-   inline T toLittleEndian(T value)
+   static inline T toLittleEndian(T value)
    {
       return value;
    }
 
    template<typename T>
-   inline T fromLittleEndian(T value)
+   static inline T fromLittleEndian(T value)
    {
       return value;
    }
@@ -536,12 +1461,12 @@ bool RecordDevice::isStreaming() const
    return impl->isStreaming();
 }
 
-int RecordDevice::sampleCount() const
+long long RecordDevice::sampleCount() const
 {
    return impl->sampleCount;
 }
 
-int RecordDevice::sampleOffset() const
+long long RecordDevice::sampleOffset() const
 {
    return impl->sampleOffset;
 }
@@ -604,6 +1529,113 @@ int RecordDevice::setStreamTime(long value)
    return 0;
 }
 
+bool RecordDevice::isDitherEnabled() const
+{
+   return impl->ditherEnabled;
+}
+
+void RecordDevice::setDitherEnabled(bool value)
+{
+   impl->ditherEnabled = value;
+}
+
+long long RecordDevice::writeBacklog() const
+{
+   if (impl->packed)
+      return impl->packed->backlog();
+
+   return impl->writer ? impl->writer->backlog() : 0;
+}
+
+long long RecordDevice::writeBytes() const
+{
+   if (impl->packed)
+      return impl->packed->packedBytes();
+
+   return impl->writtenBytes + (impl->writer ? impl->writer->written() : 0);
+}
+
+long long RecordDevice::writeStallTime() const
+{
+   if (impl->packed)
+      return impl->packed->stallTime();
+
+   return impl->writtenStall + (impl->writer ? impl->writer->stallTime() : 0);
+}
+
+long long RecordDevice::writeBusyTime() const
+{
+   if (impl->packed)
+      return impl->packed->busyTime();
+
+   return impl->writtenBusy + (impl->writer ? impl->writer->busyTime() : 0);
+}
+
+bool RecordDevice::isCompressed() const
+{
+   if (isOpen())
+      return impl->packed != nullptr;
+
+   return impl->compressEnabled;
+}
+
+void RecordDevice::setCompressed(bool value)
+{
+   impl->compressEnabled = value;
+}
+
+double RecordDevice::compressionRatio() const
+{
+   // nothing to compare until first block is stored
+   if (!impl->packed || !impl->packed->rawBytes())
+      return 1.0;
+
+   return (double) impl->packed->rawBytes() / impl->packed->packedBytes();
+}
+
+bool RecordDevice::isMapped() const
+{
+   return impl->mapData != nullptr;
+}
+
+void RecordDevice::setMapped(bool value)
+{
+   impl->mapEnabled = value;
+}
+
+long long RecordDevice::segmentSize() const
+{
+   return impl->segmentSize;
+}
+
+void RecordDevice::setSegmentSize(long long value)
+{
+   impl->segmentSize = value;
+}
+
+long RecordDevice::segmentTime() const
+{
+   return impl->segmentTime;
+}
+
+void RecordDevice::setSegmentTime(long value)
+{
+   impl->segmentTime = value;
+}
+
+int RecordDevice::segmentCount() const
+{
+   if (impl->packed)
+      return 1;
+
+   return impl->openMode == SignalDevice::Write ? impl->segmentIndex + 1 : (int) impl->segments.size();
+}
+
+bool RecordDevice::seek(long long sample)
+{
+   return impl->seek(sample);
+}
+
 int RecordDevice::read(SignalBuffer &buffer)
 {
    return impl->read(buffer);
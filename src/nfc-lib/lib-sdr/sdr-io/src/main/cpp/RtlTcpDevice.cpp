@@ -0,0 +1,911 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifdef _WIN32
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#undef ERROR
+
+typedef SOCKET socket_t;
+
+#define closesocket_t closesocket
+
+#else
+
+#include <netdb.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+typedef int socket_t;
+
+#define INVALID_SOCKET (-1)
+#define closesocket_t ::close
+
+#endif
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+#include <x86intrin.h>
+
+#endif
+
+#include <queue>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <rt/Logger.h>
+#include <rt/Scheduler.h>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RtlTcpDevice.h>
+
+#define DEFAULT_PORT 1234
+
+#define READER_BYTES 65536
+#define BUFFER_SAMPLES 65536
+
+// socket receive buffer, about one second of samples at 3.2 Msps
+#define SOCKET_BUFFER (8 * 1024 * 1024)
+
+// socket receive timeout, in milliseconds
+#define SOCKET_TIMEOUT 250
+
+#define MAX_QUEUE_SIZE 4
+#define MAX_POOL_SIZE 16
+
+namespace sdr {
+
+// rtl_tcp command codes
+enum RtlTcpCommand
+{
+   SetFrequency = 0x01,
+   SetSampleRate = 0x02,
+   SetGainMode = 0x03,
+   SetGain = 0x04,
+   SetAgcMode = 0x08,
+   SetTestMode = 0x07,
+   SetDirectSampling = 0x09,
+   SetBiasTee = 0x0e
+};
+
+// rtl_tcp tuner types, as reported in server header
+enum RtlTcpTuner
+{
+   TunerUnknown = 0,
+   TunerE4000 = 1,
+   TunerFC0012 = 2,
+   TunerFC0013 = 3,
+   TunerFC2580 = 4,
+   TunerR820T = 5,
+   TunerR828D = 6
+};
+
+struct RtlTcpDevice::Impl
+{
+   rt::Logger log {"RtlTcpDevice"};
+
+   std::string deviceName;
+   std::string deviceVersion;
+   std::string host;
+   int port = DEFAULT_PORT;
+   long centerFreq = 0;
+   long sampleRate = 0;
+   int sampleSize = 8;
+   int gainMode = 0;
+   int gainValue = 0;
+   int tunerAgc = 0;
+   int mixerAgc = 0;
+   int biasTee = 0;
+   int decimation = 0;
+   int testMode = 0;
+   int directSampling = 0;
+   long streamTime = 0;
+
+   // server tuner type and gain count, from connection header
+   unsigned int tunerType = TunerUnknown;
+   unsigned int tunerGains = 0;
+
+   // connection socket, commands are sent from caller thread and samples received from worker thread
+   socket_t socket = INVALID_SOCKET;
+   std::mutex commandMutex;
+   std::atomic_bool connected {false};
+
+   std::mutex workerMutex;
+   std::atomic_bool workerStreaming {false};
+   std::thread workerThread;
+
+   std::mutex streamMutex;
+   std::queue<SignalBuffer> streamQueue;
+   RadioDevice::StreamHandler streamCallback;
+
+   // storage pool to avoid per-buffer allocations
+   std::vector<SignalBuffer> bufferPool;
+
+   // sample conversion table, same scale as local RTL-SDR devices
+   float convert[256];
+
+   long samplesReceived = 0;
+   long samplesDropped = 0;
+
+   explicit Impl(std::string name) : deviceName(std::move(name))
+   {
+      log.debug("created RtlTcpDevice for name [{}]", {this->deviceName});
+
+      // extract host and port from device name
+      if (deviceName.find("rtltcp://") == 0)
+      {
+         host = deviceName.substr(9);
+
+         auto separator = host.rfind(':');
+
+         if (separator != std::string::npos)
+         {
+            port = std::atoi(host.c_str() + separator + 1);
+            host = host.substr(0, separator);
+         }
+      }
+
+      for (int i = 0; i < 256; i++)
+         convert[i] = float(i - 128) / 256.0f + 0.0025f;
+   }
+
+   ~Impl()
+   {
+      log.debug("destroy RtlTcpDevice");
+
+      // close underline device
+      close();
+   }
+
+   bool open(SignalDevice::OpenMode mode)
+   {
+      if (host.empty())
+      {
+         log.warn("invalid device name [{}]", {deviceName});
+         return false;
+      }
+
+      close();
+
+#ifdef _WIN32
+      static WSADATA wsaData;
+      static int wsaResult = WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+      if (wsaResult != 0)
+      {
+         log.error("failed WSAStartup: [{}]", {wsaResult});
+         return false;
+      }
+#endif
+
+      struct addrinfo hints {};
+      struct addrinfo *address = nullptr;
+
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+
+      if (int result = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &address))
+      {
+         log.warn("unable to resolve host {}: [{}]", {host, result});
+         return false;
+      }
+
+      for (auto entry = address; entry; entry = entry->ai_next)
+      {
+         socket = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+
+         if (socket == INVALID_SOCKET)
+            continue;
+
+         // large receive buffer absorbs network and scheduling jitter, must be set before connect
+         int bufferSize = SOCKET_BUFFER;
+         setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (const char *) &bufferSize, sizeof(bufferSize));
+
+         if (::connect(socket, entry->ai_addr, (int) entry->ai_addrlen) == 0)
+            break;
+
+         closesocket_t(socket);
+
+         socket = INVALID_SOCKET;
+      }
+
+      freeaddrinfo(address);
+
+      if (socket == INVALID_SOCKET)
+      {
+         log.warn("unable to connect to {}:{}", {host, port});
+         return false;
+      }
+
+      // commands are small and must be sent immediately
+      int noDelay = 1;
+      setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *) &noDelay, sizeof(noDelay));
+
+      // receive timeout, so worker can check for stop requests
+#ifdef _WIN32
+      DWORD timeout = SOCKET_TIMEOUT;
+#else
+      struct timeval timeout {0, SOCKET_TIMEOUT * 1000};
+#endif
+      setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char *) &timeout, sizeof(timeout));
+
+      // read server header, magic followed by tuner type and gain count in network order
+      unsigned char header[12];
+
+      if (!receive(header, sizeof(header)) || std::memcmp(header, "RTL0", 4) != 0)
+      {
+         log.warn("invalid rtl_tcp header from {}:{}", {host, port});
+
+         closesocket_t(socket);
+
+         socket = INVALID_SOCKET;
+
+         return false;
+      }
+
+      tunerType = header[4] << 24 | header[5] << 16 | header[6] << 8 | header[7];
+      tunerGains = header[8] << 24 | header[9] << 16 | header[10] << 8 | header[11];
+
+      deviceVersion = "rtl_tcp tuner " + std::to_string(tunerType);
+
+      connected = true;
+
+      // configure frequency
+      if (centerFreq)
+         command(SetFrequency, centerFreq);
+
+      // configure samplerate
+      if (sampleRate)
+         command(SetSampleRate, sampleRate);
+
+      // configure gain mode and value
+      setGainMode(gainMode);
+
+      // configure mixer agc and bias tee
+      command(SetAgcMode, mixerAgc);
+      command(SetBiasTee, biasTee);
+
+      // configure direct sampling
+      command(SetDirectSampling, directSampling);
+
+      // configure test mode
+      command(SetTestMode, testMode);
+
+      log.info("openned rtl_tcp device {} with tuner type {} and {} gains", {deviceName, tunerType, tunerGains});
+
+      return true;
+   }
+
+   void close()
+   {
+      if (socket != INVALID_SOCKET)
+      {
+         // stop streaming if active...
+         stop();
+
+         log.info("close device {}", {deviceName});
+
+         closesocket_t(socket);
+
+         socket = INVALID_SOCKET;
+         connected = false;
+      }
+   }
+
+   // read exactly length bytes, used for connection header
+   bool receive(unsigned char *data, int length)
+   {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+      for (int offset = 0, result; offset < length; offset += result)
+      {
+         if ((result = (int) recv(socket, (char *) data + offset, length - offset, 0)) <= 0)
+         {
+            // closed, failed or no data in time, only timeouts are retried
+            if (result == 0 || !timedOut() || std::chrono::steady_clock::now() > deadline)
+               return false;
+
+            result = 0;
+         }
+      }
+
+      return true;
+   }
+
+   int command(unsigned char code, unsigned int value)
+   {
+      if (!connected)
+         return 0;
+
+      unsigned char data[5] = {code, (unsigned char) (value >> 24), (unsigned char) (value >> 16), (unsigned char) (value >> 8), (unsigned char) value};
+
+      std::lock_guard<std::mutex> lock(commandMutex);
+
+      if (send(socket, (const char *) data, sizeof(data), 0) != sizeof(data))
+      {
+         log.warn("failed rtl_tcp command {}: {}", {code, value});
+
+         return -1;
+      }
+
+      log.debug("rtl_tcp command {}: {}", {code, value});
+
+      return 0;
+   }
+
+   int start(RadioDevice::StreamHandler handler)
+   {
+      if (connected)
+      {
+         // delay worker start until method is finished
+         std::lock_guard<std::mutex> lock(workerMutex);
+
+         // clear counters
+         samplesDropped = 0;
+         samplesReceived = 0;
+
+         // reset stream status
+         streamCallback = std::move(handler);
+         streamQueue = std::queue<SignalBuffer>();
+
+         log.info("start streaming for device {}", {deviceName});
+
+         // set streaming flag to enable worker
+         workerStreaming = true;
+
+         // run worker thread
+         workerThread = std::thread([this] { streamWorker(); });
+
+         // sets stream start time
+         streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+         return 0;
+      }
+
+      return -1;
+   }
+
+   int stop()
+   {
+      if (workerThread.joinable())
+      {
+         log.info("stop streaming for device {}", {deviceName});
+
+         // signal finish to running thread
+         workerStreaming = false;
+
+         // wait until worker is finished
+         std::lock_guard<std::mutex> lock(workerMutex);
+
+         // wait for thread joint
+         workerThread.join();
+
+         // disable stream callback and queue
+         streamCallback = nullptr;
+         streamQueue = std::queue<SignalBuffer>();
+         bufferPool.clear();
+         streamTime = 0;
+
+         return 0;
+      }
+
+      return -1;
+   }
+
+   int setGainMode(int mode)
+   {
+      gainMode = mode;
+
+      if (gainMode == RtlTcpDevice::Auto)
+         return command(SetGainMode, 0);
+
+      command(SetGainMode, 1);
+
+      return setGainValue(gainValue);
+   }
+
+   int setGainValue(int value)
+   {
+      gainValue = value;
+
+      if (gainMode == RtlTcpDevice::Manual)
+         return command(SetGain, gainValue);
+
+      return 0;
+   }
+
+   std::map<int, std::string> supportedGainValues() const
+   {
+      static const int r820tGains[] = {0, 9, 14, 27, 37, 77, 87, 125, 144, 157, 166, 197, 207, 229, 254, 280, 297, 328, 338, 364, 372, 386, 402, 421, 434, 439, 445, 480, 496};
+      static const int e4000Gains[] = {-10, 15, 40, 65, 90, 115, 140, 165, 190, 215, 240, 290, 340, 420};
+
+      std::map<int, std::string> result;
+
+      auto add = [&result](int value) {
+         char buffer[64];
+
+         snprintf(buffer, sizeof(buffer), "%.2f db", float(value) / 10.0f);
+
+         result[value] = buffer;
+      };
+
+      if (tunerType == TunerR820T || tunerType == TunerR828D)
+      {
+         for (int value: r820tGains)
+            add(value);
+      }
+      else if (tunerType == TunerE4000)
+      {
+         for (int value: e4000Gains)
+            add(value);
+      }
+
+      return result;
+   }
+
+   int read(SignalBuffer &buffer)
+   {
+      // lock buffer access
+      std::lock_guard<std::mutex> lock(streamMutex);
+
+      if (!streamQueue.empty())
+      {
+         buffer = streamQueue.front();
+
+         streamQueue.pop();
+
+         return buffer.limit();
+      }
+
+      return -1;
+   }
+
+   // convert unsigned 8 bit samples to float, straight into buffer storage
+   void convertSamples(const unsigned char *src, float *dst, int length)
+   {
+      int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      const __m128i zero = _mm_setzero_si128();
+      const __m128 scale = _mm_set1_ps(1.0f / 256.0f);
+      const __m128 offset = _mm_set1_ps(-128.0f / 256.0f + 0.0025f);
+
+      for (; i + 16 <= length; i += 16)
+      {
+         // load 16 unsigned bytes, I0, Q0 ... I7, Q7
+         __m128i b = _mm_loadu_si128((const __m128i *) (src + i));
+
+         // widen to 16 bits
+         __m128i w0 = _mm_unpacklo_epi8(b, zero);
+         __m128i w1 = _mm_unpackhi_epi8(b, zero);
+
+         // widen to 32 bits and convert to float
+         __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w0, zero));
+         __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w0, zero));
+         __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(w1, zero));
+         __m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(w1, zero));
+
+         // scale and center
+         _mm_storeu_ps(dst + i + 0, _mm_add_ps(_mm_mul_ps(f0, scale), offset));
+         _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_mul_ps(f1, scale), offset));
+         _mm_storeu_ps(dst + i + 8, _mm_add_ps(_mm_mul_ps(f2, scale), offset));
+         _mm_storeu_ps(dst + i + 12, _mm_add_ps(_mm_mul_ps(f3, scale), offset));
+      }
+#endif
+
+      for (; i < length; i++)
+         dst[i] = convert[src[i]];
+   }
+
+   void streamWorker()
+   {
+      unsigned char data[READER_BYTES];
+
+      // raise reader priority over decoding threads, cpu set is inherited from receiver thread
+      rt::Scheduler::Profile profile;
+
+      profile.policy = rt::Scheduler::Fifo;
+      profile.priority = 20;
+
+      if (!rt::Scheduler::apply(profile))
+         log.warn("unable to raise stream worker priority, samples may be dropped under load");
+
+      std::lock_guard<std::mutex> lock(workerMutex);
+
+      log.info("stream worker started for device {}", {deviceName});
+
+      while (workerStreaming)
+      {
+         SignalBuffer buffer = acquireBuffer();
+
+         // fill whole buffer, so it always contains complete IQ pairs
+         while (workerStreaming && buffer.available())
+         {
+            int length = (int) recv(socket, (char *) data, std::min<int>(sizeof(data), buffer.available()), 0);
+
+            // connection closed or failed
+            if (length == 0 || (length < 0 && !timedOut()))
+            {
+               log.warn("connection lost for device {}", {deviceName});
+
+               connected = false;
+               workerStreaming = false;
+
+               break;
+            }
+
+            if (length > 0)
+               convertSamples(data, buffer.pull(length), length);
+         }
+
+         if (buffer.available())
+            break;
+
+         // flip buffer contents
+         buffer.flip();
+
+         // update counters
+         samplesReceived += BUFFER_SAMPLES;
+
+         // stamp buffer with last transfer completion time for latency measures
+         buffer.setCaptureTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+         // stream to buffer callback
+         if (streamCallback)
+         {
+            streamCallback(buffer);
+         }
+
+            // or store buffer in receive queue
+         else
+         {
+            // lock buffer access
+            std::lock_guard<std::mutex> lock(streamMutex);
+
+            // discard oldest buffers
+            if (streamQueue.size() >= MAX_QUEUE_SIZE)
+            {
+               samplesDropped += streamQueue.front().elements();
+               streamQueue.pop();
+            }
+
+            // queue new sample buffer
+            streamQueue.push(buffer);
+         }
+      }
+
+      log.info("stream worker finished for device {}", {deviceName});
+   }
+
+   // take a buffer no longer referenced by consumers, or allocate a new one when all are in use
+   SignalBuffer acquireBuffer()
+   {
+      unsigned int offset = samplesReceived;
+
+      for (auto &buffer: bufferPool)
+      {
+         if (buffer.references() == 1 && (long) buffer.sampleRate() == sampleRate)
+            return buffer.recycle(offset);
+      }
+
+      SignalBuffer buffer = SignalBuffer(BUFFER_SAMPLES * 2, 2, sampleRate, offset, 0, SignalType::SAMPLE_IQ);
+
+      // buffers of previous sample rate are replaced as they are released
+      for (auto &entry: bufferPool)
+      {
+         if (entry.references() == 1)
+            return entry = buffer;
+      }
+
+      if (bufferPool.size() < MAX_POOL_SIZE)
+         bufferPool.push_back(buffer);
+
+      return buffer;
+   }
+
+   static bool timedOut()
+   {
+#ifdef _WIN32
+      return WSAGetLastError() == WSAETIMEDOUT;
+#else
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+   }
+};
+
+RtlTcpDevice::RtlTcpDevice(const std::string &name) : impl(std::make_shared<Impl>(name))
+{
+}
+
+const std::string &RtlTcpDevice::name()
+{
+   return impl->deviceName;
+}
+
+const std::string &RtlTcpDevice::version()
+{
+   return impl->deviceVersion;
+}
+
+bool RtlTcpDevice::open(OpenMode mode)
+{
+   return impl->open(mode);
+}
+
+void RtlTcpDevice::close()
+{
+   impl->close();
+}
+
+int RtlTcpDevice::start(StreamHandler handler)
+{
+   return impl->start(handler);
+}
+
+int RtlTcpDevice::stop()
+{
+   return impl->stop();
+}
+
+bool RtlTcpDevice::isOpen() const
+{
+   return impl->socket != INVALID_SOCKET;
+}
+
+bool RtlTcpDevice::isEof() const
+{
+   return !impl->connected || !impl->workerStreaming;
+}
+
+bool RtlTcpDevice::isReady() const
+{
+   return impl->connected;
+}
+
+bool RtlTcpDevice::isStreaming() const
+{
+   return impl->workerStreaming;
+}
+
+int RtlTcpDevice::sampleSize() const
+{
+   return impl->sampleSize;
+}
+
+int RtlTcpDevice::setSampleSize(int value)
+{
+   impl->log.warn("setSampleSize has no effect!");
+
+   return -1;
+}
+
+long RtlTcpDevice::sampleRate() const
+{
+   return impl->sampleRate;
+}
+
+int RtlTcpDevice::setSampleRate(long value)
+{
+   impl->sampleRate = value;
+
+   return impl->command(SetSampleRate, (unsigned int) value);
+}
+
+int RtlTcpDevice::sampleType() const
+{
+   return Float;
+}
+
+int RtlTcpDevice::setSampleType(int value)
+{
+   impl->log.warn("setSampleType has no effect!");
+
+   return -1;
+}
+
+long RtlTcpDevice::streamTime() const
+{
+   return impl->streamTime;
+}
+
+int RtlTcpDevice::setStreamTime(long value)
+{
+   return 0;
+}
+
+long RtlTcpDevice::centerFreq() const
+{
+   return impl->centerFreq;
+}
+
+int RtlTcpDevice::setCenterFreq(long value)
+{
+   impl->centerFreq = value;
+
+   return impl->command(SetFrequency, (unsigned int) value);
+}
+
+int RtlTcpDevice::tunerAgc() const
+{
+   return impl->tunerAgc;
+}
+
+int RtlTcpDevice::setTunerAgc(int value)
+{
+   impl->tunerAgc = value;
+
+   if (value)
+      impl->gainMode = RtlTcpDevice::Auto;
+
+   return impl->command(SetGainMode, !value);
+}
+
+int RtlTcpDevice::mixerAgc() const
+{
+   return impl->mixerAgc;
+}
+
+int RtlTcpDevice::setMixerAgc(int value)
+{
+   impl->mixerAgc = value;
+
+   return impl->command(SetAgcMode, value);
+}
+
+int RtlTcpDevice::biasTee() const
+{
+   return impl->biasTee;
+}
+
+int RtlTcpDevice::setBiasTee(int value)
+{
+   impl->biasTee = value;
+
+   return impl->command(SetBiasTee, value);
+}
+
+int RtlTcpDevice::gainMode() const
+{
+   return impl->gainMode;
+}
+
+int RtlTcpDevice::setGainMode(int value)
+{
+   return impl->setGainMode(value);
+}
+
+int RtlTcpDevice::gainValue() const
+{
+   return impl->gainValue;
+}
+
+int RtlTcpDevice::setGainValue(int value)
+{
+   return impl->setGainValue(value);
+}
+
+int RtlTcpDevice::decimation() const
+{
+   return impl->decimation;
+}
+
+int RtlTcpDevice::setDecimation(int value)
+{
+   impl->log.warn("setDecimation has no effect!");
+
+   return -1;
+}
+
+int RtlTcpDevice::testMode() const
+{
+   return impl->testMode;
+}
+
+int RtlTcpDevice::setTestMode(int value)
+{
+   impl->testMode = value;
+
+   return impl->command(SetTestMode, value);
+}
+
+int RtlTcpDevice::directSampling() const
+{
+   return impl->directSampling;
+}
+
+int RtlTcpDevice::setDirectSampling(int value)
+{
+   impl->directSampling = value;
+
+   return impl->command(SetDirectSampling, value);
+}
+
+long RtlTcpDevice::samplesReceived()
+{
+   return impl->samplesReceived;
+}
+
+long RtlTcpDevice::samplesDropped()
+{
+   return impl->samplesDropped;
+}
+
+std::map<int, std::string> RtlTcpDevice::supportedSampleRates() const
+{
+   std::map<int, std::string> result;
+
+   result[225000] = "225000"; // 0.25 MSPS
+   result[900000] = "900000"; // 0.90 MSPS
+   result[1024000] = "1024000"; // 1.024 MSPS
+   result[1400000] = "1400000"; // 1.4 MSPS
+   result[1800000] = "1800000"; // 1.8 MSPS
+   result[1920000] = "1920000"; // 1.92 MSPS
+   result[2048000] = "2048000"; // 2.048 MSPS
+   result[2400000] = "2400000"; // 2.4 MSPS
+   result[2560000] = "2560000"; // 2.56 MSPS
+   result[2800000] = "2800000"; // 2.8 MSPS
+   result[3200000] = "3200000"; // 3.2 MSPS
+
+   return result;
+}
+
+std::map<int, std::string> RtlTcpDevice::supportedGainModes() const
+{
+   std::map<int, std::string> result;
+
+   result[RtlTcpDevice::Auto] = "Auto";
+   result[RtlTcpDevice::Manual] = "Manual";
+
+   return result;
+}
+
+std::map<int, std::string> RtlTcpDevice::supportedGainValues() const
+{
+   return impl->supportedGainValues();
+}
+
+int RtlTcpDevice::read(SignalBuffer &buffer)
+{
+   return impl->read(buffer);
+}
+
+int RtlTcpDevice::write(SignalBuffer &buffer)
+{
+   impl->log.warn("write not supported on this device!");
+
+   return -1;
+}
+
+}
@@ -22,30 +22,37 @@
 
 */
 
+#include <atomic>
+
 #include <sdr/SignalBuffer.h>
 
 namespace sdr {
 
+// last assigned buffer id
+static std::atomic<unsigned long long> sequence {0};
+
 struct SignalBuffer::Impl
 {
    long samplerate;
    long decimation;
    long offset;
+   long long captureTime = 0;
+   unsigned long long id;
 
-   explicit Impl(long samplerate, long decimation, long offset) : samplerate(samplerate), decimation(decimation), offset(offset)
+   explicit Impl(long samplerate, long decimation, long offset, unsigned long long id) : samplerate(samplerate), decimation(decimation), offset(offset), id(id)
    {
    }
 };
 
-SignalBuffer::SignalBuffer() : impl(std::make_shared<Impl>(0, 0, 0))
+SignalBuffer::SignalBuffer() : impl(std::make_shared<Impl>(0, 0, 0, 0))
 {
 }
 
-SignalBuffer::SignalBuffer(unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(length, type, stride, context), impl(std::make_shared<Impl>(samplerate, decimation, offset))
+SignalBuffer::SignalBuffer(unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(length, type, stride, context), impl(std::make_shared<Impl>(samplerate, decimation, offset, ++sequence))
 {
 }
 
-SignalBuffer::SignalBuffer(float *data, unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(data, length, type, stride, context), impl(std::make_shared<Impl>(samplerate, decimation, offset))
+SignalBuffer::SignalBuffer(float *data, unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(data, length, type, stride, context), impl(std::make_shared<Impl>(samplerate, decimation, offset, ++sequence))
 {
 }
 
@@ -53,6 +60,10 @@ SignalBuffer::SignalBuffer(const SignalBuffer &other) : Buffer(other), impl(othe
 {
 }
 
+SignalBuffer::SignalBuffer(SignalBuffer &&other) noexcept : Buffer(std::move(other)), impl(std::move(other.impl))
+{
+}
+
 SignalBuffer &SignalBuffer::operator=(const SignalBuffer &other)
 {
    if (this == &other)
@@ -65,19 +76,79 @@ SignalBuffer &SignalBuffer::operator=(const SignalBuffer &other)
    return *this;
 }
 
+SignalBuffer &SignalBuffer::operator=(SignalBuffer &&other) noexcept
+{
+   if (this == &other)
+      return *this;
+
+   rt::Buffer<float>::operator=(std::move(other));
+
+   impl = std::move(other.impl);
+
+   return *this;
+}
+
+const SignalBuffer::Impl *SignalBuffer::attributes() const
+{
+   static const Impl empty(0, 0, 0, 0);
+
+   return impl ? impl.get() : &empty;
+}
+
+SignalBuffer::Impl *SignalBuffer::attributes()
+{
+   if (!impl)
+      impl = std::make_shared<Impl>(0, 0, 0, 0);
+
+   return impl.get();
+}
+
 unsigned int SignalBuffer::offset() const
 {
-   return impl->offset;
+   return attributes()->offset;
 }
 
 unsigned int SignalBuffer::decimation() const
 {
-   return impl->decimation;
+   return attributes()->decimation;
 }
 
 unsigned int SignalBuffer::sampleRate() const
 {
-   return impl->samplerate;
+   return attributes()->samplerate;
+}
+
+long long SignalBuffer::captureTime() const
+{
+   return attributes()->captureTime;
+}
+
+void SignalBuffer::setCaptureTime(long long value)
+{
+   attributes()->captureTime = value;
+}
+
+unsigned long long SignalBuffer::id() const
+{
+   return attributes()->id;
+}
+
+void SignalBuffer::setId(unsigned long long value)
+{
+   attributes()->id = value;
+}
+
+SignalBuffer &SignalBuffer::recycle(unsigned int offset)
+{
+   clear();
+
+   Impl *attrs = attributes();
+
+   attrs->offset = offset;
+   attrs->captureTime = 0;
+   attrs->id = ++sequence;
+
+   return *this;
 }
 
 }
@@ -0,0 +1,836 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <queue>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include <rt/Logger.h>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RecordDevice.h>
+#include <sdr/SimulatedDevice.h>
+
+#define BUFFER_SAMPLES 65536
+
+// receiver processes samples in groups of 16
+#define SAMPLE_GROUP 16
+
+// pending buffers before samples are dropped, about 100ms at 10 Msps
+#define MAX_QUEUE_SIZE 16
+
+// NFC carrier frequency
+#define NFC_FC 13.56E6
+
+// synthesized traffic repeats each 5ms
+#define CYCLE_PERIOD 5E-3
+
+// synthesized carrier level and card load modulation deep
+#define CARRIER_LEVEL 0.25f
+#define LOAD_MODULATION 0.10f
+
+namespace sdr {
+
+struct SimulatedDevice::Impl
+{
+   rt::Logger log {"SimulatedDevice"};
+
+   std::string deviceName;
+   std::string deviceVersion = "simulated";
+   std::string sourceName;
+   long centerFreq = 0;
+   long sampleRate = 10000000;
+   int gainMode = 0;
+   int gainValue = 0;
+   int tunerAgc = 0;
+   int mixerAgc = 0;
+   int biasTee = 0;
+   int decimation = 0;
+   int testMode = 0;
+   int directSampling = 0;
+   long streamTime = 0;
+
+   // stream speed over sample rate, zero for unpaced stream
+   double speed = 1;
+
+   // device is ready for streaming
+   bool deviceOpen = false;
+
+   // recording played by this device, none for synthesized traffic
+   std::shared_ptr<RecordDevice> source;
+
+   // one cycle of synthesized traffic and current position
+   std::vector<float> cycle;
+   unsigned int cycleOffset = 0;
+
+   std::mutex workerMutex;
+   std::atomic_bool workerStreaming {false};
+   std::thread workerThread;
+   std::thread callbackThread;
+
+   std::mutex streamMutex;
+   std::condition_variable streamSync;
+   std::queue<SignalBuffer> streamQueue;
+   RadioDevice::StreamHandler streamCallback;
+
+   // set by stream worker on exit, callback worker drains queue until then
+   bool workerFinished = false;
+
+   std::atomic<long> samplesReceived {0};
+   std::atomic<long> samplesDropped {0};
+
+   explicit Impl(std::string name) : deviceName(std::move(name))
+   {
+      log.debug("created SimulatedDevice for name [{}]", {this->deviceName});
+
+      // source name and optional parameters
+      sourceName = deviceName.find("sim://") == 0 ? deviceName.substr(6) : deviceName;
+
+      auto query = sourceName.find('?');
+
+      if (query != std::string::npos)
+      {
+         auto params = sourceName.substr(query + 1);
+
+         if (params.find("speed=") == 0)
+            speed = std::max(0.0, std::atof(params.c_str() + 6));
+
+         sourceName = sourceName.substr(0, query);
+      }
+   }
+
+   ~Impl()
+   {
+      log.debug("destroy SimulatedDevice");
+
+      close();
+   }
+
+   bool open(SignalDevice::OpenMode mode)
+   {
+      if (deviceName.find("sim://") != 0)
+      {
+         log.warn("invalid device name [{}]", {deviceName});
+         return false;
+      }
+
+      if (mode != SignalDevice::Read)
+      {
+         log.warn("invalid open mode, only read is supported");
+         return false;
+      }
+
+      close();
+
+      if (sourceName != "nfca")
+      {
+         source = std::make_shared<RecordDevice>(sourceName);
+
+         if (!source->open(SignalDevice::Read))
+         {
+            log.warn("unable to open recording for device {}", {deviceName});
+
+            source.reset();
+
+            return false;
+         }
+
+         // recording defines device sample rate
+         sampleRate = source->sampleRate();
+      }
+
+      deviceOpen = true;
+
+      log.info("openned simulated device {} at {} sps, speed {}", {deviceName, sampleRate, speed});
+
+      return true;
+   }
+
+   void close()
+   {
+      if (deviceOpen)
+      {
+         // stop streaming if active...
+         stop();
+
+         log.info("close device {}", {deviceName});
+
+         if (source)
+         {
+            source->close();
+            source.reset();
+         }
+
+         deviceOpen = false;
+      }
+   }
+
+   int start(RadioDevice::StreamHandler handler)
+   {
+      if (deviceOpen && !workerStreaming)
+      {
+         // release threads of a stream that reached the end of the source
+         stop();
+
+         // delay worker start until method is finished
+         std::lock_guard<std::mutex> lock(workerMutex);
+
+         // clear counters
+         samplesDropped = 0;
+         samplesReceived = 0;
+
+         // reset stream status
+         streamCallback = std::move(handler);
+         streamQueue = std::queue<SignalBuffer>();
+         workerFinished = false;
+
+         // traffic is synthesized for current sample rate
+         if (!source)
+            synthesize();
+
+         log.info("start streaming for device {}", {deviceName});
+
+         // set streaming flag to enable worker
+         workerStreaming = true;
+
+         // run worker thread
+         workerThread = std::thread([this] { streamWorker(); });
+
+         // run callback thread, decoupled from sample generation as USB transfers are
+         if (streamCallback)
+            callbackThread = std::thread([this] { callbackWorker(); });
+
+         // sets stream start time
+         streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+         return 0;
+      }
+
+      return -1;
+   }
+
+   int stop()
+   {
+      int result = -1;
+
+      if (deviceOpen && workerStreaming)
+      {
+         log.info("stop streaming for device {}", {deviceName});
+
+         // signal finish to running threads
+         workerStreaming = false;
+
+         streamSync.notify_all();
+
+         result = 0;
+      }
+
+      // worker also finishes by itself at the end of the source, its threads must be joined anyway
+      if (workerThread.joinable() || callbackThread.joinable())
+      {
+         if (workerThread.joinable())
+            workerThread.join();
+
+         if (callbackThread.joinable())
+            callbackThread.join();
+
+         // buffers not taken by read are lost
+         while (!streamQueue.empty())
+         {
+            samplesDropped += streamQueue.front().elements();
+            streamQueue.pop();
+         }
+
+         // disable stream callback and queue
+         streamCallback = nullptr;
+         streamTime = 0;
+      }
+
+      return result;
+   }
+
+   int read(SignalBuffer &buffer)
+   {
+      // lock buffer access
+      std::lock_guard<std::mutex> lock(streamMutex);
+
+      if (!streamQueue.empty())
+      {
+         buffer = streamQueue.front();
+
+         streamQueue.pop();
+
+         return buffer.limit();
+      }
+
+      return -1;
+   }
+
+   /*
+    * Build one cycle of NFC-A polling, REQA command from reader and ATQA response from card
+    */
+   void synthesize()
+   {
+      double rate = double(sampleRate);
+      double bit = 128 / NFC_FC;
+      double pause = 40 / NFC_FC;
+      double subcarrier = 16 / NFC_FC;
+
+      cycle.assign((unsigned int) (rate * CYCLE_PERIOD), CARRIER_LEVEL);
+      cycleOffset = 0;
+
+      // amplitude over time interval
+      auto shape = [&](double from, double to, const std::function<float(double)> &level) {
+         for (auto i = (unsigned int) std::ceil(from * rate); i < cycle.size() && i < to * rate; i++)
+            cycle[i] = level(i / rate);
+      };
+
+      // reader modified miller pause
+      auto modulatePause = [&](double time) {
+         shape(time, time + pause, [](double) { return 0.0f; });
+      };
+
+      // card load modulation over half bit, with fc/16 subcarrier
+      auto modulateLoad = [&](double time) {
+         shape(time, time + bit / 2, [&](double t) {
+            return std::fmod(t - time, subcarrier) < subcarrier / 2 ? CARRIER_LEVEL * (1 - LOAD_MODULATION) : CARRIER_LEVEL;
+         });
+      };
+
+      double time = 100E-6;
+
+      // REQA short frame, 7 bits LSB first, start of frame is a logic 0
+      int last = 0;
+
+      modulatePause(time);
+
+      time += bit;
+
+      for (int i = 0; i < 7; i++, time += bit)
+      {
+         int value = (0x26 >> i) & 1;
+
+         if (value)
+            modulatePause(time + bit / 2);
+         else if (!last)
+            modulatePause(time);
+
+         last = value;
+      }
+
+      // end of frame, logic 0 followed by no modulation
+      double lastPause = last ? time - bit / 2 : time;
+
+      if (!last)
+         modulatePause(time);
+
+      // ATQA response after frame delay time, last command bit was 0
+      time = lastPause + pause + 1172 / NFC_FC;
+
+      // start of frame
+      modulateLoad(time);
+
+      time += bit;
+
+      // ATQA 0x0004, bytes LSB first with odd parity
+      for (int data: {0x04, 0x00})
+      {
+         int parity = 1;
+
+         for (int i = 0; i < 9; i++, time += bit)
+         {
+            int value = i < 8 ? (data >> i) & 1 : parity;
+
+            parity ^= value;
+
+            modulateLoad(value ? time : time + bit / 2);
+         }
+      }
+   }
+
+   // read next block from recording, rewinds on end of file or when the tail is shorter than one group of samples
+   int readBlock(SignalBuffer &block)
+   {
+      if (source->read(block) > 0 && block.elements() >= SAMPLE_GROUP)
+         return block.elements();
+
+      log.debug("end of recording reached for device {}, rewind", {deviceName});
+
+      source->close();
+
+      if (!source->open(SignalDevice::Read))
+         return -1;
+
+      block.clear();
+
+      return source->read(block) > 0 && block.elements() >= SAMPLE_GROUP ? block.elements() : -1;
+   }
+
+   // next buffer of IQ samples, from recording or synthesized traffic
+   SignalBuffer nextBuffer(float gain)
+   {
+      if (source)
+      {
+         int channels = source->channelCount();
+
+         SignalBuffer block(BUFFER_SAMPLES * channels, channels, sampleRate, 0, 0, SignalType::SAMPLE_REAL);
+
+         int samples = readBlock(block);
+
+         if (samples <= 0)
+            return {};
+
+         // whole groups only, readBlock never returns less than one group
+         samples &= ~(SAMPLE_GROUP - 1);
+
+         SignalBuffer buffer(samples * 2, 2, sampleRate, samplesReceived, 0, SignalType::SAMPLE_IQ);
+
+         float *src = block.data();
+         float *dst = buffer.pull(samples * 2);
+
+         // first channel is I, second channel is Q when present
+         for (int i = 0; i < samples; i++, src += channels)
+         {
+            dst[i * 2 + 0] = src[0] * gain;
+            dst[i * 2 + 1] = channels > 1 ? src[1] * gain : 0.0f;
+         }
+
+         buffer.flip();
+
+         return buffer;
+      }
+
+      SignalBuffer buffer(BUFFER_SAMPLES * 2, 2, sampleRate, samplesReceived, 0, SignalType::SAMPLE_IQ);
+
+      float *dst = buffer.pull(BUFFER_SAMPLES * 2);
+
+      // synthesized signal is in phase with local oscillator
+      for (int i = 0; i < BUFFER_SAMPLES; i++)
+      {
+         dst[i * 2 + 0] = cycle[cycleOffset] * gain;
+         dst[i * 2 + 1] = 0.0f;
+
+         if (++cycleOffset == cycle.size())
+            cycleOffset = 0;
+      }
+
+      buffer.flip();
+
+      return buffer;
+   }
+
+   void streamWorker()
+   {
+      std::lock_guard<std::mutex> lock(workerMutex);
+
+      log.info("stream worker started for device {}", {deviceName});
+
+      // buffers are released at sample rate scaled by speed factor
+      auto deadline = std::chrono::steady_clock::now();
+
+      while (workerStreaming)
+      {
+         // gain value in db
+         SignalBuffer buffer = nextBuffer(std::pow(10.0f, float(gainValue) / 20.0f));
+
+         if (!buffer.elements())
+         {
+            log.error("unable to read recording for device {}", {deviceName});
+            break;
+         }
+
+         int samples = (int) buffer.elements();
+
+         if (speed > 0)
+         {
+            deadline += std::chrono::nanoseconds((long long) (1E9 * samples / (sampleRate * speed)));
+
+            std::this_thread::sleep_until(deadline);
+
+            // stopped while waiting, buffer is not part of the stream
+            if (!workerStreaming)
+               break;
+         }
+
+         // stamp buffer with delivery time for latency measures
+         buffer.setCaptureTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+         {
+            // lock buffer access
+            std::lock_guard<std::mutex> guard(streamMutex);
+
+            if (streamCallback)
+            {
+               // consumer is not keeping up, new samples are lost
+               if (streamQueue.size() >= MAX_QUEUE_SIZE)
+               {
+                  samplesDropped += samples;
+
+                  log.warn("dropped samples {}", {samplesDropped.load()});
+
+                  continue;
+               }
+            }
+            else if (streamQueue.size() >= MAX_QUEUE_SIZE)
+            {
+               // discard oldest buffers
+               samplesDropped += streamQueue.front().elements();
+               streamQueue.pop();
+            }
+
+            samplesReceived += samples;
+
+            // queue new sample buffer
+            streamQueue.push(buffer);
+         }
+
+         streamSync.notify_one();
+      }
+
+      {
+         std::lock_guard<std::mutex> guard(streamMutex);
+
+         workerStreaming = false;
+         workerFinished = true;
+      }
+
+      streamSync.notify_all();
+
+      log.info("stream worker finished for device {}", {deviceName});
+   }
+
+   void callbackWorker()
+   {
+      while (true)
+      {
+         SignalBuffer buffer;
+
+         {
+            std::unique_lock<std::mutex> lock(streamMutex);
+
+            // queued buffers are delivered until stream worker is gone, so none is lost on stop
+            streamSync.wait(lock, [this] { return !streamQueue.empty() || workerFinished; });
+
+            if (streamQueue.empty())
+               break;
+
+            buffer = streamQueue.front();
+
+            streamQueue.pop();
+         }
+
+         // stream to buffer callback
+         streamCallback(buffer);
+      }
+   }
+};
+
+SimulatedDevice::SimulatedDevice(const std::string &name) : impl(std::make_shared<Impl>(name))
+{
+}
+
+const std::string &SimulatedDevice::name()
+{
+   return impl->deviceName;
+}
+
+const std::string &SimulatedDevice::version()
+{
+   return impl->deviceVersion;
+}
+
+bool SimulatedDevice::open(OpenMode mode)
+{
+   return impl->open(mode);
+}
+
+void SimulatedDevice::close()
+{
+   impl->close();
+}
+
+int SimulatedDevice::start(StreamHandler handler)
+{
+   return impl->start(handler);
+}
+
+int SimulatedDevice::stop()
+{
+   return impl->stop();
+}
+
+double SimulatedDevice::speed() const
+{
+   return impl->speed;
+}
+
+void SimulatedDevice::setSpeed(double value)
+{
+   impl->speed = value > 0 ? value : 0;
+}
+
+bool SimulatedDevice::isOpen() const
+{
+   return impl->deviceOpen;
+}
+
+bool SimulatedDevice::isEof() const
+{
+   return !impl->deviceOpen || !impl->workerStreaming;
+}
+
+bool SimulatedDevice::isReady() const
+{
+   return impl->deviceOpen;
+}
+
+bool SimulatedDevice::isStreaming() const
+{
+   return impl->workerStreaming;
+}
+
+int SimulatedDevice::sampleSize() const
+{
+   return 32;
+}
+
+int SimulatedDevice::setSampleSize(int value)
+{
+   impl->log.warn("setSampleSize has no effect!");
+
+   return -1;
+}
+
+long SimulatedDevice::sampleRate() const
+{
+   return impl->sampleRate;
+}
+
+int SimulatedDevice::setSampleRate(long value)
+{
+   // sample rate is fixed by recording once opened, synthesized traffic is built on stream start
+   if (impl->source || impl->workerStreaming)
+   {
+      impl->log.warn("setSampleRate has no effect!");
+
+      return -1;
+   }
+
+   impl->sampleRate = value;
+
+   return 0;
+}
+
+int SimulatedDevice::sampleType() const
+{
+   return Float;
+}
+
+int SimulatedDevice::setSampleType(int value)
+{
+   impl->log.warn("setSampleType has no effect!");
+
+   return -1;
+}
+
+long SimulatedDevice::streamTime() const
+{
+   return impl->streamTime;
+}
+
+int SimulatedDevice::setStreamTime(long value)
+{
+   return 0;
+}
+
+long SimulatedDevice::centerFreq() const
+{
+   return impl->centerFreq;
+}
+
+int SimulatedDevice::setCenterFreq(long value)
+{
+   impl->centerFreq = value;
+
+   return 0;
+}
+
+int SimulatedDevice::tunerAgc() const
+{
+   return impl->tunerAgc;
+}
+
+int SimulatedDevice::setTunerAgc(int value)
+{
+   impl->tunerAgc = value;
+
+   return 0;
+}
+
+int SimulatedDevice::mixerAgc() const
+{
+   return impl->mixerAgc;
+}
+
+int SimulatedDevice::setMixerAgc(int value)
+{
+   impl->mixerAgc = value;
+
+   return 0;
+}
+
+int SimulatedDevice::biasTee() const
+{
+   return impl->biasTee;
+}
+
+int SimulatedDevice::setBiasTee(int value)
+{
+   impl->biasTee = value;
+
+   return 0;
+}
+
+int SimulatedDevice::gainMode() const
+{
+   return impl->gainMode;
+}
+
+int SimulatedDevice::setGainMode(int value)
+{
+   impl->gainMode = value;
+
+   return 0;
+}
+
+int SimulatedDevice::gainValue() const
+{
+   return impl->gainValue;
+}
+
+int SimulatedDevice::setGainValue(int value)
+{
+   impl->gainValue = value;
+
+   return 0;
+}
+
+int SimulatedDevice::decimation() const
+{
+   return impl->decimation;
+}
+
+int SimulatedDevice::setDecimation(int value)
+{
+   impl->decimation = value;
+
+   return 0;
+}
+
+int SimulatedDevice::testMode() const
+{
+   return impl->testMode;
+}
+
+int SimulatedDevice::setTestMode(int value)
+{
+   impl->testMode = value;
+
+   return 0;
+}
+
+int SimulatedDevice::directSampling() const
+{
+   return impl->directSampling;
+}
+
+int SimulatedDevice::setDirectSampling(int value)
+{
+   impl->directSampling = value;
+
+   return 0;
+}
+
+long SimulatedDevice::samplesReceived()
+{
+   return impl->samplesReceived;
+}
+
+long SimulatedDevice::samplesDropped()
+{
+   return impl->samplesDropped;
+}
+
+std::map<int, std::string> SimulatedDevice::supportedSampleRates() const
+{
+   std::map<int, std::string> result;
+
+   if (impl->source)
+   {
+      result[(int) impl->sampleRate] = std::to_string(impl->sampleRate);
+   }
+   else
+   {
+      result[2400000] = "2400000"; // 2.4 MSPS
+      result[3200000] = "3200000"; // 3.2 MSPS
+      result[10000000] = "10000000"; // 10 MSPS
+   }
+
+   return result;
+}
+
+std::map<int, std::string> SimulatedDevice::supportedGainValues() const
+{
+   std::map<int, std::string> result;
+
+   // gain values in db, applied to stream samples
+   for (int i = 0; i <= 6; i++)
+      result[i] = std::to_string(i) + " db";
+
+   return result;
+}
+
+std::map<int, std::string> SimulatedDevice::supportedGainModes() const
+{
+   return {{0, "Auto"}, {1, "Manual"}};
+}
+
+int SimulatedDevice::read(SignalBuffer &buffer)
+{
+   return impl->read(buffer);
+}
+
+int SimulatedDevice::write(SignalBuffer &buffer)
+{
+   impl->log.warn("write not supported on this device!");
+
+   return -1;
+}
+
+}
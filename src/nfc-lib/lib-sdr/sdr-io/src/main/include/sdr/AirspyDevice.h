@@ -25,6 +25,7 @@
 #define SDR_AIRSPYDEVICE_H
 
 #include <vector>
+#include <memory>
 #include <functional>
 
 #include <rt/FloatBuffer.h>
@@ -44,6 +45,12 @@ class AirspyDevice : public RadioDevice
          Auto = 0, Linearity = 1, Sensitivity = 2
       };
 
+      // Converted: float IQ from libairspy, Raw: 12 bit samples converted on stream worker, Packed: same with packed USB transfers
+      enum TransferMode
+      {
+         Converted = 0, Raw = 1, Packed = 2
+      };
+
    public:
 
       explicit AirspyDevice(int fd);
@@ -54,6 +61,10 @@ class AirspyDevice : public RadioDevice
 
    public:
 
+      int transferMode() const;
+
+      int setTransferMode(int value);
+
       const std::string &name() override;
 
       const std::string &version() override;
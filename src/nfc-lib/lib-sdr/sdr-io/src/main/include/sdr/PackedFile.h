@@ -0,0 +1,112 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_PACKEDFILE_H
+#define SDR_PACKEDFILE_H
+
+#include <memory>
+#include <string>
+
+namespace sdr {
+
+/*
+ * Lossless compressed container for integer PCM sample data. Samples are split in blocks of fixed frame count,
+ * each block is coded independently with per channel linear prediction and Rice coded residuals, so blocks are
+ * compressed in parallel and any of them can be decoded after a seek. An index with block offsets is appended
+ * on close, files without index are recovered by scanning block headers.
+ */
+class PackedFile
+{
+      struct Impl;
+
+   public:
+
+      struct Format
+      {
+         int sampleRate;
+         int sampleSize;
+         int channelCount;
+         long streamTime;
+      };
+
+      // threads used to code blocks, zero selects from available cores
+      explicit PackedFile(const std::string &name, int threads = 0);
+
+      // true if file starts with container signature
+      static bool probe(const std::string &name);
+
+      const std::string &name() const;
+
+      // create new file for given format, only 8, 16 and 24 bit samples are supported
+      bool create(const Format &format);
+
+      // open existing file for reading
+      bool open();
+
+      // code pending samples, write index and finish file
+      void close();
+
+      bool isOpen() const;
+
+      bool isEof() const;
+
+      bool hasError() const;
+
+      const Format &format() const;
+
+      // append interleaved little endian PCM data, same layout as WAV data chunk
+      bool write(const void *data, unsigned int size);
+
+      // decode next PCM data into buffer, returns bytes stored
+      unsigned int read(void *data, unsigned int size);
+
+      // move read position to given sample frame
+      bool seek(long long frame);
+
+      // sample frames in file
+      long long frameCount() const;
+
+      // PCM bytes of stored blocks, or decoded
+      long long rawBytes() const;
+
+      // container bytes written or read
+      long long packedBytes() const;
+
+      // PCM bytes accepted and not yet stored
+      long long backlog() const;
+
+      // microseconds callers waited for block coding or disk
+      long long stallTime() const;
+
+      // microseconds spent coding blocks, added over all threads
+      long long busyTime() const;
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
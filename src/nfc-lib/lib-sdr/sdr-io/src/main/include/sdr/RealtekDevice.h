@@ -27,6 +27,7 @@
 #define SDR_REALTEKDEVICE_H
 
 #include <vector>
+#include <memory>
 #include <functional>
 
 #include <sdr/RadioDevice.h>
@@ -52,6 +53,16 @@ class RealtekDevice : public RadioDevice
 
    public:
 
+      // number of USB transfers queued by async reader
+      int transferCount() const;
+
+      int setTransferCount(int value);
+
+      // size in bytes of each USB transfer, multiple of 512
+      int transferSize() const;
+
+      int setTransferSize(int value);
+
       const std::string &name() override;
 
       const std::string &version() override;
@@ -56,9 +56,11 @@ class RecordDevice : public SignalDevice
 
       bool isStreaming() const override;
 
-      int sampleCount() const;
+      // sample frames in recording, all segments included
+      long long sampleCount() const;
 
-      int sampleOffset() const;
+      // values read or written since start of recording, counted across channels
+      long long sampleOffset() const;
 
       int sampleSize() const override;
 
@@ -80,6 +82,53 @@ class RecordDevice : public SignalDevice
 
       void setChannelCount(int value);
 
+      // triangular dither when writing integer samples of 8 to 24 bits
+      bool isDitherEnabled() const;
+
+      void setDitherEnabled(bool value);
+
+      // bytes queued in asynchronous writer and not yet on disk
+      long long writeBacklog() const;
+
+      // bytes stored on disk
+      long long writeBytes() const;
+
+      // microseconds spent waiting for writer blocks, non zero means disk can't keep up
+      long long writeStallTime() const;
+
+      // microseconds spent by writer thread in I/O calls, or coding blocks for compressed recordings
+      long long writeBusyTime() const;
+
+      // samples stored in lossless compressed container instead of WAV, must be set before open for write,
+      // while open tells if the file is a compressed container
+      bool isCompressed() const;
+
+      void setCompressed(bool value);
+
+      // PCM bytes per stored byte, one for uncompressed recordings
+      double compressionRatio() const;
+
+      // files opened for read are memory mapped when possible, must be set before open
+      bool isMapped() const;
+
+      void setMapped(bool value);
+
+      // maximum bytes of sample data per file before rotating to next segment, zero disables
+      long long segmentSize() const;
+
+      void setSegmentSize(long long value);
+
+      // maximum seconds per file before rotating to next segment, zero disables
+      long segmentTime() const;
+
+      void setSegmentTime(long value);
+
+      // files written so far, or found for recording opened for read
+      int segmentCount() const;
+
+      // move read position to given sample, counted per channel
+      bool seek(long long sample);
+
       int read(SignalBuffer &buffer) override;
 
       int write(SignalBuffer &buffer) override;
@@ -43,16 +43,38 @@ class SignalBuffer : public rt::Buffer<float>
 
       SignalBuffer(const SignalBuffer &other);
 
+      SignalBuffer(SignalBuffer &&other) noexcept;
+
       SignalBuffer &operator=(const SignalBuffer &other);
 
+      SignalBuffer &operator=(SignalBuffer &&other) noexcept;
+
       unsigned int offset() const;
 
       unsigned int decimation() const;
 
       unsigned int sampleRate() const;
 
+      // monotonic capture time in nanoseconds (steady clock), 0 if unknown
+      long long captureTime() const;
+
+      void setCaptureTime(long long value);
+
+      // unique buffer id, buffers derived from another one keep its id so they can be followed across tasks
+      unsigned long long id() const;
+
+      void setId(unsigned long long value);
+
+      // reuse storage for a new block of samples at given offset, caller must hold the only reference
+      SignalBuffer &recycle(unsigned int offset);
+
    private:
 
+      // moved-from buffers have no attributes, they read as empty and get new ones when modified
+      const Impl *attributes() const;
+
+      Impl *attributes();
+
       std::shared_ptr<Impl> impl;
 };
 
@@ -0,0 +1,89 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include <chrono>
+
+/*
+ * Benchmarks and stand-in harnesses behind the measures quoted in commit messages, each one runs
+ * without radio hardware and prints its results to stdout.
+ */
+namespace bench {
+
+// RecordDevice encode and decode of each sample format
+int codec(int argc, char *argv[]);
+
+// FrameCompactor run detection and FrameExpander round trip
+int compact(int argc, char *argv[]);
+
+// SignalBuffer and NfcFrame handoff through Subject and BlockingQueue
+int handoff(int argc, char *argv[]);
+
+// Logger producer cost for literal and copied formats
+int logger(int argc, char *argv[]);
+
+// PackedFile lossless round trip of a WAV corpus
+int pack(int argc, char *argv[]);
+
+// RtlTcpDevice against a loopback rtl_tcp server
+int rtltcp(int argc, char *argv[]);
+
+// SimulatedDevice delivery and drop accounting on recordings
+int sim(int argc, char *argv[]);
+
+// FrameStore retention limits with spill file
+int spill(int argc, char *argv[]);
+
+// FrameStore range queries and filtered counts
+int store(int argc, char *argv[]);
+
+// FrameTrace streaming load against the JSON document loader
+int trace(int argc, char *argv[]);
+
+// Tracer span cost, disabled and enabled
+int tracer(int argc, char *argv[]);
+
+// Worker notification latency and idle wake-ups, against timed polling
+int wake(int argc, char *argv[]);
+
+// RecordDevice sequential reads, memory mapped and through streams
+int wavread(int argc, char *argv[]);
+
+// FileWriter producer cost against synchronous stream writes
+int writer(int argc, char *argv[]);
+
+// peak resident memory of this process in bytes
+long long peakMemory();
+
+// seconds elapsed since given time point
+inline double elapsed(std::chrono::steady_clock::time_point start)
+{
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+#endif
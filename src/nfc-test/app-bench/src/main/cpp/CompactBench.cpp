@@ -0,0 +1,269 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+#include <nfc/Nfc.h>
+#include <nfc/NfcFrame.h>
+#include <nfc/FrameCompactor.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// seconds between generated frames and length of each one
+#define COMPACT_SLOT 0.001
+#define COMPACT_LENGTH 0.0002
+
+// sample rate of generated capture
+#define COMPACT_RATE 10E6
+
+// frames passed to the compactor at once, as decoder tasks publish them
+#define COMPACT_BATCH 64
+
+// frame of given type starting at slot, polls carry command and cycle member index
+static nfc::NfcFrame makeFrame(long slot, int frameType, int member)
+{
+   double start = slot * COMPACT_SLOT;
+
+   nfc::NfcFrame frame(frameType == nfc::FrameType::CarrierOn ? nfc::TechType::None : nfc::TechType::NfcA, frameType, start, start + COMPACT_LENGTH);
+
+   frame.setSampleStart((unsigned long) std::llround(start * COMPACT_RATE));
+   frame.setSampleEnd((unsigned long) std::llround((start + COMPACT_LENGTH) * COMPACT_RATE));
+
+   if (frameType != nfc::FrameType::CarrierOn)
+   {
+      frame.put(frameType == nfc::FrameType::PollFrame ? 0x26 : 0x44);
+      frame.put((unsigned char) member);
+   }
+
+   frame.flip();
+
+   return frame;
+}
+
+// cycles of period frames, last member of longer cycles is a carrier frame as between reader polls
+static void appendPolling(std::vector<nfc::NfcFrame> &frames, long &slot, int period, long cycles)
+{
+   for (long c = 0; c < cycles; c++)
+   {
+      for (int m = 0; m < period; m++)
+         frames.push_back(makeFrame(slot++, period > 2 && m == period - 1 ? nfc::FrameType::CarrierOn : nfc::FrameType::PollFrame, m));
+   }
+}
+
+// runs frames through the compactor in batches, flushes at end
+static std::list<nfc::NfcFrame> compact(nfc::FrameCompactor &compactor, const std::vector<nfc::NfcFrame> &frames)
+{
+   std::list<nfc::NfcFrame> output;
+   std::list<nfc::NfcFrame> batch;
+
+   for (const auto &frame: frames)
+   {
+      batch.push_back(frame);
+
+      if (batch.size() == COMPACT_BATCH)
+      {
+         output.splice(output.end(), compactor.nextFrames(batch));
+         batch.clear();
+      }
+   }
+
+   output.splice(output.end(), compactor.nextFrames(batch));
+   output.splice(output.end(), compactor.flush());
+
+   return output;
+}
+
+static std::list<nfc::NfcFrame> expand(const std::list<nfc::NfcFrame> &frames)
+{
+   nfc::FrameExpander expander;
+
+   std::list<nfc::NfcFrame> output;
+
+   for (const auto &frame: frames)
+      output.splice(output.end(), expander.nextFrames(frame));
+
+   output.splice(output.end(), expander.flush());
+
+   return output;
+}
+
+// expanded frame matches original up to summary rounding
+static bool isRestored(const nfc::NfcFrame &expanded, const nfc::NfcFrame &original)
+{
+   if (expanded.isRepeated() ||
+       expanded.techType() != original.techType() ||
+       expanded.frameType() != original.frameType() ||
+       expanded.limit() != original.limit())
+      return false;
+
+   for (unsigned int i = 0; i < original.limit(); i++)
+   {
+      if (expanded[i] != original[i])
+         return false;
+   }
+
+   return std::fabs(expanded.timeStart() - original.timeStart()) < 1E-9 &&
+          std::fabs(expanded.timeEnd() - original.timeEnd()) < 1E-9 &&
+          std::labs((long) expanded.sampleStart() - (long) original.sampleStart()) <= 1;
+}
+
+// cycles of each period up to the longest recognized one are compacted, longer ones pass unchanged
+static int checkPeriods()
+{
+   int failures = 0;
+
+   for (int period: {1, 2, 3, 5, 16, 17})
+   {
+      std::vector<nfc::NfcFrame> frames;
+      long slot = 0;
+
+      appendPolling(frames, slot, period, 20);
+
+      nfc::FrameCompactor compactor;
+
+      compactor.setEnabled(true);
+
+      std::list<nfc::NfcFrame> output = compact(compactor, frames);
+
+      bool expected = period <= 16 ? compactor.suppressed() > 0 : compactor.suppressed() == 0 && output.size() == frames.size();
+
+      printf("  period %2d: %zu frames in, %zu out, %lld suppressed, %s\n", period, frames.size(), output.size(), compactor.suppressed(), expected ? "ok" : "FAILED");
+
+      if (!expected)
+         failures++;
+   }
+
+   return failures;
+}
+
+// poll held back by the run is released unchanged right before the listen frame ending it
+static int checkRelease()
+{
+   std::vector<nfc::NfcFrame> frames;
+   long slot = 0;
+
+   appendPolling(frames, slot, 2, 10);
+
+   frames.push_back(makeFrame(slot++, nfc::FrameType::PollFrame, 0));
+   frames.push_back(makeFrame(slot++, nfc::FrameType::ListenFrame, 0));
+
+   nfc::FrameCompactor compactor;
+
+   compactor.setEnabled(true);
+
+   std::list<nfc::NfcFrame> output = compactor.nextFrames({frames.begin(), frames.end()});
+
+   bool released = output.size() >= 2 &&
+                   isRestored(*std::prev(output.end(), 2), frames[frames.size() - 2]) &&
+                   isRestored(output.back(), frames.back());
+
+   printf("  release: %zu frames in, %zu out, pending poll %s\n", frames.size(), output.size(), released ? "released before listen frame" : "FAILED");
+
+   return released ? 0 : 1;
+}
+
+// compactor output expanded back to the original stream, with periodic summaries of long runs
+static int checkRoundTrip(long target)
+{
+   static const int periods[] = {1, 2, 3, 4, 7, 16};
+
+   std::vector<nfc::NfcFrame> frames;
+   long slot = 0;
+
+   frames.reserve(target + 64);
+
+   for (long run = 0; (long) frames.size() < target; run++)
+   {
+      int period = periods[run % 6];
+
+      appendPolling(frames, slot, period, 50 + (run * 37) % 400);
+
+      // card exchange ends the run
+      frames.push_back(makeFrame(slot++, nfc::FrameType::PollFrame, 0x93));
+      frames.push_back(makeFrame(slot++, nfc::FrameType::ListenFrame, run & 0xff));
+   }
+
+   int failures = 0;
+
+   for (double interval: {0.0, 0.1})
+   {
+      nfc::FrameCompactor compactor;
+
+      compactor.setEnabled(true);
+      compactor.setSummaryInterval(interval);
+
+      auto start = std::chrono::steady_clock::now();
+
+      std::list<nfc::NfcFrame> compacted = compact(compactor, frames);
+
+      double compactTime = elapsed(start);
+
+      start = std::chrono::steady_clock::now();
+
+      std::list<nfc::NfcFrame> expanded = expand(compacted);
+
+      double expandTime = elapsed(start);
+
+      long wrong = expanded.size() == frames.size() ? 0 : 1;
+
+      auto original = frames.begin();
+
+      for (auto it = expanded.begin(); it != expanded.end() && original != frames.end(); ++it, ++original)
+      {
+         if (!isRestored(*it, *original))
+            wrong++;
+      }
+
+      printf("  round trip, summary interval %.1f s: %zu frames to %zu, compact %.1f Mframes/s, expand %.1f Mframes/s, %zu restored, wrong %ld\n",
+             interval, frames.size(), compacted.size(), frames.size() / compactTime / 1E6, frames.size() / expandTime / 1E6, expanded.size(), wrong);
+
+      if (wrong)
+         failures++;
+   }
+
+   return failures;
+}
+
+/*
+ * FrameCompactor period detection, release of the held back poll when a run ends, and the summary to
+ * FrameExpander round trip on a generated polling stream.
+ */
+int compact(int argc, char *argv[])
+{
+   long frames = argc > 0 ? std::atol(argv[0]) : 1000000;
+
+   printf("compaction of %ld polling frames\n", frames);
+
+   int failures = checkPeriods() + checkRelease() + checkRoundTrip(frames);
+
+   return failures ? 1 : 0;
+}
+
+}
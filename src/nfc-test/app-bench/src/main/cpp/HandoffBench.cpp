@@ -0,0 +1,107 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <rt/Subject.h>
+#include <rt/BlockingQueue.h>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+
+#include <nfc/Nfc.h>
+#include <nfc/NfcFrame.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// number of subscribers, as the receiver output has decoder, recorder and fourier tasks
+#define HANDOFF_SUBSCRIBERS 3
+
+/*
+ * Publish the same value through a subject whose subscribers queue it, then drain each queue as the
+ * consumer tasks do. Reports the cost of one publish including the dequeue on every subscriber.
+ */
+template <typename T>
+double publish(const std::string &name, const T &value, long iterations)
+{
+   rt::Subject<T> *subject = rt::Subject<T>::name(name);
+
+   std::vector<rt::BlockingQueue<T>> queues(HANDOFF_SUBSCRIBERS);
+
+   std::vector<typename rt::Subject<T>::Subscription> subscriptions;
+
+   for (auto &queue: queues)
+      subscriptions.push_back(subject->subscribe([&queue](const T &entry) { queue.add(entry); }));
+
+   long received = 0;
+
+   auto start = std::chrono::steady_clock::now();
+
+   for (long i = 0; i < iterations; i++)
+   {
+      subject->next(value);
+
+      for (auto &queue: queues)
+      {
+         if (auto entry = queue.get())
+            received += entry->limit() > 0;
+      }
+   }
+
+   double time = elapsed(start);
+
+   if (received != iterations * HANDOFF_SUBSCRIBERS)
+      printf("  unexpected number of received values %ld\n", received);
+
+   return time * 1E9 / iterations;
+}
+
+int handoff(int argc, char *argv[])
+{
+   long iterations = argc > 0 ? std::atol(argv[0]) : 2000000;
+
+   sdr::SignalBuffer buffer(65536 * 2, 2, 10000000, 0, 0, sdr::SignalType::SAMPLE_IQ);
+
+   // contents are irrelevant, only the handoff is measured
+   buffer.pull(65536 * 2);
+   buffer.flip();
+
+   nfc::NfcFrame frame(nfc::TechType::NfcA, nfc::FrameType::PollFrame);
+
+   frame.put(0x26).flip();
+
+   printf("handoff to %d subscribers, %ld iterations\n", HANDOFF_SUBSCRIBERS, iterations);
+
+   printf("  SignalBuffer: %.1f ns per publish\n", publish("bench.signal", buffer, iterations));
+
+   printf("  NfcFrame:     %.1f ns per publish\n", publish("bench.frame", frame, iterations));
+
+   return 0;
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <rt/Logger.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// calls per burst, below ring size so bursts are not dropped while writer drains
+#define LOGGER_BURST 500
+
+/*
+ * Producer side cost of one debug call with three parameters, bursts are spaced so the writer thread
+ * drains the ring between them as it does in a running pipeline.
+ */
+int logger(int argc, char *argv[])
+{
+   int bursts = argc > 0 ? std::atoi(argv[0]) : 400;
+
+   rt::Logger log {"LoggerBench", rt::Logger::DEBUG};
+
+   std::string tech = "NfcA";
+
+   std::string format = "decoded frame {} tech {} rate {.2} Msps";
+
+   double literal = 0;
+   double copied = 0;
+
+   for (int i = 0; i < bursts; i++)
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      for (int n = 0; n < LOGGER_BURST; n++)
+         log.debug("decoded frame {} tech {} rate {.2} Msps", {n, tech, 1.25});
+
+      literal += elapsed(start);
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+      start = std::chrono::steady_clock::now();
+
+      for (int n = 0; n < LOGGER_BURST; n++)
+         log.debug(format, {n, tech, 1.25});
+
+      copied += elapsed(start);
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+   }
+
+   printf("logger, %d bursts of %d debug calls with 3 parameters\n", bursts, LOGGER_BURST);
+
+   printf("  literal format: %.1f ns per call\n", literal * 1E9 / (bursts * LOGGER_BURST));
+
+   printf("  string format:  %.1f ns per call\n", copied * 1E9 / (bursts * LOGGER_BURST));
+
+   return 0;
+}
+
+}
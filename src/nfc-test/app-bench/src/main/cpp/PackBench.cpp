@@ -0,0 +1,198 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <rt/FileSystem.h>
+
+#include <sdr/PackedFile.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// PCM bytes handed to each write or read call, as RecordDevice does
+#define PACK_CHUNK (256 * 1024)
+
+struct WavData
+{
+   sdr::PackedFile::Format format {};
+   std::vector<unsigned char> pcm;
+};
+
+static unsigned int le32(const unsigned char *p)
+{
+   return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int) p[3] << 24;
+}
+
+// raw data chunk of integer PCM WAV, without conversion so round trip can be compared bytewise
+static bool loadWav(const std::string &path, WavData &wav)
+{
+   std::ifstream file(path, std::ios::binary);
+
+   std::vector<unsigned char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+   if (content.size() < 12 || std::memcmp(content.data(), "RIFF", 4) != 0 || std::memcmp(content.data() + 8, "WAVE", 4) != 0)
+      return false;
+
+   size_t offset = 12;
+
+   while (offset + 8 <= content.size())
+   {
+      const unsigned char *entry = content.data() + offset;
+
+      size_t size = le32(entry + 4);
+
+      if (std::memcmp(entry, "fmt ", 4) == 0 && size >= 16)
+      {
+         if ((entry[8] | entry[9] << 8) != 1)
+            return false;
+
+         wav.format.channelCount = entry[10] | entry[11] << 8;
+         wav.format.sampleRate = (int) le32(entry + 12);
+         wav.format.sampleSize = entry[22] | entry[23] << 8;
+      }
+      else if (std::memcmp(entry, "data", 4) == 0)
+      {
+         size = std::min(size, content.size() - offset - 8);
+
+         wav.pcm.assign(entry + 8, entry + 8 + size);
+
+         return wav.format.channelCount > 0;
+      }
+
+      offset += 8 + size + (size & 1);
+   }
+
+   return false;
+}
+
+/*
+ * Lossless packing of a WAV corpus through sdr::PackedFile. Each integer PCM file is packed to a temporary
+ * container and unpacked again, the decoded PCM must match the original bytes. Rates are sample frames per
+ * second over the whole corpus, encode includes close so all blocks are coded and stored.
+ */
+int pack(int argc, char *argv[])
+{
+   std::string corpus = argc > 0 ? argv[0] : "wav";
+   int threads = argc > 1 ? std::atoi(argv[1]) : 0;
+   std::string path = argc > 2 ? argv[2] : "nfc-bench-pack.iqz";
+
+   long long files = 0;
+   long long frames = 0;
+   long long rawBytes = 0;
+   long long packedBytes = 0;
+   double encodeTime = 0;
+   double decodeTime = 0;
+   bool passed = true;
+
+   for (const auto &entry: rt::FileSystem::directoryList(corpus))
+   {
+      if (entry.name.find(".wav") == std::string::npos)
+         continue;
+
+      WavData wav;
+
+      if (!loadWav(entry.name, wav) || (wav.format.sampleSize != 8 && wav.format.sampleSize != 16 && wav.format.sampleSize != 24))
+      {
+         printf("  %s: skipped, not 8, 16 or 24 bit PCM\n", entry.name.c_str());
+         continue;
+      }
+
+      {
+         sdr::PackedFile output(path, threads);
+
+         auto start = std::chrono::steady_clock::now();
+
+         if (!output.create(wav.format))
+         {
+            printf("unable to write %s\n", path.c_str());
+            return 1;
+         }
+
+         for (size_t offset = 0; offset < wav.pcm.size(); offset += PACK_CHUNK)
+            output.write(wav.pcm.data() + offset, (unsigned int) std::min<size_t>(PACK_CHUNK, wav.pcm.size() - offset));
+
+         output.close();
+
+         encodeTime += elapsed(start);
+
+         packedBytes += output.packedBytes();
+      }
+
+      std::vector<unsigned char> decoded(wav.pcm.size() + PACK_CHUNK);
+
+      size_t length = 0;
+
+      {
+         sdr::PackedFile input(path, threads);
+
+         auto start = std::chrono::steady_clock::now();
+
+         if (!input.open())
+         {
+            printf("unable to read %s\n", path.c_str());
+            return 1;
+         }
+
+         while (unsigned int size = input.read(decoded.data() + length, PACK_CHUNK))
+            length += size;
+
+         decodeTime += elapsed(start);
+      }
+
+      bool exact = length == wav.pcm.size() && std::memcmp(decoded.data(), wav.pcm.data(), length) == 0;
+
+      if (!exact)
+         printf("  %s: round trip DIFFERS\n", entry.name.c_str());
+
+      files++;
+      frames += wav.pcm.size() / (wav.format.channelCount * wav.format.sampleSize / 8);
+      rawBytes += wav.pcm.size();
+
+      passed &= exact;
+   }
+
+   std::remove(path.c_str());
+
+   if (!files)
+   {
+      printf("no WAV files in %s\n", corpus.c_str());
+      return 1;
+   }
+
+   printf("%lld files, %lld frames, %.1f MB raw, %.1f MB packed, ratio %.2f\n", files, frames, rawBytes / 1E6, packedBytes / 1E6, (double) rawBytes / packedBytes);
+   printf("  encode %.1f MS/s, decode %.1f MS/s, round trip %s\n", frames / encodeTime / 1E6, frames / decodeTime / 1E6, passed ? "bit exact" : "FAILED");
+
+   return passed ? 0 : 1;
+}
+
+}
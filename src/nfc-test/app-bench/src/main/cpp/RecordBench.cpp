@@ -0,0 +1,378 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RecordDevice.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// IQ samples per buffer, as SignalRecorderTask reads them
+#define RECORD_BUFFER 65536
+
+// write a 16 bit IQ recording of given size with a slowly rotating tone
+static bool writeRecording(const std::string &path, long long samples)
+{
+   sdr::RecordDevice record(path);
+
+   record.setChannelCount(2);
+   record.setSampleRate(10000000);
+   record.setSampleSize(16);
+
+   if (!record.open(sdr::SignalDevice::Write))
+      return false;
+
+   sdr::SignalBuffer buffer(RECORD_BUFFER * 2, 2, 10000000, 0, 0, sdr::SignalType::SAMPLE_IQ);
+
+   for (long long offset = 0; offset < samples; offset += RECORD_BUFFER)
+   {
+      int length = (int) std::min<long long>(RECORD_BUFFER, samples - offset);
+
+      buffer.clear();
+
+      float *data = buffer.pull(length * 2);
+
+      for (int i = 0; i < length; i++)
+      {
+         data[i * 2 + 0] = 0.5f * std::cos(float(offset + i) * 0.001f);
+         data[i * 2 + 1] = 0.5f * std::sin(float(offset + i) * 0.001f);
+      }
+
+      buffer.flip();
+
+      record.write(buffer);
+   }
+
+   record.close();
+
+   return true;
+}
+
+struct ReadResult
+{
+   long long samples = 0;
+   double time = 0;
+   double seek = 0;
+   unsigned long long hash = 14695981039346656037ull;
+};
+
+// sequential read of whole recording in decoder sized buffers, mapped or through streams
+static ReadResult readRecording(const std::string &path, bool mapped)
+{
+   ReadResult result;
+
+   sdr::RecordDevice record(path);
+
+   record.setMapped(mapped);
+
+   auto start = std::chrono::steady_clock::now();
+
+   if (!record.open(sdr::SignalDevice::Read))
+      return result;
+
+   sdr::SignalBuffer buffer(RECORD_BUFFER * 2, 2, record.sampleRate(), 0, 0, sdr::SignalType::SAMPLE_IQ);
+
+   while (true)
+   {
+      buffer.clear();
+
+      if (record.read(buffer) <= 0)
+         break;
+
+      const float *data = buffer.data();
+
+      // sparse hash, both paths must return the same values
+      for (unsigned int i = 0; i < buffer.limit(); i += 4093)
+      {
+         uint32_t bits;
+
+         std::memcpy(&bits, data + i, sizeof(bits));
+
+         result.hash = (result.hash ^ bits) * 1099511628211ull;
+      }
+
+      result.samples += buffer.limit() / 2;
+   }
+
+   result.time = elapsed(start);
+
+   // open and seek to last buffer, as replay from a given time does
+   start = std::chrono::steady_clock::now();
+
+   record.close();
+   record.open(sdr::SignalDevice::Read);
+   record.seek(std::max(0LL, result.samples - RECORD_BUFFER));
+
+   buffer.clear();
+   record.read(buffer);
+
+   result.seek = elapsed(start);
+
+   return result;
+}
+
+/*
+ * Sequential decode of a 16 bit IQ recording through memory mapping and through file streams. The file
+ * is read once before timing so both paths run from page cache, then each path is timed twice and the
+ * best pass is reported.
+ */
+int wavread(int argc, char *argv[])
+{
+   long long megabytes = argc > 0 ? std::atoll(argv[0]) : 1024;
+   std::string path = argc > 1 ? argv[1] : "nfc-bench-record.wav";
+
+   long long samples = megabytes * 1024 * 1024 / 4;
+
+   if (!writeRecording(path, samples))
+   {
+      printf("unable to write %s\n", path.c_str());
+      return 1;
+   }
+
+   printf("16 bit IQ recording of %lld MB, %lld samples\n", megabytes, samples);
+
+   readRecording(path, false);
+
+   ReadResult best[2];
+
+   for (int pass = 0; pass < 2; pass++)
+   {
+      for (bool mapped: {false, true})
+      {
+         ReadResult result = readRecording(path, mapped);
+
+         if (!pass || result.time < best[mapped].time)
+            best[mapped] = result;
+      }
+   }
+
+   for (bool mapped: {false, true})
+   {
+      printf("  %s: %.0f Msps, open and seek to end %.3f ms\n", mapped ? "mapped " : "streams",
+             best[mapped].samples / best[mapped].time / 1E6, best[mapped].seek * 1E3);
+   }
+
+   bool passed = best[0].samples == samples && best[1].samples == samples && best[0].hash == best[1].hash;
+
+   printf("  samples %s\n", passed ? "match" : "DIFFER");
+
+   std::remove(path.c_str());
+
+   return passed ? 0 : 1;
+}
+
+struct CodecFormat
+{
+   const char *name;
+   int sampleType;
+   int sampleSize;
+};
+
+static const CodecFormat codecFormats[] = {
+      {"u8", sdr::SignalDevice::Integer, 8},
+      {"s16", sdr::SignalDevice::Integer, 16},
+      {"s24", sdr::SignalDevice::Integer, 24},
+      {"s32", sdr::SignalDevice::Integer, 32},
+      {"f32", sdr::SignalDevice::Float, 32},
+};
+
+// 8 bit file as written by releases before unsigned WAV layout, signed values with date list and no ds64 space
+static bool writeLegacyRecording(const std::string &path)
+{
+   std::FILE *file = std::fopen(path.c_str(), "wb");
+
+   if (!file)
+      return false;
+
+   auto u32 = [file](unsigned int value) {
+      unsigned char bytes[4] = {(unsigned char) value, (unsigned char) (value >> 8), (unsigned char) (value >> 16), (unsigned char) (value >> 24)};
+      std::fwrite(bytes, 1, 4, file);
+   };
+
+   auto u16 = [file](unsigned int value) {
+      unsigned char bytes[2] = {(unsigned char) value, (unsigned char) (value >> 8)};
+      std::fwrite(bytes, 1, 2, file);
+   };
+
+   std::fwrite("RIFF", 1, 4, file);
+   u32(4 + 24 + 16 + 8 + 256);
+   std::fwrite("WAVEfmt ", 1, 8, file);
+   u32(16);
+   u16(1);
+   u16(1);
+   u32(10000000);
+   u32(10000000);
+   u16(1);
+   u16(8);
+   std::fwrite("LIST", 1, 4, file);
+   u32(8);
+   std::fwrite("date", 1, 4, file);
+   u32(1600000000);
+   std::fwrite("data", 1, 4, file);
+   u32(256);
+
+   for (int i = 0; i < 256; i++)
+      std::fputc(i, file);
+
+   std::fclose(file);
+
+   return true;
+}
+
+/*
+ * Encode and decode cost of each recording sample format. A block of IQ values is written repeatedly
+ * through RecordDevice and read back memory mapped, rates are values per second including file I/O from
+ * page cache. A second untimed read compares every value against the source to check rounding stays
+ * within half LSB.
+ * Finally a signed 8 bit file in the layout of previous releases is read to check it still decodes.
+ */
+int codec(int argc, char *argv[])
+{
+   long long megavalues = argc > 0 ? std::atoll(argv[0]) : 64;
+   std::string path = argc > 1 ? argv[1] : "nfc-bench-codec.wav";
+
+   long long values = megavalues * 1000000 / (RECORD_BUFFER * 2) * (RECORD_BUFFER * 2);
+
+   sdr::SignalBuffer source(RECORD_BUFFER * 2, 2, 10000000, 0, 0, sdr::SignalType::SAMPLE_IQ);
+
+   float *data = source.pull(RECORD_BUFFER * 2);
+
+   // tone just below full scale plus small offset, so rounding of every format is exercised
+   for (int i = 0; i < RECORD_BUFFER * 2; i++)
+      data[i] = std::sin(float(i) * 0.0123f) * 0.99f + 1E-5f * float(i % 7);
+
+   source.flip();
+
+   printf("%lld values per format\n", values);
+
+   bool passed = true;
+
+   for (const CodecFormat &format: codecFormats)
+   {
+      sdr::RecordDevice output(path);
+
+      output.setChannelCount(2);
+      output.setSampleRate(10000000);
+      output.setSampleType(format.sampleType);
+      output.setSampleSize(format.sampleSize);
+
+      if (!output.open(sdr::SignalDevice::Write))
+      {
+         printf("unable to write %s\n", path.c_str());
+         return 1;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (long long offset = 0; offset < values; offset += RECORD_BUFFER * 2)
+         output.write(source);
+
+      output.close();
+
+      double encodeTime = elapsed(start);
+
+      sdr::RecordDevice input(path);
+
+      if (!input.open(sdr::SignalDevice::Read))
+      {
+         printf("unable to read %s\n", path.c_str());
+         return 1;
+      }
+
+      sdr::SignalBuffer buffer(RECORD_BUFFER * 2, 2, 10000000, 0, 0, sdr::SignalType::SAMPLE_IQ);
+
+      long long count = 0;
+
+      start = std::chrono::steady_clock::now();
+
+      while (true)
+      {
+         buffer.clear();
+
+         if (input.read(buffer) <= 0)
+            break;
+
+         count += buffer.limit();
+      }
+
+      double decodeTime = elapsed(start);
+
+      float error = 0;
+
+      input.seek(0);
+
+      while (true)
+      {
+         buffer.clear();
+
+         if (input.read(buffer) <= 0)
+            break;
+
+         // buffers line up with written blocks
+         for (unsigned int i = 0; i < buffer.limit(); i++)
+            error = std::max(error, std::abs(buffer.data()[i] - data[i]));
+      }
+
+      // half LSB for integer formats, exact for float
+      float limit = format.sampleType == sdr::SignalDevice::Float ? 0 : 0.5f / float(1u << (format.sampleSize - 1)) * 1.0001f;
+
+      bool valid = count == values && error <= limit;
+
+      printf("  %-3s: encode %5.0f M/s, decode %5.0f M/s, max error %.3g %s\n", format.name, values / encodeTime / 1E6, count / decodeTime / 1E6, error, valid ? "ok" : "FAILED");
+
+      passed &= valid;
+   }
+
+   // previous releases stored 8 bit samples as signed values
+   if (writeLegacyRecording(path))
+   {
+      sdr::RecordDevice legacy(path);
+
+      sdr::SignalBuffer buffer(256, 1, 10000000, 0, 0, sdr::SignalType::SAMPLE_REAL);
+
+      bool valid = legacy.open(sdr::SignalDevice::Read) && legacy.read(buffer) == 256;
+
+      for (int i = 0; valid && i < 256; i++)
+         valid = buffer.data()[i] == float((signed char) i) / 128;
+
+      printf("  legacy signed 8 bit file: %s\n", valid ? "ok" : "FAILED");
+
+      passed &= valid;
+   }
+
+   std::remove(path.c_str());
+
+   return passed ? 0 : 1;
+}
+
+}
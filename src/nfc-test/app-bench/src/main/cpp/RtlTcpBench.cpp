@@ -0,0 +1,230 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifdef _WIN32
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#undef ERROR
+
+typedef SOCKET socket_t;
+
+#define closesocket_t closesocket
+
+#else
+
+#include <unistd.h>
+#include <sys/select.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+typedef int socket_t;
+
+#define INVALID_SOCKET (-1)
+#define closesocket_t ::close
+
+#endif
+
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RtlTcpDevice.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+/*
+ * Minimal rtl_tcp server on loopback, sends the RTL0 header for an R820T tuner and then a repeating
+ * 0..255 byte ramp, so every received value can be checked. Commands from the client are ignored.
+ */
+struct RtlTcpServer
+{
+   socket_t listener = INVALID_SOCKET;
+
+   int port = 0;
+
+   bool listen()
+   {
+      sockaddr_in address {};
+
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = 0;
+
+      socklen_t length = sizeof(address);
+
+      if ((listener = socket(AF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET)
+         return false;
+
+      if (bind(listener, (sockaddr *) &address, sizeof(address)) || ::listen(listener, 1) || getsockname(listener, (sockaddr *) &address, &length))
+         return false;
+
+      port = ntohs(address.sin_port);
+
+      return true;
+   }
+
+   void serve(long long total)
+   {
+      socket_t client = accept(listener, nullptr, nullptr);
+
+      if (client == INVALID_SOCKET)
+         return;
+
+      // magic, tuner type 5 (R820T) and gain count 29, big endian
+      unsigned char header[12] = {'R', 'T', 'L', '0', 0, 0, 0, 5, 0, 0, 0, 29};
+
+      send(client, (const char *) header, sizeof(header), 0);
+
+      std::vector<unsigned char> ramp(256 * 1024);
+
+      for (size_t i = 0; i < ramp.size(); i++)
+         ramp[i] = (unsigned char) i;
+
+      for (long long sent = 0; sent < total;)
+      {
+         int length = (int) send(client, (const char *) ramp.data(), (int) ramp.size(), 0);
+
+         if (length <= 0)
+            break;
+
+         // keep ramp phase across partial sends
+         std::rotate(ramp.begin(), ramp.begin() + (length % 256), ramp.end());
+
+         sent += length;
+      }
+
+      // consume client commands, closing with unread input resets the connection and discards the samples in flight
+      while (true)
+      {
+         fd_set input;
+         timeval timeout {0, 100000};
+         char command[64];
+
+         FD_ZERO(&input);
+         FD_SET(client, &input);
+
+         if (select((int) client + 1, &input, nullptr, nullptr, &timeout) <= 0 || recv(client, command, sizeof(command), 0) <= 0)
+            break;
+      }
+
+      closesocket_t(client);
+      closesocket_t(listener);
+   }
+};
+
+/*
+ * Receive a fixed amount of u8 IQ from a loopback rtl_tcp server through RtlTcpDevice, measures the
+ * sustained conversion rate and checks every value against the expected ramp.
+ */
+int rtltcp(int argc, char *argv[])
+{
+   long long megabytes = argc > 0 ? std::atoll(argv[0]) : 2048;
+
+#ifdef _WIN32
+   WSADATA wsaData;
+
+   WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+   RtlTcpServer server;
+
+   if (!server.listen())
+   {
+      printf("unable to open loopback listener\n");
+      return 1;
+   }
+
+   std::thread thread([&server, megabytes] { server.serve(megabytes * 1024 * 1024); });
+
+   sdr::RtlTcpDevice device("rtltcp://127.0.0.1:" + std::to_string(server.port));
+
+   device.setSampleRate(3200000);
+
+   if (!device.open(sdr::SignalDevice::Read))
+   {
+      printf("unable to open device %s\n", device.name().c_str());
+      thread.join();
+      return 1;
+   }
+
+   std::atomic<long long> values {0};
+   std::atomic<long long> errors {0};
+   std::atomic<long long> buffers {0};
+
+   auto start = std::chrono::steady_clock::now();
+
+   device.start([&](sdr::SignalBuffer &buffer) {
+      const float *data = buffer.data();
+
+      long long base = values;
+      long long wrong = 0;
+
+      for (unsigned int i = 0; i < buffer.limit(); i++)
+      {
+         float expected = (float((base + i) % 256) - 128.0f) / 256.0f + 0.0025f;
+
+         wrong += std::fabs(data[i] - expected) > 1E-6f;
+      }
+
+      values += buffer.limit();
+      errors += wrong;
+      buffers++;
+   });
+
+   while (device.isReady())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+   double time = elapsed(start);
+
+   device.stop();
+
+   thread.join();
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+   const char *build = "SSE2";
+#else
+   const char *build = "scalar";
+#endif
+
+   printf("rtl_tcp loopback, %lld MB, %s build\n", megabytes, build);
+
+   printf("  %lld buffers, %.1f Msps (IQ), %lld wrong values\n", buffers.load(), values / 2 / time / 1E6, errors.load());
+
+   return 0;
+}
+
+}
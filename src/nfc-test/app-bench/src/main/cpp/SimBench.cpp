@@ -0,0 +1,246 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RecordDevice.h>
+#include <sdr/SimulatedDevice.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// one SimulatedDevice block plus a tail shorter than one group of 16 samples
+#define TAIL_LOOP 65536
+#define TAIL_SAMPLES 5
+
+// concurrent devices, as in multi-receiver capture
+#define SIM_DEVICES 2
+
+// ramp written to the short tail recording, exact in 16 bit PCM
+static float ramp(long long i)
+{
+   return float((i * 7) % 4096 - 2048) / 32768.0f;
+}
+
+/*
+ * Consumer attached to one simulated device, counts delivered samples, checks buffer offsets are
+ * contiguous and stalls on 1 in 16 buffers as a preempted decoder would.
+ */
+struct SimConsumer
+{
+   int stall = 0;
+
+   std::mt19937 random;
+
+   std::atomic<long long> delivered {0};
+   std::atomic<long long> discontinuities {0};
+   std::atomic<long long> wrong {0};
+
+   bool checkRamp = false;
+
+   explicit SimConsumer(int stall, int seed) : stall(stall), random(seed)
+   {
+   }
+
+   void operator()(const sdr::SignalBuffer &buffer)
+   {
+      long long base = delivered;
+
+      if (buffer.offset() != (unsigned int) base)
+         discontinuities++;
+
+      if (checkRamp)
+      {
+         const float *data = buffer.data();
+
+         for (unsigned int i = 0; i < buffer.elements(); i++)
+         {
+            if (std::fabs(data[i * 2] - ramp((base + i) % TAIL_LOOP)) > 1E-6f || data[i * 2 + 1] != 0.0f)
+               wrong++;
+         }
+      }
+
+      delivered += buffer.elements();
+
+      if (stall && random() % 16 == 0)
+         std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+   }
+};
+
+// write a recording whose last samples do not fill a group, it must rewind instead of ending the stream
+static bool writeTail(const std::string &path)
+{
+   sdr::RecordDevice record(path);
+
+   record.setChannelCount(1);
+   record.setSampleRate(10000000);
+   record.setSampleSize(16);
+
+   if (!record.open(sdr::SignalDevice::Write))
+      return false;
+
+   sdr::SignalBuffer buffer(TAIL_LOOP + TAIL_SAMPLES, 1, 10000000, 0, 0, sdr::SignalType::SAMPLE_REAL);
+
+   float *data = buffer.pull(TAIL_LOOP + TAIL_SAMPLES);
+
+   for (int i = 0; i < TAIL_LOOP + TAIL_SAMPLES; i++)
+      data[i] = ramp(i);
+
+   buffer.flip();
+
+   record.write(buffer);
+   record.close();
+
+   return true;
+}
+
+// concurrent paced devices with given consumer stall, returns number of failed devices
+static int playPaced(double seconds, int stall, const std::string &path)
+{
+   int failures = 0;
+
+   std::vector<std::unique_ptr<sdr::SimulatedDevice>> devices;
+   std::vector<std::unique_ptr<SimConsumer>> consumers;
+
+   for (int i = 0; i < SIM_DEVICES; i++)
+   {
+      devices.push_back(std::make_unique<sdr::SimulatedDevice>("sim://" + path));
+      consumers.push_back(std::make_unique<SimConsumer>(stall, i + 1));
+
+      if (!devices[i]->open(sdr::SignalDevice::Read))
+      {
+         printf("unable to open %s\n", devices[i]->name().c_str());
+         return SIM_DEVICES;
+      }
+   }
+
+   auto start = std::chrono::steady_clock::now();
+
+   for (int i = 0; i < SIM_DEVICES; i++)
+   {
+      SimConsumer *consumer = consumers[i].get();
+
+      devices[i]->start([consumer](sdr::SignalBuffer &buffer) { (*consumer)(buffer); });
+   }
+
+   std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+   for (int i = 0; i < SIM_DEVICES; i++)
+   {
+      // samples produced until this device stops, paced at its sample rate
+      double expected = elapsed(start) * (double) devices[i]->sampleRate();
+
+      // queued buffers are delivered before stop returns
+      devices[i]->stop();
+
+      long long received = devices[i]->samplesReceived();
+      long long dropped = devices[i]->samplesDropped();
+      long long delivered = consumers[i]->delivered;
+
+      // production is paced per block, allow one block of difference at each end
+      bool passed = delivered == received && !consumers[i]->discontinuities && std::fabs(double(received + dropped) - expected) <= 2 * TAIL_LOOP;
+
+      printf("%s, %d ms stalls: delivered %lld, received %lld, dropped %lld, produced %lld of %.0f expected: %s\n",
+             devices[i]->name().c_str(), stall, delivered, received, dropped, received + dropped, expected, passed ? "ok" : "FAILED");
+
+      failures += !passed;
+
+      devices[i]->close();
+   }
+
+   return failures;
+}
+
+/*
+ * Play recordings through sim:// devices. First an unpaced recording with a short tail, which must
+ * loop with the expected values. Then concurrent paced devices on a recording from wav/ with a consumer
+ * that keeps up and with one that stalls, unless a stall is given, where every produced sample must be
+ * either delivered or counted as dropped.
+ */
+int sim(int argc, char *argv[])
+{
+   double seconds = argc > 0 ? std::atof(argv[0]) : 5;
+   std::vector<int> stalls = argc > 1 ? std::vector<int> {std::atoi(argv[1])} : std::vector<int> {0, 120};
+   std::string path = argc > 2 ? argv[2] : "wav/test_NFC-A_106kbps_001.wav";
+
+   int failures = 0;
+
+   // short tail recording, unpaced
+   std::string tail = "nfc-bench-sim-tail.wav";
+
+   if (!writeTail(tail))
+   {
+      printf("unable to write %s\n", tail.c_str());
+      return 1;
+   }
+
+   {
+      sdr::SimulatedDevice device("sim://" + tail + "?speed=0");
+
+      SimConsumer consumer(0, 1);
+
+      consumer.checkRamp = true;
+
+      device.open(sdr::SignalDevice::Read);
+
+      device.start([&consumer](sdr::SignalBuffer &buffer) { consumer(buffer); });
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+      bool streaming = device.isStreaming();
+
+      device.stop();
+      device.close();
+
+      long long loops = consumer.delivered / TAIL_LOOP;
+
+      bool passed = streaming && loops > 2 && !consumer.wrong && !consumer.discontinuities;
+
+      printf("short tail: %lld loops of %d samples, %s, wrong values %lld, discontinuities %lld: %s\n",
+             loops, TAIL_LOOP, streaming ? "streaming" : "stream ended", consumer.wrong.load(), consumer.discontinuities.load(), passed ? "ok" : "FAILED");
+
+      failures += !passed;
+   }
+
+   std::remove(tail.c_str());
+
+   // without stalls the consumer keeps up and every stop races with a block in flight
+   for (int value: stalls)
+      failures += playPaced(seconds, value, path);
+
+   return failures ? 1 : 0;
+}
+
+}
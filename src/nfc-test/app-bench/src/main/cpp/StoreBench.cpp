@@ -0,0 +1,242 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <nfc/Nfc.h>
+#include <nfc/NfcFrame.h>
+#include <nfc/FrameStore.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// frames per second of generated capture
+#define STORE_RATE 1000.0
+
+// every this many frames one arrives late, as merged multi-receiver streams may
+#define STORE_LATE_INTERVAL 100000
+
+// queries checked against a full scan
+#define STORE_CHECKED 200
+
+// frame i of generated capture, polling and listen frames of all techs with 1 to 16 bytes payload
+static nfc::NfcFrame makeFrame(long i, bool late)
+{
+   static const int techs[] = {nfc::TechType::NfcA, nfc::TechType::NfcB, nfc::TechType::NfcF, nfc::TechType::NfcV};
+
+   nfc::NfcFrame frame(techs[i % 4], i % 2 ? nfc::FrameType::ListenFrame : nfc::FrameType::PollFrame);
+
+   double start = i / STORE_RATE - (late ? 0.005 : 0.0);
+
+   frame.setTimeStart(start);
+   frame.setTimeEnd(start + 0.0005);
+   frame.setSampleStart((unsigned long) (start * 10E6));
+   frame.setSampleEnd((unsigned long) ((start + 0.0005) * 10E6));
+   frame.setFrameFlags(i % 7 == 0 ? nfc::FrameFlags::CrcError : 0);
+
+   for (long b = 0; b <= i % 16; b++)
+      frame.put((unsigned char) (i + b));
+
+   frame.flip();
+
+   return frame;
+}
+
+/*
+ * Random time range queries with a filtered count over the result, on a store in time order and on one
+ * with late frames. The first queries are checked against a full scan of the frame list, which is also
+ * timed as the cost of the linear lookup.
+ */
+int store(int argc, char *argv[])
+{
+   long frames = argc > 0 ? std::atol(argv[0]) : 1000000;
+   long queries = argc > 1 ? std::atol(argv[1]) : 10000;
+
+   double duration = frames / STORE_RATE;
+
+   printf("store of %ld frames, %ld range queries of up to 1 s\n", frames, queries);
+
+   int failures = 0;
+
+   for (bool late: {false, true})
+   {
+      nfc::FrameStore store;
+
+      std::vector<double> starts;
+      std::vector<unsigned int> techs;
+
+      for (long i = 0; i < frames; i++)
+      {
+         nfc::NfcFrame frame = makeFrame(i, late && i % STORE_LATE_INTERVAL == STORE_LATE_INTERVAL - 1);
+
+         store.append(frame);
+
+         starts.push_back(frame.timeStart());
+         techs.push_back(frame.techType());
+      }
+
+      std::mt19937 random(1);
+      std::uniform_real_distribution<double> time(0, duration);
+      std::uniform_real_distribution<double> span(0, 1);
+
+      std::vector<std::pair<double, double>> ranges;
+
+      for (long q = 0; q < queries; q++)
+      {
+         double from = time(random);
+
+         ranges.emplace_back(from, from + span(random));
+      }
+
+      size_t sink = 0;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (const auto &query: ranges)
+      {
+         auto range = store.range(query.first, query.second);
+
+         sink += store.count(range.first, range.second, nfc::TechType::NfcA);
+      }
+
+      double indexed = elapsed(start) / queries;
+
+      long wrong = 0;
+
+      start = std::chrono::steady_clock::now();
+
+      for (long q = 0; q < STORE_CHECKED && q < queries; q++)
+      {
+         double from = ranges[q].first;
+         double to = ranges[q].second;
+
+         size_t expected = 0;
+
+         for (size_t i = 0; i < starts.size(); i++)
+            expected += starts[i] >= from && starts[i] <= to && techs[i] == nfc::TechType::NfcA;
+
+         sink += expected;
+
+         // range must hold every matching frame, and only them when frames are in order
+         auto range = store.range(from, to);
+
+         size_t found = 0;
+
+         for (size_t i = range.first; i < range.second; i++)
+            found += starts[i] >= from && starts[i] <= to && techs[i] == nfc::TechType::NfcA;
+
+         if (found != expected || (!late && store.count(range.first, range.second, nfc::TechType::NfcA) != expected))
+            wrong++;
+      }
+
+      double linear = elapsed(start) / std::min<long>(STORE_CHECKED, queries);
+
+      printf("  %s: range and count %.4f ms, linear scan %.3f ms, %zu frames counted, wrong results %ld\n",
+             late ? "with late frames" : "in time order   ", indexed * 1E3, linear * 1E3, sink, wrong);
+
+      failures += wrong != 0;
+   }
+
+   return failures ? 1 : 0;
+}
+
+/*
+ * Append frames with a resident limit and a spill folder, then read random frames back. Reports resident
+ * bytes and peak memory growth, and the cost of random access to resident and to spilled frames. Every
+ * frame read back is compared with the appended one. With a limit set, fails unless frames were spilled,
+ * none was refused and resident frames stay within the limit plus the block being filled.
+ */
+int spill(int argc, char *argv[])
+{
+   long frames = argc > 0 ? std::atol(argv[0]) : 1000000;
+   long retention = argc > 1 ? std::atol(argv[1]) : 20000;
+   std::string path = argc > 2 ? argv[2] : ".";
+   long reads = 20000;
+
+   printf("store of %ld frames, resident limit %ld (0 for none), spill folder %s\n", frames, retention, path.c_str());
+
+   long long base = peakMemory();
+
+   nfc::FrameStore store;
+
+   store.setSpillPath(path);
+   store.setRetention(retention, 0, 0);
+
+   auto start = std::chrono::steady_clock::now();
+
+   for (long i = 0; i < frames; i++)
+      store.append(makeFrame(i, false));
+
+   double append = elapsed(start);
+
+   printf("  append: %.3f s, %zu resident frames, %zu refused, %.1f MB resident, peak memory +%.1f MB\n",
+          append, store.residentSize(), store.refusedSize(), store.bytes() / 1E6, double(peakMemory() - base) / 1E6);
+
+   // frames only appended in order, refused frames are the newest ones
+   frames = (long) store.size();
+
+   std::mt19937 random(1);
+
+   long wrong = 0;
+
+   long oldest = frames - (long) store.residentSize();
+
+   // newest frames are resident, oldest ones were spilled
+   for (bool spilled: {false, true})
+   {
+      if (spilled && !oldest)
+         break;
+
+      std::uniform_int_distribution<long> index(spilled ? 0 : oldest, spilled ? oldest - 1 : frames - 1);
+
+      start = std::chrono::steady_clock::now();
+
+      for (long r = 0; r < reads; r++)
+      {
+         long i = index(random);
+
+         nfc::NfcFrame frame = store.frame(i);
+         nfc::NfcFrame expected = makeFrame(i, false);
+
+         if (frame.timeStart() != expected.timeStart() || frame.techType() != expected.techType() || frame.limit() != expected.limit() || frame[frame.limit() - 1] != expected[expected.limit() - 1])
+            wrong++;
+      }
+
+      printf("  random %s frame: %.2f us\n", spilled ? "spilled " : "resident", elapsed(start) * 1E6 / reads);
+   }
+
+   // limit is applied each time a block of 1024 frames is completed
+   bool bounded = !retention || (store.residentSize() <= (size_t) retention + 1024 && oldest > 0 && !store.refusedSize());
+
+   printf("  wrong frames %ld, resident limit %s\n", wrong, bounded ? "kept" : "FAILED");
+
+   return wrong || !bounded ? 1 : 0;
+}
+
+}
@@ -0,0 +1,253 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include <nfc/Nfc.h>
+#include <nfc/NfcFrame.h>
+#include <nfc/FrameTrace.h>
+
+#include <Bench.h>
+
+using json = nlohmann::json;
+
+namespace bench {
+
+/*
+ * Write a trace in the layout saved by FrameStorageTask, polling frames followed by listen frames with
+ * payloads of 1 to 32 bytes. Written as text so generation does not count in peak memory.
+ */
+static bool writeTrace(const std::string &path, long frames)
+{
+   FILE *file = fopen(path.c_str(), "w");
+
+   if (!file)
+      return false;
+
+   fprintf(file, "{\n   \"frames\": [\n");
+
+   for (long i = 0; i < frames; i++)
+   {
+      unsigned long start = i * 2000 + 100;
+      unsigned long end = start + 760 + (i % 32) * 100;
+
+      std::string data;
+
+      for (long b = 0; b <= i % 32; b++)
+      {
+         char hex[4];
+
+         snprintf(hex, sizeof(hex), b ? ":%02X" : "%02X", (unsigned int) ((i + b * 7) & 0xff));
+
+         data += hex;
+      }
+
+      fprintf(file, "      {\n");
+      fprintf(file, "         \"frameData\": \"%s\",\n", data.c_str());
+      fprintf(file, "         \"frameFlags\": %ld,\n", i % 3 == 0 ? 1L : 0L);
+      fprintf(file, "         \"framePhase\": %ld,\n", 1 + i % 2);
+      fprintf(file, "         \"frameRate\": 105938,\n");
+      fprintf(file, "         \"frameType\": %d,\n", i % 2 ? nfc::FrameType::ListenFrame : nfc::FrameType::PollFrame);
+      fprintf(file, "         \"sampleEnd\": %lu,\n", end);
+      fprintf(file, "         \"sampleStart\": %lu,\n", start);
+      fprintf(file, "         \"sourceId\": %ld,\n", i % 2);
+      fprintf(file, "         \"techType\": %d,\n", nfc::TechType::NfcA);
+      fprintf(file, "         \"timeEnd\": %.9g,\n", end / 10E6);
+      fprintf(file, "         \"timeStart\": %.9g\n", start / 10E6);
+      fprintf(file, "      }%s\n", i + 1 < frames ? "," : "");
+   }
+
+   fprintf(file, "   ]\n}\n");
+
+   fclose(file);
+
+   return true;
+}
+
+// hash of every attribute restored by loaders, both must produce the same frames
+static unsigned long long hashFrame(unsigned long long hash, const nfc::NfcFrame &frame)
+{
+   auto mix = [&hash](unsigned long long value) {
+      hash = (hash ^ value) * 1099511628211ull;
+   };
+
+   double timeStart = frame.timeStart();
+   double timeEnd = frame.timeEnd();
+   unsigned long long bits;
+
+   mix(frame.techType());
+   mix(frame.frameType());
+   mix(frame.framePhase());
+   mix(frame.frameFlags());
+   mix(frame.frameRate());
+   mix(frame.sampleStart());
+   mix(frame.sampleEnd());
+   mix(frame.sourceId());
+
+   std::memcpy(&bits, &timeStart, sizeof(bits));
+   mix(bits);
+
+   std::memcpy(&bits, &timeEnd, sizeof(bits));
+   mix(bits);
+
+   for (unsigned int i = 0; i < frame.limit(); i++)
+      mix(frame[i]);
+
+   return hash;
+}
+
+struct LoadResult
+{
+   long frames = 0;
+   double first = 0;
+   double total = 0;
+   unsigned long long hash = 14695981039346656037ull;
+};
+
+// streaming loader used by FrameStorageTask
+static LoadResult loadStream(const std::string &path)
+{
+   LoadResult result;
+
+   auto start = std::chrono::steady_clock::now();
+
+   nfc::FrameTrace trace(path);
+
+   if (!trace.open())
+      return result;
+
+   nfc::NfcFrame frame;
+
+   while (trace.read(frame))
+   {
+      if (!result.frames++)
+         result.first = elapsed(start);
+
+      result.hash = hashFrame(result.hash, frame);
+   }
+
+   result.total = elapsed(start);
+
+   return result;
+}
+
+// document loader, as FrameStorageTask did before FrameTrace
+static LoadResult loadDocument(const std::string &path)
+{
+   LoadResult result;
+
+   auto start = std::chrono::steady_clock::now();
+
+   json info;
+
+   std::ifstream input(path);
+
+   input >> info;
+
+   for (const auto &frame: info["frames"])
+   {
+      nfc::NfcFrame nfcFrame(256);
+
+      nfcFrame.setTechType(frame["techType"]);
+      nfcFrame.setFrameType(frame["frameType"]);
+      nfcFrame.setFramePhase(frame["framePhase"]);
+      nfcFrame.setFrameFlags(frame["frameFlags"]);
+      nfcFrame.setFrameRate(frame["frameRate"]);
+      nfcFrame.setTimeStart(frame["timeStart"]);
+      nfcFrame.setTimeEnd(frame["timeEnd"]);
+      nfcFrame.setSampleStart(frame["sampleStart"]);
+      nfcFrame.setSampleEnd(frame["sampleEnd"]);
+
+      if (frame.contains("sourceId"))
+         nfcFrame.setSourceId(frame["sourceId"]);
+
+      std::string frameData = frame["frameData"];
+
+      for (size_t index = 0, size = 0; index < frameData.length(); index += size + 1)
+         nfcFrame.put(std::stoi(frameData.c_str() + index, &size, 16));
+
+      nfcFrame.flip();
+
+      if (!result.frames++)
+         result.first = elapsed(start);
+
+      result.hash = hashFrame(result.hash, nfcFrame);
+   }
+
+   result.total = elapsed(start);
+
+   return result;
+}
+
+/*
+ * Load a large generated JSON trace with the streaming reader and then with the previous document
+ * loader. Streaming runs first so its peak memory is not hidden by the document one.
+ */
+int trace(int argc, char *argv[])
+{
+   long frames = argc > 0 ? std::atol(argv[0]) : 500000;
+   std::string path = argc > 1 ? argv[1] : "nfc-bench-trace.json";
+
+   if (!writeTrace(path, frames))
+   {
+      printf("unable to write %s\n", path.c_str());
+      return 1;
+   }
+
+   std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+   printf("trace of %ld frames, %.1f MB\n", frames, (double) file.tellg() / 1E6);
+
+   long long base = peakMemory();
+
+   LoadResult stream = loadStream(path);
+
+   long long streamPeak = peakMemory();
+
+   LoadResult document = loadDocument(path);
+
+   long long documentPeak = peakMemory();
+
+   printf("  FrameTrace: %ld frames in %.3f s, first frame after %.3f ms, peak memory +%.1f MB\n",
+          stream.frames, stream.total, stream.first * 1E3, double(streamPeak - base) / 1E6);
+
+   printf("  document:   %ld frames in %.3f s, first frame after %.3f ms, peak memory +%.1f MB\n",
+          document.frames, document.total, document.first * 1E3, double(documentPeak - base) / 1E6);
+
+   bool passed = stream.frames == frames && document.frames == frames && stream.hash == document.hash;
+
+   printf("  frames %s\n", passed ? "match" : "DIFFER");
+
+   std::remove(path.c_str());
+
+   return passed ? 0 : 1;
+}
+
+}
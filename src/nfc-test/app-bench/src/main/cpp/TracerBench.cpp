@@ -0,0 +1,113 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <rt/Tracer.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// short lived threads started one after another, as devices and decoders restarted over a session
+#define TRACER_THREADS 256
+
+// runs given number of threads one after another, each recording one span
+static void churn(int threads)
+{
+   for (int i = 0; i < threads; i++)
+   {
+      std::thread worker([] {
+         rt::Tracer::Scope scope("worker", "bench");
+      });
+
+      worker.join();
+   }
+}
+
+/*
+ * Cost of one traced span with tracing disabled and enabled, enabled spans carry a flow id as buffer
+ * conversions do. Then checks that threads finishing one after another do not each leave a ring behind.
+ * Optionally writes the recorded timeline to given path.
+ */
+int tracer(int argc, char *argv[])
+{
+   long spans = argc > 0 ? std::atol(argv[0]) : 1000000;
+
+   std::string path = argc > 1 ? argv[1] : "";
+
+   rt::Tracer::enable(false);
+
+   auto start = std::chrono::steady_clock::now();
+
+   for (long i = 0; i < spans; i++)
+      rt::Tracer::Scope scope("disabled", "bench");
+
+   double disabled = elapsed(start);
+
+   rt::Tracer::enable(true);
+
+   rt::Tracer::thread("TracerBench");
+
+   start = std::chrono::steady_clock::now();
+
+   for (long i = 0; i < spans; i++)
+      rt::Tracer::Scope scope("enabled", "bench", i + 1, rt::Tracer::FlowOut);
+
+   double enabled = elapsed(start);
+
+   // rings of finished threads are reused, so memory stops growing once the kept ones are allocated
+   long long memory = peakMemory();
+
+   churn(TRACER_THREADS / 8);
+
+   long long first = peakMemory() - memory;
+
+   churn(TRACER_THREADS - TRACER_THREADS / 8);
+
+   long long rest = peakMemory() - memory - first;
+
+   bool bounded = rest < 8 * 1024 * 1024;
+
+   rt::Tracer::enable(false);
+
+   printf("tracer, %ld spans\n", spans);
+
+   printf("  disabled: %.2f ns per span\n", disabled * 1E9 / spans);
+
+   printf("  enabled:  %.2f ns per span\n", enabled * 1E9 / spans);
+
+   printf("  %d finished threads: first %d +%.1f MB, rest +%.1f MB, span memory %s\n",
+          TRACER_THREADS, TRACER_THREADS / 8, first / 1E6, rest / 1E6, bounded ? "bounded" : "FAILED");
+
+   if (!path.empty())
+      printf("  timeline %s: %s\n", path.c_str(), rt::Tracer::dump(path) ? "written" : "failed");
+
+   return bounded ? 0 : 1;
+}
+
+}
@@ -0,0 +1,154 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <rt/Worker.h>
+#include <rt/Executor.h>
+#include <rt/BlockingQueue.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// shared with the worker, as the executor owns and releases it
+struct WakeState
+{
+   rt::BlockingQueue<std::chrono::steady_clock::time_point> queue;
+
+   std::vector<double> latency;
+
+   std::atomic<long> passes {0};
+};
+
+/*
+ * Worker that drains a queue of send timestamps, as task loops drain their command and data queues.
+ * With a poll interval it sleeps with timed waits and nobody notifies it, as task loops did before.
+ */
+struct WakeWorker : rt::Worker
+{
+   int poll;
+
+   std::shared_ptr<WakeState> state;
+
+   WakeWorker(int poll, std::shared_ptr<WakeState> state) : rt::Worker("WakeWorker"), poll(poll), state(std::move(state))
+   {
+   }
+
+   bool loop() override
+   {
+      state->passes++;
+
+      while (auto sent = state->queue.get())
+         state->latency.push_back(elapsed(sent.value()));
+
+      if (poll > 0)
+         wait(poll);
+      else
+         wait();
+
+      return true;
+   }
+};
+
+void wakeRun(rt::Executor &executor, int poll, int messages)
+{
+   auto state = std::make_shared<WakeState>();
+
+   auto worker = new WakeWorker(poll, state);
+
+   executor.submit(worker);
+
+   // let worker reach its first wait
+   std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+   // idle worker, only timeouts wake it
+   long before = state->passes;
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+   long idle = state->passes - before;
+
+   // sparse messages, worker is always sleeping when they arrive
+   for (int i = 0; i < messages; i++)
+   {
+      state->queue.add(std::chrono::steady_clock::now());
+
+      if (!poll)
+         worker->notify();
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(2 + i % 7));
+   }
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(poll + 100));
+
+   // returns once worker loop has finished
+   worker->terminate();
+
+   std::vector<double> &latency = state->latency;
+
+   std::sort(latency.begin(), latency.end());
+
+   double total = 0;
+
+   for (double value: latency)
+      total += value;
+
+   if (latency.empty())
+   {
+      printf("  %-12s no messages received\n", poll ? "poll" : "notify");
+      return;
+   }
+
+   char mode[32];
+
+   snprintf(mode, sizeof(mode), poll ? "poll %d ms" : "notify", poll);
+
+   printf("  %-12s latency avg %8.1f us, p99 %8.1f us, max %8.1f us, %ld loop passes in 500 ms idle\n", mode,
+          total / latency.size() * 1E6, latency[latency.size() * 99 / 100] * 1E6, latency.back() * 1E6, idle);
+}
+
+int wake(int argc, char *argv[])
+{
+   int messages = argc > 0 ? std::atoi(argv[0]) : 500;
+
+   rt::Executor executor(4, 1);
+
+   printf("worker wake-up, %d messages\n", messages);
+
+   wakeRun(executor, 0, messages);
+
+   for (int poll: {50, 250})
+      wakeRun(executor, poll, messages / 10);
+
+   return 0;
+}
+
+}
@@ -0,0 +1,155 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rt/FileWriter.h>
+
+#include <Bench.h>
+
+namespace bench {
+
+// bytes per recorder buffer, 65536 IQ samples of 16 bits
+#define WRITER_BUFFER (65536 * 4)
+
+struct WriteResult
+{
+   double produce = 0;
+   double total = 0;
+   double worst = 0;
+};
+
+// one buffer per period when paced like a capture, time spent in write calls is what the recorder loop loses
+template <typename W>
+static WriteResult produce(W &&write, long long buffers, const std::vector<char> &data, double period)
+{
+   WriteResult result;
+
+   auto start = std::chrono::steady_clock::now();
+
+   for (long long i = 0; i < buffers; i++)
+   {
+      if (period > 0)
+         std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(period * double(i))));
+
+      auto call = std::chrono::steady_clock::now();
+
+      write(data.data(), data.size());
+
+      double time = elapsed(call);
+
+      result.produce += time;
+      result.worst = std::max(result.worst, time);
+   }
+
+   result.total = elapsed(start);
+
+   return result;
+}
+
+/*
+ * Producer cost of writing 16 bit IQ buffers through rt::FileWriter against synchronous std::ofstream writes
+ * as recordings were stored before. Producer rate counts only time spent inside write calls, which is what
+ * the recorder loop loses, total rate includes close and reflects disk bandwidth. With a rate given buffers
+ * are produced at that pace, as a receiver delivers them, otherwise as fast as possible.
+ */
+int writer(int argc, char *argv[])
+{
+   long long megabytes = argc > 0 ? std::atoll(argv[0]) : 2048;
+   double rate = argc > 1 ? std::atof(argv[1]) : 0;
+   std::string path = argc > 2 ? argv[2] : "nfc-bench-writer.raw";
+
+   long long buffers = megabytes * 1024 * 1024 / WRITER_BUFFER;
+
+   // seconds per buffer at given rate in MS/s
+   double period = rate > 0 ? WRITER_BUFFER / 4 / (rate * 1E6) : 0;
+
+   std::vector<char> data(WRITER_BUFFER);
+
+   for (size_t i = 0; i < data.size(); i++)
+      data[i] = char(i * 31 + (i >> 12));
+
+   if (period > 0)
+      printf("%lld buffers of %d bytes, %lld MB, paced at %.0f MS/s\n", buffers, WRITER_BUFFER, megabytes, rate);
+   else
+      printf("%lld buffers of %d bytes, %lld MB, unpaced\n", buffers, WRITER_BUFFER, megabytes);
+
+   for (int pass = 0; pass < 2; pass++)
+   {
+      WriteResult stream, async;
+
+      {
+         std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+         stream = produce([&](const char *data, size_t size) { file.write(data, size); }, buffers, data, period);
+
+         auto start = std::chrono::steady_clock::now();
+
+         file.close();
+
+         stream.total += elapsed(start);
+      }
+
+      std::remove(path.c_str());
+
+      bool direct;
+
+      {
+         rt::FileWriter file(path);
+
+         if (!file.open())
+         {
+            printf("unable to write %s\n", path.c_str());
+            return 1;
+         }
+
+         direct = file.isDirect();
+
+         async = produce([&](const char *data, size_t size) { file.write(data, size); }, buffers, data, period);
+
+         auto start = std::chrono::steady_clock::now();
+
+         file.close();
+
+         async.total += elapsed(start);
+      }
+
+      std::remove(path.c_str());
+
+      double samples = double(buffers) * WRITER_BUFFER / 4;
+
+      printf("  ofstream  : producer %5.0f MS/s, total %5.0f MS/s, worst call %6.2f ms\n", samples / stream.produce / 1E6, samples / stream.total / 1E6, stream.worst * 1E3);
+      printf("  FileWriter: producer %5.0f MS/s, total %5.0f MS/s, worst call %6.2f ms, direct I/O %s\n", samples / async.produce / 1E6, samples / async.total / 1E6, async.worst * 1E3, direct ? "yes" : "no");
+   }
+
+   return 0;
+}
+
+}
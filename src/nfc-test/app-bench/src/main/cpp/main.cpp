@@ -0,0 +1,117 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <psapi.h>
+
+#undef ERROR
+
+#else
+
+#include <sys/resource.h>
+
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+#include <rt/Logger.h>
+
+#include <Bench.h>
+
+using namespace rt;
+
+Logger logger {"main"};
+
+struct Entry
+{
+   const char *name;
+   const char *help;
+   int (*run)(int argc, char *argv[]);
+};
+
+// available benchmarks, selected by first argument
+const Entry entries[] = {
+      {"codec", "[megavalues] [path]: encode and decode IQ through recordings in each sample format, check rounding and legacy 8 bit files", bench::codec},
+      {"compact", "[frames]: compact a generated polling stream, check period detection, held back polls and expansion round trip", bench::compact},
+      {"handoff", "[iterations]: publish 64k sample buffers and frames to 3 queued subscribers", bench::handoff},
+      {"logger", "[bursts]: producer cost of debug calls while the writer thread drains", bench::logger},
+      {"pack", "[directory] [threads] [path]: pack and unpack WAV files losslessly, check round trip, ratio and rate", bench::pack},
+      {"rtltcp", "[megabytes]: receive and check u8 IQ from a loopback rtl_tcp server", bench::rtltcp},
+      {"sim", "[seconds] [stall ms] [path]: play recordings through sim:// devices, check delivered and dropped samples, 0 and 120 ms stalls by default", bench::sim},
+      {"spill", "[frames] [resident] [path]: FrameStore with retention limit and spill file, memory and random access", bench::spill},
+      {"store", "[frames] [queries]: FrameStore time range queries with filtered count, in order and with late frames", bench::store},
+      {"trace", "[frames] [path]: load a generated JSON trace streaming and as a document, time and peak memory", bench::trace},
+      {"tracer", "[spans] [path]: cost of one span with tracing disabled and enabled, span memory of finished threads", bench::tracer},
+      {"wake", "[messages]: worker wake-up latency and idle loop passes, notified and polling", bench::wake},
+      {"wavread", "[megabytes] [path]: sequential read of a 16 bit IQ recording, memory mapped and through streams", bench::wavread},
+      {"writer", "[megabytes] [rate] [path]: producer cost of 16 bit IQ buffers through FileWriter and synchronous ofstream", bench::writer},
+};
+
+long long bench::peakMemory()
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS counters {};
+
+   GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+   return (long long) counters.PeakWorkingSetSize;
+#else
+   rusage usage {};
+
+   getrusage(RUSAGE_SELF, &usage);
+
+   return (long long) usage.ru_maxrss * 1024;
+#endif
+}
+
+int usage()
+{
+   printf("usage: nfc-bench <name> [arguments]\n");
+
+   for (const auto &entry: entries)
+      printf("  %s %s\n", entry.name, entry.help);
+
+   return 1;
+}
+
+int main(int argc, char *argv[])
+{
+   if (argc < 2)
+      return usage();
+
+   for (const auto &entry: entries)
+   {
+      if (std::strcmp(argv[1], entry.name) == 0)
+      {
+         logger.info("running benchmark {}", {entry.name});
+
+         return entry.run(argc - 2, argv + 2);
+      }
+   }
+
+   return usage();
+}
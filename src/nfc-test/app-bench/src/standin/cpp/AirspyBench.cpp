@@ -0,0 +1,127 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <chrono>
+
+#include <rt/Logger.h>
+
+#include <sdr/SignalBuffer.h>
+#include <sdr/AirspyDevice.h>
+
+#include <Standin.h>
+
+// samples hashed on every run, output of all modes must match
+#define CHECKED_SAMPLES 4000000
+
+using namespace rt;
+
+Logger logger {"main"};
+
+/*
+ * Consumer for all modes: hashes the first IQ samples bit by bit and stalls on 1 in 25 buffers, as a
+ * decoder thread preempted under load would.
+ */
+struct Consumer
+{
+   int stall;
+
+   std::mt19937 random {1};
+
+   long long samples = 0;
+
+   unsigned long long hash = 14695981039346656037ull;
+
+   void operator()(const sdr::SignalBuffer &buffer)
+   {
+      const float *data = buffer.data();
+
+      for (unsigned int i = 0; i < buffer.limit() && samples * 2 + i < CHECKED_SAMPLES * 2; i++)
+      {
+         uint32_t bits;
+
+         std::memcpy(&bits, data + i, sizeof(bits));
+
+         hash = (hash ^ bits) * 1099511628211ull;
+      }
+
+      samples += buffer.limit() / 2;
+
+      if (stall && random() % 25 == 0)
+         std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+   }
+};
+
+int main(int argc, char *argv[])
+{
+   int mode = -1;
+
+   if (argc > 1)
+   {
+      if (std::strcmp(argv[1], "converted") == 0)
+         mode = sdr::AirspyDevice::Converted;
+      else if (std::strcmp(argv[1], "raw") == 0)
+         mode = sdr::AirspyDevice::Raw;
+      else if (std::strcmp(argv[1], "packed") == 0)
+         mode = sdr::AirspyDevice::Packed;
+   }
+
+   if (mode < 0)
+   {
+      printf("usage: nfc-bench-airspy <converted|raw|packed> [stall ms] [seconds]\n");
+      return 1;
+   }
+
+   Consumer consumer {argc > 2 ? atoi(argv[2]) : 60};
+
+   double seconds = argc > 3 ? atof(argv[3]) : 5;
+
+   sdr::AirspyDevice device("airspy://00000001");
+
+   device.setSampleRate(10000000);
+   device.setTransferMode(mode);
+
+   device.open(sdr::SignalDevice::Read);
+
+   device.start([&consumer](sdr::SignalBuffer &buffer) {
+      consumer(buffer);
+   });
+
+   std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+   device.stop();
+
+   long long dropped = device.samplesDropped();
+
+   device.close();
+
+   printf("%s mode, %d ms stalls: %.3f Msps, callback thread %.1f%% cpu, device dropped %lld transfers, reported dropped %lld, hash %016llx\n",
+          argv[1], consumer.stall, (double) consumer.samples / seconds / 1E6, standin::airspyCallbackTime.load() * 100 / seconds, standin::airspyDropped.load(), dropped, consumer.hash);
+
+   return 0;
+}
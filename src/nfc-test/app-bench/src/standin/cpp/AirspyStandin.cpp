@@ -0,0 +1,415 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <ctime>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <condition_variable>
+
+#include <airspy.h>
+
+extern "C" {
+#include <filters.h>
+#include <iqconverter_float.h>
+}
+
+#include <Standin.h>
+
+// transfer ring between USB and consumer threads, as in libairspy
+#define RAW_BUFFER_COUNT 8
+
+// USB transfer size, unpacked and packed
+#define TRANSFER_BYTES 262144
+#define PACKED_TRANSFER_BYTES (6144 * 24)
+
+// same scale as libairspy for 12 bit samples
+#define SAMPLE_SCALE (1.0f / 2048.0f)
+
+namespace standin {
+
+std::atomic<long long> airspyDropped {0};
+std::atomic<double> airspyCallbackTime {0};
+
+}
+
+/*
+ * Simulated Airspy: a USB thread produces 12 bit real samples at the configured rate into a ring of
+ * transfers, packed when requested, and a consumer thread converts them as libairspy does before
+ * calling the sample callback. Transfers arriving with the ring full are dropped and reported in
+ * dropped_samples of the next callback.
+ */
+struct airspy_device
+{
+   airspy_sample_type sampleType = AIRSPY_SAMPLE_FLOAT32_IQ;
+
+   uint32_t sampleRate = 10000000;
+
+   bool packing = false;
+
+   std::vector<std::vector<uint16_t>> ring {RAW_BUFFER_COUNT};
+   std::vector<uint32_t> ringDropped = std::vector<uint32_t>(RAW_BUFFER_COUNT);
+
+   int head = 0;
+   int tail = 0;
+   int count = 0;
+
+   uint32_t dropped = 0;
+
+   std::mutex mutex;
+   std::condition_variable signal;
+
+   std::atomic<bool> streaming {false};
+
+   std::thread usbThread;
+   std::thread consumerThread;
+
+   airspy_sample_block_cb_fn callback = nullptr;
+
+   void *context = nullptr;
+
+   iqconverter_float_t *converter = iqconverter_float_create(HB_KERNEL_FLOAT, HB_KERNEL_FLOAT_LEN);
+
+   ~airspy_device()
+   {
+      iqconverter_float_free(converter);
+   }
+
+   int transferBytes() const
+   {
+      return packing ? PACKED_TRANSFER_BYTES : TRANSFER_BYTES;
+   }
+
+   int transferSamples() const
+   {
+      return packing ? PACKED_TRANSFER_BYTES * 2 / 3 : TRANSFER_BYTES / 2;
+   }
+
+   // deterministic tone with some noise, same sequence on every start
+   static uint16_t sampleAt(long long k)
+   {
+      return (uint16_t) (2048 + 1500 * std::sin(k * 0.7853981634 * 1.01) + ((uint32_t) (k * 2654435761u) >> 28));
+   }
+
+   static void pack(const uint16_t *input, uint32_t *output, int length)
+   {
+      for (int i = 0, j = 0; j < length; i += 3, j += 8)
+      {
+         const uint16_t *s = input + j;
+
+         output[i + 0] = (uint32_t) s[0] << 20 | (uint32_t) s[1] << 8 | s[2] >> 4;
+         output[i + 1] = (uint32_t) (s[2] & 0xf) << 28 | (uint32_t) s[3] << 16 | (uint32_t) s[4] << 4 | s[5] >> 8;
+         output[i + 2] = (uint32_t) (s[5] & 0xff) << 24 | (uint32_t) s[6] << 12 | s[7];
+      }
+   }
+
+   static void unpack(const uint32_t *input, uint16_t *output, int length)
+   {
+      for (int i = 0, j = 0; j < length; i += 3, j += 8)
+      {
+         output[j + 0] = (input[i] >> 20) & 0xfff;
+         output[j + 1] = (input[i] >> 8) & 0xfff;
+         output[j + 2] = ((input[i] & 0xff) << 4) | ((input[i + 1] >> 28) & 0xf);
+         output[j + 3] = ((input[i + 1] & 0xfff0000) >> 16);
+         output[j + 4] = ((input[i + 1] & 0xfff0) >> 4);
+         output[j + 5] = ((input[i + 1] & 0xf) << 8) | ((input[i + 2] & 0xff000000) >> 24);
+         output[j + 6] = ((input[i + 2] >> 12) & 0xfff);
+         output[j + 7] = ((input[i + 2] & 0xfff));
+      }
+   }
+
+   void usbRun()
+   {
+      int samples = transferSamples();
+
+      double period = samples / (2.0 * sampleRate);
+
+      auto start = std::chrono::steady_clock::now();
+
+      std::vector<uint16_t> raw(samples);
+
+      long long k = 0;
+      long long n = 0;
+
+      while (streaming)
+      {
+         for (int i = 0; i < samples; i++)
+            raw[i] = sampleAt(k++);
+
+         // transfer completes when the device has sampled it
+         std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(++n * period)));
+
+         std::lock_guard<std::mutex> lock(mutex);
+
+         if (count == RAW_BUFFER_COUNT)
+         {
+            dropped++;
+            standin::airspyDropped++;
+            continue;
+         }
+
+         auto &slot = ring[head];
+
+         slot.resize(transferBytes() / 2);
+
+         if (packing)
+            pack(raw.data(), reinterpret_cast<uint32_t *>(slot.data()), samples);
+         else
+            std::memcpy(slot.data(), raw.data(), transferBytes());
+
+         ringDropped[head] = dropped;
+
+         dropped = 0;
+
+         head = (head + 1) % RAW_BUFFER_COUNT;
+
+         count++;
+
+         signal.notify_one();
+      }
+   }
+
+   void consumerRun()
+   {
+      int samples = transferSamples();
+
+      std::vector<float> converted(samples);
+      std::vector<uint16_t> unpacked(samples);
+
+      while (true)
+      {
+         uint16_t *input;
+         uint32_t lost;
+
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            signal.wait(lock, [this] { return count > 0 || !streaming; });
+
+            if (!streaming)
+               break;
+
+            input = ring[tail].data();
+            lost = ringDropped[tail];
+
+            tail = (tail + 1) % RAW_BUFFER_COUNT;
+         }
+
+         // libairspy unpacks for every sample type except raw
+         if (packing && sampleType != AIRSPY_SAMPLE_RAW)
+         {
+            unpack(reinterpret_cast<const uint32_t *>(input), unpacked.data(), samples);
+            input = unpacked.data();
+         }
+
+         airspy_transfer transfer {};
+
+         transfer.device = this;
+         transfer.ctx = context;
+         transfer.sample_type = sampleType;
+
+         if (sampleType == AIRSPY_SAMPLE_FLOAT32_IQ)
+         {
+            for (int i = 0; i < samples; i++)
+               converted[i] = float(input[i] - 2048) * SAMPLE_SCALE;
+
+            iqconverter_float_process(converter, converted.data(), samples);
+
+            transfer.samples = converted.data();
+            transfer.sample_count = samples / 2;
+         }
+         else
+         {
+            transfer.samples = input;
+            transfer.sample_count = samples;
+         }
+
+         transfer.dropped_samples = (uint64_t) lost * transfer.sample_count;
+
+         callback(&transfer);
+
+         std::lock_guard<std::mutex> lock(mutex);
+
+         count--;
+      }
+
+      timespec time {};
+
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+      standin::airspyCallbackTime = (double) time.tv_sec + (double) time.tv_nsec * 1E-9;
+   }
+};
+
+extern "C" {
+
+int airspy_list_devices(uint64_t *serials, int count)
+{
+   if (serials && count > 0)
+      serials[0] = 1;
+
+   return 1;
+}
+
+int airspy_open_sn(airspy_device **device, uint64_t serial_number)
+{
+   *device = new airspy_device;
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_open_fd(airspy_device **device, const char *path, int fd)
+{
+   return airspy_open_sn(device, 1);
+}
+
+int airspy_close(airspy_device *device)
+{
+   delete device;
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_get_samplerates(airspy_device *device, uint32_t *buffer, const uint32_t len)
+{
+   buffer[0] = len ? 10000000 : 1;
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_samplerate(airspy_device *device, uint32_t samplerate)
+{
+   if (samplerate)
+      device->sampleRate = samplerate;
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_start_rx(airspy_device *device, airspy_sample_block_cb_fn callback, void *rx_ctx)
+{
+   device->callback = callback;
+   device->context = rx_ctx;
+   device->head = device->tail = device->count = 0;
+
+   iqconverter_float_reset(device->converter);
+
+   device->streaming = true;
+   device->consumerThread = std::thread([device] { device->consumerRun(); });
+   device->usbThread = std::thread([device] { device->usbRun(); });
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_stop_rx(airspy_device *device)
+{
+   device->streaming = false;
+   device->signal.notify_all();
+
+   if (device->usbThread.joinable())
+      device->usbThread.join();
+
+   if (device->consumerThread.joinable())
+      device->consumerThread.join();
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_is_streaming(airspy_device *device)
+{
+   return device->streaming;
+}
+
+int airspy_version_string_read(airspy_device *device, char *version, uint8_t length)
+{
+   if (length)
+   {
+      strncpy(version, "standin", length);
+      version[length - 1] = 0;
+   }
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_board_partid_serialno_read(airspy_device *device, airspy_read_partid_serialno_t *read_partid_serialno)
+{
+   *read_partid_serialno = {};
+
+   read_partid_serialno->serial_no[3] = 1;
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_sample_type(airspy_device *device, enum airspy_sample_type sample_type)
+{
+   device->sampleType = sample_type;
+
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_freq(airspy_device *device, const uint32_t freq_hz)
+{
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_lna_agc(airspy_device *device, uint8_t value)
+{
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_mixer_agc(airspy_device *device, uint8_t value)
+{
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_linearity_gain(airspy_device *device, uint8_t value)
+{
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_sensitivity_gain(airspy_device *device, uint8_t value)
+{
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_rf_bias(airspy_device *device, uint8_t value)
+{
+   return AIRSPY_SUCCESS;
+}
+
+int airspy_set_packing(airspy_device *device, uint8_t value)
+{
+   device->packing = value;
+
+   return AIRSPY_SUCCESS;
+}
+
+const char *airspy_error_name(enum airspy_error errcode)
+{
+   return errcode == AIRSPY_SUCCESS ? "AIRSPY_SUCCESS" : "AIRSPY_ERROR";
+}
+
+}
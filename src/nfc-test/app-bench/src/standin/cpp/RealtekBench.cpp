@@ -0,0 +1,173 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+#include <rtl-sdr.h>
+
+#include <rt/Logger.h>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RealtekDevice.h>
+
+#include <Standin.h>
+
+// blocks read by the synchronous reader, as RealtekDevice did before the async transfers
+#define READER_SAMPLES 2048
+#define BUFFER_SAMPLES 65536
+
+using namespace rt;
+
+Logger logger {"main"};
+
+/*
+ * Consumer for both readers: checks the converted ramp until the stand-in loses the first byte and
+ * stalls on 1 in 20 buffers, as a decoder thread preempted under load would.
+ */
+struct Consumer
+{
+   int stall;
+
+   std::mt19937 random {1};
+
+   long long samples = 0;
+   long long wrong = 0;
+
+   void operator()(const sdr::SignalBuffer &buffer)
+   {
+      const float *data = buffer.data();
+
+      if (standin::rtlsdrLost == 0)
+      {
+         for (unsigned int i = 0; i < buffer.limit(); i++)
+         {
+            float expected = float(int((samples * 2 + i) & 0xff) - 128) / 256.0f + 0.0025f;
+
+            if (std::fabs(data[i] - expected) > 1e-6f)
+               wrong++;
+         }
+      }
+
+      samples += buffer.limit() / 2;
+
+      if (stall && random() % 20 == 0)
+         std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+   }
+};
+
+// synchronous reader: read, convert and deliver on one thread, short reads are the only loss signal
+long long readSync(Consumer &consumer, double seconds)
+{
+   rtlsdr_dev_t *dev;
+
+   unsigned char data[READER_SAMPLES * 2];
+   float scaled[READER_SAMPLES * 2];
+
+   long long dropped = 0;
+
+   rtlsdr_open(&dev, 0);
+   rtlsdr_set_sample_rate(dev, 3200000);
+   rtlsdr_reset_buffer(dev);
+
+   auto start = std::chrono::steady_clock::now();
+
+   while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds)
+   {
+      int length;
+
+      sdr::SignalBuffer buffer(BUFFER_SAMPLES * 2, 2, 3200000, consumer.samples, 0, sdr::SignalType::SAMPLE_IQ);
+
+      while (buffer.available() > READER_SAMPLES && rtlsdr_read_sync(dev, data, sizeof(data), &length) == 0)
+      {
+         for (int i = 0; i < length; i++)
+            scaled[i] = float((data[i] - 128) / 256.0) + 0.0025f;
+
+         buffer.put(scaled, length);
+
+         dropped += (sizeof(data) - length) >> 1;
+      }
+
+      buffer.flip();
+
+      consumer(buffer);
+   }
+
+   rtlsdr_close(dev);
+
+   return dropped;
+}
+
+// asynchronous reader through RealtekDevice
+long long readAsync(Consumer &consumer, double seconds)
+{
+   sdr::RealtekDevice device("rtlsdr://00000001");
+
+   device.setSampleRate(3200000);
+
+   device.open(sdr::SignalDevice::Read);
+
+   device.start([&consumer](sdr::SignalBuffer &buffer) {
+      consumer(buffer);
+   });
+
+   std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+   device.stop();
+
+   long long dropped = device.samplesDropped();
+
+   device.close();
+
+   return dropped;
+}
+
+int main(int argc, char *argv[])
+{
+   if (argc < 2 || (std::strcmp(argv[1], "sync") != 0 && std::strcmp(argv[1], "async") != 0))
+   {
+      printf("usage: nfc-bench-rtlsdr <sync|async> [stall ms] [seconds]\n");
+      return 1;
+   }
+
+   bool async = std::strcmp(argv[1], "async") == 0;
+
+   Consumer consumer {argc > 2 ? atoi(argv[2]) : 8};
+
+   double seconds = argc > 3 ? atof(argv[3]) : 5;
+
+   long long dropped = async ? readAsync(consumer, seconds) : readSync(consumer, seconds);
+
+   printf("%s reader, %d ms stalls: %.3f Msps, device lost %lld samples, reported dropped %lld, wrong values %lld\n",
+          argv[1], consumer.stall, (double) consumer.samples / seconds / 1E6, standin::rtlsdrLost.load() / 2, dropped, consumer.wrong);
+
+   return 0;
+}
@@ -0,0 +1,332 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include <rtl-sdr.h>
+
+#include <Standin.h>
+
+// size of the RTL2832 USB endpoint FIFO, samples are lost when no transfer drains it in time
+#define FIFO_BYTES 16384
+
+// producer period, the FIFO is filled in small steps to follow the sample rate closely
+#define PRODUCER_PERIOD std::chrono::microseconds(100)
+
+namespace standin {
+
+std::atomic<long long> rtlsdrProduced {0};
+std::atomic<long long> rtlsdrLost {0};
+
+}
+
+/*
+ * Pending USB transfer, filled by the producer thread from the device FIFO
+ */
+struct Transfer
+{
+   std::vector<unsigned char> data;
+
+   size_t used = 0;
+};
+
+/*
+ * Simulated RTL2832: a producer thread generates an 8 bit ramp at the configured sample rate into
+ * the device FIFO, which is drained into the transfers submitted by rtlsdr_read_sync or
+ * rtlsdr_read_async. Bytes that do not fit in the FIFO are lost, as they are on the real device.
+ */
+struct rtlsdr_dev
+{
+   uint32_t sampleRate = 3200000;
+
+   long long position = 0;
+
+   size_t fifo = 0;
+
+   std::deque<Transfer *> pending;
+   std::deque<Transfer *> completed;
+
+   std::mutex mutex;
+   std::condition_variable signal;
+
+   std::atomic<bool> running {false};
+   std::atomic<bool> cancelled {false};
+
+   std::thread producer;
+
+   void run()
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      long long produced = 0;
+
+      while (running)
+      {
+         std::this_thread::sleep_for(PRODUCER_PERIOD);
+
+         // bytes the device has sampled since start, always whole IQ pairs
+         long long target = (long long) (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * sampleRate * 2) & ~1LL;
+
+         std::lock_guard<std::mutex> lock(mutex);
+
+         fifo += target - produced;
+         produced = target;
+
+         while (fifo > 0 && !pending.empty())
+         {
+            Transfer *transfer = pending.front();
+
+            size_t length = std::min(fifo, transfer->data.size() - transfer->used);
+
+            for (size_t i = 0; i < length; i++)
+               transfer->data[transfer->used + i] = (unsigned char) (position++ & 0xff);
+
+            transfer->used += length;
+
+            fifo -= length;
+
+            standin::rtlsdrProduced += length;
+
+            if (transfer->used == transfer->data.size())
+            {
+               pending.pop_front();
+               completed.push_back(transfer);
+               signal.notify_all();
+            }
+         }
+
+         // overflow, oldest bytes are lost and the ramp continues after them
+         if (fifo > FIFO_BYTES)
+         {
+            size_t lost = fifo - FIFO_BYTES;
+
+            position += lost;
+
+            fifo = FIFO_BYTES;
+
+            standin::rtlsdrLost += lost;
+         }
+      }
+   }
+};
+
+extern "C" {
+
+uint32_t rtlsdr_get_device_count(void)
+{
+   return 1;
+}
+
+int rtlsdr_get_device_usb_strings(uint32_t index, char *manufact, char *product, char *serial)
+{
+   strcpy(manufact, "standin");
+   strcpy(product, "RTL2832U");
+   strcpy(serial, "00000001");
+
+   return 0;
+}
+
+int rtlsdr_get_index_by_serial(const char *serial)
+{
+   return 0;
+}
+
+int rtlsdr_open(rtlsdr_dev_t **dev, uint32_t index)
+{
+   *dev = new rtlsdr_dev;
+
+   return 0;
+}
+
+int rtlsdr_close(rtlsdr_dev_t *dev)
+{
+   dev->running = false;
+
+   if (dev->producer.joinable())
+      dev->producer.join();
+
+   delete dev;
+
+   return 0;
+}
+
+enum rtlsdr_tuner rtlsdr_get_tuner_type(rtlsdr_dev_t *dev)
+{
+   return RTLSDR_TUNER_R820T;
+}
+
+int rtlsdr_get_tuner_gains(rtlsdr_dev_t *dev, int *gains)
+{
+   if (gains)
+      gains[0] = 0;
+
+   return 1;
+}
+
+int rtlsdr_set_tuner_gain(rtlsdr_dev_t *dev, int gain)
+{
+   return 0;
+}
+
+int rtlsdr_set_tuner_bandwidth(rtlsdr_dev_t *dev, uint32_t bw)
+{
+   return 0;
+}
+
+int rtlsdr_set_tuner_gain_mode(rtlsdr_dev_t *dev, int manual)
+{
+   return 0;
+}
+
+int rtlsdr_set_center_freq(rtlsdr_dev_t *dev, uint32_t freq)
+{
+   return 0;
+}
+
+int rtlsdr_set_sample_rate(rtlsdr_dev_t *dev, uint32_t rate)
+{
+   if (rate)
+      dev->sampleRate = rate;
+
+   return 0;
+}
+
+int rtlsdr_set_testmode(rtlsdr_dev_t *dev, int on)
+{
+   return 0;
+}
+
+int rtlsdr_set_agc_mode(rtlsdr_dev_t *dev, int on)
+{
+   return 0;
+}
+
+int rtlsdr_set_direct_sampling(rtlsdr_dev_t *dev, int on)
+{
+   return 0;
+}
+
+int rtlsdr_get_direct_sampling(rtlsdr_dev_t *dev)
+{
+   return 0;
+}
+
+// the device starts sampling when its buffer is reset, as before the first read
+int rtlsdr_reset_buffer(rtlsdr_dev_t *dev)
+{
+   if (!dev->running)
+   {
+      dev->running = true;
+      dev->producer = std::thread([dev] { dev->run(); });
+   }
+
+   return 0;
+}
+
+int rtlsdr_read_sync(rtlsdr_dev_t *dev, void *buf, int len, int *n_read)
+{
+   Transfer transfer;
+
+   transfer.data.resize(len);
+
+   std::unique_lock<std::mutex> lock(dev->mutex);
+
+   dev->pending.push_back(&transfer);
+
+   dev->signal.wait(lock, [dev] { return !dev->completed.empty(); });
+
+   dev->completed.pop_front();
+
+   memcpy(buf, transfer.data.data(), len);
+
+   *n_read = len;
+
+   return 0;
+}
+
+int rtlsdr_read_async(rtlsdr_dev_t *dev, rtlsdr_read_async_cb_t cb, void *ctx, uint32_t buf_num, uint32_t buf_len)
+{
+   std::vector<Transfer> transfers(buf_num);
+
+   dev->cancelled = false;
+
+   {
+      std::lock_guard<std::mutex> lock(dev->mutex);
+
+      for (auto &transfer: transfers)
+      {
+         transfer.data.resize(buf_len);
+         dev->pending.push_back(&transfer);
+      }
+   }
+
+   while (!dev->cancelled)
+   {
+      Transfer *transfer;
+
+      {
+         std::unique_lock<std::mutex> lock(dev->mutex);
+
+         // wake periodically to see cancellation, as libusb event handling does
+         if (!dev->signal.wait_for(lock, std::chrono::milliseconds(50), [dev] { return !dev->completed.empty(); }))
+            continue;
+
+         transfer = dev->completed.front();
+
+         dev->completed.pop_front();
+      }
+
+      cb(transfer->data.data(), (uint32_t) transfer->used, ctx);
+
+      // resubmit transfer
+      std::lock_guard<std::mutex> lock(dev->mutex);
+
+      transfer->used = 0;
+
+      dev->pending.push_back(transfer);
+   }
+
+   std::lock_guard<std::mutex> lock(dev->mutex);
+
+   dev->pending.clear();
+   dev->completed.clear();
+
+   return 0;
+}
+
+int rtlsdr_cancel_async(rtlsdr_dev_t *dev)
+{
+   dev->cancelled = true;
+
+   return 0;
+}
+
+}
@@ -0,0 +1,46 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef STANDIN_STANDIN_H
+#define STANDIN_STANDIN_H
+
+#include <atomic>
+
+/*
+ * Counters exported by the librtlsdr and libairspy stand-ins, so the harnesses can compare what the
+ * simulated device lost with what the SignalDevice reports.
+ */
+namespace standin {
+
+// bytes produced by the simulated RTL2832 and bytes lost when its FIFO overflowed
+extern std::atomic<long long> rtlsdrProduced;
+extern std::atomic<long long> rtlsdrLost;
+
+// transfers discarded by the simulated libairspy ring and CPU seconds spent by its callback thread
+extern std::atomic<long long> airspyDropped;
+extern std::atomic<double> airspyCallbackTime;
+
+}
+
+#endif
@@ -25,9 +25,12 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <mutex>
+#include <thread>
 #include <nlohmann/json.hpp>
 
 #include <rt/Logger.h>
+#include <rt/Executor.h>
 #include <rt/FileSystem.h>
 
 #include <sdr/SignalType.h>
@@ -35,12 +38,16 @@
 
 #include <nfc/NfcFrame.h>
 #include <nfc/NfcDecoder.h>
+#include <nfc/FrameTrace.h>
 
 using namespace rt;
 using namespace nlohmann;
 
 Logger logger {"main"};
 
+// serialize test report lines from parallel jobs
+std::mutex outputMutex;
+
 /*
  * Read frames from JSON storage
  */
@@ -49,41 +56,16 @@ bool readFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
    if (!rt::FileSystem::exists(path))
       return false;
 
-   json data;
-
-   // open file
-   std::ifstream input(path);
-
-   // read json
-   input >> data;
+   // frames are parsed incrementally, without loading whole document
+   nfc::FrameTrace input(path);
 
-   if (!data.contains("frames"))
+   if (!input.open() || input.isEof())
       return false;
 
-   // read frames from file
-   for (const auto &entry: data["frames"])
-   {
-      nfc::NfcFrame frame(256);
-
-      frame.setTechType(entry["techType"]);
-      frame.setFrameType(entry["frameType"]);
-      frame.setFramePhase(entry["framePhase"]);
-      frame.setFrameFlags(entry["frameFlags"]);
-      frame.setFrameRate(entry["frameRate"]);
-      frame.setTimeStart(entry["timeStart"]);
-      frame.setTimeEnd(entry["timeEnd"]);
-      frame.setSampleStart(entry["sampleStart"]);
-      frame.setSampleEnd(entry["sampleEnd"]);
-
-      std::string bytes = entry["frameData"];
-
-      for (size_t index = 0, size = 0; index < bytes.length(); index += size + 1)
-      {
-         frame.put(std::stoi(bytes.c_str() + index, &size, 16));
-      }
-
-      frame.flip();
+   nfc::NfcFrame frame;
 
+   while (input.read(frame))
+   {
       list.push_back(frame);
    }
 
@@ -195,6 +177,8 @@ int testFile(const std::string &signal)
       // read frames from json file
       if (readFrames(target, list2))
       {
+         std::lock_guard<std::mutex> lock(outputMutex);
+
          // show result
          std::cout << "TEST FILE " << filename << ": " << (list1 == list2 ? "PASS" : "FAIL") << std::endl;
       }
@@ -203,6 +187,8 @@ int testFile(const std::string &signal)
          // or create json file if not exists at first time
          writeFrames(target, list1);
 
+         std::lock_guard<std::mutex> lock(outputMutex);
+
          std::cout << "TEST FILE " << filename << ": TEST UPDATED!" << std::endl;
       }
    }
@@ -212,14 +198,24 @@ int testFile(const std::string &signal)
 
 int testPath(const std::string &path)
 {
+   // each file is decoded independently, run them in parallel
+   rt::Executor executor(128, std::max(1u, std::thread::hardware_concurrency()));
+
+   std::list<std::future<int>> results;
+
    for (const auto &entry: rt::FileSystem::directoryList(path))
    {
       if (entry.name.find(".wav") != std::string::npos)
       {
-         testFile(entry.name);
+         results.push_back(executor.async([name = entry.name] { return testFile(name); }));
       }
    }
 
+   for (auto &result: results)
+   {
+      result.wait();
+   }
+
    return 0;
 }
 